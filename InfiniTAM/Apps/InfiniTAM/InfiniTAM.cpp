@@ -13,6 +13,10 @@
 #include "../../InputSource/LibUVCEngine.h"
 #include "../../InputSource/RealSenseEngine.h"
 #include "../../InputSource/FFMPEGReader.h"
+#include "../../InputSource/LatestFrameImageSourceEngine.h"
+#include "../../InputSource/PackedSequence.h"
+#include "../../InputSource/PrefetchingImageSourceEngine.h"
+#include "../../InputSource/SharedMemoryRing.h"
 #include "../../ITMLib/ITMLibDefines.h"
 #include "../../ITMLib/Core/ITMBasicEngine.h"
 #include "../../ITMLib/Core/ITMBasicSurfelEngine.h"
@@ -68,6 +72,32 @@ static void CreateDefaultImageSource(ImageSourceEngine* & imageSource, IMUSource
 		}
 	}
 
+	if ((imageSource == NULL) && (filename1 != NULL) && (filename2 == NULL) && (strncmp(filename1, "shm:", 4) == 0))
+	{
+		printf("using shared memory ring: %s\n", filename1 + 4);
+		imageSource = new SharedMemoryImageSource(calibFile, filename1 + 4);
+		if (imageSource->getDepthImageSize().x == 0)
+		{
+			delete imageSource;
+			imageSource = NULL;
+		}
+	}
+
+	if ((imageSource == NULL) && (filename1 != NULL) && (filename2 == NULL))
+	{
+		imageSource = new PackedSequenceReader(calibFile, filename1);
+		if (imageSource->getDepthImageSize().x == 0)
+		{
+			delete imageSource;
+			imageSource = NULL;
+		}
+		else
+		{
+			printf("using packed sequence: %s\n", filename1);
+			imageSource = new PrefetchingImageSourceEngine(imageSource);
+		}
+	}
+
 	if ((imageSource == NULL) && (filename1 != NULL) && (filename_imu == NULL))
 	{
 		imageSource = new InputSource::FFMPEGReader(calibFile, filename1, filename2);
@@ -147,7 +177,16 @@ try
 	const char *arg3 = NULL;
 	const char *arg4 = NULL;
 
+	bool latestFrameOnly = false;
+
 	int arg = 1;
+	if (argv[arg] != NULL && strcmp(argv[arg], "--latest") == 0)
+	{
+		latestFrameOnly = true;
+		++arg;
+	}
+
+	int firstArg = arg;
 	do {
 		if (argv[arg] != NULL) arg1 = argv[arg]; else break;
 		++arg;
@@ -158,10 +197,12 @@ try
 		if (argv[arg] != NULL) arg4 = argv[arg]; else break;
 	} while (false);
 
-	if (arg == 1) {
-		printf("usage: %s [<calibfile> [<imagesource>] ]\n"
+	if (arg == firstArg) {
+		printf("usage: %s [--latest] [<calibfile> [<imagesource>] ]\n"
+		       "  --latest      : always process the newest frame, skipping those that arrive while a frame is processed\n"
 		       "  <calibfile>   : path to a file containing intrinsic calibration parameters\n"
-		       "  <imagesource> : either one argument to specify OpenNI device ID\n"
+		       "  <imagesource> : either one argument to specify a packed sequence, shm:<name> for a shared memory ring\n"
+		       "                  or OpenNI device ID\n"
 		       "                  or two arguments specifying rgb and depth file masks\n"
 		       "\n"
 		       "examples:\n"
@@ -182,6 +223,14 @@ try
 
 	ITMLibSettings *internalSettings = new ITMLibSettings();
 
+	// IMU measurements are read in step with the frames, so they cannot be skipped along with them
+	if (latestFrameOnly && imuSource == NULL)
+	{
+		printf("processing the latest frame only\n");
+		imageSource = new LatestFrameImageSourceEngine(imageSource, internalSettings->deviceType == ITMLibSettings::DEVICE_CUDA);
+	}
+	else if (latestFrameOnly) printf("warning: --latest is ignored with an IMU source\n");
+
 	ITMMainEngine *mainEngine = NULL;
 	switch (internalSettings->libMode)
 	{
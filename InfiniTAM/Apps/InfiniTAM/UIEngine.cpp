@@ -39,6 +39,16 @@ static void safe_glutBitmapString(void *font, const char *str)
 	}
 }
 
+/// Waits for a recorder to write its queued frames and deletes it
+static void StopRecorder(AsyncFrameRecorder* & recorder)
+{
+	recorder->waitUntilWritten();
+	printf("recorded %d frames, dropped %d\n", recorder->getNoRecordedFrames(), recorder->getNoDroppedFrames());
+
+	delete recorder;
+	recorder = NULL;
+}
+
 void UIEngine::glutDisplayFunction()
 {
 	UIEngine *uiEngine = UIEngine::Instance();
@@ -99,6 +109,13 @@ void UIEngine::glutDisplayFunction()
 	char str[200]; sprintf(str, "%04.2lf", uiEngine->processedTime);
 	safe_glutBitmapString(GLUT_BITMAP_HELVETICA_18, (const char*)str);
 
+	if (uiEngine->latestFrameSource != NULL)
+	{
+		glRasterPos2f(0.55f, -0.962f);
+		sprintf(str, "skipped %d", uiEngine->latestFrameSource->getNoSkippedFrames());
+		safe_glutBitmapString(GLUT_BITMAP_HELVETICA_18, (const char*)str);
+	}
+
 
 	glColor3f(1.0f, 0.0f, 0.0f); glRasterPos2f(-0.98f, -0.95f);
 	if (uiEngine->freeviewActive)
@@ -178,32 +195,32 @@ void UIEngine::glutKeyUpFunction(unsigned char key, int x, int y)
 		uiEngine->mainLoopAction = UIEngine::PROCESS_VIDEO;
 		break;
 	case 's':
-		if (uiEngine->isRecording)
+		if (uiEngine->sequenceRecorder != NULL)
 		{
 			printf("stopped recoding disk ...\n");
-			uiEngine->isRecording = false;
+			StopRecorder(uiEngine->sequenceRecorder);
 		}
 		else
 		{
-			printf("started recoding disk ...\n");
+			char str[250];
+			sprintf(str, "%s/recording.itmseq", uiEngine->outFolder);
+
+			// the recording is a packed sequence with losslessly compressed depth, which can be played back directly
+			printf("started recoding disk to %s ...\n", str);
 			uiEngine->currentFrameNo = 0;
-			uiEngine->isRecording = true;
+			uiEngine->sequenceRecorder = new AsyncFrameRecorder(new PackedSequenceSink(str, uiEngine->imageSource->getCalib()));
 		}
 		break;
 	case 'v':
-		if ((uiEngine->rgbVideoWriter != NULL) || (uiEngine->depthVideoWriter != NULL))
+		if (uiEngine->videoRecorder != NULL)
 		{
 			printf("stop recoding video\n");
-			delete uiEngine->rgbVideoWriter;
-			delete uiEngine->depthVideoWriter;
-			uiEngine->rgbVideoWriter = NULL;
-			uiEngine->depthVideoWriter = NULL;
+			StopRecorder(uiEngine->videoRecorder);
 		}
 		else
 		{
 			printf("start recoding video\n");
-			uiEngine->rgbVideoWriter = new FFMPEGWriter();
-			uiEngine->depthVideoWriter = new FFMPEGWriter();
+			uiEngine->videoRecorder = new AsyncFrameRecorder(new VideoSink("out_rgb.avi", "out_d.avi", 30));
 		}
 		break;
 	case 'e':
@@ -505,6 +522,7 @@ void UIEngine::Initialise(int & argc, char** argv, ImageSourceEngine *imageSourc
 	this->colourModes_freeview.push_back(UIColourMode("confidence", ITMMainEngine::InfiniTAM_IMAGE_FREECAMERA_COLOUR_FROM_CONFIDENCE));
 
 	this->imageSource = imageSource;
+	this->latestFrameSource = dynamic_cast<LatestFrameImageSourceEngine*>(imageSource);
 	this->imuSource = imuSource;
 	this->mainEngine = mainEngine;
 	{
@@ -534,10 +552,9 @@ void UIEngine::Initialise(int & argc, char** argv, ImageSourceEngine *imageSourc
 	winReg[1] = Vector4f(0.665f, h2, 1.0f, 1.0f);   // Side sub window 0
 	winReg[2] = Vector4f(0.665f, h1, 1.0f, h2);     // Side sub window 2
 
-	this->isRecording = false;
 	this->currentFrameNo = 0;
-	this->rgbVideoWriter = NULL;
-	this->depthVideoWriter = NULL;
+	this->sequenceRecorder = NULL;
+	this->videoRecorder = NULL;
 
 	glutInit(&argc, argv);
 	glutInitDisplayMode(GLUT_RGBA | GLUT_DOUBLE);
@@ -616,26 +633,9 @@ void UIEngine::ProcessFrame()
 		else imuSource->getMeasurement(inputIMUMeasurement);
 	}
 
-	if (isRecording)
-	{
-		char str[250];
-
-		sprintf(str, "%s/%04d.pgm", outFolder, currentFrameNo);
-		SaveImageToFile(inputRawDepthImage, str);
-
-		if (inputRGBImage->noDims != Vector2i(0, 0)) {
-			sprintf(str, "%s/%04d.ppm", outFolder, currentFrameNo);
-			SaveImageToFile(inputRGBImage, str);
-		}
-	}
-	if ((rgbVideoWriter != NULL) && (inputRGBImage->noDims.x != 0)) {
-		if (!rgbVideoWriter->isOpen()) rgbVideoWriter->open("out_rgb.avi", inputRGBImage->noDims.x, inputRGBImage->noDims.y, false, 30);
-		rgbVideoWriter->writeFrame(inputRGBImage);
-	}
-	if ((depthVideoWriter != NULL) && (inputRawDepthImage->noDims.x != 0)) {
-		if (!depthVideoWriter->isOpen()) depthVideoWriter->open("out_d.avi", inputRawDepthImage->noDims.x, inputRawDepthImage->noDims.y, true, 30);
-		depthVideoWriter->writeFrame(inputRawDepthImage);
-	}
+	// frames are encoded and written on the recorders' own threads, a frame is dropped if they fall behind
+	if (sequenceRecorder != NULL) sequenceRecorder->recordFrame(inputRGBImage, inputRawDepthImage);
+	if (videoRecorder != NULL) videoRecorder->recordFrame(inputRGBImage, inputRawDepthImage);
 
 	sdkResetTimer(&timer_instant);
 	sdkStartTimer(&timer_instant); sdkStartTimer(&timer_average);
@@ -664,8 +664,11 @@ void UIEngine::Shutdown()
 	sdkDeleteTimer(&timer_instant);
 	sdkDeleteTimer(&timer_average);
 
-	if (rgbVideoWriter != NULL) delete rgbVideoWriter;
-	if (depthVideoWriter != NULL) delete depthVideoWriter;
+	if (sequenceRecorder != NULL) StopRecorder(sequenceRecorder);
+	if (videoRecorder != NULL) StopRecorder(videoRecorder);
+
+	if (latestFrameSource != NULL)
+		printf("processed %d of %d captured frames, skipped %d\n", processedFrameNo, latestFrameSource->getNoCapturedFrames(), latestFrameSource->getNoSkippedFrames());
 
 	for (int w = 0; w < NUM_WIN; w++)
 		delete outImage[w];
@@ -4,7 +4,8 @@
 
 #include "../../InputSource/ImageSourceEngine.h"
 #include "../../InputSource/IMUSourceEngine.h"
-#include "../../InputSource/FFMPEGWriter.h"
+#include "../../InputSource/LatestFrameImageSourceEngine.h"
+#include "../../InputSource/AsyncFrameRecorder.h"
 #include "../../ITMLib/Core/ITMMainEngine.h"
 #include "../../ITMLib/Utils/ITMLibSettings.h"
 #include "../../ORUtils/FileUtils.h"
@@ -37,6 +38,8 @@ namespace InfiniTAM
 
 			InputSource::ImageSourceEngine *imageSource;
 			InputSource::IMUSourceEngine *imuSource;
+			/// The image source if it yields only the latest frame, whose skipped frames are shown, or NULL
+			InputSource::LatestFrameImageSourceEngine *latestFrameSource;
 			ITMLib::ITMLibSettings internalSettings;
 			ITMLib::ITMMainEngine *mainEngine;
 
@@ -63,9 +66,9 @@ namespace InfiniTAM
 			Vector2i mouseLastClick;
 			bool mouseWarped; // To avoid the extra motion generated by glutWarpPointer
 
-			int currentFrameNo; bool isRecording;
-			InputSource::FFMPEGWriter *rgbVideoWriter;
-			InputSource::FFMPEGWriter *depthVideoWriter;
+			int currentFrameNo;
+			InputSource::AsyncFrameRecorder *sequenceRecorder;
+			InputSource::AsyncFrameRecorder *videoRecorder;
 		public:
 			static UIEngine* Instance(void) {
 				if (instance == NULL) instance = new UIEngine();
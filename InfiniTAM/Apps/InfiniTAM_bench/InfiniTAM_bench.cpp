@@ -0,0 +1,414 @@
+// Copyright 2014-2017 Oxford University Innovation Limited and the authors of InfiniTAM
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "../../InputSource/ImageSourceEngine.h"
+
+#include "../../ITMLib/ITMLibDefines.h"
+#include "../../ITMLib/Core/ITMBasicEngine.h"
+#include "../../ITMLib/Core/ITMBasicSurfelEngine.h"
+#include "../../ITMLib/Core/ITMMultiEngine.h"
+
+#include "../../ORUtils/NVTimer.h"
+
+using namespace InputSource;
+using namespace ITMLib;
+
+// stage percentiles below this (in ms) are too noisy to be compared against a baseline
+static const double MIN_COMPARED_TIME = 0.1;
+
+static const float PERCENTILES[] = { 50.0f, 95.0f, 99.0f };
+static const int NO_PERCENTILES = 3;
+
+/// Nearest-rank percentile, \p p between 0 and 100
+static double Percentile(std::vector<double> samples, float p)
+{
+	if (samples.empty()) return 0.0;
+
+	int rank = (int)ceil(p / 100.0f * (float)samples.size()) - 1;
+	rank = std::max(0, std::min(rank, (int)samples.size() - 1));
+
+	std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+	return samples[rank];
+}
+
+/// Peak resident set size of the process in MB, -1 if unknown
+static double GetPeakHostMemoryMB()
+{
+#ifndef _WIN32
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) return -1.0;
+#ifdef __APPLE__
+	return (double)usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+	return (double)usage.ru_maxrss / 1024.0;
+#endif
+#else
+	return -1.0;
+#endif
+}
+
+/// Memory in use on the current CUDA device in MB, this includes other processes
+static double GetDeviceMemoryMB()
+{
+#ifndef COMPILE_WITHOUT_CUDA
+	size_t freeMemory, totalMemory;
+	ORcudaSafeCall(cudaMemGetInfo(&freeMemory, &totalMemory));
+	return (double)(totalMemory - freeMemory) / (1024.0 * 1024.0);
+#else
+	return 0.0;
+#endif
+}
+
+static void SynchroniseDevice(ITMLibSettings::DeviceType deviceType)
+{
+#ifndef COMPILE_WITHOUT_CUDA
+	if (deviceType == ITMLibSettings::DEVICE_CUDA) ORcudaSafeCall(cudaDeviceSynchronize());
+#endif
+}
+
+// Reads the numbers of a JSON document into a map from dotted key paths to values, everything else is skipped.
+
+static void SkipSpace(const std::string &text, size_t &pos)
+{
+	while (pos < text.size() && isspace((unsigned char)text[pos])) pos++;
+}
+
+static bool ReadJSONString(const std::string &text, size_t &pos, std::string &value)
+{
+	if (pos >= text.size() || text[pos] != '"') return false;
+
+	value.clear();
+	for (pos++; pos < text.size() && text[pos] != '"'; pos++)
+	{
+		if (text[pos] == '\\') pos++;
+		if (pos < text.size()) value += text[pos];
+	}
+
+	if (pos >= text.size()) return false;
+	pos++;
+	return true;
+}
+
+static bool ReadJSONValue(const std::string &text, size_t &pos, const std::string &path, std::map<std::string, double> &values)
+{
+	SkipSpace(text, pos);
+	if (pos >= text.size()) return false;
+
+	if (text[pos] == '{' || text[pos] == '[')
+	{
+		bool isObject = text[pos] == '{';
+		char closing = isObject ? '}' : ']';
+
+		pos++; SkipSpace(text, pos);
+		if (pos < text.size() && text[pos] == closing) { pos++; return true; }
+
+		for (int elementId = 0; ; elementId++)
+		{
+			std::string key;
+			if (isObject)
+			{
+				SkipSpace(text, pos);
+				if (!ReadJSONString(text, pos, key)) return false;
+				SkipSpace(text, pos);
+				if (pos >= text.size() || text[pos] != ':') return false;
+				pos++;
+			}
+			else
+			{
+				std::ostringstream oss; oss << elementId;
+				key = oss.str();
+			}
+
+			if (!ReadJSONValue(text, pos, path.empty() ? key : path + "." + key, values)) return false;
+
+			SkipSpace(text, pos);
+			if (pos >= text.size()) return false;
+			if (text[pos] == closing) { pos++; return true; }
+			if (text[pos] != ',') return false;
+			pos++;
+		}
+	}
+
+	if (text[pos] == '"')
+	{
+		std::string value;
+		return ReadJSONString(text, pos, value);
+	}
+
+	size_t end = pos;
+	while (end < text.size() && strchr(",}] \t\r\n", text[end]) == NULL) end++;
+	std::string token = text.substr(pos, end - pos);
+	pos = end;
+
+	if (token == "true" || token == "false" || token == "null") return true;
+
+	char *tokenEnd;
+	double value = strtod(token.c_str(), &tokenEnd);
+	if (token.empty() || *tokenEnd != 0) return false;
+
+	values[path] = value;
+	return true;
+}
+
+static bool ReadJSONFile(const char *fileName, std::map<std::string, double> &values)
+{
+	std::ifstream f(fileName);
+	if (!f) return false;
+
+	std::stringstream buffer;
+	buffer << f.rdbuf();
+
+	std::string text = buffer.str();
+	size_t pos = 0;
+	return ReadJSONValue(text, pos, "", values);
+}
+
+static void PrintUsage(const char *name)
+{
+	printf("usage: %s [options] <calibfile> <rgbmask> <depthmask>\n"
+	       "  replays an image sequence from memory through a main engine and reports per stage latencies as JSON\n"
+	       "\n"
+	       "options:\n"
+	       "  --engine <basic|surfel|multi> : main engine to run (default basic)\n"
+	       "  --device <cpu|cuda>           : device to run on (default as built)\n"
+	       "  --tracker <config>            : tracker configuration string (default from ITMLibSettings)\n"
+	       "  --frames <n>                  : replay at most n frames (default all)\n"
+	       "  --warmup <n>                  : leave the first n frames out of the statistics (default 5)\n"
+	       "  --output <file>               : write the JSON report to this file (default stdout)\n"
+	       "  --baseline <file>             : compare with an earlier report, exit with 2 on a regression\n"
+	       "  --margin <fraction>           : allowed slowdown against the baseline (default 0.1)\n"
+	       "\n"
+	       "example:\n"
+	       "  %s --baseline teddy.json ./Files/Teddy/calib.txt ./Files/Teddy/Frames/%%04i.ppm ./Files/Teddy/Frames/%%04i.pgm\n\n", name, name);
+}
+
+int main(int argc, char** argv)
+try
+{
+	const char *engineName = "basic", *deviceName = NULL, *trackerConfig = NULL;
+	const char *outputFile = NULL, *baselineFile = NULL;
+	int maxFrames = -1, noWarmupFrames = 5;
+	double margin = 0.1;
+
+	std::vector<const char*> positional;
+	for (int arg = 1; arg < argc; arg++)
+	{
+		std::string option = argv[arg];
+		bool hasValue = arg + 1 < argc;
+
+		if (option == "--engine" && hasValue) engineName = argv[++arg];
+		else if (option == "--device" && hasValue) deviceName = argv[++arg];
+		else if (option == "--tracker" && hasValue) trackerConfig = argv[++arg];
+		else if (option == "--frames" && hasValue) maxFrames = atoi(argv[++arg]);
+		else if (option == "--warmup" && hasValue) noWarmupFrames = atoi(argv[++arg]);
+		else if (option == "--output" && hasValue) outputFile = argv[++arg];
+		else if (option == "--baseline" && hasValue) baselineFile = argv[++arg];
+		else if (option == "--margin" && hasValue) margin = atof(argv[++arg]);
+		else if (option.compare(0, 2, "--") == 0) { PrintUsage(argv[0]); return EXIT_FAILURE; }
+		else positional.push_back(argv[arg]);
+	}
+
+	if (positional.size() != 3) { PrintUsage(argv[0]); return EXIT_FAILURE; }
+
+	ITMLibSettings *internalSettings = new ITMLibSettings();
+	internalSettings->collectStatistics = true;
+	internalSettings->createMeshingEngine = false;
+	if (trackerConfig != NULL) internalSettings->trackerConfig = trackerConfig;
+	if (deviceName != NULL)
+	{
+		if (strcmp(deviceName, "cpu") == 0) internalSettings->deviceType = ITMLibSettings::DEVICE_CPU;
+		else if (strcmp(deviceName, "cuda") == 0) internalSettings->deviceType = ITMLibSettings::DEVICE_CUDA;
+		else throw std::runtime_error(std::string("unknown device: ") + deviceName);
+	}
+
+	// preload the sequence so that disk I/O and decoding are not timed
+	ImageMaskPathGenerator pathGenerator(positional[1], positional[2]);
+	ImageFileReader<ImageMaskPathGenerator> imageSource(positional[0], pathGenerator);
+
+	std::vector<ITMUChar4Image*> rgbFrames;
+	std::vector<ITMShortImage*> depthFrames;
+	double preloadedMB = 0.0;
+	while (imageSource.hasMoreImages() && (maxFrames < 0 || (int)rgbFrames.size() < maxFrames))
+	{
+		ITMUChar4Image *rgb = new ITMUChar4Image(imageSource.getRGBImageSize(), true, false);
+		ITMShortImage *depth = new ITMShortImage(imageSource.getDepthImageSize(), true, false);
+		imageSource.getImages(rgb, depth);
+
+		rgbFrames.push_back(rgb);
+		depthFrames.push_back(depth);
+		preloadedMB += (double)(rgb->dataSize * sizeof(Vector4u) + depth->dataSize * sizeof(short)) / (1024.0 * 1024.0);
+	}
+
+	if ((int)rgbFrames.size() <= noWarmupFrames) throw std::runtime_error("not enough frames in the sequence");
+	fprintf(stderr, "preloaded %d frames (%.1f MB)\n", (int)rgbFrames.size(), preloadedMB);
+
+	Vector2i imgSize_rgb = rgbFrames[0]->noDims, imgSize_d = depthFrames[0]->noDims;
+
+	ITMMainEngine *mainEngine = NULL;
+	if (strcmp(engineName, "basic") == 0)
+	{
+		internalSettings->libMode = ITMLibSettings::LIBMODE_BASIC;
+		mainEngine = new ITMBasicEngine<ITMVoxel, ITMVoxelIndex>(internalSettings, imageSource.getCalib(), imgSize_rgb, imgSize_d);
+	}
+	else if (strcmp(engineName, "surfel") == 0)
+	{
+		internalSettings->libMode = ITMLibSettings::LIBMODE_BASIC_SURFELS;
+		mainEngine = new ITMBasicSurfelEngine<ITMSurfelT>(internalSettings, imageSource.getCalib(), imgSize_rgb, imgSize_d);
+	}
+	else if (strcmp(engineName, "multi") == 0)
+	{
+		internalSettings->libMode = ITMLibSettings::LIBMODE_LOOPCLOSURE;
+		mainEngine = new ITMMultiEngine<ITMVoxel, ITMVoxelIndex>(internalSettings, imageSource.getCalib(), imgSize_rgb, imgSize_d);
+	}
+	else throw std::runtime_error(std::string("unknown engine: ") + engineName);
+
+	bool allocateGPU = internalSettings->deviceType == ITMLibSettings::DEVICE_CUDA;
+	ITMUChar4Image *inputRGBImage = new ITMUChar4Image(imgSize_rgb, true, allocateGPU);
+	ITMShortImage *inputRawDepthImage = new ITMShortImage(imgSize_d, true, allocateGPU);
+
+	// replay
+	std::vector<double> frameTimes;
+	std::vector<std::vector<double> > stageTimes(ITMEngineStatistics::STAGE_COUNT);
+	double peakDeviceMB = GetDeviceMemoryMB(), totalTime = 0.0;
+
+	StopWatchInterface *timer;
+	sdkCreateTimer(&timer);
+
+	for (size_t frameNo = 0; frameNo < rgbFrames.size(); frameNo++)
+	{
+		inputRGBImage->SetFrom(rgbFrames[frameNo], ORUtils::MemoryBlock<Vector4u>::CPU_TO_CPU);
+		inputRawDepthImage->SetFrom(depthFrames[frameNo], ORUtils::MemoryBlock<short>::CPU_TO_CPU);
+
+		SynchroniseDevice(internalSettings->deviceType);
+		sdkResetTimer(&timer); sdkStartTimer(&timer);
+
+		mainEngine->ProcessFrame(inputRGBImage, inputRawDepthImage);
+
+		SynchroniseDevice(internalSettings->deviceType);
+		sdkStopTimer(&timer);
+
+		peakDeviceMB = std::max(peakDeviceMB, GetDeviceMemoryMB());
+
+		if ((int)frameNo < noWarmupFrames) continue;
+
+		double frameTime = sdkGetTimerValue(&timer);
+		frameTimes.push_back(frameTime);
+		totalTime += frameTime;
+
+		const ITMEngineStatistics *statistics = mainEngine->GetStatistics();
+		if (statistics != NULL)
+		{
+			ITMEngineStatistics::Frame frame = statistics->GetLastFrame();
+			for (int stage = 0; stage < ITMEngineStatistics::STAGE_COUNT; stage++)
+				if (stage != ITMEngineStatistics::STAGE_FRAME) stageTimes[stage].push_back(frame.stageTimes[stage]);
+		}
+	}
+
+	sdkDeleteTimer(&timer);
+
+	// report
+	std::map<std::string, double> results;
+	std::ostringstream report;
+	report.precision(4);
+	report << std::fixed;
+
+	double fps = totalTime > 0.0 ? 1000.0 * (double)frameTimes.size() / totalTime : 0.0;
+	double peakHostMB = GetPeakHostMemoryMB();
+	results["fps"] = fps;
+	results["peakHostMemoryMB"] = peakHostMB;
+	results["peakDeviceMemoryMB"] = peakDeviceMB;
+
+	report << "{\n"
+	       << "  \"engine\": \"" << engineName << "\",\n"
+	       << "  \"device\": \"" << (internalSettings->deviceType == ITMLibSettings::DEVICE_CUDA ? "cuda" : "cpu") << "\",\n"
+	       << "  \"trackerConfig\": \"" << internalSettings->trackerConfig << "\",\n"
+	       << "  \"frames\": " << frameTimes.size() << ",\n"
+	       << "  \"warmupFrames\": " << noWarmupFrames << ",\n"
+	       << "  \"fps\": " << fps << ",\n"
+	       << "  \"peakHostMemoryMB\": " << peakHostMB << ",\n"
+	       << "  \"preloadedMB\": " << preloadedMB << ",\n"
+	       << "  \"peakDeviceMemoryMB\": " << peakDeviceMB << ",\n"
+	       << "  \"stages\": {";
+
+	for (int stage = ITMEngineStatistics::STAGE_COUNT - 1; stage >= 0; stage--)
+	{
+		const std::vector<double> &samples = stage == ITMEngineStatistics::STAGE_FRAME ? frameTimes : stageTimes[stage];
+		if (samples.empty()) continue;
+
+		const char *stageName = ITMEngineStatistics::GetStageName((ITMEngineStatistics::Stage)stage);
+		report << (stage == ITMEngineStatistics::STAGE_FRAME ? "\n" : ",\n") << "    \"" << stageName << "\": { ";
+		for (int i = 0; i < NO_PERCENTILES; i++)
+		{
+			std::ostringstream key; key << "p" << (int)PERCENTILES[i];
+			double value = Percentile(samples, PERCENTILES[i]);
+			results[std::string("stages.") + stageName + "." + key.str()] = value;
+			report << (i > 0 ? ", " : "") << "\"" << key.str() << "\": " << value;
+		}
+		report << " }";
+	}
+	report << "\n  }\n}\n";
+
+	if (outputFile != NULL)
+	{
+		std::ofstream f(outputFile);
+		if (!f) throw std::runtime_error(std::string("could not write ") + outputFile);
+		f << report.str();
+	}
+	else std::cout << report.str();
+
+	// compare with the baseline: slower stages, lower frame rate or more memory are regressions
+	int exitCode = EXIT_SUCCESS;
+	if (baselineFile != NULL)
+	{
+		std::map<std::string, double> baseline;
+		if (!ReadJSONFile(baselineFile, baseline)) throw std::runtime_error(std::string("could not read baseline ") + baselineFile);
+
+		for (std::map<std::string, double>::const_iterator it = results.begin(); it != results.end(); ++it)
+		{
+			std::map<std::string, double>::const_iterator base = baseline.find(it->first);
+			if (base == baseline.end() || base->second <= 0.0) continue;
+
+			bool regressed;
+			if (it->first == "fps") regressed = it->second * (1.0 + margin) < base->second;
+			else if (it->first.compare(0, 7, "stages.") == 0) regressed = base->second >= MIN_COMPARED_TIME && it->second > base->second * (1.0 + margin);
+			else regressed = it->second > base->second * (1.0 + margin);
+
+			if (regressed)
+			{
+				fprintf(stderr, "regression: %s is %.3f, baseline %.3f\n", it->first.c_str(), it->second, base->second);
+				exitCode = 2;
+			}
+		}
+
+		if (exitCode == EXIT_SUCCESS) fprintf(stderr, "within %.0f%% of the baseline\n", margin * 100.0);
+	}
+
+	delete inputRGBImage;
+	delete inputRawDepthImage;
+	delete mainEngine;
+	delete internalSettings;
+	for (size_t i = 0; i < rgbFrames.size(); i++) { delete rgbFrames[i]; delete depthFrames[i]; }
+
+	return exitCode;
+}
+catch(std::exception& e)
+{
+	std::cerr << e.what() << '\n';
+	return EXIT_FAILURE;
+}
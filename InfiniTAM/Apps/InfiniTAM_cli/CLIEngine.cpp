@@ -10,13 +10,13 @@ using namespace InfiniTAM::Engine;
 using namespace InputSource;
 using namespace ITMLib;
 
-CLIEngine* CLIEngine::instance;
-
 void CLIEngine::Initialise(ImageSourceEngine *imageSource, IMUSourceEngine *imuSource, ITMMainEngine *mainEngine,
-	ITMLibSettings::DeviceType deviceType)
+	ITMLibSettings::DeviceType deviceType, AsyncFrameRecorder *recorder)
 {
 	this->imageSource = imageSource;
 	this->imuSource = imuSource;
+	this->recorder = recorder;
+	this->latestFrameSource = dynamic_cast<LatestFrameImageSourceEngine*>(imageSource);
 	this->mainEngine = mainEngine;
 
 	this->currentFrameNo = 0;
@@ -50,6 +50,8 @@ bool CLIEngine::ProcessFrame()
 		else imuSource->getMeasurement(inputIMUMeasurement);
 	}
 
+	if (recorder != NULL) recorder->recordFrame(inputRGBImage, inputRawDepthImage);
+
 	sdkResetTimer(&timer_instant);
 	sdkStartTimer(&timer_instant); sdkStartTimer(&timer_average);
 
@@ -65,7 +67,8 @@ bool CLIEngine::ProcessFrame()
 	float processedTime_inst = sdkGetTimerValue(&timer_instant);
 	float processedTime_avg = sdkGetAverageTimerValue(&timer_average);
 
-	printf("frame %i: time %.2f, avg %.2f\n", currentFrameNo, processedTime_inst, processedTime_avg);
+	if (latestFrameSource != NULL) printf("frame %i: time %.2f, avg %.2f, skipped %i\n", currentFrameNo, processedTime_inst, processedTime_avg, latestFrameSource->getNoSkippedFrames());
+	else printf("frame %i: time %.2f, avg %.2f\n", currentFrameNo, processedTime_inst, processedTime_avg);
 
 	currentFrameNo++;
 
@@ -81,12 +84,32 @@ void CLIEngine::Run()
 
 void CLIEngine::Shutdown()
 {
+	if (latestFrameSource != NULL)
+		printf("processed %i of %i captured frames, skipped %i\n", currentFrameNo, latestFrameSource->getNoCapturedFrames(), latestFrameSource->getNoSkippedFrames());
+
+	const ITMEngineStatistics *statistics = mainEngine->GetStatistics();
+	if (statistics != NULL && statistics->GetNoHistoryFrames() > 0)
+	{
+		printf("stage timings over the last %i frames (p50 / p95 / p99 ms, occupancy):\n", statistics->GetNoHistoryFrames());
+		for (int i = 0; i < ITMEngineStatistics::STAGE_COUNT; i++)
+		{
+			ITMEngineStatistics::Stage stage = (ITMEngineStatistics::Stage)i;
+			printf("  %-20s %8.2f %8.2f %8.2f %7.1f%%\n", ITMEngineStatistics::GetStageName(stage),
+				statistics->GetStagePercentile(stage, 50.0f), statistics->GetStagePercentile(stage, 95.0f), statistics->GetStagePercentile(stage, 99.0f),
+				statistics->GetStageOccupancy(stage) * 100.0f);
+		}
+		for (int i = 0; i < ITMEngineStatistics::COUNTER_COUNT; i++)
+		{
+			ITMEngineStatistics::Counter counter = (ITMEngineStatistics::Counter)i;
+			printf("  %-20s %8i %8i %8i\n", ITMEngineStatistics::GetCounterName(counter),
+				statistics->GetCounterPercentile(counter, 50.0f), statistics->GetCounterPercentile(counter, 95.0f), statistics->GetCounterPercentile(counter, 99.0f));
+		}
+	}
+
 	sdkDeleteTimer(&timer_instant);
 	sdkDeleteTimer(&timer_average);
 
 	delete inputRGBImage;
 	delete inputRawDepthImage;
 	delete inputIMUMeasurement;
-
-	delete instance;
 }
@@ -2,7 +2,9 @@
 
 #pragma once
 
+#include "../../InputSource/AsyncFrameRecorder.h"
 #include "../../InputSource/ImageSourceEngine.h"
+#include "../../InputSource/LatestFrameImageSourceEngine.h"
 #include "../../InputSource/IMUSourceEngine.h"
 #include "../../ITMLib/Core/ITMMainEngine.h"
 #include "../../ITMLib/Utils/ITMLibSettings.h"
@@ -13,12 +15,14 @@ namespace InfiniTAM
 {
 	namespace Engine
 	{
+		/// Processes the frames of an image source with a main engine, several can run in one process
 		class CLIEngine
 		{
-			static CLIEngine* instance;
-
 			InputSource::ImageSourceEngine *imageSource;
 			InputSource::IMUSourceEngine *imuSource;
+			InputSource::AsyncFrameRecorder *recorder;
+			/// The image source if it yields only the latest frame, whose skipped frames are reported, or NULL
+			InputSource::LatestFrameImageSourceEngine *latestFrameSource;
 			ITMLib::ITMLibSettings internalSettings;
 			ITMLib::ITMMainEngine *mainEngine;
 
@@ -31,15 +35,11 @@ namespace InfiniTAM
 
 			int currentFrameNo;
 		public:
-			static CLIEngine* Instance(void) {
-				if (instance == NULL) instance = new CLIEngine();
-				return instance;
-			}
-
 			float processedTime;
 
+			/// The frames are also passed to \p recorder if it is not NULL, which is owned by the caller
 			void Initialise(InputSource::ImageSourceEngine *imageSource, InputSource::IMUSourceEngine *imuSource, ITMLib::ITMMainEngine *mainEngine,
-				ITMLib::ITMLibSettings::DeviceType deviceType);
+				ITMLib::ITMLibSettings::DeviceType deviceType, InputSource::AsyncFrameRecorder *recorder = NULL);
 			void Shutdown();
 
 			void Run();
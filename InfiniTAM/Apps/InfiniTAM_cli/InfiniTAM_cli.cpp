@@ -1,15 +1,21 @@
 // Copyright 2014-2017 Oxford University Innovation Limited and the authors of InfiniTAM
 
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 
 #include "CLIEngine.h"
 
 #include "../../InputSource/OpenNIEngine.h"
 #include "../../InputSource/Kinect2Engine.h"
+#include "../../InputSource/LatestFrameImageSourceEngine.h"
+#include "../../InputSource/PackedSequence.h"
+#include "../../InputSource/PrefetchingImageSourceEngine.h"
+#include "../../InputSource/SharedMemoryRing.h"
 
 #include "../../ITMLib/ITMLibDefines.h"
 #include "../../ITMLib/Core/ITMBasicEngine.h"
+#include "../../ORUtils/Trace.h"
 
 using namespace InfiniTAM::Engine;
 using namespace InputSource;
@@ -22,8 +28,37 @@ try
 	const char *imagesource_part1 = NULL;
 	const char *imagesource_part2 = NULL;
 	const char *imagesource_part3 = NULL;
+	const char *traceFile = NULL;
+	const char *recordFile = NULL;
+	bool latestFrameOnly = false, pipelineFrames = false;
+	int noCPUThreads = 0, firstCPUCore = -1;
 
 	int arg = 1;
+	while (argv[arg] != NULL)
+	{
+		if (strcmp(argv[arg], "--latest") == 0)
+		{
+			latestFrameOnly = true;
+			arg++;
+			continue;
+		}
+		if (strcmp(argv[arg], "--pipeline") == 0)
+		{
+			pipelineFrames = true;
+			arg++;
+			continue;
+		}
+
+		if (argv[arg + 1] == NULL) break;
+		if (strcmp(argv[arg], "--trace") == 0) traceFile = argv[arg + 1];
+		else if (strcmp(argv[arg], "--record") == 0) recordFile = argv[arg + 1];
+		else if (strcmp(argv[arg], "--threads") == 0) noCPUThreads = atoi(argv[arg + 1]);
+		else if (strcmp(argv[arg], "--pin-core") == 0) firstCPUCore = atoi(argv[arg + 1]);
+		else break;
+		arg += 2;
+	}
+
+	int firstArg = arg;
 	do {
 		if (argv[arg] != NULL) calibFile = argv[arg]; else break;
 		++arg;
@@ -34,10 +69,17 @@ try
 		if (argv[arg] != NULL) imagesource_part3 = argv[arg]; else break;
 	} while (false);
 
-	if (arg == 1) {
-		printf("usage: %s [<calibfile> [<imagesource>] ]\n"
+	if (arg == firstArg) {
+		printf("usage: %s [--latest] [--pipeline] [--threads <n>] [--pin-core <core>] [--trace <tracefile>] [--record <recordfile>] [<calibfile> [<imagesource>] ]\n"
+		       "  --latest      : always process the newest frame, skipping those that arrive while a frame is processed\n"
+		       "  --pipeline    : on the CPU, build the view of a frame while the previous one is fused, and report stage occupancy\n"
+		       "  <n>           : number of threads the CPU engines run on, 0 (default) uses one per hardware thread\n"
+		       "  <core>        : pin the worker threads of the CPU engines to consecutive cores starting at this one\n"
+		       "  <tracefile>   : write a timeline of the processing stages to this Chrome trace file (JSON)\n"
+		       "  <recordfile>  : record the input frames into this packed sequence, while they are processed\n"
 		       "  <calibfile>   : path to a file containing intrinsic calibration parameters\n"
-		       "  <imagesource> : either one argument to specify OpenNI device ID\n"
+		       "  <imagesource> : either one argument to specify a packed sequence (see InfiniTAM_pack), shm:<name> for a\n"
+		       "                  shared memory ring (see InfiniTAM_shmproducer) or OpenNI device ID\n"
 		       "                  or two arguments specifying rgb and depth file masks\n"
 		       "\n"
 		       "examples:\n"
@@ -45,20 +87,63 @@ try
 		       "  %s ./Files/Teddy/calib.txt\n\n", argv[0], argv[0], argv[0]);
 	}
 
+	if (traceFile != NULL)
+	{
+		ORUtils::TraceRecorder::SetEnabled(true);
+		ORUtils::TraceRecorder::SetThreadName("main");
+	}
+
 	printf("initialising ...\n");
 	ITMLibSettings *internalSettings = new ITMLibSettings();
+	internalSettings->noCPUThreads = noCPUThreads;
+	internalSettings->firstCPUCore = firstCPUCore;
+
+	// the occupancy of the stages shows how much they overlap
+	if (pipelineFrames)
+	{
+		internalSettings->pipelineFrames = true;
+		internalSettings->collectStatistics = true;
+	}
 
 	ImageSourceEngine *imageSource;
 	IMUSourceEngine *imuSource = NULL;
+	bool isLiveSource = false;
 	printf("using calibration file: %s\n", calibFile);
 	if (imagesource_part2 == NULL) 
 	{
-		printf("using OpenNI device: %s\n", (imagesource_part1==NULL)?"<OpenNI default device>":imagesource_part1);
-		imageSource = new OpenNIEngine(calibFile, imagesource_part1);
-		if (imageSource->getDepthImageSize().x == 0) {
-			delete imageSource;
-			printf("trying MS Kinect device\n");
-			imageSource = new Kinect2Engine(calibFile);
+		imageSource = NULL;
+		if (imagesource_part1 != NULL && strncmp(imagesource_part1, "shm:", 4) == 0)
+		{
+			isLiveSource = true;
+			printf("using shared memory ring: %s\n", imagesource_part1 + 4);
+			imageSource = new SharedMemoryImageSource(calibFile, imagesource_part1 + 4);
+			if (imageSource->getDepthImageSize().x == 0) {
+				delete imageSource;
+				DIEWITHEXCEPTION("error: no producer has created the shared memory ring");
+			}
+		}
+		else if (imagesource_part1 != NULL)
+		{
+			imageSource = new PackedSequenceReader(calibFile, imagesource_part1);
+			if (imageSource->getDepthImageSize().x == 0) {
+				delete imageSource;
+				imageSource = NULL;
+			}
+			else {
+				printf("using packed sequence: %s\n", imagesource_part1);
+				imageSource = new PrefetchingImageSourceEngine(imageSource, 8, 2, internalSettings->deviceType == ITMLibSettings::DEVICE_CUDA);
+			}
+		}
+
+		if (imageSource == NULL) {
+			isLiveSource = true;
+			printf("using OpenNI device: %s\n", (imagesource_part1==NULL)?"<OpenNI default device>":imagesource_part1);
+			imageSource = new OpenNIEngine(calibFile, imagesource_part1);
+			if (imageSource->getDepthImageSize().x == 0) {
+				delete imageSource;
+				printf("trying MS Kinect device\n");
+				imageSource = new Kinect2Engine(calibFile);
+			}
 		}
 	} 
 	else
@@ -75,15 +160,48 @@ try
 			imageSource = new RawFileReader(calibFile, imagesource_part1, imagesource_part2, Vector2i(320, 240), 0.5f);
 			imuSource = new IMUSourceEngine(imagesource_part3);
 		}
+
+		// files are read ahead while the frames before them are processed
+		imageSource = new PrefetchingImageSourceEngine(imageSource, 8, 2, internalSettings->deviceType == ITMLibSettings::DEVICE_CUDA);
 	}
 
+	// IMU measurements are read in step with the frames, so they cannot be skipped along with them
+	if (latestFrameOnly && imuSource == NULL)
+	{
+		printf("processing the latest frame only\n");
+		imageSource = new LatestFrameImageSourceEngine(imageSource, internalSettings->deviceType == ITMLibSettings::DEVICE_CUDA);
+	}
+	else if (latestFrameOnly) printf("warning: --latest is ignored with an IMU source\n");
+
 	ITMMainEngine *mainEngine = new ITMBasicEngine<ITMVoxel,ITMVoxelIndex>(
 		internalSettings, imageSource->getCalib(), imageSource->getRGBImageSize(), imageSource->getDepthImageSize()
 	);
 
-	CLIEngine::Instance()->Initialise(imageSource, imuSource, mainEngine, internalSettings->deviceType);
-	CLIEngine::Instance()->Run();
-	CLIEngine::Instance()->Shutdown();
+	// frames from a live camera are dropped if writing falls behind, frames read from files are all recorded
+	AsyncFrameRecorder *recorder = NULL;
+	if (recordFile != NULL)
+	{
+		printf("recording to: %s\n", recordFile);
+		recorder = new AsyncFrameRecorder(new PackedSequenceSink(recordFile, imageSource->getCalib()), 16, !isLiveSource);
+	}
+
+	CLIEngine cliEngine;
+	cliEngine.Initialise(imageSource, imuSource, mainEngine, internalSettings->deviceType, recorder);
+	cliEngine.Run();
+	cliEngine.Shutdown();
+
+	if (recorder != NULL)
+	{
+		recorder->waitUntilWritten();
+		printf("recorded %d frames, dropped %d\n", recorder->getNoRecordedFrames(), recorder->getNoDroppedFrames());
+		delete recorder;
+	}
+
+	if (traceFile != NULL)
+	{
+		if (ORUtils::TraceRecorder::WriteChromeTrace(traceFile)) printf("trace written to %s\n", traceFile);
+		else fprintf(stderr, "could not write trace to %s\n", traceFile);
+	}
 
 	delete mainEngine;
 	delete internalSettings;
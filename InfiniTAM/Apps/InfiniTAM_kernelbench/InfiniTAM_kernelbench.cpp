@@ -0,0 +1,661 @@
+// Copyright 2014-2017 Oxford University Innovation Limited and the authors of InfiniTAM
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../../ITMLib/ITMLibDefines.h"
+#include "../../ITMLib/Utils/ITMLibSettings.h"
+#include "../../ITMLib/Engines/LowLevel/Shared/ITMLowLevelEngine_Shared.h"
+#include "../../ITMLib/Engines/Meshing/Shared/ITMMeshingEngine_Shared.h"
+#include "../../ITMLib/Engines/Reconstruction/ITMSceneReconstructionEngineFactory.h"
+#include "../../ITMLib/Engines/Reconstruction/Shared/ITMSceneReconstructionEngine_Shared.h"
+#include "../../ITMLib/Engines/Visualisation/ITMVisualisationEngineFactory.h"
+#include "../../ITMLib/Engines/Visualisation/Shared/ITMVisualisationEngine_Shared.h"
+#include "../../ITMLib/Trackers/Shared/ITMExtendedTracker_Shared.h"
+
+#include "../../ORUtils/NVTimer.h"
+
+using namespace ITMLib;
+
+/** \brief
+    A synthetic room - a back wall, a floor, a side wall and a
+    sphere - integrated into a voxel block hash by the CPU engines
+    from a few viewpoints, with the reference point and normal maps
+    raycast from it and a depth frame of a slightly moved camera to
+    track against.
+*/
+class SyntheticScene
+{
+private:
+	ITMSceneReconstructionEngine<ITMVoxel, ITMVoxelIndex> *sceneRecoEngine;
+	ITMVisualisationEngine<ITMVoxel, ITMVoxelIndex> *visualisationEngine;
+
+	/// Casts the rays of a camera with pose \p invM (camera to world) against the room
+	static void RenderDepth(ITMFloatImage *depthImage, const ITMIntrinsics &intrinsics, const Matrix4f &invM)
+	{
+		Vector2i imgSize = depthImage->noDims;
+		Vector4f projParams = intrinsics.projectionParamsSimple.all;
+		float *depth = depthImage->GetData(MEMORYDEVICE_CPU);
+
+		const Vector3f sphereCentre(0.2f, 0.1f, 1.6f);
+		const float sphereRadius = 0.45f;
+
+		Vector3f origin = invM.getColumn(3).toVector3();
+
+		for (int y = 0; y < imgSize.y; y++) for (int x = 0; x < imgSize.x; x++)
+		{
+			// with a unit z component in camera space, the ray parameter is the depth
+			Vector4f rayCamera(((float)x - projParams.z) / projParams.x, ((float)y - projParams.w) / projParams.y, 1.0f, 0.0f);
+			Vector3f ray = (invM * rayCamera).toVector3();
+
+			float t = 1e10f;
+			if (ray.z > 0.0f) t = MIN(t, (3.0f - origin.z) / ray.z);
+			if (ray.y > 0.0f) t = MIN(t, (0.8f - origin.y) / ray.y);
+			if (ray.x < 0.0f) t = MIN(t, (-1.2f - origin.x) / ray.x);
+
+			Vector3f toCentre = origin - sphereCentre;
+			float a = dot(ray, ray), b = 2.0f * dot(ray, toCentre), c = dot(toCentre, toCentre) - sphereRadius * sphereRadius;
+			float discriminant = b * b - 4.0f * a * c;
+			if (discriminant >= 0.0f)
+			{
+				float tSphere = (-b - sqrtf(discriminant)) / (2.0f * a);
+				if (tSphere > 0.0f) t = MIN(t, tSphere);
+			}
+
+			// some surface detail, so that the maps are not piecewise planar
+			Vector3f point = origin + ray * t;
+			if (t < 1e10f) t += 0.003f * sinf(25.0f * point.x) * cosf(25.0f * point.y);
+
+			depth[x + y * imgSize.x] = t < 1e10f ? t : 0.0f;
+		}
+	}
+
+	static void RenderColour(ITMUChar4Image *colourImage)
+	{
+		Vector2i imgSize = colourImage->noDims;
+		Vector4u *rgb = colourImage->GetData(MEMORYDEVICE_CPU);
+
+		for (int y = 0; y < imgSize.y; y++) for (int x = 0; x < imgSize.x; x++)
+			rgb[x + y * imgSize.x] = Vector4u((uchar)(x * 255 / imgSize.x), (uchar)(y * 255 / imgSize.y), (uchar)((x ^ y) & 255), 255);
+	}
+
+	static void SetPose(ORUtils::SE3Pose *pose, float step)
+	{
+		pose->SetFrom(0.05f * step, -0.02f * step, 0.03f * step, 0.01f * step, 0.02f * step, 0.0f);
+	}
+
+public:
+	ITMSceneParams sceneParams;
+	ITMRGBDCalib calib;
+	ITMView *view;
+	ITMTrackingState *trackingState;
+	ITMScene<ITMVoxel, ITMVoxelIndex> *scene;
+	ITMRenderState_VH *renderState;
+
+	/// Depth frame to track, of the camera moved by a fraction of the integration steps
+	ITMFloatImage *trackingDepth;
+	ORUtils::SE3Pose trackingPose;
+
+	/// Depth and colour images of \p imgSize, the scene integrated from \p noFrames views
+	SyntheticScene(Vector2i imgSize, int noFrames)
+		: sceneParams(0.02f, 100, 0.005f, 0.2f, 3.0f, false)
+	{
+		calib.intrinsics_rgb.SetFrom(525.0f * imgSize.x / 640.0f, 525.0f * imgSize.x / 640.0f, imgSize.x / 2.0f, imgSize.y / 2.0f);
+		calib.intrinsics_d = calib.intrinsics_rgb;
+
+		sceneRecoEngine = ITMSceneReconstructionEngineFactory::MakeSceneReconstructionEngine<ITMVoxel, ITMVoxelIndex>(ITMLibSettings::DEVICE_CPU);
+		visualisationEngine = ITMVisualisationEngineFactory::MakeVisualisationEngine<ITMVoxel, ITMVoxelIndex>(ITMLibSettings::DEVICE_CPU);
+
+		view = new ITMView(calib, imgSize, imgSize, false);
+		trackingState = new ITMTrackingState(imgSize, MEMORYDEVICE_CPU);
+		scene = new ITMScene<ITMVoxel, ITMVoxelIndex>(&sceneParams, false, MEMORYDEVICE_CPU);
+		renderState = (ITMRenderState_VH*)visualisationEngine->CreateRenderState(scene, imgSize);
+		trackingDepth = new ITMFloatImage(imgSize, true, false);
+
+		sceneRecoEngine->ResetScene(scene);
+		RenderColour(view->rgb);
+		view->depthConfidence->Clear();
+
+		// the last view is the reference the maps are raycast from
+		for (int frameId = noFrames - 1; frameId >= 0; frameId--)
+		{
+			SetPose(trackingState->pose_d, (float)frameId);
+			RenderDepth(view->depth, calib.intrinsics_d, trackingState->pose_d->GetInvM());
+
+			sceneRecoEngine->AllocateSceneFromDepth(scene, view, trackingState, renderState);
+			sceneRecoEngine->IntegrateIntoScene(scene, view, trackingState, renderState);
+		}
+
+		visualisationEngine->CreateExpectedDepths(scene, trackingState->pose_d, &calib.intrinsics_d, renderState);
+		visualisationEngine->CreateICPMaps(scene, view, trackingState, renderState);
+
+		SetPose(&trackingPose, 0.2f);
+		RenderDepth(trackingDepth, calib.intrinsics_d, trackingPose.GetInvM());
+	}
+
+	~SyntheticScene()
+	{
+		delete trackingDepth;
+		delete renderState;
+		delete scene;
+		delete trackingState;
+		delete view;
+		delete visualisationEngine;
+		delete sceneRecoEngine;
+	}
+
+	// Suppress the default copy constructor and assignment operator
+	SyntheticScene(const SyntheticScene&);
+	SyntheticScene& operator=(const SyntheticScene&);
+};
+
+/** \brief
+    One shared kernel, called for every element of its input in a
+    single thread the way the CPU engines call it, so that the time
+    per element is not diluted by the OpenMP scaling of the host.
+
+    The bytes per element are the least each call reads and writes:
+    its own input and output elements. Kernels with data dependent
+    accesses - hash lookups, ray marching, neighbouring voxels - move
+    more than that, their bandwidth figures are lower bounds.
+*/
+class KernelBenchmark
+{
+public:
+	virtual ~KernelBenchmark() {}
+
+	virtual const char* GetName() const = 0;
+	virtual int GetNoElements() const = 0;
+	virtual int GetBytesPerElement() const = 0;
+
+	/// Restores the state the kernel modifies, not timed
+	virtual void Prepare() {}
+
+	/// Runs the kernel over all elements, returns a checksum that keeps the work from being optimised away
+	virtual double Run() = 0;
+};
+
+class FilterSubsampleBenchmark : public KernelBenchmark
+{
+private:
+	ITMUChar4Image *imageOut;
+	const ITMUChar4Image *imageIn;
+
+public:
+	explicit FilterSubsampleBenchmark(const SyntheticScene &synthetic) : imageIn(synthetic.view->rgb)
+	{
+		imageOut = new ITMUChar4Image(imageIn->noDims / 2, true, false);
+	}
+
+	~FilterSubsampleBenchmark() { delete imageOut; }
+
+	const char* GetName() const { return "filterSubsample"; }
+	int GetNoElements() const { return (int)imageOut->dataSize; }
+	int GetBytesPerElement() const { return 5 * sizeof(Vector4u); }
+
+	double Run()
+	{
+		Vector2i oldDims = imageIn->noDims, newDims = imageOut->noDims;
+		const Vector4u *dataIn = imageIn->GetData(MEMORYDEVICE_CPU);
+		Vector4u *dataOut = imageOut->GetData(MEMORYDEVICE_CPU);
+
+		for (int y = 0; y < newDims.y; y++) for (int x = 0; x < newDims.x; x++)
+			filterSubsample(dataOut, x, y, newDims, dataIn, oldDims);
+
+		return dataOut[newDims.x * newDims.y / 2 + newDims.x / 2].x;
+	}
+};
+
+class FilterSubsampleWithHolesBenchmark : public KernelBenchmark
+{
+private:
+	ITMFloatImage *imageOut;
+	const ITMFloatImage *imageIn;
+
+public:
+	explicit FilterSubsampleWithHolesBenchmark(const SyntheticScene &synthetic) : imageIn(synthetic.view->depth)
+	{
+		imageOut = new ITMFloatImage(imageIn->noDims / 2, true, false);
+	}
+
+	~FilterSubsampleWithHolesBenchmark() { delete imageOut; }
+
+	const char* GetName() const { return "filterSubsampleWithHoles"; }
+	int GetNoElements() const { return (int)imageOut->dataSize; }
+	int GetBytesPerElement() const { return 5 * sizeof(float); }
+
+	double Run()
+	{
+		Vector2i oldDims = imageIn->noDims, newDims = imageOut->noDims;
+		const float *dataIn = imageIn->GetData(MEMORYDEVICE_CPU);
+		float *dataOut = imageOut->GetData(MEMORYDEVICE_CPU);
+
+		for (int y = 0; y < newDims.y; y++) for (int x = 0; x < newDims.x; x++)
+			filterSubsampleWithHoles(dataOut, x, y, newDims, dataIn, oldDims);
+
+		return dataOut[newDims.x * newDims.y / 2 + newDims.x / 2];
+	}
+};
+
+/// The allocation pass over the depth image, on a scene that already holds most of the blocks it touches
+class BuildHashAllocAndVisibleTypeBenchmark : public KernelBenchmark
+{
+private:
+	const SyntheticScene &synthetic;
+	ORUtils::MemoryBlock<uchar> *entriesAllocType, *entriesVisibleType;
+	ORUtils::MemoryBlock<Vector4s> *blockCoords;
+
+public:
+	explicit BuildHashAllocAndVisibleTypeBenchmark(const SyntheticScene &synthetic) : synthetic(synthetic)
+	{
+		entriesAllocType = new ORUtils::MemoryBlock<uchar>(ITMVoxelBlockHash::noTotalEntries, MEMORYDEVICE_CPU);
+		entriesVisibleType = new ORUtils::MemoryBlock<uchar>(ITMVoxelBlockHash::noTotalEntries, MEMORYDEVICE_CPU);
+		blockCoords = new ORUtils::MemoryBlock<Vector4s>(ITMVoxelBlockHash::noTotalEntries, MEMORYDEVICE_CPU);
+	}
+
+	~BuildHashAllocAndVisibleTypeBenchmark()
+	{
+		delete blockCoords;
+		delete entriesVisibleType;
+		delete entriesAllocType;
+	}
+
+	const char* GetName() const { return "buildHashAllocAndVisibleTypePP"; }
+	int GetNoElements() const { return (int)synthetic.trackingDepth->dataSize; }
+	int GetBytesPerElement() const { return sizeof(float); }
+
+	void Prepare()
+	{
+		entriesAllocType->Clear();
+		entriesVisibleType->Clear();
+	}
+
+	double Run()
+	{
+		Vector2i imgSize = synthetic.trackingDepth->noDims;
+		const float *depth = synthetic.trackingDepth->GetData(MEMORYDEVICE_CPU);
+		const ITMHashEntry *hashTable = synthetic.scene->index.GetEntries();
+		uchar *allocType = entriesAllocType->GetData(MEMORYDEVICE_CPU);
+		uchar *visibleType = entriesVisibleType->GetData(MEMORYDEVICE_CPU);
+
+		Matrix4f invM_d = synthetic.trackingPose.GetInvM();
+		Vector4f invProjParams_d = synthetic.calib.intrinsics_d.projectionParamsSimple.all;
+		invProjParams_d.x = 1.0f / invProjParams_d.x;
+		invProjParams_d.y = 1.0f / invProjParams_d.y;
+
+		const ITMSceneParams &sceneParams = synthetic.sceneParams;
+		float oneOverVoxelSize = 1.0f / (sceneParams.voxelSize * SDF_BLOCK_SIZE);
+
+		for (int y = 0; y < imgSize.y; y++) for (int x = 0; x < imgSize.x; x++)
+			buildHashAllocAndVisibleTypePP(allocType, visibleType, x, y, blockCoords->GetData(MEMORYDEVICE_CPU), depth, invM_d,
+				invProjParams_d, sceneParams.mu, imgSize, oneOverVoxelSize, hashTable, sceneParams.viewFrustum_min, sceneParams.viewFrustum_max);
+
+		int noVisible = 0;
+		for (int i = 0; i < ITMVoxelBlockHash::noTotalEntries; i++) noVisible += visibleType[i] != 0;
+		return noVisible;
+	}
+};
+
+/// Every voxel of the blocks visible in the reference view, the way the CUDA integration kernel visits them
+class ComputeUpdatedVoxelInfoBenchmark : public KernelBenchmark
+{
+private:
+	const SyntheticScene &synthetic;
+	std::vector<ITMVoxel> voxelsBefore;
+	std::vector<int> blockPtrs;
+
+public:
+	explicit ComputeUpdatedVoxelInfoBenchmark(const SyntheticScene &synthetic) : synthetic(synthetic)
+	{
+		const ITMHashEntry *hashTable = synthetic.scene->index.GetEntries();
+		const int *visibleEntryIds = synthetic.renderState->GetVisibleEntryIDs();
+
+		for (int i = 0; i < synthetic.renderState->noVisibleEntries; i++)
+			if (hashTable[visibleEntryIds[i]].ptr >= 0) blockPtrs.push_back(visibleEntryIds[i]);
+	}
+
+	const char* GetName() const { return "ComputeUpdatedVoxelInfo"; }
+	int GetNoElements() const { return (int)blockPtrs.size() * SDF_BLOCK_SIZE3; }
+	int GetBytesPerElement() const { return 2 * sizeof(ITMVoxel) + sizeof(float); }
+
+	/// The voxels are restored so that every run fuses into the same weights, copying whole blocks keeps this independent of the block layout
+	void Prepare()
+	{
+		const ITMHashEntry *hashTable = synthetic.scene->index.GetEntries();
+		ITMVoxel *localVBA = synthetic.scene->localVBA.GetVoxelBlocks();
+
+		bool save = voxelsBefore.empty();
+		if (save) voxelsBefore.resize(blockPtrs.size() * SDF_BLOCK_SIZE3);
+
+		for (size_t i = 0; i < blockPtrs.size(); i++)
+		{
+			ITMVoxel *block = localVBA + hashTable[blockPtrs[i]].ptr * SDF_BLOCK_SIZE3;
+			if (save) std::copy(block, block + SDF_BLOCK_SIZE3, &voxelsBefore[i * SDF_BLOCK_SIZE3]);
+			else std::copy(&voxelsBefore[i * SDF_BLOCK_SIZE3], &voxelsBefore[i * SDF_BLOCK_SIZE3] + SDF_BLOCK_SIZE3, block);
+		}
+	}
+
+	double Run()
+	{
+		const ITMView *view = synthetic.view;
+		const ITMHashEntry *hashTable = synthetic.scene->index.GetEntries();
+		ITMVoxel *localVBA = synthetic.scene->localVBA.GetVoxelBlocks();
+
+		Matrix4f M_d = synthetic.trackingPose.GetM(), M_rgb = view->calib.trafo_rgb_to_depth.calib_inv * M_d;
+		Vector4f projParams_d = view->calib.intrinsics_d.projectionParamsSimple.all;
+		Vector4f projParams_rgb = view->calib.intrinsics_rgb.projectionParamsSimple.all;
+		const float *depth = synthetic.trackingDepth->GetData(MEMORYDEVICE_CPU);
+		const float *confidence = view->depthConfidence->GetData(MEMORYDEVICE_CPU);
+		const Vector4u *rgb = view->rgb->GetData(MEMORYDEVICE_CPU);
+		Vector2i depthImgSize = synthetic.trackingDepth->noDims, rgbImgSize = view->rgb->noDims;
+
+		float voxelSize = synthetic.sceneParams.voxelSize, mu = synthetic.sceneParams.mu;
+		int maxW = synthetic.sceneParams.maxW;
+
+		for (size_t i = 0; i < blockPtrs.size(); i++)
+		{
+			const ITMHashEntry &hashEntry = hashTable[blockPtrs[i]];
+			Vector3i globalPos = hashEntry.pos.toInt() * SDF_BLOCK_SIZE;
+			ITMVoxel *localVoxelBlock = localVBA + hashEntry.ptr * SDF_BLOCK_SIZE3;
+
+			for (int z = 0; z < SDF_BLOCK_SIZE; z++) for (int y = 0; y < SDF_BLOCK_SIZE; y++) for (int x = 0; x < SDF_BLOCK_SIZE; x++)
+			{
+				Vector4f pt_model;
+				pt_model.x = (float)(globalPos.x + x) * voxelSize;
+				pt_model.y = (float)(globalPos.y + y) * voxelSize;
+				pt_model.z = (float)(globalPos.z + z) * voxelSize;
+				pt_model.w = 1.0f;
+
+				int locId = x + y * SDF_BLOCK_SIZE + z * SDF_BLOCK_SIZE * SDF_BLOCK_SIZE;
+				ITMVoxel voxel = loadVoxel(localVoxelBlock, locId);
+
+				ComputeUpdatedVoxelInfo<ITMVoxel::hasColorInformation, ITMVoxel::hasConfidenceInformation, ITMVoxel>::compute(
+					voxel, pt_model, M_d, projParams_d, M_rgb, projParams_rgb, mu, maxW, depth, confidence, depthImgSize, rgb, rgbImgSize);
+
+				storeVoxel(localVoxelBlock, locId, voxel);
+			}
+		}
+
+		return loadVoxel(localVBA, hashTable[blockPtrs[0]].ptr * SDF_BLOCK_SIZE3).w_depth;
+	}
+};
+
+/// The raycast of the reference view, within the expected depth ranges of its visible blocks
+class CastRayBenchmark : public KernelBenchmark
+{
+private:
+	const SyntheticScene &synthetic;
+	ORUtils::Image<Vector4f> *pointsRay;
+
+public:
+	explicit CastRayBenchmark(const SyntheticScene &synthetic) : synthetic(synthetic)
+	{
+		pointsRay = new ORUtils::Image<Vector4f>(synthetic.renderState->raycastResult->noDims, true, false);
+	}
+
+	~CastRayBenchmark() { delete pointsRay; }
+
+	const char* GetName() const { return "castRay"; }
+	int GetNoElements() const { return (int)pointsRay->dataSize; }
+	int GetBytesPerElement() const { return sizeof(Vector2f) + sizeof(Vector4f); }
+
+	double Run()
+	{
+		Vector2i imgSize = pointsRay->noDims;
+		const Vector2f *minmaximg = synthetic.renderState->renderingRangeImage->GetData(MEMORYDEVICE_CPU);
+		const ITMVoxel *voxelData = synthetic.scene->localVBA.GetVoxelBlocks();
+		const ITMVoxelIndex::IndexData *voxelIndex = synthetic.scene->index.getIndexData();
+		Vector4f *points = pointsRay->GetData(MEMORYDEVICE_CPU);
+
+		Matrix4f invM = synthetic.trackingState->pose_d->GetInvM();
+		Vector4f invProjParams = InvertProjectionParams(synthetic.calib.intrinsics_d.projectionParamsSimple.all);
+		float oneOverVoxelSize = 1.0f / synthetic.sceneParams.voxelSize, mu = synthetic.sceneParams.mu;
+
+		int noFound = 0;
+		for (int y = 0; y < imgSize.y; y++) for (int x = 0; x < imgSize.x; x++)
+		{
+			int locId2 = (x / minmaximg_subsample) + (y / minmaximg_subsample) * imgSize.x;
+			noFound += castRay<ITMVoxel, ITMVoxelIndex, false>(points[x + y * imgSize.x], NULL, x, y, voxelData, voxelIndex,
+				invM, invProjParams, oneOverVoxelSize, mu, minmaximg[locId2]);
+		}
+
+		return noFound;
+	}
+};
+
+/// One full (six parameter) ICP iteration of the extended tracker, with the per point terms summed up as the tracker does
+class ComputePerPointGHBenchmark : public KernelBenchmark
+{
+private:
+	const SyntheticScene &synthetic;
+
+public:
+	explicit ComputePerPointGHBenchmark(const SyntheticScene &synthetic) : synthetic(synthetic) {}
+
+	const char* GetName() const { return "computePerPointGH_exDepth"; }
+	int GetNoElements() const { return (int)synthetic.trackingDepth->dataSize; }
+	int GetBytesPerElement() const { return sizeof(float) + 8 * sizeof(Vector4f); }
+
+	double Run()
+	{
+		const ITMPointCloud *pointCloud = synthetic.trackingState->pointCloud;
+		const Vector4f *pointsMap = pointCloud->locations->GetData(MEMORYDEVICE_CPU);
+		const Vector4f *normalsMap = pointCloud->colours->GetData(MEMORYDEVICE_CPU);
+		Vector2i sceneImageSize = pointCloud->locations->noDims;
+		Matrix4f scenePose = synthetic.trackingState->pose_pointCloud->GetM();
+
+		const float *depth = synthetic.trackingDepth->GetData(MEMORYDEVICE_CPU);
+		Vector2i viewImageSize = synthetic.trackingDepth->noDims;
+		Vector4f intrinsics = synthetic.calib.intrinsics_d.projectionParamsSimple.all;
+		Matrix4f approxInvPose = synthetic.trackingPose.GetInvM();
+
+		// the defaults of the extended tracker at its coarsest level
+		const float spaceThresh = 0.1f, tukeyCutOff = 8.0f;
+		const int framesToSkip = 20, framesToWeight = 50;
+		float viewFrustum_min = synthetic.sceneParams.viewFrustum_min, viewFrustum_max = synthetic.sceneParams.viewFrustum_max;
+
+		float sumHessian[6 + 5 + 4 + 3 + 2 + 1] = { 0 }, sumNabla[6] = { 0 }, sumF = 0.0f;
+
+		for (int y = 0; y < viewImageSize.y; y++) for (int x = 0; x < viewImageSize.x; x++)
+		{
+			float localHessian[6 + 5 + 4 + 3 + 2 + 1], localNabla[6], localF = 0.0f, depthWeight;
+
+			if (!computePerPointGH_exDepth<false, false, false>(localNabla, localHessian, localF, x, y, depth[x + y * viewImageSize.x], depthWeight,
+				viewImageSize, intrinsics, sceneImageSize, intrinsics, approxInvPose, scenePose, pointsMap, normalsMap, spaceThresh,
+				viewFrustum_min, viewFrustum_max, tukeyCutOff, framesToSkip, framesToWeight)) continue;
+
+			sumF += localF;
+			for (int i = 0; i < 6; i++) sumNabla[i] += localNabla[i];
+			for (int i = 0; i < 6 + 5 + 4 + 3 + 2 + 1; i++) sumHessian[i] += localHessian[i];
+		}
+
+		return sumF + sumNabla[0] + sumHessian[0];
+	}
+};
+
+/// The marching cubes vertices of every voxel of every allocated block, as the CPU meshing engine visits them
+class BuildVertListBenchmark : public KernelBenchmark
+{
+private:
+	const SyntheticScene &synthetic;
+	std::vector<int> entryIds;
+
+public:
+	explicit BuildVertListBenchmark(const SyntheticScene &synthetic) : synthetic(synthetic)
+	{
+		const ITMHashEntry *hashTable = synthetic.scene->index.GetEntries();
+		for (int entryId = 0; entryId < ITMVoxelBlockHash::noTotalEntries; entryId++)
+			if (hashTable[entryId].ptr >= 0) entryIds.push_back(entryId);
+	}
+
+	const char* GetName() const { return "buildVertList"; }
+	int GetNoElements() const { return (int)entryIds.size() * SDF_BLOCK_SIZE3; }
+	int GetBytesPerElement() const { return sizeof(ITMVoxel); }
+
+	double Run()
+	{
+		const ITMVoxel *localVBA = synthetic.scene->localVBA.GetVoxelBlocks();
+		const ITMHashEntry *hashTable = synthetic.scene->index.GetEntries();
+
+		int noCubes = 0;
+		for (size_t i = 0; i < entryIds.size(); i++)
+		{
+			Vector3i globalPos = hashTable[entryIds[i]].pos.toInt() * SDF_BLOCK_SIZE;
+
+			for (int z = 0; z < SDF_BLOCK_SIZE; z++) for (int y = 0; y < SDF_BLOCK_SIZE; y++) for (int x = 0; x < SDF_BLOCK_SIZE; x++)
+			{
+				Vector3f vertList[12];
+				noCubes += buildVertList(vertList, globalPos, Vector3i(x, y, z), localVBA, hashTable) >= 0;
+			}
+		}
+
+		return noCubes;
+	}
+};
+
+static void PrintUsage(const char *programName)
+{
+	printf("usage: %s [options]\n"
+		"  --kernel <name>        only run this kernel, may be given several times\n"
+		"  --repetitions <n>      timed runs of each kernel (default 10), after one untimed run\n"
+		"  --width <w>            width of the synthetic frames (default 640), the height is 3/4 of it\n"
+		"  --frames <n>           views integrated into the synthetic scene (default 8)\n"
+		"  --output <file>        also write the results as JSON\n"
+		"  --list                 list the kernels and exit\n"
+		"kernels run in a single thread on the host\n", programName);
+}
+
+int main(int argc, char** argv)
+try
+{
+	std::vector<std::string> selectedKernels;
+	int noRepetitions = 10, width = 640, noFrames = 8;
+	const char *outputFile = NULL;
+	bool listOnly = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (arg == "--kernel" && hasValue) selectedKernels.push_back(argv[++i]);
+		else if (arg == "--repetitions" && hasValue) noRepetitions = atoi(argv[++i]);
+		else if (arg == "--width" && hasValue) width = atoi(argv[++i]);
+		else if (arg == "--frames" && hasValue) noFrames = atoi(argv[++i]);
+		else if (arg == "--output" && hasValue) outputFile = argv[++i];
+		else if (arg == "--list") listOnly = true;
+		else
+		{
+			PrintUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (noRepetitions < 1 || width < 16 || width % 8 != 0 || noFrames < 1)
+	{
+		printf("the repetitions and frames must be positive, the width a multiple of 8 of at least 16\n");
+		return 1;
+	}
+
+	Vector2i imgSize(width, width * 3 / 4);
+
+	printf("building a synthetic scene of %d frames at %dx%d ...\n", noFrames, imgSize.x, imgSize.y);
+	SyntheticScene synthetic(imgSize, noFrames);
+	printf("%d blocks allocated, %d visible in the reference view\n\n",
+		synthetic.scene->index.getNumAllocatedVoxelBlocks() - 1 - synthetic.scene->localVBA.lastFreeBlockId, synthetic.renderState->noVisibleEntries);
+
+	std::vector<KernelBenchmark*> kernels;
+	kernels.push_back(new FilterSubsampleBenchmark(synthetic));
+	kernels.push_back(new FilterSubsampleWithHolesBenchmark(synthetic));
+	kernels.push_back(new BuildHashAllocAndVisibleTypeBenchmark(synthetic));
+	kernels.push_back(new ComputeUpdatedVoxelInfoBenchmark(synthetic));
+	kernels.push_back(new CastRayBenchmark(synthetic));
+	kernels.push_back(new ComputePerPointGHBenchmark(synthetic));
+	kernels.push_back(new BuildVertListBenchmark(synthetic));
+
+	if (listOnly)
+	{
+		for (size_t i = 0; i < kernels.size(); i++) printf("%s\n", kernels[i]->GetName());
+		for (size_t i = 0; i < kernels.size(); i++) delete kernels[i];
+		return 0;
+	}
+
+	std::ofstream json;
+	if (outputFile != NULL)
+	{
+		json.open(outputFile);
+		if (!json) throw std::runtime_error(std::string("cannot write ") + outputFile);
+		json << "{\n  \"width\": " << imgSize.x << ",\n  \"height\": " << imgSize.y << ",\n  \"repetitions\": " << noRepetitions << ",\n  \"kernels\": {";
+	}
+
+	printf("%-32s %10s %12s %12s %10s %10s\n", "kernel", "elements", "median ms", "min ms", "ns/elem", "GB/s");
+
+	StopWatchInterface *timer;
+	sdkCreateTimer(&timer);
+
+	bool firstResult = true;
+	for (size_t kernelId = 0; kernelId < kernels.size(); kernelId++)
+	{
+		KernelBenchmark *kernel = kernels[kernelId];
+		if (!selectedKernels.empty() && std::find(selectedKernels.begin(), selectedKernels.end(), kernel->GetName()) == selectedKernels.end()) continue;
+
+		if (kernel->GetNoElements() == 0)
+		{
+			printf("%-32s %10s\n", kernel->GetName(), "no input");
+			continue;
+		}
+
+		// the first run warms the caches and is not timed
+		double checksum = 0.0;
+		std::vector<double> times;
+		for (int run = 0; run <= noRepetitions; run++)
+		{
+			kernel->Prepare();
+
+			sdkResetTimer(&timer); sdkStartTimer(&timer);
+			checksum += kernel->Run();
+			sdkStopTimer(&timer);
+
+			if (run > 0) times.push_back(sdkGetTimerValue(&timer));
+		}
+
+		std::sort(times.begin(), times.end());
+		double median = times[times.size() / 2], minimum = times[0];
+		double nsPerElement = median * 1e6 / kernel->GetNoElements();
+		double gbPerSecond = (double)kernel->GetBytesPerElement() / nsPerElement;
+
+		printf("%-32s %10d %12.3f %12.3f %10.2f %10.2f\n", kernel->GetName(), kernel->GetNoElements(), median, minimum, nsPerElement, gbPerSecond);
+
+		if (json.is_open())
+		{
+			json << (firstResult ? "" : ",") << "\n    \"" << kernel->GetName() << "\": { \"elements\": " << kernel->GetNoElements()
+				<< ", \"bytesPerElement\": " << kernel->GetBytesPerElement() << ", \"medianMs\": " << median << ", \"minMs\": " << minimum
+				<< ", \"nsPerElement\": " << nsPerElement << ", \"GBps\": " << gbPerSecond << ", \"checksum\": " << checksum << " }";
+			firstResult = false;
+		}
+	}
+
+	sdkDeleteTimer(&timer);
+
+	if (json.is_open())
+	{
+		json << "\n  }\n}\n";
+		if (!json) throw std::runtime_error(std::string("cannot write ") + outputFile);
+	}
+
+	for (size_t i = 0; i < kernels.size(); i++) delete kernels[i];
+
+	return 0;
+}
+catch (std::exception& e)
+{
+	std::cerr << e.what() << '\n';
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,399 @@
+// Copyright 2014-2017 Oxford University Innovation Limited and the authors of InfiniTAM
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef NO_CPP11
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "../../InputSource/ImageSourceEngine.h"
+
+#include "../../ITMLib/ITMLibDefines.h"
+#include "../../ITMLib/Core/ITMBasicEngine.h"
+#include "../../ITMLib/Core/ITMBasicSurfelEngine.h"
+#include "../../ITMLib/Core/ITMMultiEngine.h"
+
+#include "../../ORUtils/NVTimer.h"
+#include "../../ORUtils/TaskScheduler.h"
+#include "../../ORUtils/Trace.h"
+
+using namespace InputSource;
+using namespace ITMLib;
+
+static const float PERCENTILES[] = { 50.0f, 95.0f, 99.0f };
+static const int NO_PERCENTILES = 3;
+
+/// Nearest-rank percentile, \p p between 0 and 100
+static double Percentile(std::vector<double> samples, float p)
+{
+	if (samples.empty()) return 0.0;
+
+	int rank = (int)ceil(p / 100.0f * (float)samples.size()) - 1;
+	rank = std::max(0, std::min(rank, (int)samples.size() - 1));
+
+	std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+	return samples[rank];
+}
+
+/// The latency percentiles of \p frameTimes as a JSON object
+static std::string LatencyJSON(const std::vector<double>& frameTimes)
+{
+	std::ostringstream json;
+	json.precision(4);
+	json << std::fixed << "{ ";
+	for (int i = 0; i < NO_PERCENTILES; i++)
+		json << (i > 0 ? ", " : "") << "\"p" << (int)PERCENTILES[i] << "\": " << Percentile(frameTimes, PERCENTILES[i]);
+	json << " }";
+	return json.str();
+}
+
+/// Peak resident set size of the process in MB, -1 if unknown
+static double GetPeakHostMemoryMB()
+{
+#ifndef _WIN32
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) return -1.0;
+#ifdef __APPLE__
+	return (double)usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+	return (double)usage.ru_maxrss / 1024.0;
+#endif
+#else
+	return -1.0;
+#endif
+}
+
+static void SynchroniseDevice(ITMLibSettings::DeviceType deviceType)
+{
+#ifndef COMPILE_WITHOUT_CUDA
+	if (deviceType == ITMLibSettings::DEVICE_CUDA) ORcudaSafeCall(cudaDeviceSynchronize());
+#endif
+}
+
+/// The preloaded sequence, read by all sessions
+struct Sequence
+{
+	std::vector<ITMUChar4Image*> rgbFrames;
+	std::vector<ITMShortImage*> depthFrames;
+	int noWarmupFrames;
+};
+
+/// Starts the timed frames of all sessions at once
+class StartBarrier
+{
+private:
+	int noWaiting, noSessions;
+#ifndef NO_CPP11
+	std::mutex mutex;
+	std::condition_variable released;
+	std::chrono::steady_clock::time_point releaseTime;
+#endif
+
+public:
+	explicit StartBarrier(int noSessions) : noWaiting(0), noSessions(noSessions) {}
+
+	void Wait(void)
+	{
+#ifndef NO_CPP11
+		std::unique_lock<std::mutex> lock(mutex);
+		if (++noWaiting == noSessions)
+		{
+			releaseTime = std::chrono::steady_clock::now();
+			released.notify_all();
+		}
+		else while (noWaiting < noSessions) released.wait(lock);
+#endif
+	}
+
+	/// Milliseconds since all sessions passed the barrier
+	double GetElapsedTime(void)
+	{
+#ifndef NO_CPP11
+		std::lock_guard<std::mutex> lock(mutex);
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - releaseTime).count();
+#else
+		return 0.0;
+#endif
+	}
+};
+
+/// One engine with its own input images, replaying the shared sequence
+struct Session
+{
+	ITMMainEngine *mainEngine;
+	ITMUChar4Image *inputRGBImage;
+	ITMShortImage *inputRawDepthImage;
+
+	std::vector<double> frameTimes;
+	double totalTime;
+};
+
+static void RunSession(Session *session, const Sequence *sequence, ITMLibSettings::DeviceType deviceType, StartBarrier *barrier)
+{
+	ORUtils::TraceRecorder::SetThreadName("session");
+
+	StopWatchInterface *timer;
+	sdkCreateTimer(&timer);
+
+	session->totalTime = 0.0;
+	for (size_t frameNo = 0; frameNo < sequence->rgbFrames.size(); frameNo++)
+	{
+		if ((int)frameNo == sequence->noWarmupFrames) barrier->Wait();
+
+		session->inputRGBImage->SetFrom(sequence->rgbFrames[frameNo], ORUtils::MemoryBlock<Vector4u>::CPU_TO_CPU);
+		session->inputRawDepthImage->SetFrom(sequence->depthFrames[frameNo], ORUtils::MemoryBlock<short>::CPU_TO_CPU);
+
+		sdkResetTimer(&timer); sdkStartTimer(&timer);
+
+		session->mainEngine->ProcessFrame(session->inputRGBImage, session->inputRawDepthImage);
+		SynchroniseDevice(deviceType);
+
+		sdkStopTimer(&timer);
+
+		if ((int)frameNo < sequence->noWarmupFrames) continue;
+
+		double frameTime = sdkGetTimerValue(&timer);
+		session->frameTimes.push_back(frameTime);
+		session->totalTime += frameTime;
+	}
+
+	sdkDeleteTimer(&timer);
+}
+
+static void PrintUsage(const char *name)
+{
+	printf("usage: %s [options] <calibfile> <rgbmask> <depthmask>\n"
+	       "  replays an image sequence from memory through several main engines at once, one thread each,\n"
+	       "  and reports their aggregate throughput as JSON\n"
+	       "\n"
+	       "options:\n"
+	       "  --sessions <n>                : number of concurrent engines (default 2)\n"
+	       "  --engine <basic|surfel|multi> : main engine to run (default basic)\n"
+	       "  --device <cpu|cuda>           : device to run on (default as built)\n"
+	       "  --threads <n>                 : threads running the CPU engines in total, 0 uses one per hardware thread (default 0)\n"
+	       "  --pool <shared|separate>      : one scheduler for all engines, or a scheduler per engine with an equal\n"
+	       "                                  share of the threads (default shared)\n"
+	       "  --pin-core <core>             : pin the worker threads to consecutive cores starting at this one\n"
+	       "  --budget <MB>                 : memory of the local voxel block array of each scene (default 256)\n"
+	       "  --frames <n>                  : replay at most n frames (default all)\n"
+	       "  --warmup <n>                  : leave the first n frames out of the statistics (default 5)\n"
+	       "  --output <file>               : write the JSON report to this file (default stdout)\n"
+	       "\n"
+	       "example:\n"
+	       "  %s --sessions 4 ./Files/Teddy/calib.txt ./Files/Teddy/Frames/%%04i.ppm ./Files/Teddy/Frames/%%04i.pgm\n\n", name, name);
+}
+
+int main(int argc, char** argv)
+try
+{
+	const char *engineName = "basic", *deviceName = NULL, *poolName = "shared", *outputFile = NULL;
+	int noSessions = 2, noThreads = 0, firstCore = -1, maxFrames = -1, noWarmupFrames = 5;
+	double budgetMB = 256.0;
+
+	std::vector<const char*> positional;
+	for (int arg = 1; arg < argc; arg++)
+	{
+		std::string option = argv[arg];
+		bool hasValue = arg + 1 < argc;
+
+		if (option == "--sessions" && hasValue) noSessions = atoi(argv[++arg]);
+		else if (option == "--engine" && hasValue) engineName = argv[++arg];
+		else if (option == "--device" && hasValue) deviceName = argv[++arg];
+		else if (option == "--threads" && hasValue) noThreads = atoi(argv[++arg]);
+		else if (option == "--pool" && hasValue) poolName = argv[++arg];
+		else if (option == "--pin-core" && hasValue) firstCore = atoi(argv[++arg]);
+		else if (option == "--budget" && hasValue) budgetMB = atof(argv[++arg]);
+		else if (option == "--frames" && hasValue) maxFrames = atoi(argv[++arg]);
+		else if (option == "--warmup" && hasValue) noWarmupFrames = atoi(argv[++arg]);
+		else if (option == "--output" && hasValue) outputFile = argv[++arg];
+		else if (option.compare(0, 2, "--") == 0) { PrintUsage(argv[0]); return EXIT_FAILURE; }
+		else positional.push_back(argv[arg]);
+	}
+
+	if (positional.size() != 3 || noSessions < 1) { PrintUsage(argv[0]); return EXIT_FAILURE; }
+
+	bool sharedPool;
+	if (strcmp(poolName, "shared") == 0) sharedPool = true;
+	else if (strcmp(poolName, "separate") == 0) sharedPool = false;
+	else throw std::runtime_error(std::string("unknown pool: ") + poolName);
+
+	// the settings are only read by the engines, so all sessions use the same
+	ITMLibSettings *internalSettings = new ITMLibSettings();
+	internalSettings->createMeshingEngine = false;
+	if (deviceName != NULL)
+	{
+		if (strcmp(deviceName, "cpu") == 0) internalSettings->deviceType = ITMLibSettings::DEVICE_CPU;
+		else if (strcmp(deviceName, "cuda") == 0) internalSettings->deviceType = ITMLibSettings::DEVICE_CUDA;
+		else throw std::runtime_error(std::string("unknown device: ") + deviceName);
+	}
+
+	double voxelBlockMB = (double)(SDF_BLOCK_SIZE3 * sizeof(ITMVoxel)) / (1024.0 * 1024.0);
+	internalSettings->noLocalVoxelBlocks = std::max(1, std::min((int)(budgetMB / voxelBlockMB), SDF_LOCAL_BLOCK_NUM));
+
+	// preload the sequence so that disk I/O and decoding are not timed
+	ImageMaskPathGenerator pathGenerator(positional[1], positional[2]);
+	ImageFileReader<ImageMaskPathGenerator> imageSource(positional[0], pathGenerator);
+
+	Sequence sequence;
+	sequence.noWarmupFrames = noWarmupFrames;
+	while (imageSource.hasMoreImages() && (maxFrames < 0 || (int)sequence.rgbFrames.size() < maxFrames))
+	{
+		ITMUChar4Image *rgb = new ITMUChar4Image(imageSource.getRGBImageSize(), true, false);
+		ITMShortImage *depth = new ITMShortImage(imageSource.getDepthImageSize(), true, false);
+		imageSource.getImages(rgb, depth);
+
+		sequence.rgbFrames.push_back(rgb);
+		sequence.depthFrames.push_back(depth);
+	}
+
+	if ((int)sequence.rgbFrames.size() <= noWarmupFrames) throw std::runtime_error("not enough frames in the sequence");
+
+	Vector2i imgSize_rgb = sequence.rgbFrames[0]->noDims, imgSize_d = sequence.depthFrames[0]->noDims;
+
+	// one scheduler for all sessions, or an equal share of the threads and cores for each
+	std::vector<ORUtils::TaskScheduler*> taskSchedulers;
+	if (internalSettings->deviceType != ITMLibSettings::DEVICE_CUDA)
+	{
+		if (sharedPool) taskSchedulers.push_back(new ORUtils::TaskScheduler(noThreads, firstCore));
+		else
+		{
+			int noTotalThreads = noThreads;
+#ifndef NO_CPP11
+			if (noTotalThreads <= 0) noTotalThreads = (int)std::thread::hardware_concurrency();
+#endif
+			int noSessionThreads = std::max(1, noTotalThreads / noSessions);
+			for (int sessionId = 0; sessionId < noSessions; sessionId++)
+				taskSchedulers.push_back(new ORUtils::TaskScheduler(noSessionThreads, firstCore >= 0 ? firstCore + sessionId * noSessionThreads : -1));
+		}
+	}
+
+	if (strcmp(engineName, "basic") == 0) internalSettings->libMode = ITMLibSettings::LIBMODE_BASIC;
+	else if (strcmp(engineName, "surfel") == 0) internalSettings->libMode = ITMLibSettings::LIBMODE_BASIC_SURFELS;
+	else if (strcmp(engineName, "multi") == 0) internalSettings->libMode = ITMLibSettings::LIBMODE_LOOPCLOSURE;
+	else throw std::runtime_error(std::string("unknown engine: ") + engineName);
+
+	bool allocateGPU = internalSettings->deviceType == ITMLibSettings::DEVICE_CUDA;
+	std::vector<Session> sessions(noSessions);
+	for (int sessionId = 0; sessionId < noSessions; sessionId++)
+	{
+		Session &session = sessions[sessionId];
+		ORUtils::TaskScheduler *taskScheduler = taskSchedulers.empty() ? NULL : taskSchedulers[sharedPool ? 0 : sessionId];
+
+		switch (internalSettings->libMode)
+		{
+		case ITMLibSettings::LIBMODE_BASIC:
+			session.mainEngine = new ITMBasicEngine<ITMVoxel, ITMVoxelIndex>(internalSettings, imageSource.getCalib(), imgSize_rgb, imgSize_d, taskScheduler);
+			break;
+		case ITMLibSettings::LIBMODE_BASIC_SURFELS:
+			session.mainEngine = new ITMBasicSurfelEngine<ITMSurfelT>(internalSettings, imageSource.getCalib(), imgSize_rgb, imgSize_d, taskScheduler);
+			break;
+		case ITMLibSettings::LIBMODE_LOOPCLOSURE:
+			session.mainEngine = new ITMMultiEngine<ITMVoxel, ITMVoxelIndex>(internalSettings, imageSource.getCalib(), imgSize_rgb, imgSize_d, taskScheduler);
+			break;
+		}
+
+		session.inputRGBImage = new ITMUChar4Image(imgSize_rgb, true, allocateGPU);
+		session.inputRawDepthImage = new ITMShortImage(imgSize_d, true, allocateGPU);
+	}
+
+	fprintf(stderr, "replaying %d frames in %d sessions\n", (int)sequence.rgbFrames.size(), noSessions);
+
+	// replay
+	StartBarrier barrier(noSessions);
+	double wallTime;
+#ifndef NO_CPP11
+	std::vector<std::thread> sessionThreads;
+	for (int sessionId = 0; sessionId < noSessions; sessionId++)
+		sessionThreads.push_back(std::thread(RunSession, &sessions[sessionId], &sequence, internalSettings->deviceType, &barrier));
+	for (int sessionId = 0; sessionId < noSessions; sessionId++) sessionThreads[sessionId].join();
+	wallTime = barrier.GetElapsedTime();
+#else
+	// without threads the sessions run one after the other
+	wallTime = 0.0;
+	for (int sessionId = 0; sessionId < noSessions; sessionId++)
+	{
+		RunSession(&sessions[sessionId], &sequence, internalSettings->deviceType, &barrier);
+		wallTime += sessions[sessionId].totalTime;
+	}
+#endif
+
+	// report
+	std::vector<double> frameTimes, sessionFps(noSessions, 0.0);
+	double sessionFpsSum = 0.0;
+	int noTimedFrames = 0;
+	for (int sessionId = 0; sessionId < noSessions; sessionId++)
+	{
+		const Session &session = sessions[sessionId];
+		frameTimes.insert(frameTimes.end(), session.frameTimes.begin(), session.frameTimes.end());
+		noTimedFrames += (int)session.frameTimes.size();
+		if (session.totalTime > 0.0) sessionFps[sessionId] = 1000.0 * (double)session.frameTimes.size() / session.totalTime;
+		sessionFpsSum += sessionFps[sessionId];
+	}
+
+	double aggregateFps = wallTime > 0.0 ? 1000.0 * (double)noTimedFrames / wallTime : 0.0;
+
+	std::ostringstream report;
+	report.precision(4);
+	report << std::fixed;
+
+	report << "{\n"
+	       << "  \"engine\": \"" << engineName << "\",\n"
+	       << "  \"device\": \"" << (internalSettings->deviceType == ITMLibSettings::DEVICE_CUDA ? "cuda" : "cpu") << "\",\n"
+	       << "  \"noSessions\": " << noSessions << ",\n"
+	       << "  \"pool\": \"" << poolName << "\",\n"
+	       << "  \"threads\": " << (taskSchedulers.empty() ? 0 : taskSchedulers[0]->GetNoThreads() * (int)taskSchedulers.size()) << ",\n"
+	       << "  \"voxelBlocksPerSession\": " << internalSettings->noLocalVoxelBlocks << ",\n"
+	       << "  \"voxelMemoryPerSessionMB\": " << internalSettings->noLocalVoxelBlocks * voxelBlockMB << ",\n"
+	       << "  \"framesPerSession\": " << sequence.rgbFrames.size() - noWarmupFrames << ",\n"
+	       << "  \"warmupFrames\": " << noWarmupFrames << ",\n"
+	       << "  \"aggregateFps\": " << aggregateFps << ",\n"
+	       << "  \"meanSessionFps\": " << sessionFpsSum / noSessions << ",\n"
+	       << "  \"peakHostMemoryMB\": " << GetPeakHostMemoryMB() << ",\n"
+	       << "  \"frameLatency\": " << LatencyJSON(frameTimes) << ",\n"
+	       << "  \"sessions\": [\n";
+	for (int sessionId = 0; sessionId < noSessions; sessionId++)
+		report << "    { \"fps\": " << sessionFps[sessionId] << ", \"frameLatency\": " << LatencyJSON(sessions[sessionId].frameTimes) << " }"
+		       << (sessionId + 1 < noSessions ? ",\n" : "\n");
+	report << "  ]\n}\n";
+
+	if (outputFile != NULL)
+	{
+		std::ofstream f(outputFile);
+		if (!f) throw std::runtime_error(std::string("could not write ") + outputFile);
+		f << report.str();
+	}
+	else std::cout << report.str();
+
+	for (int sessionId = 0; sessionId < noSessions; sessionId++)
+	{
+		delete sessions[sessionId].inputRGBImage;
+		delete sessions[sessionId].inputRawDepthImage;
+		delete sessions[sessionId].mainEngine;
+	}
+	for (size_t i = 0; i < taskSchedulers.size(); i++) delete taskSchedulers[i];
+	delete internalSettings;
+	for (size_t i = 0; i < sequence.rgbFrames.size(); i++) { delete sequence.rgbFrames[i]; delete sequence.depthFrames[i]; }
+
+	return EXIT_SUCCESS;
+}
+catch(std::exception& e)
+{
+	std::cerr << e.what() << '\n';
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,132 @@
+// Copyright 2014-2017 Oxford University Innovation Limited and the authors of InfiniTAM
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../../InputSource/ImageSourceEngine.h"
+#include "../../InputSource/PackedSequence.h"
+#include "../../InputSource/PrefetchingImageSourceEngine.h"
+
+#include "../../ORUtils/NVTimer.h"
+
+using namespace InputSource;
+using namespace ITMLib;
+
+/// Reads a list file with one path per line, empty lines are skipped
+static std::vector<std::string> ReadPathList(const char *fileName)
+{
+	std::ifstream f(fileName);
+	if (!f) DIEWITHEXCEPTION(std::string("error: could not open list file ") + fileName);
+
+	std::vector<std::string> paths;
+	std::string line;
+	while (std::getline(f, line))
+	{
+		if (!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+		if (!line.empty()) paths.push_back(line);
+	}
+
+	return paths;
+}
+
+int main(int argc, char** argv)
+try
+{
+	bool useLists = false, compressDepth = true;
+
+	int arg = 1;
+	for (; arg < argc && strncmp(argv[arg], "--", 2) == 0; arg++)
+	{
+		if (strcmp(argv[arg], "--lists") == 0) useLists = true;
+		else if (strcmp(argv[arg], "--raw") == 0) compressDepth = false;
+		else break;
+	}
+
+	if (argc - arg != 4)
+	{
+		printf("usage: %s [--lists] [--raw] <calibfile> <rgbimages> <depthimages> <output>\n"
+		       "  --lists       : <rgbimages> and <depthimages> are files listing one image path per line\n"
+		       "  --raw         : store depth uncompressed rather than with the lossless RVL codec\n"
+		       "  <calibfile>   : path to a file containing intrinsic calibration parameters, stored in the output\n"
+		       "  <rgbimages>   : rgb file mask, or list file with --lists\n"
+		       "  <depthimages> : depth file mask, or list file with --lists\n"
+		       "  <output>      : packed sequence file to write, which InfiniTAM and InfiniTAM_cli accept as image source\n"
+		       "\n"
+		       "examples:\n"
+		       "  %s ./Files/Teddy/calib.txt ./Files/Teddy/Frames/%%04i.ppm ./Files/Teddy/Frames/%%04i.pgm teddy.itmseq\n\n", argv[0], argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	const char *calibFile = argv[arg];
+	const char *rgbImages = argv[arg + 1];
+	const char *depthImages = argv[arg + 2];
+	const char *outputFile = argv[arg + 3];
+
+	ImageSourceEngine *imageSource;
+	if (useLists)
+	{
+		ImageListPathGenerator pathGenerator(ReadPathList(rgbImages), ReadPathList(depthImages));
+		imageSource = new ImageFileReader<ImageListPathGenerator>(calibFile, pathGenerator);
+	}
+	else
+	{
+		ImageMaskPathGenerator pathGenerator(rgbImages, depthImages);
+		imageSource = new ImageFileReader<ImageMaskPathGenerator>(calibFile, pathGenerator);
+	}
+
+	// the images are decoded ahead while the frames before them are written
+	imageSource = new PrefetchingImageSourceEngine(imageSource);
+
+	if (!imageSource->hasMoreImages())
+	{
+		delete imageSource;
+		DIEWITHEXCEPTION("error: no images could be read");
+	}
+
+	Vector2i rgbImageSize = imageSource->getRGBImageSize(), depthImageSize = imageSource->getDepthImageSize();
+	printf("packing rgb images: %s (%dx%d)\n        depth images: %s (%dx%d)\n", rgbImages, rgbImageSize.x, rgbImageSize.y, depthImages, depthImageSize.x, depthImageSize.y);
+
+	PackedSequenceWriter writer;
+	if (!writer.open(outputFile, imageSource->getCalib(), rgbImageSize, depthImageSize, compressDepth))
+	{
+		delete imageSource;
+		DIEWITHEXCEPTION(std::string("error: could not create ") + outputFile);
+	}
+
+	ITMUChar4Image *rgb = new ITMUChar4Image(true, false);
+	ITMShortImage *rawDepth = new ITMShortImage(true, false);
+
+	StopWatchInterface *timer = NULL;
+	sdkCreateTimer(&timer);
+	sdkStartTimer(&timer);
+
+	bool success = true;
+	while (success && imageSource->hasMoreImages())
+	{
+		imageSource->getImages(rgb, rawDepth);
+		success = writer.writeFrame(rgb, rawDepth);
+		if (!success) printf("error: frame %d could not be written, the image sizes differ from the first frame\n", (int)writer.getNoFrames());
+	}
+
+	size_t noFrames = writer.getNoFrames();
+	success = writer.close() && success;
+
+	sdkStopTimer(&timer);
+	printf("%s %d frames to %s in %.2f s\n", success ? "packed" : "failed after", (int)noFrames, outputFile, sdkGetTimerValue(&timer) / 1000.0f);
+	sdkDeleteTimer(&timer);
+
+	delete rgb;
+	delete rawDepth;
+	delete imageSource;
+
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+catch(std::exception& e)
+{
+	std::cerr << e.what() << '\n';
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,118 @@
+// Copyright 2014-2017 Oxford University Innovation Limited and the authors of InfiniTAM
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#ifndef NO_CPP11
+#include <chrono>
+#include <thread>
+#endif
+
+#include "../../InputSource/ImageSourceEngine.h"
+#include "../../InputSource/PackedSequence.h"
+#include "../../InputSource/PrefetchingImageSourceEngine.h"
+#include "../../InputSource/SharedMemoryRing.h"
+
+using namespace InputSource;
+using namespace ITMLib;
+
+int main(int argc, char** argv)
+try
+{
+	int fps = 30, noSlots = 4;
+
+	int arg = 1;
+	for (; arg + 1 < argc && strncmp(argv[arg], "--", 2) == 0; arg += 2)
+	{
+		if (strcmp(argv[arg], "--fps") == 0) fps = atoi(argv[arg + 1]);
+		else if (strcmp(argv[arg], "--slots") == 0) noSlots = atoi(argv[arg + 1]);
+		else break;
+	}
+
+	if ((argc - arg != 3 && argc - arg != 4) || noSlots < 2)
+	{
+		printf("usage: %s [--fps <fps>] [--slots <slots>] <name> <calibfile> <packedsequence | rgbimages depthimages>\n"
+		       "  <fps>         : frames published per second, 0 publishes them as fast as possible (default 30)\n"
+		       "  <slots>       : number of frames the ring holds, at least 2 (default 4)\n"
+		       "  <name>        : name of the shared memory ring, which InfiniTAM and InfiniTAM_cli read as shm:<name>\n"
+		       "  <calibfile>   : path to a file containing intrinsic calibration parameters, passed on in the ring\n"
+		       "  <imagesource> : a packed sequence (see InfiniTAM_pack) or rgb and depth file masks to replay\n"
+		       "\n"
+		       "examples:\n"
+		       "  %s teddy ./Files/Teddy/calib.txt ./Files/Teddy/Frames/%%04i.ppm ./Files/Teddy/Frames/%%04i.pgm\n\n", argv[0], argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	const char *name = argv[arg];
+	const char *calibFile = argv[arg + 1];
+
+	ImageSourceEngine *imageSource;
+	if (argc - arg == 3) imageSource = new PackedSequenceReader(calibFile, argv[arg + 2]);
+	else
+	{
+		ImageMaskPathGenerator pathGenerator(argv[arg + 2], argv[arg + 3]);
+		imageSource = new ImageFileReader<ImageMaskPathGenerator>(calibFile, pathGenerator);
+	}
+
+	// frames are read ahead, so that reading them does not disturb the frame rate
+	imageSource = new PrefetchingImageSourceEngine(imageSource);
+
+	if (!imageSource->hasMoreImages())
+	{
+		delete imageSource;
+		DIEWITHEXCEPTION("error: no images could be read");
+	}
+
+	SharedMemoryRingWriter writer;
+	if (!writer.open(name, imageSource->getCalib(), imageSource->getRGBImageSize(), imageSource->getDepthImageSize(), noSlots))
+	{
+		delete imageSource;
+		DIEWITHEXCEPTION(std::string("error: could not create the shared memory ring ") + name);
+	}
+
+	printf("publishing into shm:%s at %d fps with %d slots\n", name, fps, noSlots);
+
+	ITMUChar4Image *rgb = new ITMUChar4Image(true, false);
+	ITMShortImage *rawDepth = new ITMShortImage(true, false);
+
+#ifndef NO_CPP11
+	std::chrono::steady_clock::time_point nextFrameTime = std::chrono::steady_clock::now();
+#endif
+
+	int noFrames = 0;
+	while (imageSource->hasMoreImages())
+	{
+		imageSource->getImages(rgb, rawDepth);
+
+#ifndef NO_CPP11
+		if (fps > 0)
+		{
+			std::this_thread::sleep_until(nextFrameTime);
+			nextFrameTime += std::chrono::microseconds(1000000 / fps);
+		}
+#endif
+
+		if (!writer.writeFrame(rgb, rawDepth))
+		{
+			printf("error: frame %d could not be published, the image sizes differ from the first frame\n", noFrames);
+			break;
+		}
+		noFrames++;
+	}
+
+	writer.close();
+	printf("published %d frames\n", noFrames);
+
+	delete rgb;
+	delete rawDepth;
+	delete imageSource;
+
+	return EXIT_SUCCESS;
+}
+catch(std::exception& e)
+{
+	std::cerr << e.what() << '\n';
+	return EXIT_FAILURE;
+}
@@ -6,9 +6,11 @@
 
 using namespace FernRelocLib;
 
-static float random_uniform01(void)
+// a generator per conservatory rather than rand(), whose state is shared by every relocaliser and thread of the process
+static float random_uniform01(unsigned int &state)
 {
-	return (float)rand() / (float)RAND_MAX;
+	state = state * 1664525u + 1013904223u;
+	return (float)(state >> 8) / (float)(1 << 24);
 }
 
 FernConservatory::FernConservatory(int numFerns, ORUtils::Vector2<int> imgSize, ORUtils::Vector2<float> bounds, int decisionsPerFern)
@@ -16,10 +18,11 @@ FernConservatory::FernConservatory(int numFerns, ORUtils::Vector2<int> imgSize,
 	mNumFerns = numFerns;
 	mNumDecisions = decisionsPerFern;
 	mEncoders = new FernTester[mNumFerns*decisionsPerFern];
+	unsigned int randomState = 1;
 	for (int f = 0; f < mNumFerns*decisionsPerFern; ++f) {
-		mEncoders[f].location.x = (int)floor(random_uniform01() * imgSize.x);
-		mEncoders[f].location.y = (int)floor(random_uniform01() * imgSize.y);
-		mEncoders[f].threshold = random_uniform01() * (bounds.y - bounds.x) + bounds.x;
+		mEncoders[f].location.x = (int)floor(random_uniform01(randomState) * imgSize.x);
+		mEncoders[f].location.y = (int)floor(random_uniform01(randomState) * imgSize.y);
+		mEncoders[f].threshold = random_uniform01(randomState) * (bounds.y - bounds.x) + bounds.x;
 	}
 }
 
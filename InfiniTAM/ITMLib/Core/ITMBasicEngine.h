@@ -12,6 +12,7 @@
 #include "../Objects/Misc/ITMIMUCalibrator.h"
 
 #include "../../FernRelocLib/Relocaliser.h"
+#include "../../ORUtils/TaskScheduler.h"
 
 namespace ITMLib
 {
@@ -46,13 +47,39 @@ namespace ITMLib
 		/// Pointer for storing the current input frame
 		ITMView *view;
 
+		/// With ITMLibSettings::pipelineFrames, the view the next frame is built into while the current one is fused, else NULL
+		ITMView *nextView;
+		bool pipelineFrames;
+
+		/// Runs the CPU engines, installed on the calling thread by every public method that processes data, NULL on CUDA
+		ORUtils::TaskScheduler *taskScheduler;
+		bool ownsTaskScheduler;
+
+		/// What remains to be done to the scene for the last tracked frame, deferred to the next frame when pipelining
+		struct PendingSceneUpdate
+		{
+			bool isPending, doFusion, doRaycast;
+			/// The pose to fuse the frame at, when the tracked pose was discarded
+			ORUtils::SE3Pose fusionPose;
+		} pendingSceneUpdate;
+
+		/// Fuses the last tracked frame and raycasts the scene for the next one, if that is still pending
+		void UpdateScene(void);
+
+		/// Builds \p view from the input images, timed as STAGE_VIEW_BUILDING
+		void BuildView(ITMView **view, ITMUChar4Image *rgbImage, ITMShortImage *rawDepthImage, ITMIMUMeasurement *imuMeasurement);
+
 		/// Pointer to the current camera pose and additional tracking information
 		ITMTrackingState *trackingState;
 
+		ITMEngineStatistics *statistics;
+
 	public:
 		ITMView* GetView(void) { return view; }
 		ITMTrackingState* GetTrackingState(void) { return trackingState; }
 
+		const ITMEngineStatistics* GetStatistics(void) const { return statistics; }
+
 		/// Gives access to the internal world representation
 		ITMScene<TVoxel, TIndex>* GetScene(void) { return scene; }
 
@@ -88,8 +115,12 @@ namespace ITMLib
 		/** \brief Constructor
 			Omitting a separate image size for the depth images
 			will assume same resolution as for the RGB images.
+			If \p sharedTaskScheduler is not NULL, the CPU engines run
+			on it rather than on a scheduler of their own, so that
+			several main engines share one pool of threads. It is
+			owned by the caller.
 		*/
-		ITMBasicEngine(const ITMLibSettings *settings, const ITMRGBDCalib& calib, Vector2i imgSize_rgb, Vector2i imgSize_d = Vector2i(-1, -1));
+		ITMBasicEngine(const ITMLibSettings *settings, const ITMRGBDCalib& calib, Vector2i imgSize_rgb, Vector2i imgSize_d = Vector2i(-1, -1), ORUtils::TaskScheduler *sharedTaskScheduler = NULL);
 		~ITMBasicEngine();
 	};
 }
@@ -10,21 +10,24 @@
 #include "../Trackers/ITMTrackerFactory.h"
 
 #include "../../ORUtils/NVTimer.h"
+#include "../../ORUtils/Trace.h"
 #include "../../ORUtils/FileUtils.h"
 
+#include <algorithm>
+
 //#define OUTPUT_TRAJECTORY_QUATERNIONS
 
 using namespace ITMLib;
 
 template <typename TVoxel, typename TIndex>
-ITMBasicEngine<TVoxel,TIndex>::ITMBasicEngine(const ITMLibSettings *settings, const ITMRGBDCalib& calib, Vector2i imgSize_rgb, Vector2i imgSize_d)
+ITMBasicEngine<TVoxel,TIndex>::ITMBasicEngine(const ITMLibSettings *settings, const ITMRGBDCalib& calib, Vector2i imgSize_rgb, Vector2i imgSize_d, ORUtils::TaskScheduler *sharedTaskScheduler)
 {
 	this->settings = settings;
 
 	if ((imgSize_d.x == -1) || (imgSize_d.y == -1)) imgSize_d = imgSize_rgb;
 
 	MemoryDeviceType memoryType = settings->GetMemoryType();
-	this->scene = new ITMScene<TVoxel,TIndex>(&settings->sceneParams, settings->swappingMode == ITMLibSettings::SWAPPINGMODE_ENABLED, memoryType);
+	this->scene = new ITMScene<TVoxel,TIndex>(&settings->sceneParams, settings->UseGlobalCache(), memoryType, settings->GetGlobalCacheCapacity(), settings->noLocalVoxelBlocks);
 
 	const ITMLibSettings::DeviceType deviceType = settings->deviceType;
 
@@ -40,7 +43,7 @@ ITMBasicEngine<TVoxel,TIndex>::ITMBasicEngine(const ITMLibSettings *settings, co
 	denseMapper->ResetScene(scene);
 
 	imuCalibrator = new ITMIMUCalibrator_iPad();
-	tracker = ITMTrackerFactory::Instance().Make(imgSize_rgb, imgSize_d, settings, lowLevelEngine, imuCalibrator, scene->sceneParams);
+	tracker = ITMTrackerFactory().Make(imgSize_rgb, imgSize_d, settings, lowLevelEngine, imuCalibrator, scene->sceneParams);
 	trackingController = new ITMTrackingController(tracker, settings);
 
 	Vector2i trackedImageSize = trackingController->GetTrackedImageSize(imgSize_rgb, imgSize_d);
@@ -52,13 +55,25 @@ ITMBasicEngine<TVoxel,TIndex>::ITMBasicEngine(const ITMLibSettings *settings, co
 	tracker->UpdateInitialPose(trackingState);
 
 	view = NULL; // will be allocated by the view builder
-	
+	nextView = NULL;
+
+	// the view building of the next frame only overlaps the rest of the current one on the CPU
+	pipelineFrames = settings->pipelineFrames && deviceType == ITMLibSettings::DEVICE_CPU;
+	pendingSceneUpdate.isPending = false;
+
+	if (sharedTaskScheduler != NULL) taskScheduler = sharedTaskScheduler;
+	else if (deviceType != ITMLibSettings::DEVICE_CUDA) taskScheduler = new ORUtils::TaskScheduler(settings->noCPUThreads, settings->firstCPUCore);
+	else taskScheduler = NULL;
+	ownsTaskScheduler = sharedTaskScheduler == NULL;
+
 	if (settings->behaviourOnFailure == settings->FAILUREMODE_RELOCALISE)
 		relocaliser = new FernRelocLib::Relocaliser<float>(imgSize_d, Vector2f(settings->sceneParams.viewFrustum_min, settings->sceneParams.viewFrustum_max), 0.2f, 500, 4);
 	else relocaliser = NULL;
 
 	kfRaycast = new ITMUChar4Image(imgSize_d, memoryType);
 
+	statistics = new ITMEngineStatistics(settings->collectStatistics, deviceType == ITMLibSettings::DEVICE_CUDA);
+
 	trackingActive = true;
 	fusionActive = true;
 	mainProcessingActive = true;
@@ -86,6 +101,7 @@ ITMBasicEngine<TVoxel,TIndex>::~ITMBasicEngine()
 
 	delete trackingState;
 	if (view != NULL) delete view;
+	if (nextView != NULL) delete nextView;
 
 	delete visualisationEngine;
 
@@ -93,6 +109,9 @@ ITMBasicEngine<TVoxel,TIndex>::~ITMBasicEngine()
 	delete kfRaycast;
 
 	if (meshingEngine != NULL) delete meshingEngine;
+
+	delete statistics;
+	if (ownsTaskScheduler && taskScheduler != NULL) delete taskScheduler;
 }
 
 template <typename TVoxel, typename TIndex>
@@ -100,7 +119,11 @@ void ITMBasicEngine<TVoxel,TIndex>::SaveSceneToMesh(const char *objFileName)
 {
 	if (meshingEngine == NULL) return;
 
-	ITMMesh *mesh = new ITMMesh(settings->GetMemoryType());
+	ORUtils::TaskScheduler::Scope schedulerScope(taskScheduler);
+	UpdateScene();
+
+	// sized for the blocks the scene can hold rather than for SDF_LOCAL_BLOCK_NUM
+	ITMMesh *mesh = new ITMMesh(settings->GetMemoryType(), scene->index.getNumAllocatedVoxelBlocks() * ITMMesh::noMaxTrianglesPerBlock);
 
 	meshingEngine->MeshScene(mesh, scene);
 	mesh->WriteSTL(objFileName);
@@ -113,6 +136,9 @@ void ITMBasicEngine<TVoxel, TIndex>::SaveToFile()
 {
 	// throws error if any of the saves fail
 
+	ORUtils::TaskScheduler::Scope schedulerScope(taskScheduler);
+	UpdateScene();
+
 	std::string saveOutputDirectory = "State/";
 	std::string relocaliserOutputDirectory = saveOutputDirectory + "Relocaliser/", sceneOutputDirectory = saveOutputDirectory + "Scene/";
 	
@@ -134,6 +160,7 @@ void ITMBasicEngine<TVoxel, TIndex>::LoadFromFile()
 	////TODO: add factory for relocaliser and rebuild using config from relocaliserOutputDirectory + "config.txt"
 	////TODO: add proper management of case when scene load fails (keep old scene or also reset relocaliser)
 
+	ORUtils::TaskScheduler::Scope schedulerScope(taskScheduler);
 	this->resetAll();
 
 	try // load relocaliser
@@ -164,6 +191,11 @@ void ITMBasicEngine<TVoxel, TIndex>::LoadFromFile()
 template <typename TVoxel, typename TIndex>
 void ITMBasicEngine<TVoxel,TIndex>::resetAll()
 {
+	ORUtils::TaskScheduler::Scope schedulerScope(taskScheduler);
+
+	// as without pipelining, the last frame is in the scene until it is reset
+	UpdateScene();
+
 	denseMapper->ResetScene(scene);
 	trackingState->Reset();
 }
@@ -244,15 +276,48 @@ static void QuaternionFromRotationMatrix(const double *matrix, double *q) {
 template <typename TVoxel, typename TIndex>
 ITMTrackingState::TrackingResult ITMBasicEngine<TVoxel,TIndex>::ProcessFrame(ITMUChar4Image *rgbImage, ITMShortImage *rawDepthImage, ITMIMUMeasurement *imuMeasurement)
 {
-	// prepare image and turn it into a depth image
-	if (imuMeasurement == NULL) viewBuilder->UpdateView(&view, rgbImage, rawDepthImage, settings->useBilateralFilter);
-	else viewBuilder->UpdateView(&view, rgbImage, rawDepthImage, settings->useBilateralFilter, imuMeasurement);
+	ORUtils::TraceSpan frameSpan("ITMBasicEngine::ProcessFrame");
+	ORUtils::TaskScheduler::Scope schedulerScope(taskScheduler);
+	statistics->BeginFrame();
 
-	if (!mainProcessingActive) return ITMTrackingState::TRACKING_FAILED;
+	if (!pipelineFrames)
+	{
+		// prepare image and turn it into a depth image
+		BuildView(&view, rgbImage, rawDepthImage, imuMeasurement);
+	}
+	else
+	{
+		// With frame N arriving, the stages depend on each other as follows:
+		//   view building N              <- the input images of N
+		//   fusion and raycasting of N-1 <- tracking N-1, deferred from the previous call
+		//   tracking N                   <- view building N, raycasting of N-1
+		// so the first two run at the same time, on separate views, and the poses are those of the sequential schedule.
+#ifndef NO_CPP11
+		ORUtils::TaskGraph stages;
+		stages.AddTask([&]() { BuildView(&nextView, rgbImage, rawDepthImage, imuMeasurement); });
+		stages.AddTask([&]() { UpdateScene(); });
+		stages.Run(taskScheduler);
+#else
+		BuildView(&nextView, rgbImage, rawDepthImage, imuMeasurement);
+		UpdateScene();
+#endif
+
+		// the tracker's previous colour image is the one of the previous view, swapped in rather than copied
+		if (view != NULL && nextView->rgb_prev != NULL) nextView->rgb_prev->Swap(*view->rgb);
+		std::swap(view, nextView);
+	}
+
+	if (!mainProcessingActive) { statistics->EndFrame(); return ITMTrackingState::TRACKING_FAILED; }
 
 	// tracking
 	ORUtils::SE3Pose oldPose(*(trackingState->pose_d));
-	if (trackingActive) trackingController->Track(trackingState, view);
+	if (trackingActive)
+	{
+		ORUtils::TraceSpan span("tracking");
+		statistics->BeginStage(ITMEngineStatistics::STAGE_TRACKING);
+		trackingController->Track(trackingState, view);
+		statistics->EndStage(ITMEngineStatistics::STAGE_TRACKING);
+	}
 
 	ITMTrackingState::TrackingResult trackerResult = ITMTrackingState::TRACKING_GOOD;
 	switch (settings->behaviourOnFailure) {
@@ -269,9 +334,11 @@ ITMTrackingState::TrackingResult ITMBasicEngine<TVoxel,TIndex>::ProcessFrame(ITM
 	}
 
 	//relocalisation
-	int addKeyframeIdx = -1;
 	if (settings->behaviourOnFailure == ITMLibSettings::FAILUREMODE_RELOCALISE)
 	{
+		ORUtils::TraceSpan span("relocalisation");
+		statistics->BeginStage(ITMEngineStatistics::STAGE_RELOCALISATION);
+
 		if (trackerResult == ITMTrackingState::TRACKING_GOOD && relocalisationCount > 0) relocalisationCount--;
 
 		int NN; float distances;
@@ -297,34 +364,32 @@ ITMTrackingState::TrackingResult ITMBasicEngine<TVoxel,TIndex>::ProcessFrame(ITM
 
 			trackerResult = trackingState->trackerResult;
 		}
-	}
-
-	bool didFusion = false;
-	if ((trackerResult == ITMTrackingState::TRACKING_GOOD || !trackingInitialised) && (fusionActive) && (relocalisationCount == 0)) {
-		// fusion
-		denseMapper->ProcessFrame(view, trackingState, scene, renderState_live);
-		didFusion = true;
-		if (framesProcessed > 50) trackingInitialised = true;
 
-		framesProcessed++;
+		statistics->EndStage(ITMEngineStatistics::STAGE_RELOCALISATION);
 	}
 
-	if (trackerResult == ITMTrackingState::TRACKING_GOOD || trackerResult == ITMTrackingState::TRACKING_POOR)
+	if (statistics->IsEnabled() && trackingActive)
 	{
-		if (!didFusion) denseMapper->UpdateVisibleList(view, trackingState, scene, renderState_live);
+		statistics->SetTrackerIterations(trackingState->trackerIterations, trackingState->noTrackerLevels);
 
-		// raycast to renderState_live for tracking and free visualisation
-		trackingController->Prepare(trackingState, scene, view, visualisationEngine, renderState_live);
+		int noIterations = 0;
+		for (int i = 0; i < trackingState->noTrackerLevels; i++) noIterations += trackingState->trackerIterations[i];
+		statistics->SetCounter(ITMEngineStatistics::COUNTER_TRACKER_ITERATIONS, noIterations);
+		statistics->SetCounter(ITMEngineStatistics::COUNTER_TRACKING_POINTS, trackingState->noValidPoints);
+	}
 
-		if (addKeyframeIdx >= 0)
-		{
-			ORUtils::MemoryBlock<Vector4u>::MemoryCopyDirection memoryCopyDirection =
-				settings->deviceType == ITMLibSettings::DEVICE_CUDA ? ORUtils::MemoryBlock<Vector4u>::CUDA_TO_CUDA : ORUtils::MemoryBlock<Vector4u>::CPU_TO_CPU;
+	pendingSceneUpdate.isPending = true;
+	pendingSceneUpdate.doFusion = (trackerResult == ITMTrackingState::TRACKING_GOOD || !trackingInitialised) && (fusionActive) && (relocalisationCount == 0);
+	pendingSceneUpdate.doRaycast = trackerResult == ITMTrackingState::TRACKING_GOOD || trackerResult == ITMTrackingState::TRACKING_POOR;
 
-			kfRaycast->SetFrom(renderState_live->raycastImage, memoryCopyDirection);
-		}
+	// a discarded pose is still used for fusion, but the next frame is tracked from the previous pose
+	if (!pendingSceneUpdate.doRaycast)
+	{
+		pendingSceneUpdate.fusionPose.SetFrom(trackingState->pose_d);
+		*trackingState->pose_d = oldPose;
 	}
-	else *trackingState->pose_d = oldPose;
+
+	if (!pipelineFrames) UpdateScene();
 
 #ifdef OUTPUT_TRAJECTORY_QUATERNIONS
 	const ORUtils::SE3Pose *p = trackingState->pose_d;
@@ -337,10 +402,73 @@ ITMTrackingState::TrackingResult ITMBasicEngine<TVoxel,TIndex>::ProcessFrame(ITM
 	QuaternionFromRotationMatrix(R, q);
 	fprintf(stderr, "%f %f %f %f %f %f %f\n", t[0], t[1], t[2], q[1], q[2], q[3], q[0]);
 #endif
+
+	statistics->EndFrame();
     
     return trackerResult;
 }
 
+template <typename TVoxel, typename TIndex>
+void ITMBasicEngine<TVoxel,TIndex>::BuildView(ITMView **view, ITMUChar4Image *rgbImage, ITMShortImage *rawDepthImage, ITMIMUMeasurement *imuMeasurement)
+{
+	ORUtils::TraceSpan span("view building");
+	statistics->BeginStage(ITMEngineStatistics::STAGE_VIEW_BUILDING);
+	if (imuMeasurement == NULL) viewBuilder->UpdateView(view, rgbImage, rawDepthImage, settings->useBilateralFilter);
+	else viewBuilder->UpdateView(view, rgbImage, rawDepthImage, settings->useBilateralFilter, imuMeasurement);
+	statistics->EndStage(ITMEngineStatistics::STAGE_VIEW_BUILDING);
+}
+
+template <typename TVoxel, typename TIndex>
+void ITMBasicEngine<TVoxel,TIndex>::UpdateScene(void)
+{
+	if (!pendingSceneUpdate.isPending) return;
+	pendingSceneUpdate.isPending = false;
+
+	int addKeyframeIdx = -1;
+
+	// the frame is fused at its tracked pose, even if that was discarded for tracking the next frame
+	ORUtils::SE3Pose currentPose(*(trackingState->pose_d));
+	if (!pendingSceneUpdate.doRaycast) trackingState->pose_d->SetFrom(&pendingSceneUpdate.fusionPose);
+
+	bool didFusion = false;
+	if (pendingSceneUpdate.doFusion) {
+		// fusion
+		denseMapper->ProcessFrame(view, trackingState, scene, renderState_live, statistics);
+		didFusion = true;
+		if (framesProcessed > 50) trackingInitialised = true;
+
+		framesProcessed++;
+	}
+	else denseMapper->DefragmentScene(scene);
+
+	if (pendingSceneUpdate.doRaycast)
+	{
+		if (!didFusion)
+		{
+			statistics->BeginStage(ITMEngineStatistics::STAGE_ALLOCATION);
+			denseMapper->UpdateVisibleList(view, trackingState, scene, renderState_live);
+			statistics->EndStage(ITMEngineStatistics::STAGE_ALLOCATION);
+		}
+
+		// raycast to renderState_live for tracking and free visualisation
+		{
+			ORUtils::TraceSpan span("raycasting");
+			statistics->BeginStage(ITMEngineStatistics::STAGE_RAYCASTING);
+			trackingController->Prepare(trackingState, scene, view, visualisationEngine, renderState_live);
+			statistics->EndStage(ITMEngineStatistics::STAGE_RAYCASTING);
+		}
+
+		if (addKeyframeIdx >= 0)
+		{
+			ORUtils::MemoryBlock<Vector4u>::MemoryCopyDirection memoryCopyDirection =
+				settings->deviceType == ITMLibSettings::DEVICE_CUDA ? ORUtils::MemoryBlock<Vector4u>::CUDA_TO_CUDA : ORUtils::MemoryBlock<Vector4u>::CPU_TO_CPU;
+
+			kfRaycast->SetFrom(renderState_live->raycastImage, memoryCopyDirection);
+		}
+	}
+	else trackingState->pose_d->SetFrom(&currentPose);
+}
+
 template <typename TVoxel, typename TIndex>
 Vector2i ITMBasicEngine<TVoxel,TIndex>::GetImageSize(void) const
 {
@@ -352,6 +480,7 @@ void ITMBasicEngine<TVoxel,TIndex>::GetImage(ITMUChar4Image *out, GetImageType g
 {
 	if (view == NULL) return;
 
+	ORUtils::TaskScheduler::Scope schedulerScope(taskScheduler);
 	out->Clear();
 
 	switch (getImageType)
@@ -11,6 +11,7 @@
 #include "../Objects/Misc/ITMIMUCalibrator.h"
 
 #include "../../FernRelocLib/Relocaliser.h"
+#include "../../ORUtils/TaskScheduler.h"
 
 namespace ITMLib
 {
@@ -46,6 +47,10 @@ namespace ITMLib
 		/// Pointer to the current camera pose and additional tracking information
 		ITMTrackingState *trackingState;
 
+		/// Runs the CPU engines, installed on the calling thread by every public method that processes data, NULL on CUDA
+		ORUtils::TaskScheduler *taskScheduler;
+		bool ownsTaskScheduler;
+
 		static typename ITMSurfelVisualisationEngine<TSurfel>::RenderImageType ToSurfelImageType(GetImageType getImageType);
 
 	public:
@@ -84,8 +89,12 @@ namespace ITMLib
 		/** \brief Constructor
 			Omitting a separate image size for the depth images
 			will assume same resolution as for the RGB images.
+			If \p sharedTaskScheduler is not NULL, the CPU engines run
+			on it rather than on a scheduler of their own, so that
+			several main engines share one pool of threads. It is
+			owned by the caller.
 		*/
-		ITMBasicSurfelEngine(const ITMLibSettings *settings, const ITMRGBDCalib& calib, Vector2i imgSize_rgb, Vector2i imgSize_d = Vector2i(-1, -1));
+		ITMBasicSurfelEngine(const ITMLibSettings *settings, const ITMRGBDCalib& calib, Vector2i imgSize_rgb, Vector2i imgSize_d = Vector2i(-1, -1), ORUtils::TaskScheduler *sharedTaskScheduler = NULL);
 		~ITMBasicSurfelEngine();
 	};
 }
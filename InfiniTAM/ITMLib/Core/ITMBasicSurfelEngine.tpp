@@ -15,7 +15,7 @@
 using namespace ITMLib;
 
 template <typename TSurfel>
-ITMBasicSurfelEngine<TSurfel>::ITMBasicSurfelEngine(const ITMLibSettings *settings, const ITMRGBDCalib& calib, Vector2i imgSize_rgb, Vector2i imgSize_d)
+ITMBasicSurfelEngine<TSurfel>::ITMBasicSurfelEngine(const ITMLibSettings *settings, const ITMRGBDCalib& calib, Vector2i imgSize_rgb, Vector2i imgSize_d, ORUtils::TaskScheduler *sharedTaskScheduler)
 {
 	this->settings = settings;
 
@@ -34,7 +34,7 @@ ITMBasicSurfelEngine<TSurfel>::ITMBasicSurfelEngine(const ITMLibSettings *settin
 	this->surfelScene->Reset();
 
 	imuCalibrator = new ITMIMUCalibrator_iPad();
-	tracker = ITMTrackerFactory::Instance().Make(imgSize_rgb, imgSize_d, settings, lowLevelEngine, imuCalibrator, &settings->sceneParams);
+	tracker = ITMTrackerFactory().Make(imgSize_rgb, imgSize_d, settings, lowLevelEngine, imuCalibrator, &settings->sceneParams);
 	trackingController = new ITMTrackingController(tracker, settings);
 
 	Vector2i trackedImageSize = trackingController->GetTrackedImageSize(imgSize_rgb, imgSize_d);
@@ -53,6 +53,11 @@ ITMBasicSurfelEngine<TSurfel>::ITMBasicSurfelEngine(const ITMLibSettings *settin
 
 	kfRaycast = new ITMUChar4Image(imgSize_d, memoryType);
 
+	if (sharedTaskScheduler != NULL) taskScheduler = sharedTaskScheduler;
+	else if (deviceType != ITMLibSettings::DEVICE_CUDA) taskScheduler = new ORUtils::TaskScheduler(settings->noCPUThreads, settings->firstCPUCore);
+	else taskScheduler = NULL;
+	ownsTaskScheduler = sharedTaskScheduler == NULL;
+
 	trackingActive = true;
 	fusionActive = true;
 	mainProcessingActive = true;
@@ -85,6 +90,8 @@ ITMBasicSurfelEngine<TSurfel>::~ITMBasicSurfelEngine()
 
 	if (relocaliser != NULL) delete relocaliser;
 	delete kfRaycast;
+
+	if (ownsTaskScheduler && taskScheduler != NULL) delete taskScheduler;
 }
 
 template <typename TSurfel>
@@ -108,6 +115,8 @@ void ITMBasicSurfelEngine<TSurfel>::LoadFromFile()
 template <typename TSurfel>
 void ITMBasicSurfelEngine<TSurfel>::resetAll()
 {
+	ORUtils::TaskScheduler::Scope schedulerScope(taskScheduler);
+
 	surfelScene->Reset();
 	trackingState->Reset();
 }
@@ -188,6 +197,8 @@ static void QuaternionFromRotationMatrix(const double *matrix, double *q) {
 template <typename TSurfel>
 ITMTrackingState::TrackingResult ITMBasicSurfelEngine<TSurfel>::ProcessFrame(ITMUChar4Image *rgbImage, ITMShortImage *rawDepthImage, ITMIMUMeasurement *imuMeasurement)
 {
+	ORUtils::TaskScheduler::Scope schedulerScope(taskScheduler);
+
 	// prepare image and turn it into a depth image
 	if (imuMeasurement == NULL) viewBuilder->UpdateView(&view, rgbImage, rawDepthImage, settings->useBilateralFilter);
 	else viewBuilder->UpdateView(&view, rgbImage, rawDepthImage, settings->useBilateralFilter, imuMeasurement);
@@ -317,6 +328,7 @@ void ITMBasicSurfelEngine<TSurfel>::GetImage(ITMUChar4Image *out, GetImageType g
 {
 	if (view == NULL) return;
 
+	ORUtils::TaskScheduler::Scope schedulerScope(taskScheduler);
 	out->Clear();
 
 	switch (getImageType)
@@ -4,6 +4,7 @@
 
 #include "../Engines/Reconstruction/Interface/ITMSceneReconstructionEngine.h"
 #include "../Engines/Swapping/Interface/ITMSwappingEngine.h"
+#include "../Objects/Misc/ITMEngineStatistics.h"
 #include "../Utils/ITMLibSettings.h"
 
 namespace ITMLib
@@ -18,16 +19,25 @@ namespace ITMLib
 		ITMSwappingEngine<TVoxel,TIndex> *swappingEngine;
 
 		ITMLibSettings::SwappingMode swappingMode;
+		int maxDefragmentationSwaps;
+		int excessListReclaimBuckets;
+		float excessListReclaimThreshold;
+		float slidingWindowRadius;
+		int slidingWindowMaxBlocks;
 
 	public:
 		void ResetScene(ITMScene<TVoxel,TIndex> *scene) const;
 
-		/// Process a single frame
-		void ProcessFrame(const ITMView *view, const ITMTrackingState *trackingState, ITMScene<TVoxel,TIndex> *scene, ITMRenderState *renderState_live);
+		/// Process a single frame, timing the allocation, integration and swapping into \p statistics if given
+		void ProcessFrame(const ITMView *view, const ITMTrackingState *trackingState, ITMScene<TVoxel,TIndex> *scene, ITMRenderState *renderState_live,
+			ITMEngineStatistics *statistics = NULL);
 
 		/// Update the visible list (this can be called to update the visible list when fusion is turned off)
 		void UpdateVisibleList(const ITMView *view, const ITMTrackingState *trackingState, ITMScene<TVoxel, TIndex> *scene, ITMRenderState *renderState, bool resetVisibleList = false);
 
+		/// Move some voxel blocks towards Morton order in memory, for frames that are not fused
+		void DefragmentScene(ITMScene<TVoxel, TIndex> *scene) const;
+
 		/** \brief Constructor
 		    Ommitting a separate image size for the depth images
 		    will assume same resolution as for the RGB images.
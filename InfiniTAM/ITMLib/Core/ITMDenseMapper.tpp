@@ -5,8 +5,20 @@
 #include "../Engines/Reconstruction/ITMSceneReconstructionEngineFactory.h"
 #include "../Engines/Swapping/ITMSwappingEngineFactory.h"
 #include "../Objects/RenderStates/ITMRenderState_VH.h"
+#include "../../ORUtils/Trace.h"
 using namespace ITMLib;
 
+template<class TVoxel>
+static void RecordSceneCounters(ITMEngineStatistics *statistics, ITMScene<TVoxel, ITMVoxelBlockHash> *scene, const ITMRenderState *renderState)
+{
+	statistics->SetCounter(ITMEngineStatistics::COUNTER_VISIBLE_BLOCKS, ((const ITMRenderState_VH*)renderState)->noVisibleEntries);
+	statistics->SetCounter(ITMEngineStatistics::COUNTER_EXCESS_LIST_ENTRIES, SDF_EXCESS_LIST_SIZE - 1 - scene->index.GetLastFreeExcessListId());
+	statistics->SetCounter(ITMEngineStatistics::COUNTER_FREE_BLOCKS, scene->localVBA.lastFreeBlockId + 1);
+}
+
+template<class TVoxel>
+static void RecordSceneCounters(ITMEngineStatistics *statistics, ITMScene<TVoxel, ITMPlainVoxelArray> *scene, const ITMRenderState *renderState) {}
+
 template<class TVoxel, class TIndex>
 ITMDenseMapper<TVoxel, TIndex>::ITMDenseMapper(const ITMLibSettings *settings)
 {
@@ -14,6 +26,11 @@ ITMDenseMapper<TVoxel, TIndex>::ITMDenseMapper(const ITMLibSettings *settings)
 	swappingEngine = settings->swappingMode != ITMLibSettings::SWAPPINGMODE_DISABLED ? ITMSwappingEngineFactory::MakeSwappingEngine<TVoxel,TIndex>(settings->deviceType) : NULL;
 
 	swappingMode = settings->swappingMode;
+	maxDefragmentationSwaps = settings->maxDefragmentationSwaps;
+	excessListReclaimBuckets = settings->excessListReclaimBuckets;
+	excessListReclaimThreshold = settings->excessListReclaimThreshold;
+	slidingWindowRadius = settings->slidingWindowRadius;
+	slidingWindowMaxBlocks = settings->slidingWindowMaxBlocks;
 }
 
 template<class TVoxel, class TIndex>
@@ -30,17 +47,37 @@ void ITMDenseMapper<TVoxel,TIndex>::ResetScene(ITMScene<TVoxel,TIndex> *scene) c
 }
 
 template<class TVoxel, class TIndex>
-void ITMDenseMapper<TVoxel,TIndex>::ProcessFrame(const ITMView *view, const ITMTrackingState *trackingState, ITMScene<TVoxel,TIndex> *scene, ITMRenderState *renderState)
+void ITMDenseMapper<TVoxel,TIndex>::ProcessFrame(const ITMView *view, const ITMTrackingState *trackingState, ITMScene<TVoxel,TIndex> *scene, ITMRenderState *renderState,
+	ITMEngineStatistics *statistics)
 {
+	bool collectStatistics = statistics != NULL && statistics->IsEnabled();
+	int lastFreeBlockId = scene->localVBA.lastFreeBlockId;
+
 	// allocation
-	sceneRecoEngine->AllocateSceneFromDepth(scene, view, trackingState, renderState);
+	{
+		ORUtils::TraceSpan span("allocation");
+		if (collectStatistics) statistics->BeginStage(ITMEngineStatistics::STAGE_ALLOCATION);
+		sceneRecoEngine->AllocateSceneFromDepth(scene, view, trackingState, renderState);
+		if (collectStatistics) statistics->EndStage(ITMEngineStatistics::STAGE_ALLOCATION);
+	}
 
 	// integration
-	sceneRecoEngine->IntegrateIntoScene(scene, view, trackingState, renderState);
+	{
+		ORUtils::TraceSpan span("integration");
+		if (collectStatistics) statistics->BeginStage(ITMEngineStatistics::STAGE_INTEGRATION);
+		sceneRecoEngine->IntegrateIntoScene(scene, view, trackingState, renderState);
+		if (collectStatistics) statistics->EndStage(ITMEngineStatistics::STAGE_INTEGRATION);
+	}
+
+	if (collectStatistics) statistics->SetCounter(ITMEngineStatistics::COUNTER_ALLOCATED_BLOCKS, lastFreeBlockId - scene->localVBA.lastFreeBlockId);
 
 	if (swappingEngine != NULL) {
+		ORUtils::TraceSpan span("swapping");
+		if (collectStatistics) statistics->BeginStage(ITMEngineStatistics::STAGE_SWAPPING);
+
 		// swapping: CPU -> GPU
-		if (swappingMode == ITMLibSettings::SWAPPINGMODE_ENABLED) swappingEngine->IntegrateGlobalIntoLocal(scene, renderState);
+		if (swappingMode == ITMLibSettings::SWAPPINGMODE_ENABLED || swappingMode == ITMLibSettings::SWAPPINGMODE_SLIDING_WINDOW)
+			swappingEngine->IntegrateGlobalIntoLocal(scene, renderState);
 
 		// swapping: GPU -> CPU
 		switch (swappingMode)
@@ -50,15 +87,44 @@ void ITMDenseMapper<TVoxel,TIndex>::ProcessFrame(const ITMView *view, const ITMT
 			break;
 		case ITMLibSettings::SWAPPINGMODE_DELETE:
 			swappingEngine->CleanLocalMemory(scene, renderState);
+			sceneRecoEngine->ReclaimExcessEntries(scene, excessListReclaimBuckets, excessListReclaimThreshold);
+			break;
+		case ITMLibSettings::SWAPPINGMODE_SLIDING_WINDOW:
+		{
+			Matrix4f invM_d = trackingState->pose_d->GetInvM();
+			Vector3f cameraCentre(invM_d.m[12], invM_d.m[13], invM_d.m[14]);
+
+			swappingEngine->SaveDistantToGlobalMemory(scene, renderState, cameraCentre, slidingWindowRadius, slidingWindowMaxBlocks);
+			sceneRecoEngine->ReclaimExcessEntries(scene, excessListReclaimBuckets, excessListReclaimThreshold);
 			break;
+		}
 		case ITMLibSettings::SWAPPINGMODE_DISABLED:
 			break;
 		} 
+
+		if (collectStatistics)
+		{
+			statistics->EndStage(ITMEngineStatistics::STAGE_SWAPPING);
+			statistics->SetCounter(ITMEngineStatistics::COUNTER_SWAPPED_IN_BLOCKS, swappingEngine->GetNoSwappedInBlocks());
+			statistics->SetCounter(ITMEngineStatistics::COUNTER_SWAPPED_OUT_BLOCKS, swappingEngine->GetNoSwappedOutBlocks());
+		}
 	}
+
+	if (collectStatistics) RecordSceneCounters(statistics, scene, renderState);
 }
 
 template<class TVoxel, class TIndex>
 void ITMDenseMapper<TVoxel,TIndex>::UpdateVisibleList(const ITMView *view, const ITMTrackingState *trackingState, ITMScene<TVoxel,TIndex> *scene, ITMRenderState *renderState, bool resetVisibleList)
 {
+	ORUtils::TraceSpan span("visible list update");
 	sceneRecoEngine->AllocateSceneFromDepth(scene, view, trackingState, renderState, true, resetVisibleList);
 }
+
+template<class TVoxel, class TIndex>
+void ITMDenseMapper<TVoxel,TIndex>::DefragmentScene(ITMScene<TVoxel,TIndex> *scene) const
+{
+	if (maxDefragmentationSwaps <= 0) return;
+
+	ORUtils::TraceSpan span("defragmentation");
+	sceneRecoEngine->DefragmentScene(scene, maxDefragmentationSwaps);
+}
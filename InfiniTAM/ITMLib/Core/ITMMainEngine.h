@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include "../Objects/Misc/ITMEngineStatistics.h"
 #include "../Objects/Misc/ITMIMUMeasurement.h"
 #include "../Trackers/Interface/ITMTracker.h"
 #include "../Utils/ITMLibSettings.h"
@@ -79,6 +80,10 @@ namespace ITMLib
 		/// Extracts a mesh from the current scene and saves it to the model file specified by the file name
 		virtual void SaveSceneToMesh(const char *fileName) { };
 
+		/// Timings of the processing stages and internal counters of the recent frames, NULL if the engine does not collect them.
+		/// Collection is turned on with ITMLibSettings::collectStatistics.
+		virtual const ITMEngineStatistics* GetStatistics(void) const { return NULL; }
+
 		/// save and load the full scene and relocaliser (if any) to/from file
 		virtual void SaveToFile() { };
 		virtual void LoadFromFile() { };
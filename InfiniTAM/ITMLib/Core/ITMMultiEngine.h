@@ -8,6 +8,7 @@
 #include "../Engines/ViewBuilding/Interface/ITMViewBuilder.h"
 #include "../Objects/Misc/ITMIMUCalibrator.h"
 #include "../../FernRelocLib/Relocaliser.h"
+#include "../../ORUtils/TaskScheduler.h"
 
 #include "../Engines/MultiScene/ITMActiveMapManager.h"
 #include "../Engines/MultiScene/ITMGlobalAdjustmentEngine.h"
@@ -52,6 +53,11 @@ namespace ITMLib
 
 		/// Pointer for storing the current input frame
 		ITMView *view;
+
+		/// Runs the CPU engines, installed on the calling thread by every public method that processes data, NULL on CUDA
+		ORUtils::TaskScheduler *taskScheduler;
+		bool ownsTaskScheduler;
+
 	public:
 		ITMView* GetView() { return view; }
 
@@ -92,8 +98,12 @@ namespace ITMLib
 		/** \brief Constructor
 			Ommitting a separate image size for the depth images
 			will assume same resolution as for the RGB images.
+			If \p sharedTaskScheduler is not NULL, the CPU engines run
+			on it rather than on a scheduler of their own, so that
+			several main engines share one pool of threads. It is
+			owned by the caller.
 		*/
-		ITMMultiEngine(const ITMLibSettings *settings, const ITMRGBDCalib &calib, Vector2i imgSize_rgb, Vector2i imgSize_d = Vector2i(-1, -1));
+		ITMMultiEngine(const ITMLibSettings *settings, const ITMRGBDCalib &calib, Vector2i imgSize_rgb, Vector2i imgSize_d = Vector2i(-1, -1), ORUtils::TaskScheduler *sharedTaskScheduler = NULL);
 		~ITMMultiEngine(void);
 	};
 }
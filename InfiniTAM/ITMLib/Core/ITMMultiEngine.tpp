@@ -9,6 +9,7 @@
 #include "../Trackers/ITMTrackerFactory.h"
 
 #include "../../MiniSlamGraphLib/QuaternionHelpers.h"
+#include "../../ORUtils/Trace.h"
 
 using namespace ITMLib;
 
@@ -24,7 +25,7 @@ static const float F_maxdistattemptreloc = 0.05f;
 static const bool separateThreadGlobalAdjustment = true;
 
 template <typename TVoxel, typename TIndex>
-ITMMultiEngine<TVoxel, TIndex>::ITMMultiEngine(const ITMLibSettings *settings, const ITMRGBDCalib& calib, Vector2i imgSize_rgb, Vector2i imgSize_d)
+ITMMultiEngine<TVoxel, TIndex>::ITMMultiEngine(const ITMLibSettings *settings, const ITMRGBDCalib& calib, Vector2i imgSize_rgb, Vector2i imgSize_d, ORUtils::TaskScheduler *sharedTaskScheduler)
 {
 	if ((imgSize_d.x == -1) || (imgSize_d.y == -1)) imgSize_d = imgSize_rgb;
 
@@ -44,7 +45,7 @@ ITMMultiEngine<TVoxel, TIndex>::ITMMultiEngine(const ITMLibSettings *settings, c
 	denseMapper = new ITMDenseMapper<TVoxel, TIndex>(settings);
 
 	imuCalibrator = new ITMIMUCalibrator_iPad();
-	tracker = ITMTrackerFactory::Instance().Make(imgSize_rgb, imgSize_d, settings, lowLevelEngine, imuCalibrator, &settings->sceneParams);
+	tracker = ITMTrackerFactory().Make(imgSize_rgb, imgSize_d, settings, lowLevelEngine, imuCalibrator, &settings->sceneParams);
 	trackingController = new ITMTrackingController(tracker, settings);
 	trackedImageSize = trackingController->GetTrackedImageSize(imgSize_rgb, imgSize_d);
 
@@ -65,6 +66,11 @@ ITMMultiEngine<TVoxel, TIndex>::ITMMultiEngine(const ITMLibSettings *settings, c
 
 	multiVisualisationEngine = ITMMultiVisualisationEngineFactory::MakeVisualisationEngine<TVoxel,TIndex>(deviceType);
 	renderState_multiscene = NULL;
+
+	if (sharedTaskScheduler != NULL) taskScheduler = sharedTaskScheduler;
+	else if (deviceType != ITMLibSettings::DEVICE_CUDA) taskScheduler = new ORUtils::TaskScheduler(settings->noCPUThreads, settings->firstCPUCore);
+	else taskScheduler = NULL;
+	ownsTaskScheduler = sharedTaskScheduler == NULL;
 }
 
 template <typename TVoxel, typename TIndex>
@@ -94,6 +100,8 @@ ITMMultiEngine<TVoxel, TIndex>::~ITMMultiEngine(void)
 	delete relocaliser;
 
 	delete multiVisualisationEngine;
+
+	if (ownsTaskScheduler && taskScheduler != NULL) delete taskScheduler;
 }
 
 template <typename TVoxel, typename TIndex>
@@ -143,12 +151,18 @@ struct TodoListEntry {
 template <typename TVoxel, typename TIndex>
 ITMTrackingState::TrackingResult ITMMultiEngine<TVoxel, TIndex>::ProcessFrame(ITMUChar4Image *rgbImage, ITMShortImage *rawDepthImage, ITMIMUMeasurement *imuMeasurement)
 {
+	ORUtils::TraceSpan frameSpan("ITMMultiEngine::ProcessFrame");
+	ORUtils::TaskScheduler::Scope schedulerScope(taskScheduler);
+
 	std::vector<TodoListEntry> todoList;
 	ITMTrackingState::TrackingResult primaryLocalMapTrackingResult;
 
 	// prepare image and turn it into a depth image
-	if (imuMeasurement == NULL) viewBuilder->UpdateView(&view, rgbImage, rawDepthImage, settings->useBilateralFilter);
-	else viewBuilder->UpdateView(&view, rgbImage, rawDepthImage, settings->useBilateralFilter, imuMeasurement);
+	{
+		ORUtils::TraceSpan span("view building");
+		if (imuMeasurement == NULL) viewBuilder->UpdateView(&view, rgbImage, rawDepthImage, settings->useBilateralFilter);
+		else viewBuilder->UpdateView(&view, rgbImage, rawDepthImage, settings->useBilateralFilter, imuMeasurement);
+	}
 
 	// find primary data, if available
 	int primaryDataIdx = mActiveDataManager->findPrimaryDataIdx();
@@ -181,6 +195,7 @@ ITMTrackingState::TrackingResult ITMMultiEngine<TVoxel, TIndex>::ProcessFrame(IT
 
 		if (todoList[i].dataId == -1)
 		{
+			ORUtils::TraceSpan span("relocalisation");
 #ifdef DEBUG_MULTISCENE
 			fprintf(stderr, " Reloc(%i)", primaryTrackingSuccess);
 #endif
@@ -222,12 +237,14 @@ ITMTrackingState::TrackingResult ITMMultiEngine<TVoxel, TIndex>::ProcessFrame(IT
 		// if a new relocalisation/loopclosure is started, this will do the initial raycasting before tracking can start
 		if (todoList[i].preprepare) 
 		{
+			ORUtils::TraceSpan span("raycasting");
 			denseMapper->UpdateVisibleList(view, currentLocalMap->trackingState, currentLocalMap->scene, currentLocalMap->renderState);
 			trackingController->Prepare(currentLocalMap->trackingState, currentLocalMap->scene, view, visualisationEngine, currentLocalMap->renderState);
 		}
 
 		if (todoList[i].track)
 		{
+			ORUtils::TraceSpan span("tracking");
 			int dataId = todoList[i].dataId;
 
 #ifdef DEBUG_MULTISCENE
@@ -277,13 +294,18 @@ ITMTrackingState::TrackingResult ITMMultiEngine<TVoxel, TIndex>::ProcessFrame(IT
 		else if (todoList[i].prepare) denseMapper->UpdateVisibleList(view, currentLocalMap->trackingState, currentLocalMap->scene, currentLocalMap->renderState);
 
 		// raycast to renderState_live for tracking and free visualisation
-		if (todoList[i].prepare) trackingController->Prepare(currentLocalMap->trackingState, currentLocalMap->scene, view, visualisationEngine, currentLocalMap->renderState);
+		if (todoList[i].prepare)
+		{
+			ORUtils::TraceSpan span("raycasting");
+			trackingController->Prepare(currentLocalMap->trackingState, currentLocalMap->scene, view, visualisationEngine, currentLocalMap->renderState);
+		}
 	}
 
 	mScheduleGlobalAdjustment |= mActiveDataManager->maintainActiveData();
 
 	if (mScheduleGlobalAdjustment) 
 	{
+		ORUtils::TraceSpan span("global adjustment scheduling");
 		if (mGlobalAdjustmentEngine->updateMeasurements(*mapManager)) 
 		{
 			if (separateThreadGlobalAdjustment) mGlobalAdjustmentEngine->wakeupSeparateThread();
@@ -302,6 +324,7 @@ void ITMMultiEngine<TVoxel, TIndex>::SaveSceneToMesh(const char *modelFileName)
 {
 	if (meshingEngine == NULL) return;
 
+	ORUtils::TaskScheduler::Scope schedulerScope(taskScheduler);
 	ITMMesh *mesh = new ITMMesh(settings->GetMemoryType());
 
 	meshingEngine->MeshScene(mesh, *mapManager);
@@ -333,6 +356,7 @@ void ITMMultiEngine<TVoxel, TIndex>::GetImage(ITMUChar4Image *out, GetImageType
 {
 	if (view == NULL) return;
 
+	ORUtils::TaskScheduler::Scope schedulerScope(taskScheduler);
 	out->Clear();
 
 	switch (getImageType)
@@ -86,7 +86,7 @@ namespace ITMLib
 
 				if (requiresFullRendering)
 				{
-					visualisationEngine->CreateICPMaps(scene, view, trackingState, renderState);
+					visualisationEngine->CreateICPMaps(scene, view, trackingState, renderState, settings->icpNormalsMode);
 					trackingState->pose_pointCloud->SetFrom(trackingState->pose_d);
 					if (trackingState->age_pointCloud==-1) trackingState->age_pointCloud=-2;
 					else trackingState->age_pointCloud = 0;
@@ -3,6 +3,7 @@
 #include "ITMLowLevelEngine_CPU.h"
 
 #include "../Shared/ITMLowLevelEngine_Shared.h"
+#include "../../../../ORUtils/TaskScheduler.h"
 
 using namespace ITMLib;
 
@@ -41,8 +42,11 @@ void ITMLowLevelEngine_CPU::ConvertColourToIntensity(ITMFloatImage *image_out, c
 	float *dest = image_out->GetData(MEMORYDEVICE_CPU);
 	const Vector4u *src = image_in->GetData(MEMORYDEVICE_CPU);
 
-	for (int y = 0; y < dims.y; y++) for (int x = 0; x < dims.x; x++)
-		convertColourToIntensity(dest, x, y, dims, src);
+	ORUtils::ParallelFor(0, dims.y, [&](int y)
+	{
+		for (int x = 0; x < dims.x; x++)
+			convertColourToIntensity(dest, x, y, dims, src);
+	});
 }
 
 void ITMLowLevelEngine_CPU::FilterIntensity(ITMFloatImage *image_out, const ITMFloatImage *image_in) const
@@ -55,8 +59,11 @@ void ITMLowLevelEngine_CPU::FilterIntensity(ITMFloatImage *image_out, const ITMF
 	const float *imageData_in = image_in->GetData(MEMORYDEVICE_CPU);
 	float *imageData_out = image_out->GetData(MEMORYDEVICE_CPU);
 
-	for (int y = 2; y < dims.y - 2; y++) for (int x = 2; x < dims.x - 2; x++)
-		boxFilter2x2(imageData_out, x, y, dims, imageData_in, x, y, dims);
+	ORUtils::ParallelFor(2, dims.y - 2, [&](int y)
+	{
+		for (int x = 2; x < dims.x - 2; x++)
+			boxFilter2x2(imageData_out, x, y, dims, imageData_in, x, y, dims);
+	});
 }
 
 void ITMLowLevelEngine_CPU::FilterSubsample(ITMUChar4Image *image_out, const ITMUChar4Image *image_in) const
@@ -69,8 +76,11 @@ void ITMLowLevelEngine_CPU::FilterSubsample(ITMUChar4Image *image_out, const ITM
 	const Vector4u *imageData_in = image_in->GetData(MEMORYDEVICE_CPU);
 	Vector4u *imageData_out = image_out->GetData(MEMORYDEVICE_CPU);
 
-	for (int y = 0; y < newDims.y; y++) for (int x = 0; x < newDims.x; x++)
-		filterSubsample(imageData_out, x, y, newDims, imageData_in, oldDims);
+	ORUtils::ParallelFor(0, newDims.y, [&](int y)
+	{
+		for (int x = 0; x < newDims.x; x++)
+			filterSubsample(imageData_out, x, y, newDims, imageData_in, oldDims);
+	});
 }
 
 void ITMLowLevelEngine_CPU::FilterSubsample(ITMFloatImage *image_out, const ITMFloatImage *image_in) const
@@ -84,8 +94,11 @@ void ITMLowLevelEngine_CPU::FilterSubsample(ITMFloatImage *image_out, const ITMF
 	const float *imageData_in = image_in->GetData(MEMORYDEVICE_CPU);
 	float *imageData_out = image_out->GetData(MEMORYDEVICE_CPU);
 
-	for (int y = 1; y < newDims.y - 1; y++) for (int x = 1; x < newDims.x - 1; x++)
-		boxFilter2x2(imageData_out, x, y, newDims, imageData_in, x * 2, y * 2, oldDims);
+	ORUtils::ParallelFor(1, newDims.y - 1, [&](int y)
+	{
+		for (int x = 1; x < newDims.x - 1; x++)
+			boxFilter2x2(imageData_out, x, y, newDims, imageData_in, x * 2, y * 2, oldDims);
+	});
 }
 
 void ITMLowLevelEngine_CPU::FilterSubsampleWithHoles(ITMFloatImage *image_out, const ITMFloatImage *image_in) const
@@ -98,8 +111,11 @@ void ITMLowLevelEngine_CPU::FilterSubsampleWithHoles(ITMFloatImage *image_out, c
 	const float *imageData_in = image_in->GetData(MEMORYDEVICE_CPU);
 	float *imageData_out = image_out->GetData(MEMORYDEVICE_CPU);
 
-	for (int y = 0; y < newDims.y; y++) for (int x = 0; x < newDims.x; x++)
-		filterSubsampleWithHoles(imageData_out, x, y, newDims, imageData_in, oldDims);
+	ORUtils::ParallelFor(0, newDims.y, [&](int y)
+	{
+		for (int x = 0; x < newDims.x; x++)
+			filterSubsampleWithHoles(imageData_out, x, y, newDims, imageData_in, oldDims);
+	});
 }
 
 void ITMLowLevelEngine_CPU::FilterSubsampleWithHoles(ITMFloat4Image *image_out, const ITMFloat4Image *image_in) const
@@ -112,8 +128,11 @@ void ITMLowLevelEngine_CPU::FilterSubsampleWithHoles(ITMFloat4Image *image_out,
 	const Vector4f *imageData_in = image_in->GetData(MEMORYDEVICE_CPU);
 	Vector4f *imageData_out = image_out->GetData(MEMORYDEVICE_CPU);
 
-	for (int y = 0; y < newDims.y; y++) for (int x = 0; x < newDims.x; x++)
-		filterSubsampleWithHoles(imageData_out, x, y, newDims, imageData_in, oldDims);
+	ORUtils::ParallelFor(0, newDims.y, [&](int y)
+	{
+		for (int x = 0; x < newDims.x; x++)
+			filterSubsampleWithHoles(imageData_out, x, y, newDims, imageData_in, oldDims);
+	});
 }
 
 void ITMLowLevelEngine_CPU::GradientX(ITMShort4Image *grad_out, const ITMUChar4Image *image_in) const
@@ -126,8 +145,11 @@ void ITMLowLevelEngine_CPU::GradientX(ITMShort4Image *grad_out, const ITMUChar4I
 
 	memset(grad, 0, imgSize.x * imgSize.y * sizeof(Vector4s));
 
-	for (int y = 1; y < imgSize.y - 1; y++) for (int x = 1; x < imgSize.x - 1; x++)
-		gradientX(grad, x, y, image, imgSize);
+	ORUtils::ParallelFor(1, imgSize.y - 1, [&](int y)
+	{
+		for (int x = 1; x < imgSize.x - 1; x++)
+			gradientX(grad, x, y, image, imgSize);
+	});
 }
 
 void ITMLowLevelEngine_CPU::GradientY(ITMShort4Image *grad_out, const ITMUChar4Image *image_in) const
@@ -140,8 +162,11 @@ void ITMLowLevelEngine_CPU::GradientY(ITMShort4Image *grad_out, const ITMUChar4I
 
 	memset(grad, 0, imgSize.x * imgSize.y * sizeof(Vector4s));
 
-	for (int y = 1; y < imgSize.y - 1; y++) for (int x = 1; x < imgSize.x - 1; x++)
-		gradientY(grad, x, y, image, imgSize);
+	ORUtils::ParallelFor(1, imgSize.y - 1, [&](int y)
+	{
+		for (int x = 1; x < imgSize.x - 1; x++)
+			gradientY(grad, x, y, image, imgSize);
+	});
 }
 
 void ITMLowLevelEngine_CPU::GradientXY(ITMFloat2Image *grad_out, const ITMFloatImage *image_in) const
@@ -153,16 +178,23 @@ void ITMLowLevelEngine_CPU::GradientXY(ITMFloat2Image *grad_out, const ITMFloatI
 	Vector2f *grad = grad_out->GetData(MEMORYDEVICE_CPU);
 	const float *image = image_in->GetData(MEMORYDEVICE_CPU);
 
-	for (int y = 1; y < imgSize.y - 1; y++) for (int x = 1; x < imgSize.x - 1; x++)
-		gradientXY(grad, x, y, image, imgSize);
+	ORUtils::ParallelFor(1, imgSize.y - 1, [&](int y)
+	{
+		for (int x = 1; x < imgSize.x - 1; x++)
+			gradientXY(grad, x, y, image, imgSize);
+	});
 }
 
 int ITMLowLevelEngine_CPU::CountValidDepths(const ITMFloatImage *image_in) const
 {
-	int noValidPoints = 0;
 	const float *imageData_in = image_in->GetData(MEMORYDEVICE_CPU);
 
-	for (int i = 0; i < image_in->noDims.x * image_in->noDims.y; ++i) if (imageData_in[i] > 0.0) noValidPoints++;
-
-	return noValidPoints;
+	return ORUtils::ParallelReduce(0, image_in->noDims.x * image_in->noDims.y, 1 << 14, 0,
+		[&](int begin, int end)
+		{
+			int noValidPoints = 0;
+			for (int i = begin; i < end; ++i) if (imageData_in[i] > 0.0) noValidPoints++;
+			return noValidPoints;
+		},
+		[](int a, int b) { return a + b; });
 }
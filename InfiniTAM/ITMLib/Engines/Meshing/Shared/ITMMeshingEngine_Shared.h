@@ -153,39 +153,20 @@ template<class TVoxel>
 _CPU_AND_GPU_CODE_ inline bool findPointNeighbors(THREADPTR(Vector3f) *p, THREADPTR(float) *sdf, Vector3i blockLocation, const CONSTPTR(TVoxel) *localVBA, 
 	const CONSTPTR(ITMHashEntry) *hashTable)
 {
-	int vmIndex; Vector3i localBlockLocation;
-
-	localBlockLocation = blockLocation + Vector3i(0, 0, 0); p[0] = localBlockLocation.toFloat();
-	sdf[0] = TVoxel::valueToFloat(readVoxel(localVBA, hashTable, localBlockLocation, vmIndex).sdf);
-	if (!vmIndex || sdf[0] == 1.0f) return false;
-
-	localBlockLocation = blockLocation + Vector3i(1, 0, 0); p[1] = localBlockLocation.toFloat();
-	sdf[1] = TVoxel::valueToFloat(readVoxel(localVBA, hashTable, localBlockLocation, vmIndex).sdf);
-	if (!vmIndex || sdf[1] == 1.0f) return false;
-
-	localBlockLocation = blockLocation + Vector3i(1, 1, 0); p[2] = localBlockLocation.toFloat();
-	sdf[2] = TVoxel::valueToFloat(readVoxel(localVBA, hashTable, localBlockLocation, vmIndex).sdf);
-	if (!vmIndex || sdf[2] == 1.0f) return false;
-
-	localBlockLocation = blockLocation + Vector3i(0, 1, 0); p[3] = localBlockLocation.toFloat();
-	sdf[3] = TVoxel::valueToFloat(readVoxel(localVBA, hashTable, localBlockLocation, vmIndex).sdf);
-	if (!vmIndex || sdf[3] == 1.0f) return false;
-
-	localBlockLocation = blockLocation + Vector3i(0, 0, 1); p[4] = localBlockLocation.toFloat();
-	sdf[4] = TVoxel::valueToFloat(readVoxel(localVBA, hashTable, localBlockLocation, vmIndex).sdf);
-	if (!vmIndex || sdf[4] == 1.0f) return false;
-
-	localBlockLocation = blockLocation + Vector3i(1, 0, 1); p[5] = localBlockLocation.toFloat();
-	sdf[5] = TVoxel::valueToFloat(readVoxel(localVBA, hashTable, localBlockLocation, vmIndex).sdf);
-	if (!vmIndex || sdf[5] == 1.0f) return false;
-
-	localBlockLocation = blockLocation + Vector3i(1, 1, 1); p[6] = localBlockLocation.toFloat();
-	sdf[6] = TVoxel::valueToFloat(readVoxel(localVBA, hashTable, localBlockLocation, vmIndex).sdf);
-	if (!vmIndex || sdf[6] == 1.0f) return false;
-
-	localBlockLocation = blockLocation + Vector3i(0, 1, 1); p[7] = localBlockLocation.toFloat();
-	sdf[7] = TVoxel::valueToFloat(readVoxel(localVBA, hashTable, localBlockLocation, vmIndex).sdf);
-	if (!vmIndex || sdf[7] == 1.0f) return false;
+	// marching cubes corner order, as index into the readVoxelCorners layout
+	const int cornerOrder[8] = { 0, 1, 3, 2, 4, 5, 7, 6 };
+
+	ITMLib::ITMVoxelBlockHash::IndexCache cache;
+	TVoxel corners[8];
+	if (readVoxelCorners(corners, localVBA, hashTable, blockLocation, cache) != 0xff) return false;
+
+	for (int i = 0; i < 8; i++)
+	{
+		int c = cornerOrder[i];
+		p[i] = (blockLocation + Vector3i(c & 1, (c >> 1) & 1, (c >> 2) & 1)).toFloat();
+		sdf[i] = TVoxel::valueToFloat(corners[c].sdf);
+		if (sdf[i] == 1.0f) return false;
+	}
 
 	return true;
 }
@@ -6,6 +6,7 @@
 #include "../../../MiniSlamGraphLib/GraphEdgeSE3.h"
 #include "../../../MiniSlamGraphLib/SlamGraphErrorFunction.h"
 #include "../../../MiniSlamGraphLib/LevenbergMarquardtMethod.h"
+#include "../../../ORUtils/Trace.h"
 
 #ifndef NO_CPP11
 #include <mutex>
@@ -99,6 +100,8 @@ bool ITMGlobalAdjustmentEngine::runGlobalAdjustment(bool blockingWait)
 	if (blockingWait) privateData->workingData_mutex.lock();
 	else if (!privateData->workingData_mutex.try_lock()) return false;
 
+	ORUtils::TraceSpan span("global adjustment");
+
 	// now run the actual global adjustment
 	workingData->prepareEvaluations();
 	MiniSlamGraph::SlamGraphErrorFunction errf(*workingData);
@@ -143,6 +146,8 @@ bool ITMGlobalAdjustmentEngine::stopSeparateThread(void)
 void ITMGlobalAdjustmentEngine::estimationThreadMain(void)
 {
 #ifndef NO_CPP11
+	ORUtils::TraceRecorder::SetThreadName("global adjustment");
+
 	while (!privateData->stopThread)
 	{
 		runGlobalAdjustment(true);
@@ -17,6 +17,9 @@ namespace ITMLib
 	protected:
 		ORUtils::MemoryBlock<unsigned char> *entriesAllocType;
 		ORUtils::MemoryBlock<Vector4s> *blockCoords;
+		/// per voxel block, how many frames in a row it was left out by the integration budget
+		ORUtils::MemoryBlock<unsigned char> *deferredFrames;
+		int nextReclaimBucket;
 
 	public:
 		void ResetScene(ITMScene<TVoxel, ITMVoxelBlockHash> *scene);
@@ -27,6 +30,10 @@ namespace ITMLib
 		void IntegrateIntoScene(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, const ITMView *view, const ITMTrackingState *trackingState,
 			const ITMRenderState *renderState);
 
+		void DefragmentScene(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, int maxSwaps);
+
+		void ReclaimExcessEntries(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, int noBuckets, float sweepThreshold);
+
 		ITMSceneReconstructionEngine_CPU(void);
 		~ITMSceneReconstructionEngine_CPU(void);
 	};
@@ -43,6 +50,10 @@ namespace ITMLib
 		void IntegrateIntoScene(ITMScene<TVoxel, ITMPlainVoxelArray> *scene, const ITMView *view, const ITMTrackingState *trackingState,
 			const ITMRenderState *renderState);
 
+		void DefragmentScene(ITMScene<TVoxel, ITMPlainVoxelArray> *scene, int maxSwaps);
+
+		void ReclaimExcessEntries(ITMScene<TVoxel, ITMPlainVoxelArray> *scene, int noBuckets, float sweepThreshold);
+
 		ITMSceneReconstructionEngine_CPU(void);
 		~ITMSceneReconstructionEngine_CPU(void);
 	};
@@ -4,14 +4,363 @@
 
 #include "../Shared/ITMSceneReconstructionEngine_Shared.h"
 #include "../../../Objects/RenderStates/ITMRenderState_VH.h"
+#include "../../../../ORUtils/TaskScheduler.h"
+
+#if defined(__AVX2__) && (SDF_BLOCK_SIZE == 8)
+#include <immintrin.h>
+#define SDF_INTEGRATE_AVX2
+#endif
+
 using namespace ITMLib;
 
+namespace
+{
+	/** Integrates the SDF_BLOCK_SIZE voxels of row (y, z) of a voxel block one at a time. */
+	template<bool hasConfidence, class TVoxel>
+	struct IntegrateVoxelRow_CPU
+	{
+		static void integrate(TVoxel *localVoxelBlock, const Vector3i & globalPos, int y, int z, float voxelSize,
+			const Matrix4f & M_d, const Vector4f & projParams_d, const Matrix4f & M_rgb, const Vector4f & projParams_rgb,
+			float mu, int maxW, bool stopIntegratingAtMaxW, const float *depth, const float *confidence, const Vector2i & depthImgSize,
+			const Vector4u *rgb, const Vector2i & rgbImgSize)
+		{
+			for (int x = 0; x < SDF_BLOCK_SIZE; x++)
+			{
+				Vector4f pt_model; int locId;
+
+				locId = x + y * SDF_BLOCK_SIZE + z * SDF_BLOCK_SIZE * SDF_BLOCK_SIZE;
+
+				TVoxel voxel = loadVoxel(localVoxelBlock, locId);
+
+				if (stopIntegratingAtMaxW) if (voxel.w_depth == maxW) continue;
+
+				pt_model.x = (float)(globalPos.x + x) * voxelSize;
+				pt_model.y = (float)(globalPos.y + y) * voxelSize;
+				pt_model.z = (float)(globalPos.z + z) * voxelSize;
+				pt_model.w = 1.0f;
+
+				ComputeUpdatedVoxelInfo<TVoxel::hasColorInformation, TVoxel::hasConfidenceInformation, TVoxel>::compute(voxel, pt_model, M_d,
+					projParams_d, M_rgb, projParams_rgb, mu, maxW, depth, confidence, depthImgSize, rgb, rgbImgSize);
+
+				storeVoxel(localVoxelBlock, locId, voxel);
+			}
+		}
+	};
+
+#ifdef SDF_INTEGRATE_AVX2
+	/** Reads and writes the sdf values (as floats) and depth weights of
+	    the eight voxels of a row. This version goes through loadVoxel and
+	    storeVoxel one voxel at a time, the specialisations below access
+	    the whole row at once. Only the lanes set in @p update are written.
+	*/
+	template<class TVoxel>
+	struct VoxelRowAVX2
+	{
+		static void load(const TVoxel *localVoxelBlock, int rowLocId, __m256 & sdf, __m256i & w_depth)
+		{
+			float sdfs[SDF_BLOCK_SIZE]; int weights[SDF_BLOCK_SIZE];
+			for (int x = 0; x < SDF_BLOCK_SIZE; x++)
+			{
+				TVoxel voxel = loadVoxel(localVoxelBlock, rowLocId + x);
+				sdfs[x] = TVoxel::valueToFloat(voxel.sdf); weights[x] = voxel.w_depth;
+			}
+
+			sdf = _mm256_loadu_ps(sdfs);
+			w_depth = _mm256_loadu_si256((const __m256i*)weights);
+		}
+
+		static void store(TVoxel *localVoxelBlock, int rowLocId, __m256 sdf, __m256i w_depth, __m256i update)
+		{
+			float sdfs[SDF_BLOCK_SIZE]; int weights[SDF_BLOCK_SIZE];
+			_mm256_storeu_ps(sdfs, sdf);
+			_mm256_storeu_si256((__m256i*)weights, w_depth);
+
+			int updateMask = _mm256_movemask_ps(_mm256_castsi256_ps(update));
+			for (int x = 0; x < SDF_BLOCK_SIZE; x++)
+			{
+				if (!(updateMask & (1 << x))) continue;
+
+				TVoxel voxel = loadVoxel(localVoxelBlock, rowLocId + x);
+				voxel.sdf = TVoxel::floatToValue(sdfs[x]); voxel.w_depth = weights[x];
+				storeVoxel(localVoxelBlock, rowLocId + x, voxel);
+			}
+		}
+	};
+
+#ifndef SDF_BLOCK_LAYOUT_SOA
+	/// a row of ITMVoxel_s is eight 32 bit words, each holding the sdf in the low half and the depth weight in the third byte
+	template<>
+	struct VoxelRowAVX2<ITMVoxel_s>
+	{
+		static void load(const ITMVoxel_s *localVoxelBlock, int rowLocId, __m256 & sdf, __m256i & w_depth)
+		{
+			__m256i voxels = _mm256_loadu_si256((const __m256i*)(localVoxelBlock + rowLocId));
+			sdf = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_srai_epi32(_mm256_slli_epi32(voxels, 16), 16)), _mm256_set1_ps(32767.0f));
+			w_depth = _mm256_and_si256(_mm256_srli_epi32(voxels, 16), _mm256_set1_epi32(0xff));
+		}
+
+		static void store(ITMVoxel_s *localVoxelBlock, int rowLocId, __m256 sdf, __m256i w_depth, __m256i update)
+		{
+			__m256i value = _mm256_cvttps_epi32(_mm256_mul_ps(sdf, _mm256_set1_ps(32767.0f)));
+			__m256i voxels = _mm256_or_si256(_mm256_and_si256(value, _mm256_set1_epi32(0xffff)), _mm256_slli_epi32(w_depth, 16));
+			_mm256_maskstore_epi32((int*)(localVoxelBlock + rowLocId), update, voxels);
+		}
+	};
+
+	/// a row of ITMVoxel_f is sixteen 32 bit words, alternating between the sdf and a word holding the depth weight in its low byte
+	template<>
+	struct VoxelRowAVX2<ITMVoxel_f>
+	{
+		static void load(const ITMVoxel_f *localVoxelBlock, int rowLocId, __m256 & sdf, __m256i & w_depth)
+		{
+			__m256 voxelsA = _mm256_loadu_ps((const float*)(localVoxelBlock + rowLocId));
+			__m256 voxelsB = _mm256_loadu_ps((const float*)(localVoxelBlock + rowLocId + 4));
+
+			// the shuffles leave the lanes in the order 0 1 4 5 2 3 6 7
+			sdf = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(voxelsA, voxelsB, _MM_SHUFFLE(2, 0, 2, 0))), _MM_SHUFFLE(3, 1, 2, 0)));
+			__m256 words = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(voxelsA, voxelsB, _MM_SHUFFLE(3, 1, 3, 1))), _MM_SHUFFLE(3, 1, 2, 0)));
+			w_depth = _mm256_and_si256(_mm256_castps_si256(words), _mm256_set1_epi32(0xff));
+		}
+
+		static void store(ITMVoxel_f *localVoxelBlock, int rowLocId, __m256 sdf, __m256i w_depth, __m256i update)
+		{
+			// back into the order 0 1 4 5 2 3 6 7, so that unpacking interleaves voxels 0 to 3 and 4 to 7
+			sdf = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(sdf), _MM_SHUFFLE(3, 1, 2, 0)));
+			__m256 words = _mm256_castsi256_ps(_mm256_permute4x64_epi64(w_depth, _MM_SHUFFLE(3, 1, 2, 0)));
+			__m256 mask = _mm256_castsi256_ps(_mm256_permute4x64_epi64(update, _MM_SHUFFLE(3, 1, 2, 0)));
+
+			_mm256_maskstore_ps((float*)(localVoxelBlock + rowLocId), _mm256_castps_si256(_mm256_unpacklo_ps(mask, mask)), _mm256_unpacklo_ps(sdf, words));
+			_mm256_maskstore_ps((float*)(localVoxelBlock + rowLocId + 4), _mm256_castps_si256(_mm256_unpackhi_ps(mask, mask)), _mm256_unpackhi_ps(sdf, words));
+		}
+	};
+#else
+	inline __m128i packRowMask16(__m256i update)
+	{
+		return _mm_packs_epi32(_mm256_castsi256_si128(update), _mm256_extracti128_si256(update, 1));
+	}
+
+	inline __m256i loadRowWeightsSoA(const uchar *w_depth)
+	{
+		return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)w_depth));
+	}
+
+	/// the row belongs to the calling thread, so the lanes not updated can be written back unchanged
+	inline void storeRowWeightsSoA(uchar *w_depth, __m256i weights, __m256i update)
+	{
+		__m128i weights16 = _mm_packus_epi32(_mm256_castsi256_si128(weights), _mm256_extracti128_si256(weights, 1));
+		__m128i mask16 = packRowMask16(update);
+		__m128i weights8 = _mm_packus_epi16(weights16, weights16), mask8 = _mm_packs_epi16(mask16, mask16);
+		_mm_storel_epi64((__m128i*)w_depth, _mm_blendv_epi8(_mm_loadl_epi64((const __m128i*)w_depth), weights8, mask8));
+	}
+
+	template<>
+	struct VoxelRowAVX2<ITMVoxel_s>
+	{
+		typedef ITMVoxelBlockSoA<ITMVoxel_s> Layout;
+
+		static void load(const ITMVoxel_s *localVoxelBlock, int rowLocId, __m256 & sdf, __m256i & w_depth)
+		{
+			const short *sdfs = voxelFieldSoA<short>(localVoxelBlock, rowLocId, Layout::sdfOffset);
+			sdf = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)sdfs))), _mm256_set1_ps(32767.0f));
+			w_depth = loadRowWeightsSoA(voxelFieldSoA<uchar>(localVoxelBlock, rowLocId, Layout::wDepthOffset));
+		}
+
+		static void store(ITMVoxel_s *localVoxelBlock, int rowLocId, __m256 sdf, __m256i w_depth, __m256i update)
+		{
+			short *sdfs = voxelFieldSoA<short>(localVoxelBlock, rowLocId, Layout::sdfOffset);
+			__m256i value = _mm256_cvttps_epi32(_mm256_mul_ps(sdf, _mm256_set1_ps(32767.0f)));
+			__m128i value16 = _mm_packs_epi32(_mm256_castsi256_si128(value), _mm256_extracti128_si256(value, 1));
+			_mm_storeu_si128((__m128i*)sdfs, _mm_blendv_epi8(_mm_loadu_si128((const __m128i*)sdfs), value16, packRowMask16(update)));
+			storeRowWeightsSoA(voxelFieldSoA<uchar>(localVoxelBlock, rowLocId, Layout::wDepthOffset), w_depth, update);
+		}
+	};
+
+	template<>
+	struct VoxelRowAVX2<ITMVoxel_f>
+	{
+		typedef ITMVoxelBlockSoA<ITMVoxel_f> Layout;
+
+		static void load(const ITMVoxel_f *localVoxelBlock, int rowLocId, __m256 & sdf, __m256i & w_depth)
+		{
+			sdf = _mm256_loadu_ps(voxelFieldSoA<float>(localVoxelBlock, rowLocId, Layout::sdfOffset));
+			w_depth = loadRowWeightsSoA(voxelFieldSoA<uchar>(localVoxelBlock, rowLocId, Layout::wDepthOffset));
+		}
+
+		static void store(ITMVoxel_f *localVoxelBlock, int rowLocId, __m256 sdf, __m256i w_depth, __m256i update)
+		{
+			_mm256_maskstore_ps(voxelFieldSoA<float>(localVoxelBlock, rowLocId, Layout::sdfOffset), update, sdf);
+			storeRowWeightsSoA(voxelFieldSoA<uchar>(localVoxelBlock, rowLocId, Layout::wDepthOffset), w_depth, update);
+		}
+	};
+#endif
+
+	/** Projects all eight voxels of a row and looks up their depths with
+	    AVX2. Without colour, the in-band voxels are then blended and
+	    written back together, as fuseDepthObservation does one at a time.
+	    Colour voxels are fused one at a time. Like the scalar path, voxels
+	    at or behind the camera plane (cam_z <= 0) are left unchanged.
+	    The camera space positions are stepped along the row from its first
+	    voxel, so they may differ from the scalar path in the last bits.
+	    Confidence voxels keep using the scalar path.
+	*/
+	template<class TVoxel>
+	struct IntegrateVoxelRow_CPU<false, TVoxel>
+	{
+		static void integrate(TVoxel *localVoxelBlock, const Vector3i & globalPos, int y, int z, float voxelSize,
+			const Matrix4f & M_d, const Vector4f & projParams_d, const Matrix4f & M_rgb, const Vector4f & projParams_rgb,
+			float mu, int maxW, bool stopIntegratingAtMaxW, const float *depth, const float *confidence, const Vector2i & depthImgSize,
+			const Vector4u *rgb, const Vector2i & rgbImgSize)
+		{
+			Vector4f pt_row((float)globalPos.x * voxelSize, (float)(globalPos.y + y) * voxelSize, (float)(globalPos.z + z) * voxelSize, 1.0f);
+			Vector4f pt_camera = M_d * pt_row;
+			Vector4f pt_step = M_d * Vector4f(voxelSize, 0.0f, 0.0f, 0.0f);
+
+			const __m256 lane = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+			__m256 cam_x = _mm256_add_ps(_mm256_set1_ps(pt_camera.x), _mm256_mul_ps(lane, _mm256_set1_ps(pt_step.x)));
+			__m256 cam_y = _mm256_add_ps(_mm256_set1_ps(pt_camera.y), _mm256_mul_ps(lane, _mm256_set1_ps(pt_step.y)));
+			__m256 cam_z = _mm256_add_ps(_mm256_set1_ps(pt_camera.z), _mm256_mul_ps(lane, _mm256_set1_ps(pt_step.z)));
+
+			__m256 img_x = _mm256_add_ps(_mm256_div_ps(_mm256_mul_ps(_mm256_set1_ps(projParams_d.x), cam_x), cam_z), _mm256_set1_ps(projParams_d.z));
+			__m256 img_y = _mm256_add_ps(_mm256_div_ps(_mm256_mul_ps(_mm256_set1_ps(projParams_d.y), cam_y), cam_z), _mm256_set1_ps(projParams_d.w));
+
+			__m256 valid = _mm256_cmp_ps(cam_z, _mm256_setzero_ps(), _CMP_GT_OQ);
+			valid = _mm256_and_ps(valid, _mm256_cmp_ps(img_x, _mm256_set1_ps(1.0f), _CMP_GE_OQ));
+			valid = _mm256_and_ps(valid, _mm256_cmp_ps(img_x, _mm256_set1_ps((float)(depthImgSize.x - 2)), _CMP_LE_OQ));
+			valid = _mm256_and_ps(valid, _mm256_cmp_ps(img_y, _mm256_set1_ps(1.0f), _CMP_GE_OQ));
+			valid = _mm256_and_ps(valid, _mm256_cmp_ps(img_y, _mm256_set1_ps((float)(depthImgSize.y - 2)), _CMP_LE_OQ));
+			if (_mm256_movemask_ps(valid) == 0) return;
+
+			// invalid lanes are neither converted into an index nor gathered
+			const __m256 half = _mm256_set1_ps(0.5f);
+			img_x = _mm256_and_ps(valid, _mm256_add_ps(img_x, half));
+			img_y = _mm256_and_ps(valid, _mm256_add_ps(img_y, half));
+			__m256i idx = _mm256_add_epi32(_mm256_cvttps_epi32(img_x), _mm256_mullo_epi32(_mm256_cvttps_epi32(img_y), _mm256_set1_epi32(depthImgSize.x)));
+
+			__m256 depth_measure = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), depth, idx, valid, 4);
+			valid = _mm256_and_ps(valid, _mm256_cmp_ps(depth_measure, _mm256_setzero_ps(), _CMP_GT_OQ));
+
+			__m256 eta = _mm256_sub_ps(depth_measure, cam_z);
+			valid = _mm256_and_ps(valid, _mm256_cmp_ps(eta, _mm256_set1_ps(-mu), _CMP_GE_OQ));
+
+			int updateMask = _mm256_movemask_ps(valid);
+			if (updateMask == 0) return;
+
+			int rowLocId = y * SDF_BLOCK_SIZE + z * SDF_BLOCK_SIZE * SDF_BLOCK_SIZE;
+
+			if (!TVoxel::hasColorInformation)
+			{
+				__m256 oldF; __m256i oldW;
+				VoxelRowAVX2<TVoxel>::load(localVoxelBlock, rowLocId, oldF, oldW);
+
+				__m256i update = _mm256_castps_si256(valid);
+				if (stopIntegratingAtMaxW) update = _mm256_andnot_si256(_mm256_cmpeq_epi32(oldW, _mm256_set1_epi32(maxW)), update);
+
+				const __m256 one = _mm256_set1_ps(1.0f);
+				__m256 oldWf = _mm256_cvtepi32_ps(oldW);
+				__m256 newF = _mm256_min_ps(one, _mm256_div_ps(eta, _mm256_set1_ps(mu)));
+				newF = _mm256_div_ps(_mm256_add_ps(_mm256_mul_ps(oldWf, oldF), newF), _mm256_add_ps(oldWf, one));
+				__m256i newW = _mm256_min_epi32(_mm256_add_epi32(oldW, _mm256_set1_epi32(1)), _mm256_set1_epi32(maxW));
+
+				VoxelRowAVX2<TVoxel>::store(localVoxelBlock, rowLocId, newF, newW, update);
+				return;
+			}
+
+			float etas[SDF_BLOCK_SIZE];
+			_mm256_storeu_ps(etas, eta);
+
+			for (int x = 0; x < SDF_BLOCK_SIZE; x++)
+			{
+				if (!(updateMask & (1 << x))) continue;
+
+				TVoxel voxel = loadVoxel(localVoxelBlock, rowLocId + x);
+
+				if (stopIntegratingAtMaxW) if (voxel.w_depth == maxW) continue;
+
+				Vector4f pt_model((float)(globalPos.x + x) * voxelSize, pt_row.y, pt_row.z, 1.0f);
+
+				ComputeUpdatedVoxelInfo<TVoxel::hasColorInformation, false, TVoxel>::fuse(voxel, etas[x], pt_model,
+					M_rgb, projParams_rgb, mu, maxW, rgb, rgbImgSize);
+
+				storeVoxel(localVoxelBlock, rowLocId + x, voxel);
+			}
+		}
+	};
+#endif
+
+	/** Finds the z-slices [zBegin, zEnd) of the voxel block at globalPos
+	    that can receive an update, i.e. that are not entirely more than mu
+	    behind the deepest measurement inside the image footprint of the
+	    block. Returns false if no voxel of the block can be updated. Voxels
+	    in front of the surface are kept, as they carry free space updates.
+	*/
+	inline bool computeIntegrationSliceRange(int & zBegin, int & zEnd, const Vector3i & globalPos, float voxelSize,
+		const Matrix4f & M_d, const Vector4f & projParams_d, float mu, const float *depth, const Vector2i & imgSize)
+	{
+		zBegin = 0; zEnd = SDF_BLOCK_SIZE;
+
+		float extent = (SDF_BLOCK_SIZE - 1) * voxelSize;
+		Vector4f pt_origin = M_d * Vector4f(globalPos.x * voxelSize, globalPos.y * voxelSize, globalPos.z * voxelSize, 1.0f);
+		Vector4f axis_x = M_d * Vector4f(extent, 0.0f, 0.0f, 0.0f);
+		Vector4f axis_y = M_d * Vector4f(0.0f, extent, 0.0f, 0.0f);
+		Vector4f axis_z = M_d * Vector4f(0.0f, 0.0f, extent, 0.0f);
+
+		Vector2f minImg(1e10f), maxImg(-1e10f);
+		for (int cornerId = 0; cornerId < 8; cornerId++)
+		{
+			Vector4f pt_camera = pt_origin;
+			if (cornerId & 1) pt_camera += axis_x;
+			if (cornerId & 2) pt_camera += axis_y;
+			if (cornerId & 4) pt_camera += axis_z;
+
+			// the block straddles the image plane, its footprint is unbounded
+			if (pt_camera.z <= 0) return true;
+
+			Vector2f pt_image(projParams_d.x * pt_camera.x / pt_camera.z + projParams_d.z, projParams_d.y * pt_camera.y / pt_camera.z + projParams_d.w);
+			minImg.x = MIN(minImg.x, pt_image.x); maxImg.x = MAX(maxImg.x, pt_image.x);
+			minImg.y = MIN(minImg.y, pt_image.y); maxImg.y = MAX(maxImg.y, pt_image.y);
+		}
+
+		// pixels the voxels can read from, with one pixel of slack for rounding
+		int minX = MAX(1, (int)MAX(minImg.x - 0.5f, 0.0f)), maxX = MIN(imgSize.x - 2, (int)MIN(maxImg.x + 1.5f, (float)imgSize.x));
+		int minY = MAX(1, (int)MAX(minImg.y - 0.5f, 0.0f)), maxY = MIN(imgSize.y - 2, (int)MIN(maxImg.y + 1.5f, (float)imgSize.y));
+		if (minX > maxX || minY > maxY) return false;
+
+		// scanning a footprint this large would cost more than integrating the whole block
+		if ((maxX - minX + 1) * (maxY - minY + 1) > SDF_BLOCK_SIZE3) return true;
+
+		float maxDepth = 0.0f;
+		for (int y = minY; y <= maxY; y++) for (int x = minX; x <= maxX; x++)
+			maxDepth = MAX(maxDepth, depth[x + y * imgSize.x]);
+		if (maxDepth <= 0.0f) return false;
+
+		// camera depth of the nearest voxel of each slice
+		float sliceNear = pt_origin.z + MIN(axis_x.z, 0.0f) + MIN(axis_y.z, 0.0f);
+		float sliceStep = axis_z.z / (SDF_BLOCK_SIZE - 1);
+		float farLimit = maxDepth + mu;
+
+		while (zBegin < zEnd && sliceNear + zBegin * sliceStep > farLimit) zBegin++;
+		while (zEnd > zBegin && sliceNear + (zEnd - 1) * sliceStep > farLimit) zEnd--;
+
+		return zBegin < zEnd;
+	}
+
+	template<class TVoxel>
+	inline bool isVoxelBlockSaturated(const TVoxel *localVoxelBlock, int maxW)
+	{
+		for (int locId = 0; locId < SDF_BLOCK_SIZE3; locId++)
+			if (loadVoxel(localVoxelBlock, locId).w_depth != maxW) return false;
+		return true;
+	}
+}
+
 template<class TVoxel>
 ITMSceneReconstructionEngine_CPU<TVoxel,ITMVoxelBlockHash>::ITMSceneReconstructionEngine_CPU(void) 
 {
 	int noTotalEntries = ITMVoxelBlockHash::noTotalEntries;
 	entriesAllocType = new ORUtils::MemoryBlock<unsigned char>(noTotalEntries, MEMORYDEVICE_CPU);
 	blockCoords = new ORUtils::MemoryBlock<Vector4s>(noTotalEntries, MEMORYDEVICE_CPU);
+	deferredFrames = new ORUtils::MemoryBlock<unsigned char>(SDF_LOCAL_BLOCK_NUM, MEMORYDEVICE_CPU);
+	nextReclaimBucket = 0;
 }
 
 template<class TVoxel>
@@ -19,6 +368,7 @@ ITMSceneReconstructionEngine_CPU<TVoxel,ITMVoxelBlockHash>::~ITMSceneReconstruct
 {
 	delete entriesAllocType;
 	delete blockCoords;
+	delete deferredFrames;
 }
 
 template<class TVoxel>
@@ -28,10 +378,11 @@ void ITMSceneReconstructionEngine_CPU<TVoxel,ITMVoxelBlockHash>::ResetScene(ITMS
 	int blockSize = scene->index.getVoxelBlockSize();
 
 	TVoxel *voxelBlocks_ptr = scene->localVBA.GetVoxelBlocks();
-	for (int i = 0; i < numBlocks * blockSize; ++i) voxelBlocks_ptr[i] = TVoxel();
+	for (int i = 0; i < numBlocks * blockSize; ++i) storeVoxel(voxelBlocks_ptr, i, TVoxel());
 	int *vbaAllocationList_ptr = scene->localVBA.GetAllocationList();
 	for (int i = 0; i < numBlocks; ++i) vbaAllocationList_ptr[i] = i;
 	scene->localVBA.lastFreeBlockId = numBlocks - 1;
+	scene->localVBA.ClearSaturatedBlocks();
 
 	ITMHashEntry tmpEntry;
 	memset(&tmpEntry, 0, sizeof(ITMHashEntry));
@@ -69,6 +420,7 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::IntegrateIntoS
 	float *confidence = view->depthConfidence->GetData(MEMORYDEVICE_CPU);
 	Vector4u *rgb = view->rgb->GetData(MEMORYDEVICE_CPU);
 	TVoxel *localVBA = scene->localVBA.GetVoxelBlocks();
+	uchar *saturatedBlocks = scene->localVBA.GetSaturatedBlocks();
 	ITMHashEntry *hashTable = scene->index.GetEntries();
 
 	int *visibleEntryIds = renderState_vh->GetVisibleEntryIDs();
@@ -77,41 +429,70 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::IntegrateIntoS
 	bool stopIntegratingAtMaxW = scene->sceneParams->stopIntegratingAtMaxW;
 	//bool approximateIntegration = !trackingState->requiresFullRendering;
 
-#ifdef WITH_OPENMP
-	#pragma omp parallel for
-#endif
-	for (int entryId = 0; entryId < noVisibleEntries; entryId++)
+	// under a budget, the blocks nearest to the surface are integrated and the others move up for the next frames
+	int maxIntegratedBlocks = scene->sceneParams->maxIntegratedBlocksPerFrame;
+	std::vector<int> budgetedEntryIds;
+	if (maxIntegratedBlocks > 0 && noVisibleEntries > maxIntegratedBlocks)
+	{
+		uchar *deferredFrames = this->deferredFrames->GetData(MEMORYDEVICE_CPU);
+
+		std::vector<std::pair<float, int> > integrationOrder;
+		for (int entryId = 0; entryId < noVisibleEntries; entryId++)
+		{
+			const ITMHashEntry &hashEntry = hashTable[visibleEntryIds[entryId]];
+			if (hashEntry.ptr < 0 || (stopIntegratingAtMaxW && saturatedBlocks[hashEntry.ptr])) continue;
+
+			float priority = computeIntegrationPriority(hashEntry.pos, deferredFrames[hashEntry.ptr], M_d, projParams_d, voxelSize, mu, depth, depthImgSize);
+			integrationOrder.push_back(std::make_pair(priority, visibleEntryIds[entryId]));
+		}
+
+		if ((int)integrationOrder.size() > maxIntegratedBlocks)
+		{
+			std::nth_element(integrationOrder.begin(), integrationOrder.begin() + maxIntegratedBlocks, integrationOrder.end());
+			for (size_t i = maxIntegratedBlocks; i < integrationOrder.size(); i++)
+			{
+				uchar &deferred = deferredFrames[hashTable[integrationOrder[i].second].ptr];
+				if (deferred < 255) deferred++;
+			}
+			integrationOrder.resize(maxIntegratedBlocks);
+		}
+
+		for (size_t i = 0; i < integrationOrder.size(); i++)
+		{
+			deferredFrames[hashTable[integrationOrder[i].second].ptr] = 0;
+			budgetedEntryIds.push_back(integrationOrder[i].second);
+		}
+
+		visibleEntryIds = budgetedEntryIds.empty() ? NULL : &budgetedEntryIds[0];
+		noVisibleEntries = (int)budgetedEntryIds.size();
+	}
+
+	ORUtils::ParallelFor(0, noVisibleEntries, [&](int entryId)
 	{
 		Vector3i globalPos;
 		const ITMHashEntry &currentHashEntry = hashTable[visibleEntryIds[entryId]];
 
-		if (currentHashEntry.ptr < 0) continue;
+		if (currentHashEntry.ptr < 0) return;
+		if (stopIntegratingAtMaxW) if (saturatedBlocks[currentHashEntry.ptr]) return;
 
 		globalPos.x = currentHashEntry.pos.x;
 		globalPos.y = currentHashEntry.pos.y;
 		globalPos.z = currentHashEntry.pos.z;
 		globalPos *= SDF_BLOCK_SIZE;
 
+		int zBegin, zEnd;
+		if (!computeIntegrationSliceRange(zBegin, zEnd, globalPos, voxelSize, M_d, projParams_d, mu, depth, depthImgSize)) return;
+
 		TVoxel *localVoxelBlock = &(localVBA[currentHashEntry.ptr * (SDF_BLOCK_SIZE3)]);
 
-		for (int z = 0; z < SDF_BLOCK_SIZE; z++) for (int y = 0; y < SDF_BLOCK_SIZE; y++) for (int x = 0; x < SDF_BLOCK_SIZE; x++)
+		for (int z = zBegin; z < zEnd; z++) for (int y = 0; y < SDF_BLOCK_SIZE; y++)
 		{
-			Vector4f pt_model; int locId;
-
-			locId = x + y * SDF_BLOCK_SIZE + z * SDF_BLOCK_SIZE * SDF_BLOCK_SIZE;
-
-			if (stopIntegratingAtMaxW) if (localVoxelBlock[locId].w_depth == maxW) continue;
-			//if (approximateIntegration) if (localVoxelBlock[locId].w_depth != 0) continue;
-
-			pt_model.x = (float)(globalPos.x + x) * voxelSize;
-			pt_model.y = (float)(globalPos.y + y) * voxelSize;
-			pt_model.z = (float)(globalPos.z + z) * voxelSize;
-			pt_model.w = 1.0f;
-
-			ComputeUpdatedVoxelInfo<TVoxel::hasColorInformation,TVoxel::hasConfidenceInformation, TVoxel>::compute(localVoxelBlock[locId], pt_model, M_d, 
-				projParams_d, M_rgb, projParams_rgb, mu, maxW, depth, confidence, depthImgSize, rgb, rgbImgSize);
+			IntegrateVoxelRow_CPU<TVoxel::hasConfidenceInformation, TVoxel>::integrate(localVoxelBlock, globalPos, y, z, voxelSize,
+				M_d, projParams_d, M_rgb, projParams_rgb, mu, maxW, stopIntegratingAtMaxW, depth, confidence, depthImgSize, rgb, rgbImgSize);
 		}
-	}
+
+		if (stopIntegratingAtMaxW) saturatedBlocks[currentHashEntry.ptr] = isVoxelBlockSaturated(localVoxelBlock, maxW);
+	});
 }
 
 template<class TVoxel>
@@ -162,24 +543,61 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::AllocateSceneF
 		entriesVisibleType[visibleEntryIDs[i]] = 3; // visible at previous frame and unstreamed
 
 	//build hashVisibility
-#ifdef WITH_OPENMP
-	#pragma omp parallel for
-#endif
-	for (int locId = 0; locId < depthImgSize.x*depthImgSize.y; locId++)
+	ORUtils::ParallelFor(0, depthImgSize.x*depthImgSize.y, [&](int locId)
 	{
 		int y = locId / depthImgSize.x;
 		int x = locId - y * depthImgSize.x;
 		buildHashAllocAndVisibleTypePP(entriesAllocType, entriesVisibleType, x, y, blockCoords, depth, invM_d,
 			invProjParams_d, mu, depthImgSize, oneOverVoxelSize, hashTable, scene->sceneParams->viewFrustum_min,
 			scene->sceneParams->viewFrustum_max);
+	});
+
+	// under a budget, the requests nearest to the camera are served, the others come up again in later frames
+	int maxAllocatedBlocks = scene->sceneParams->maxAllocatedBlocksPerFrame;
+	if (!onlyUpdateVisibleList && maxAllocatedBlocks > 0)
+	{
+		Vector3f cameraBlockPos = invM_d.getColumn(3).toVector3() * oneOverVoxelSize;
+
+		std::vector<std::pair<float, int> > allocationRequests;
+		for (int targetIdx = 0; targetIdx < noTotalEntries; targetIdx++) if (entriesAllocType[targetIdx] != 0)
+			allocationRequests.push_back(std::make_pair(computeAllocationPriority(blockCoords[targetIdx], cameraBlockPos), targetIdx));
+
+		if ((int)allocationRequests.size() > maxAllocatedBlocks)
+		{
+			std::nth_element(allocationRequests.begin(), allocationRequests.begin() + maxAllocatedBlocks, allocationRequests.end());
+			for (size_t i = maxAllocatedBlocks; i < allocationRequests.size(); i++)
+			{
+				int targetIdx = allocationRequests[i].second;
+
+				// buildHashAllocAndVisibleTypePP marks the entries it wants to allocate in the ordered list as visible
+				if (entriesAllocType[targetIdx] == 1) entriesVisibleType[targetIdx] = 0;
+				entriesAllocType[targetIdx] = 0;
+			}
+		}
 	}
 
 	if (onlyUpdateVisibleList) useSwapping = false;
 	if (!onlyUpdateVisibleList)
 	{
+		// the free list is popped from the top, so visiting the entries in descending Morton order
+		// makes the new blocks ascend in memory, which is the order the defragmenter aims for
+		std::vector<std::pair<unsigned long long, int> > allocationOrder;
+		bool useMortonOrder = scene->sceneParams->allocateBlocksInMortonOrder;
+		if (useMortonOrder)
+		{
+			for (int targetIdx = 0; targetIdx < noTotalEntries; targetIdx++) if (entriesAllocType[targetIdx] != 0)
+			{
+				Vector4s pt_block_all = blockCoords[targetIdx];
+				allocationOrder.push_back(std::make_pair(this->BlockMortonCode(Vector3s(pt_block_all.x, pt_block_all.y, pt_block_all.z)), targetIdx));
+			}
+			std::sort(allocationOrder.begin(), allocationOrder.end(), std::greater<std::pair<unsigned long long, int> >());
+		}
+
 		//allocate
-		for (int targetIdx = 0; targetIdx < noTotalEntries; targetIdx++)
+		int noAllocationCandidates = useMortonOrder ? (int)allocationOrder.size() : noTotalEntries;
+		for (int candidateId = 0; candidateId < noAllocationCandidates; candidateId++)
 		{
+			int targetIdx = useMortonOrder ? allocationOrder[candidateId].second : candidateId;
 			int vbaIdx, exlIdx;
 			unsigned char hashChangeType = entriesAllocType[targetIdx];
 
@@ -195,7 +613,7 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::AllocateSceneF
 					ITMHashEntry hashEntry;
 					hashEntry.pos.x = pt_block_all.x; hashEntry.pos.y = pt_block_all.y; hashEntry.pos.z = pt_block_all.z;
 					hashEntry.ptr = voxelAllocationList[vbaIdx];
-					hashEntry.offset = 0;
+					hashEntry.offset = hashTable[targetIdx].offset; // keep the excess list of a reused entry
 
 					hashTable[targetIdx] = hashEntry;
 				}
@@ -323,12 +741,69 @@ void ITMSceneReconstructionEngine_CPU<TVoxel,ITMPlainVoxelArray>::ResetScene(ITM
 	int blockSize = scene->index.getVoxelBlockSize();
 
 	TVoxel *voxelBlocks_ptr = scene->localVBA.GetVoxelBlocks();
-	for (int i = 0; i < numBlocks * blockSize; ++i) voxelBlocks_ptr[i] = TVoxel();
+	for (int i = 0; i < numBlocks * blockSize; ++i) storeVoxel(voxelBlocks_ptr, i, TVoxel());
 	int *vbaAllocationList_ptr = scene->localVBA.GetAllocationList();
 	for (int i = 0; i < numBlocks; ++i) vbaAllocationList_ptr[i] = i;
 	scene->localVBA.lastFreeBlockId = numBlocks - 1;
 }
 
+template<class TVoxel>
+void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::DefragmentScene(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, int maxSwaps)
+{
+	ITMHashEntry *hashTable = scene->index.GetEntries();
+	TVoxel *localVBA = scene->localVBA.GetVoxelBlocks();
+	uchar *saturatedBlocks = scene->localVBA.GetSaturatedBlocks();
+
+	std::vector<Vector2i> entrySwaps;
+	this->PlanBlockSwaps(hashTable, scene->index.noTotalEntries, scene->index.getNumAllocatedVoxelBlocks(), maxSwaps, entrySwaps);
+
+	int noSwaps = (int)entrySwaps.size();
+
+	ORUtils::ParallelFor(0, noSwaps, [&](int swapId)
+	{
+		ITMHashEntry &entryA = hashTable[entrySwaps[swapId].x], &entryB = hashTable[entrySwaps[swapId].y];
+
+		TVoxel *voxelBlockA = localVBA + entryA.ptr * SDF_BLOCK_SIZE3, *voxelBlockB = localVBA + entryB.ptr * SDF_BLOCK_SIZE3;
+		std::swap_ranges(voxelBlockA, voxelBlockA + SDF_BLOCK_SIZE3, voxelBlockB);
+		std::swap(saturatedBlocks[entryA.ptr], saturatedBlocks[entryB.ptr]);
+		std::swap(entryA.ptr, entryB.ptr);
+	});
+}
+
+template<class TVoxel>
+void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::ReclaimExcessEntries(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, int noBuckets, float sweepThreshold)
+{
+	ITMHashEntry *hashTable = scene->index.GetEntries();
+	int *excessAllocationList = scene->index.GetExcessAllocationList();
+	int lastFreeExcessListId = scene->index.GetLastFreeExcessListId();
+
+	if (SDF_EXCESS_LIST_SIZE - 1 - lastFreeExcessListId > sweepThreshold * SDF_EXCESS_LIST_SIZE) noBuckets = SDF_BUCKET_NUM;
+	noBuckets = MIN(noBuckets, SDF_BUCKET_NUM);
+
+	for (int bucketId = 0; bucketId < noBuckets; bucketId++)
+	{
+		int prevIdx = (nextReclaimBucket + bucketId) % SDF_BUCKET_NUM;
+		int offset = hashTable[prevIdx].offset;
+
+		while (offset >= 1)
+		{
+			int hashIdx = SDF_BUCKET_NUM + offset - 1;
+			offset = hashTable[hashIdx].offset;
+
+			if (hashTable[hashIdx].ptr >= -1) { prevIdx = hashIdx; continue; }
+
+			// unlink the deleted entry and give its slot back
+			hashTable[prevIdx].offset = offset;
+			hashTable[hashIdx].offset = 0;
+			lastFreeExcessListId++;
+			excessAllocationList[lastFreeExcessListId] = hashIdx - SDF_BUCKET_NUM;
+		}
+	}
+
+	nextReclaimBucket = (nextReclaimBucket + noBuckets) % SDF_BUCKET_NUM;
+	scene->index.SetLastFreeExcessListId(lastFreeExcessListId);
+}
+
 template<class TVoxel>
 void ITMSceneReconstructionEngine_CPU<TVoxel, ITMPlainVoxelArray>::AllocateSceneFromDepth(ITMScene<TVoxel, ITMPlainVoxelArray> *scene, const ITMView *view,
 	const ITMTrackingState *trackingState, const ITMRenderState *renderState, bool onlyUpdateVisibleList, bool resetVisibleList)
@@ -362,10 +837,7 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMPlainVoxelArray>::IntegrateInto
 	bool stopIntegratingAtMaxW = scene->sceneParams->stopIntegratingAtMaxW;
 	//bool approximateIntegration = !trackingState->requiresFullRendering;
 
-#ifdef WITH_OPENMP
-	#pragma omp parallel for
-#endif
-	for (int locId = 0; locId < scene->index.getVolumeSize().x*scene->index.getVolumeSize().y*scene->index.getVolumeSize().z; ++locId)
+	ORUtils::ParallelFor(0, scene->index.getVolumeSize().x*scene->index.getVolumeSize().y*scene->index.getVolumeSize().z, [&](int locId)
 	{
 		int z = locId / (scene->index.getVolumeSize().x*scene->index.getVolumeSize().y);
 		int tmp = locId - z * scene->index.getVolumeSize().x*scene->index.getVolumeSize().y;
@@ -373,15 +845,27 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMPlainVoxelArray>::IntegrateInto
 		int x = tmp - y * scene->index.getVolumeSize().x;
 		Vector4f pt_model;
 
-		if (stopIntegratingAtMaxW) if (voxelArray[locId].w_depth == maxW) continue;
-		//if (approximateIntegration) if (voxelArray[locId].w_depth != 0) continue;
+		TVoxel voxel = loadVoxel(voxelArray, locId);
+
+		if (stopIntegratingAtMaxW) if (voxel.w_depth == maxW) return;
+		//if (approximateIntegration) if (voxel.w_depth != 0) return;
 
 		pt_model.x = (float)(x + arrayInfo->offset.x) * voxelSize;
 		pt_model.y = (float)(y + arrayInfo->offset.y) * voxelSize;
 		pt_model.z = (float)(z + arrayInfo->offset.z) * voxelSize;
 		pt_model.w = 1.0f;
 
-		ComputeUpdatedVoxelInfo<TVoxel::hasColorInformation, TVoxel::hasConfidenceInformation, TVoxel>::compute(voxelArray[locId], pt_model, M_d, projParams_d, M_rgb, projParams_rgb, mu, maxW, 
+		ComputeUpdatedVoxelInfo<TVoxel::hasColorInformation, TVoxel::hasConfidenceInformation, TVoxel>::compute(voxel, pt_model, M_d, projParams_d, M_rgb, projParams_rgb, mu, maxW, 
 			depth, depthImgSize, rgb, rgbImgSize);
-	}
+
+		storeVoxel(voxelArray, locId, voxel);
+	});
 }
+
+template<class TVoxel>
+void ITMSceneReconstructionEngine_CPU<TVoxel, ITMPlainVoxelArray>::DefragmentScene(ITMScene<TVoxel, ITMPlainVoxelArray> *scene, int maxSwaps)
+{}
+
+template<class TVoxel>
+void ITMSceneReconstructionEngine_CPU<TVoxel, ITMPlainVoxelArray>::ReclaimExcessEntries(ITMScene<TVoxel, ITMPlainVoxelArray> *scene, int noBuckets, float sweepThreshold)
+{}
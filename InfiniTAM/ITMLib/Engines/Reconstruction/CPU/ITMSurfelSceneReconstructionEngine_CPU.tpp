@@ -3,6 +3,7 @@
 #include "ITMSurfelSceneReconstructionEngine_CPU.h"
 
 #include "../Shared/ITMSurfelSceneReconstructionEngine_Shared.h"
+#include "../../../../ORUtils/TaskScheduler.h"
 
 namespace ITMLib
 {
@@ -44,10 +45,7 @@ void ITMSurfelSceneReconstructionEngine_CPU<TSurfel>::AddNewSurfels(ITMSurfelSce
   const Matrix4f T = trackingState->pose_d->GetInvM();
   const Vector4f *vertexMap = this->m_vertexMapMB->GetData(MEMORYDEVICE_CPU);
 
-#ifdef WITH_OPENMP
-  #pragma omp parallel for
-#endif
-  for(int locId = 0; locId < pixelCount; ++locId)
+  ORUtils::ParallelFor(0, pixelCount, [&](int locId)
   {
     add_new_surfel(
       locId, T, this->m_timestamp, newPointsMask, newPointsPrefixSum, vertexMap, normalMap, radiusMap, colourMap,
@@ -55,7 +53,7 @@ void ITMSurfelSceneReconstructionEngine_CPU<TSurfel>::AddNewSurfels(ITMSurfelSce
       depthToRGB, projParamsRGB, sceneParams.useGaussianSampleConfidence, sceneParams.gaussianConfidenceSigma,
       sceneParams.maxSurfelRadius, newSurfels
     );
-  }
+  });
 }
 
 template <typename TSurfel>
@@ -73,13 +71,10 @@ void ITMSurfelSceneReconstructionEngine_CPU<TSurfel>::FindCorrespondingSurfels(c
   const ITMSurfelSceneParams& sceneParams = scene->GetParams();
   const TSurfel *surfels = scene->GetSurfels()->GetData(MEMORYDEVICE_CPU);
 
-#ifdef WITH_OPENMP
-  #pragma omp parallel for
-#endif
-  for(int locId = 0; locId < pixelCount; ++locId)
+  ORUtils::ParallelFor(0, pixelCount, [&](int locId)
   {
     find_corresponding_surfel(locId, invT, depthMap, depthMapWidth, normalMap, indexImageSuper, sceneParams.supersamplingFactor, surfels, correspondenceMap, newPointsMask);
-  }
+  });
 }
 
 template <typename TSurfel>
@@ -101,17 +96,14 @@ void ITMSurfelSceneReconstructionEngine_CPU<TSurfel>::FuseMatchedPoints(ITMSurfe
   const Matrix4f T = trackingState->pose_d->GetInvM();
   const Vector4f *vertexMap = this->m_vertexMapMB->GetData(MEMORYDEVICE_CPU);
 
-#ifdef WITH_OPENMP
-  #pragma omp parallel for
-#endif
-  for(int locId = 0; locId < pixelCount; ++locId)
+  ORUtils::ParallelFor(0, pixelCount, [&](int locId)
   {
     fuse_matched_point(
       locId, correspondenceMap, T, this->m_timestamp, vertexMap, normalMap, radiusMap, colourMap, depthMapWidth, depthMapHeight, colourMapWidth, colourMapHeight,
       depthToRGB, projParamsRGB, sceneParams.deltaRadius, sceneParams.useGaussianSampleConfidence, sceneParams.gaussianConfidenceSigma, sceneParams.maxSurfelRadius,
       surfels
     );
-  }
+  });
 }
 
 template <typename TSurfel>
@@ -127,19 +119,13 @@ void ITMSurfelSceneReconstructionEngine_CPU<TSurfel>::MarkBadSurfels(ITMSurfelSc
   const TSurfel *surfels = scene->GetSurfels()->GetData(MEMORYDEVICE_CPU);
 
   // Clear the surfel removal mask.
-#ifdef WITH_OPENMP
-  #pragma omp parallel for
-#endif
-  for(int surfelId = 0; surfelId < surfelCount; ++surfelId)
+  ORUtils::ParallelFor(0, surfelCount, [&](int surfelId)
   {
     clear_removal_mask_entry(surfelId, surfelRemovalMask);
-  }
+  });
 
   // Mark long-term unstable surfels for removal.
-#ifdef WITH_OPENMP
-  #pragma omp parallel for
-#endif
-  for(int surfelId = 0; surfelId < surfelCount; ++surfelId)
+  ORUtils::ParallelFor(0, surfelCount, [&](int surfelId)
   {
     mark_for_removal_if_unstable(
       surfelId,
@@ -149,7 +135,7 @@ void ITMSurfelSceneReconstructionEngine_CPU<TSurfel>::MarkBadSurfels(ITMSurfelSc
       sceneParams.unstableSurfelPeriod,
       surfelRemovalMask
     );
-  }
+  });
 }
 
 template <typename TSurfel>
@@ -166,44 +152,32 @@ void ITMSurfelSceneReconstructionEngine_CPU<TSurfel>::MergeSimilarSurfels(ITMSur
   unsigned int *surfelRemovalMask = this->m_surfelRemovalMaskMB->GetData(MEMORYDEVICE_CPU);
 
   // Clear the merge target map.
-#ifdef WITH_OPENMP
-  #pragma omp parallel for
-#endif
-  for(int locId = 0; locId < pixelCount; ++locId)
+  ORUtils::ParallelFor(0, pixelCount, [&](int locId)
   {
     clear_merge_target(locId, mergeTargetMap);
-  }
+  });
 
   // Find pairs of surfels that can be merged.
-#ifdef WITH_OPENMP
-  #pragma omp parallel for
-#endif
-  for(int locId = 0; locId < pixelCount; ++locId)
+  ORUtils::ParallelFor(0, pixelCount, [&](int locId)
   {
     find_mergeable_surfel(
       locId, indexImage, indexImageWidth, indexImageHeight, correspondenceMap, surfels,
       sceneParams.stableSurfelConfidence, sceneParams.maxMergeDist, sceneParams.maxMergeAngle,
       sceneParams.minRadiusOverlapFactor, mergeTargetMap
     );
-  }
+  });
 
   // Prevent any merge chains.
-#ifdef WITH_OPENMP
-  #pragma omp parallel for
-#endif
-  for(int locId = 0; locId < pixelCount; ++locId)
+  ORUtils::ParallelFor(0, pixelCount, [&](int locId)
   {
     prevent_merge_chain(locId, mergeTargetMap);
-  }
+  });
 
   // Merge the relevant surfels.
-#ifdef WITH_OPENMP
-  #pragma omp parallel for
-#endif
-  for(int locId = 0; locId < pixelCount; ++locId)
+  ORUtils::ParallelFor(0, pixelCount, [&](int locId)
   {
     perform_surfel_merge(locId, mergeTargetMap, surfels, surfelRemovalMask, indexImage, sceneParams.maxSurfelRadius);
-  }
+  });
 }
 
 template <typename TSurfel>
@@ -219,31 +193,22 @@ void ITMSurfelSceneReconstructionEngine_CPU<TSurfel>::PreprocessDepthMap(const I
   const int width = view->depth->noDims.x;
 
   // Calculate the vertex map.
-#ifdef WITH_OPENMP
-  #pragma omp parallel for
-#endif
-  for(int locId = 0; locId < pixelCount; ++locId)
+  ORUtils::ParallelFor(0, pixelCount, [&](int locId)
   {
     calculate_vertex_position(locId, width, intrinsics, depthMap, vertexMap);
-  }
+  });
 
   // Calculate the normal map.
-#ifdef WITH_OPENMP
-  #pragma omp parallel for
-#endif
-  for(int locId = 0; locId < pixelCount; ++locId)
+  ORUtils::ParallelFor(0, pixelCount, [&](int locId)
   {
     calculate_normal(locId, vertexMap, width, height, normalMap);
-  }
+  });
 
   // Calculate the radius map.
-#ifdef WITH_OPENMP
-  #pragma omp parallel for
-#endif
-  for(int locId = 0; locId < pixelCount; ++locId)
+  ORUtils::ParallelFor(0, pixelCount, [&](int locId)
   {
     calculate_radius(locId, depthMap, normalMap, intrinsics, radiusMap);
-  }
+  });
 }
 
 template <typename TSurfel>
@@ -19,6 +19,13 @@ namespace ITMLib
 		void *allocationTempData_host;
 		unsigned char *entriesAllocType_device;
 		Vector4s *blockCoords_device;
+		int nextReclaimBucket;
+
+		/// priority histogram of the per frame budgets, followed by the quota left in the cut-off bin and the number of selected blocks
+		int *budgetHistogram_device;
+		int *budgetedEntryIDs_device;
+		/// per voxel block, how many frames in a row it was left out by the integration budget
+		unsigned char *deferredFrames_device;
 
 	public:
 		void ResetScene(ITMScene<TVoxel, ITMVoxelBlockHash> *scene);
@@ -29,6 +36,10 @@ namespace ITMLib
 		void IntegrateIntoScene(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, const ITMView *view, const ITMTrackingState *trackingState,
 			const ITMRenderState *renderState);
 
+		void DefragmentScene(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, int maxSwaps);
+
+		void ReclaimExcessEntries(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, int noBuckets, float sweepThreshold);
+
 		ITMSceneReconstructionEngine_CUDA(void);
 		~ITMSceneReconstructionEngine_CUDA(void);
 	};
@@ -44,5 +55,9 @@ namespace ITMLib
 
 		void IntegrateIntoScene(ITMScene<TVoxel, ITMPlainVoxelArray> *scene, const ITMView *view, const ITMTrackingState *trackingState,
 			const ITMRenderState *renderState);
+
+		void DefragmentScene(ITMScene<TVoxel, ITMPlainVoxelArray> *scene, int maxSwaps);
+
+		void ReclaimExcessEntries(ITMScene<TVoxel, ITMPlainVoxelArray> *scene, int noBuckets, float sweepThreshold);
 	};
 }
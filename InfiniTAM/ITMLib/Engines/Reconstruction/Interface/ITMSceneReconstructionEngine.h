@@ -2,7 +2,9 @@
 
 #pragma once
 
+#include <algorithm>
 #include <math.h>
+#include <vector>
 
 #include "../../../Objects/RenderStates/ITMRenderState.h"
 #include "../../../Objects/Scene/ITMScene.h"
@@ -41,7 +43,177 @@ namespace ITMLib
 		virtual void IntegrateIntoScene(ITMScene<TVoxel,TIndex> *scene, const ITMView *view, const ITMTrackingState *trackingState,
 			const ITMRenderState *renderState) = 0;
 
-		ITMSceneReconstructionEngine(void) { }
+		/** Exchange up to @p maxSwaps pairs of voxel blocks to
+		    move the blocks towards Morton order of their positions
+		    in memory, patching the hash entries accordingly. Meant
+		    for frames on which nothing is integrated.
+		*/
+		virtual void DefragmentScene(ITMScene<TVoxel,TIndex> *scene, int maxSwaps) = 0;
+
+		/** Unlink deleted entries (ptr < -1) from the excess lists
+		    of @p noBuckets hash buckets, continuing after the buckets
+		    visited by the previous call, and return their slots to
+		    the excess allocation list. All buckets are visited once
+		    more than @p sweepThreshold of the excess list is in use.
+		    Live entries never move, as their indices are referenced
+		    by the visible lists and the global cache.
+		*/
+		virtual void ReclaimExcessEntries(ITMScene<TVoxel,TIndex> *scene, int noBuckets, float sweepThreshold) = 0;
+
+		ITMSceneReconstructionEngine(void) : planCursor(0), scanCursor(0), scannedTotalEntries(0) { }
 		virtual ~ITMSceneReconstructionEngine(void) { }
+
+	protected:
+		/** Interleaves the bits of a block position, so that
+		    sorting by the code keeps nearby blocks together.
+		*/
+		static unsigned long long BlockMortonCode(const Vector3s & pos)
+		{
+			unsigned long long code = 0;
+			unsigned int x = (unsigned short)pos.x, y = (unsigned short)pos.y, z = (unsigned short)pos.z;
+
+			// shift into the unsigned range so that negative positions sort below positive ones
+			x ^= 0x8000; y ^= 0x8000; z ^= 0x8000;
+
+			for (int bit = 0; bit < 16; bit++)
+			{
+				code |= (unsigned long long)((x >> bit) & 1) << (3 * bit);
+				code |= (unsigned long long)((y >> bit) & 1) << (3 * bit + 1);
+				code |= (unsigned long long)((z >> bit) & 1) << (3 * bit + 2);
+			}
+
+			return code;
+		}
+
+		/** Plans up to @p maxSwaps exchanges of voxel blocks between
+		    pairs of hash entries, such that the k-th allocated block
+		    in Morton order moves to the k-th smallest occupied slot
+		    of the local VBA. The pairs are disjoint, so they can be
+		    carried out in parallel. Free slots are never touched.
+
+		    The work per call is bounded by @p maxSwaps. The Morton
+		    order of the blocks is kept across calls, and each call
+		    continues after the blocks already placed and looks at
+		    no more than BLOCK_SWAP_PLAN_BLOCKS * @p maxSwaps of
+		    them. Once all are placed, the hash table is scanned
+		    again, BLOCK_SWAP_SCAN_ENTRIES * @p maxSwaps entries per
+		    call, and the order is rebuilt when the scan wraps
+		    around. Blocks freed or moved by others in the meantime
+		    are skipped, new ones wait for the next scan.
+		*/
+		void PlanBlockSwaps(const ITMHashEntry *hashTable, int noTotalEntries, int noVoxelBlocks, int maxSwaps, std::vector<Vector2i> & entrySwaps)
+		{
+			static const int BLOCK_SWAP_SCAN_ENTRIES = 256;
+			static const int BLOCK_SWAP_PLAN_BLOCKS = 16;
+
+			entrySwaps.clear();
+			if (maxSwaps <= 0) return;
+
+			if (scannedTotalEntries != noTotalEntries || (int)slotOwners.size() != noVoxelBlocks)
+			{
+				plannedBlocks.clear(); plannedSlots.clear(); slotOwners.assign(noVoxelBlocks, -1);
+				scannedBlocks.clear();
+				planCursor = 0; scanCursor = 0; scannedTotalEntries = noTotalEntries;
+			}
+
+			if (planCursor >= plannedBlocks.size()) ScanAllocatedBlocks(hashTable, noTotalEntries, noVoxelBlocks, BLOCK_SWAP_SCAN_ENTRIES * maxSwaps);
+
+			size_t endBlockId = MIN(plannedBlocks.size(), planCursor + (size_t)maxSwaps * BLOCK_SWAP_PLAN_BLOCKS);
+			size_t firstDeferredId = endBlockId, blockId;
+			std::vector<int> swappedEntries;
+
+			for (blockId = planCursor; blockId < endBlockId && (int)entrySwaps.size() < maxSwaps; blockId++)
+			{
+				const AllocatedBlock & block = plannedBlocks[blockId];
+				const ITMHashEntry & entry = hashTable[block.entryId];
+				int targetPtr = plannedSlots[blockId];
+
+				// freed, or the entry now holds another block
+				if (entry.ptr < 0 || entry.ptr >= noVoxelBlocks || BlockMortonCode(entry.pos) != block.code) continue;
+				if (entry.ptr == targetPtr) continue;
+
+				// the target slot was freed or changed hands outside the planned swaps
+				int otherEntryId = slotOwners[targetPtr];
+				if (otherEntryId < 0 || hashTable[otherEntryId].ptr != targetPtr) continue;
+
+				// one of the two already takes part in a swap of this call, retry on the next one
+				if (std::find(swappedEntries.begin(), swappedEntries.end(), block.entryId) != swappedEntries.end() ||
+					std::find(swappedEntries.begin(), swappedEntries.end(), otherEntryId) != swappedEntries.end())
+				{
+					firstDeferredId = MIN(firstDeferredId, blockId);
+					continue;
+				}
+
+				entrySwaps.push_back(Vector2i(block.entryId, otherEntryId));
+				swappedEntries.push_back(block.entryId); swappedEntries.push_back(otherEntryId);
+
+				slotOwners[entry.ptr] = otherEntryId;
+				slotOwners[targetPtr] = block.entryId;
+			}
+
+			planCursor = MIN(firstDeferredId, blockId);
+		}
+
+	private:
+		struct AllocatedBlock
+		{
+			unsigned long long code;
+			int entryId;
+			bool operator<(const AllocatedBlock & other) const { return code < other.code || (code == other.code && entryId < other.entryId); }
+		};
+
+		/// allocated blocks in Morton order, the sorted occupied slots and the hash entry holding each slot, as of the last full scan
+		std::vector<AllocatedBlock> plannedBlocks;
+		std::vector<int> plannedSlots, slotOwners;
+		/// blocks before this one in plannedBlocks have been placed
+		size_t planCursor;
+
+		/// allocated blocks found by the scan in progress
+		std::vector<AllocatedBlock> scannedBlocks;
+		/// next hash entry to scan
+		int scanCursor, scannedTotalEntries;
+
+		/** Scans the next @p noEntries hash entries and, when the
+		    scan reaches the end of the table, sorts what it found
+		    and makes it the plan. The slots are only read then, so
+		    that they all come from the same state of the table.
+		*/
+		void ScanAllocatedBlocks(const ITMHashEntry *hashTable, int noTotalEntries, int noVoxelBlocks, int noEntries)
+		{
+			int endEntryId = MIN(noTotalEntries, scanCursor + noEntries);
+
+			for (int entryId = scanCursor; entryId < endEntryId; entryId++)
+			{
+				int ptr = hashTable[entryId].ptr;
+				if (ptr < 0 || ptr >= noVoxelBlocks) continue;
+
+				AllocatedBlock block = { BlockMortonCode(hashTable[entryId].pos), entryId };
+				scannedBlocks.push_back(block);
+			}
+
+			scanCursor = endEntryId;
+			if (scanCursor < noTotalEntries) return;
+
+			plannedBlocks.clear();
+			plannedSlots.clear();
+			slotOwners.assign(noVoxelBlocks, -1);
+
+			// drop the blocks freed since they were scanned
+			for (size_t blockId = 0; blockId < scannedBlocks.size(); blockId++)
+			{
+				const ITMHashEntry & entry = hashTable[scannedBlocks[blockId].entryId];
+				if (entry.ptr < 0 || entry.ptr >= noVoxelBlocks || BlockMortonCode(entry.pos) != scannedBlocks[blockId].code) continue;
+
+				plannedBlocks.push_back(scannedBlocks[blockId]);
+				plannedSlots.push_back(entry.ptr);
+				slotOwners[entry.ptr] = scannedBlocks[blockId].entryId;
+			}
+
+			std::sort(plannedBlocks.begin(), plannedBlocks.end());
+			std::sort(plannedSlots.begin(), plannedSlots.end());
+
+			scannedBlocks.clear();
+			planCursor = 0; scanCursor = 0;
+		}
 	};
 }
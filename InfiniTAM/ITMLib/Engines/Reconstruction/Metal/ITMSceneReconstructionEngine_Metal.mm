@@ -206,7 +206,7 @@ void ITMSceneReconstructionEngine_Metal<TVoxel, ITMVoxelBlockHash>::AllocateScen
                         ITMHashEntry hashEntry;
                         hashEntry.pos.x = pt_block_all.x; hashEntry.pos.y = pt_block_all.y; hashEntry.pos.z = pt_block_all.z;
                         hashEntry.ptr = voxelAllocationList[vbaIdx];
-                        hashEntry.offset = 0;
+                        hashEntry.offset = hashTable[targetIdx].offset; // keep the excess list of a reused entry
 
                         hashTable[targetIdx] = hashEntry;
                     }
@@ -3,15 +3,38 @@
 #pragma once
 
 #include "../../../Objects/Scene/ITMRepresentationAccess.h"
+#include "../../../Objects/Scene/ITMVoxelTypes.h"
 #include "../../../Utils/ITMPixelUtils.h"
 
+/** Fuses a depth observation at signed distance eta (already known to be >= -mu) into the voxel. */
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline void fuseDepthObservation(DEVICEPTR(TVoxel) &voxel, float eta, float mu, int maxW)
+{
+	float oldF, newF;
+	int oldW, newW;
+
+	// compute updated SDF value and reliability
+	oldF = TVoxel::valueToFloat(voxel.sdf); oldW = voxel.w_depth;
+
+	newF = MIN(1.0f, eta / mu);
+	newW = 1;
+
+	newF = oldW * oldF + newW * newF;
+	newW = oldW + newW;
+	newF /= newW;
+	newW = MIN(newW, maxW);
+
+	// write back
+	voxel.sdf = TVoxel::floatToValue(newF);
+	voxel.w_depth = newW;
+}
+
 template<class TVoxel>
 _CPU_AND_GPU_CODE_ inline float computeUpdatedVoxelDepthInfo(DEVICEPTR(TVoxel) &voxel, const THREADPTR(Vector4f) & pt_model, const CONSTPTR(Matrix4f) & M_d,
 	const CONSTPTR(Vector4f) & projParams_d, float mu, int maxW, const CONSTPTR(float) *depth, const CONSTPTR(Vector2i) & imgSize)
 {
 	Vector4f pt_camera; Vector2f pt_image;
-	float depth_measure, eta, oldF, newF;
-	int oldW, newW;
+	float depth_measure, eta;
 
 	// project point into image
 	pt_camera = M_d * pt_model;
@@ -29,20 +52,7 @@ _CPU_AND_GPU_CODE_ inline float computeUpdatedVoxelDepthInfo(DEVICEPTR(TVoxel) &
 	eta = depth_measure - pt_camera.z;
 	if (eta < -mu) return eta;
 
-	// compute updated SDF value and reliability
-	oldF = TVoxel::valueToFloat(voxel.sdf); oldW = voxel.w_depth;
-
-	newF = MIN(1.0f, eta / mu);
-	newW = 1;
-
-	newF = oldW * oldF + newW * newF;
-	newW = oldW + newW;
-	newF /= newW;
-	newW = MIN(newW, maxW);
-
-	// write back
-	voxel.sdf = TVoxel::floatToValue(newF);
-	voxel.w_depth = newW;
+	fuseDepthObservation(voxel, eta, mu, maxW);
 
 	return eta;
 }
@@ -89,36 +99,46 @@ _CPU_AND_GPU_CODE_ inline float computeUpdatedVoxelDepthInfo(DEVICEPTR(TVoxel) &
 	return eta;
 }
 
-template<class TVoxel>
-_CPU_AND_GPU_CODE_ inline void computeUpdatedVoxelColorInfo(DEVICEPTR(TVoxel) &voxel, const THREADPTR(Vector4f) & pt_model, const CONSTPTR(Matrix4f) & M_rgb,
-	const CONSTPTR(Vector4f) & projParams_rgb, float mu, uchar maxW, float eta, const CONSTPTR(Vector4u) *rgb, const CONSTPTR(Vector2i) & imgSize)
+/** Averages the colour observed at pt_model into colour (in [0, 1]) with weight w. Returns false if pt_model is outside the colour image. */
+_CPU_AND_GPU_CODE_ inline bool fuseColorObservation(THREADPTR(Vector3f) &colour, THREADPTR(float) &w, const THREADPTR(Vector4f) & pt_model,
+	const CONSTPTR(Matrix4f) & M_rgb, const CONSTPTR(Vector4f) & projParams_rgb, uchar maxW, const CONSTPTR(Vector4u) *rgb, const CONSTPTR(Vector2i) & imgSize)
 {
 	Vector4f pt_camera; Vector2f pt_image;
-	Vector3f rgb_measure, oldC, newC; Vector3u buffV3u;
-	float newW, oldW;
-
-	buffV3u = voxel.clr;
-	oldW = (float)voxel.w_color;
-
-	oldC = TO_FLOAT3(buffV3u) / 255.0f;
-	newC = oldC;
+	Vector3f rgb_measure, newC;
+	float newW;
 
 	pt_camera = M_rgb * pt_model;
 
 	pt_image.x = projParams_rgb.x * pt_camera.x / pt_camera.z + projParams_rgb.z;
 	pt_image.y = projParams_rgb.y * pt_camera.y / pt_camera.z + projParams_rgb.w;
 
-	if ((pt_image.x < 1) || (pt_image.x > imgSize.x - 2) || (pt_image.y < 1) || (pt_image.y > imgSize.y - 2)) return;
+	if ((pt_image.x < 1) || (pt_image.x > imgSize.x - 2) || (pt_image.y < 1) || (pt_image.y > imgSize.y - 2)) return false;
 
 	rgb_measure = TO_VECTOR3(interpolateBilinear(rgb, pt_image, imgSize)) / 255.0f;
 	//rgb_measure = rgb[(int)(pt_image.x + 0.5f) + (int)(pt_image.y + 0.5f) * imgSize.x].toVector3().toFloat() / 255.0f;
 	newW = 1;
 
-	newC = oldC * oldW + rgb_measure * newW;
-	newW = oldW + newW;
+	newC = colour * w + rgb_measure * newW;
+	newW = w + newW;
 	newC /= newW;
 	newW = MIN(newW, maxW);
 
+	colour = newC;
+	w = newW;
+
+	return true;
+}
+
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline void computeUpdatedVoxelColorInfo(DEVICEPTR(TVoxel) &voxel, const THREADPTR(Vector4f) & pt_model, const CONSTPTR(Matrix4f) & M_rgb,
+	const CONSTPTR(Vector4f) & projParams_rgb, float mu, uchar maxW, float eta, const CONSTPTR(Vector4u) *rgb, const CONSTPTR(Vector2i) & imgSize)
+{
+	Vector3u buffV3u = voxel.clr;
+	Vector3f newC = TO_FLOAT3(buffV3u) / 255.0f;
+	float newW = (float)voxel.w_color;
+
+	if (!fuseColorObservation(newC, newW, pt_model, M_rgb, projParams_rgb, maxW, rgb, imgSize)) return;
+
 	voxel.clr = TO_UCHAR3(newC * 255.0f);
 	voxel.w_color = (uchar)newW;
 }
@@ -136,6 +156,14 @@ struct ComputeUpdatedVoxelInfo<false, false, TVoxel> {
 	{
 		computeUpdatedVoxelDepthInfo(voxel, pt_model, M_d, projParams_d, mu, maxW, depth, imgSize_d);
 	}
+
+	/** Fuses an observation whose depth has already been looked up, eta must be >= -mu. */
+	_CPU_AND_GPU_CODE_ static void fuse(DEVICEPTR(TVoxel) & voxel, float eta, const THREADPTR(Vector4f) & pt_model,
+		const THREADPTR(Matrix4f) & M_rgb, const THREADPTR(Vector4f) & projParams_rgb, float mu, int maxW,
+		const CONSTPTR(Vector4u) *rgb, const THREADPTR(Vector2i) & imgSize_rgb)
+	{
+		fuseDepthObservation(voxel, eta, mu, maxW);
+	}
 };
 
 template<class TVoxel>
@@ -151,6 +179,15 @@ struct ComputeUpdatedVoxelInfo<true, false, TVoxel> {
 		if ((eta > mu) || (fabs(eta / mu) > 0.25f)) return;
 		computeUpdatedVoxelColorInfo(voxel, pt_model, M_rgb, projParams_rgb, mu, maxW, eta, rgb, imgSize_rgb);
 	}
+
+	_CPU_AND_GPU_CODE_ static void fuse(DEVICEPTR(TVoxel) & voxel, float eta, const THREADPTR(Vector4f) & pt_model,
+		const THREADPTR(Matrix4f) & M_rgb, const THREADPTR(Vector4f) & projParams_rgb, float mu, int maxW,
+		const CONSTPTR(Vector4u) *rgb, const THREADPTR(Vector2i) & imgSize_rgb)
+	{
+		fuseDepthObservation(voxel, eta, mu, maxW);
+		if ((eta > mu) || (fabs(eta / mu) > 0.25f)) return;
+		computeUpdatedVoxelColorInfo(voxel, pt_model, M_rgb, projParams_rgb, mu, maxW, eta, rgb, imgSize_rgb);
+	}
 };
 
 template<class TVoxel>
@@ -181,6 +218,43 @@ struct ComputeUpdatedVoxelInfo<true, true, TVoxel> {
 	}
 };
 
+#ifndef __METALC__
+
+/** ITMVoxel_b_rgb has no colour weight, its colour is averaged with the
+    depth weight from before this observation.
+*/
+template<>
+struct ComputeUpdatedVoxelInfo<true, false, ITMVoxel_b_rgb> {
+	_CPU_AND_GPU_CODE_ static void compute(DEVICEPTR(ITMVoxel_b_rgb) & voxel, const THREADPTR(Vector4f) & pt_model,
+		const THREADPTR(Matrix4f) & M_d, const THREADPTR(Vector4f) & projParams_d,
+		const THREADPTR(Matrix4f) & M_rgb, const THREADPTR(Vector4f) & projParams_rgb,
+		float mu, int maxW,
+		const CONSTPTR(float) *depth, const CONSTPTR(float) *confidence, const CONSTPTR(Vector2i) & imgSize_d,
+		const CONSTPTR(Vector4u) *rgb, const THREADPTR(Vector2i) & imgSize_rgb)
+	{
+		float colorW = (float)voxel.w_depth;
+		float eta = computeUpdatedVoxelDepthInfo(voxel, pt_model, M_d, projParams_d, mu, maxW, depth, imgSize_d);
+		if ((eta > mu) || (fabs(eta / mu) > 0.25f)) return;
+
+		Vector3f colour = voxel.clr.toFloat() / 255.0f;
+		if (fuseColorObservation(colour, colorW, pt_model, M_rgb, projParams_rgb, maxW, rgb, imgSize_rgb)) voxel.clr = TO_UCHAR3(colour * 255.0f);
+	}
+
+	_CPU_AND_GPU_CODE_ static void fuse(DEVICEPTR(ITMVoxel_b_rgb) & voxel, float eta, const THREADPTR(Vector4f) & pt_model,
+		const THREADPTR(Matrix4f) & M_rgb, const THREADPTR(Vector4f) & projParams_rgb, float mu, int maxW,
+		const CONSTPTR(Vector4u) *rgb, const THREADPTR(Vector2i) & imgSize_rgb)
+	{
+		float colorW = (float)voxel.w_depth;
+		fuseDepthObservation(voxel, eta, mu, maxW);
+		if ((eta > mu) || (fabs(eta / mu) > 0.25f)) return;
+
+		Vector3f colour = voxel.clr.toFloat() / 255.0f;
+		if (fuseColorObservation(colour, colorW, pt_model, M_rgb, projParams_rgb, maxW, rgb, imgSize_rgb)) voxel.clr = TO_UCHAR3(colour * 255.0f);
+	}
+};
+
+#endif
+
 _CPU_AND_GPU_CODE_ inline void buildHashAllocAndVisibleTypePP(DEVICEPTR(uchar) *entriesAllocType, DEVICEPTR(uchar) *entriesVisibleType, int x, int y,
 	DEVICEPTR(Vector4s) *blockCoords, const CONSTPTR(float) *depth, Matrix4f invM_d, Vector4f projParams_d, float mu, Vector2i imgSize,
 	float oneOverVoxelSize, const CONSTPTR(ITMHashEntry) *hashTable, float viewFrustum_min, float viewFrustum_max)
@@ -234,29 +308,29 @@ _CPU_AND_GPU_CODE_ inline void buildHashAllocAndVisibleTypePP(DEVICEPTR(uchar) *
 
 		if (!isFound)
 		{
-			bool isExcess = false;
-			if (hashEntry.ptr >= -1) //seach excess list only if there is no room in ordered part
+			// a deleted entry at the head of the bucket is reused, but its excess list may still hold live entries
+			unsigned int bucketIdx = hashIdx;
+			bool isExcess = hashEntry.ptr >= -1;
+
+			while (hashEntry.offset >= 1)
 			{
-				while (hashEntry.offset >= 1)
-				{
-					hashIdx = SDF_BUCKET_NUM + hashEntry.offset - 1;
-					hashEntry = hashTable[hashIdx];
+				hashIdx = SDF_BUCKET_NUM + hashEntry.offset - 1;
+				hashEntry = hashTable[hashIdx];
 
-					if (IS_EQUAL3(hashEntry.pos, blockPos) && hashEntry.ptr >= -1)
-					{
-						//entry has been streamed out but is visible or in memory and visible
-						entriesVisibleType[hashIdx] = (hashEntry.ptr == -1) ? 2 : 1;
+				if (IS_EQUAL3(hashEntry.pos, blockPos) && hashEntry.ptr >= -1)
+				{
+					//entry has been streamed out but is visible or in memory and visible
+					entriesVisibleType[hashIdx] = (hashEntry.ptr == -1) ? 2 : 1;
 
-						isFound = true;
-						break;
-					}
+					isFound = true;
+					break;
 				}
-
-				isExcess = true;
 			}
 
 			if (!isFound) //still not found
 			{
+				if (!isExcess) hashIdx = bucketIdx;
+
 				entriesAllocType[hashIdx] = isExcess ? 2 : 1; //needs allocation 
 				if (!isExcess) entriesVisibleType[hashIdx] = 1; //new entry is visible
 
@@ -344,3 +418,54 @@ _CPU_AND_GPU_CODE_ inline void checkBlockVisibility(THREADPTR(bool) &isVisible,
 	checkPointVisibility<useSwapping>(isVisible, isVisibleEnlarged, pt_image, M_d, projParams_d, imgSize);
 	if (isVisible) return;
 }
+
+#ifndef __METALC__
+
+/** Per frame allocation and integration budgets rank blocks by a priority, lower first. On the GPU the
+    priorities are counted in SDF_PRIORITY_BIN_NUM bins of width one to find the cut-off. */
+#define SDF_PRIORITY_BIN_NUM 128
+
+_CPU_AND_GPU_CODE_ inline int priorityBin(float priority)
+{
+	return MIN(MAX((int)priority, 0), SDF_PRIORITY_BIN_NUM - 1);
+}
+
+/** Allocation priority of a requested block, its distance from the camera in blocks. */
+_CPU_AND_GPU_CODE_ inline float computeAllocationPriority(const THREADPTR(Vector4s) &blockPos, const THREADPTR(Vector3f) &cameraBlockPos)
+{
+	float dx = (float)blockPos.x + 0.5f - cameraBlockPos.x;
+	float dy = (float)blockPos.y + 0.5f - cameraBlockPos.y;
+	float dz = (float)blockPos.z + 0.5f - cameraBlockPos.z;
+
+	return sqrtf(dx * dx + dy * dy + dz * dz);
+}
+
+/** Integration priority of a visible block: how far its centre lies from the observed surface along
+    the ray, in units of mu, less the number of frames the block has been deferred. Blocks whose centre
+    does not see a depth value come last.
+*/
+_CPU_AND_GPU_CODE_ inline float computeIntegrationPriority(const THREADPTR(Vector3s) &blockPos, int deferredFrames, const CONSTPTR(Matrix4f) &M_d,
+	const CONSTPTR(Vector4f) &projParams_d, float voxelSize, float mu, const CONSTPTR(float) *depth, const CONSTPTR(Vector2i) &imgSize)
+{
+	float blockSize = (float)SDF_BLOCK_SIZE * voxelSize;
+	Vector4f pt_model((blockPos.x + 0.5f) * blockSize, (blockPos.y + 0.5f) * blockSize, (blockPos.z + 0.5f) * blockSize, 1.0f);
+	Vector4f pt_camera = M_d * pt_model;
+
+	float priority = (float)(SDF_PRIORITY_BIN_NUM - 1);
+
+	if (pt_camera.z > 0.0f)
+	{
+		int x = (int)(projParams_d.x * pt_camera.x / pt_camera.z + projParams_d.z + 0.5f);
+		int y = (int)(projParams_d.y * pt_camera.y / pt_camera.z + projParams_d.w + 0.5f);
+
+		if (x >= 0 && x < imgSize.x && y >= 0 && y < imgSize.y)
+		{
+			float depth_measure = depth[x + y * imgSize.x];
+			if (depth_measure > 0.0f) priority = MIN(fabs(depth_measure - pt_camera.z) / mu, priority);
+		}
+	}
+
+	return MAX(priority - (float)deferredFrames, 0.0f);
+}
+
+#endif
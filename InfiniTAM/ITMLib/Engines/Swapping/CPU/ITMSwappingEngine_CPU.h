@@ -13,6 +13,8 @@ namespace ITMLib
 		void IntegrateGlobalIntoLocal(ITMScene<TVoxel, TIndex> *scene, ITMRenderState *renderState) {}
 		void SaveToGlobalMemory(ITMScene<TVoxel, TIndex> *scene, ITMRenderState *renderState) {}
 		void CleanLocalMemory(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState *renderState) {}
+		void SaveDistantToGlobalMemory(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState *renderState,
+			const Vector3f &windowCentre, float windowRadius, int maxResidentBlocks) {}
 	};
 
 	template<class TVoxel>
@@ -28,6 +30,8 @@ namespace ITMLib
 		void IntegrateGlobalIntoLocal(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState *renderState);
 		void SaveToGlobalMemory(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState *renderState);
 		void CleanLocalMemory(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState *renderState);
+		void SaveDistantToGlobalMemory(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState *renderState,
+			const Vector3f &windowCentre, float windowRadius, int maxResidentBlocks);
 
 		ITMSwappingEngine_CPU(void);
 		~ITMSwappingEngine_CPU(void);
@@ -4,6 +4,7 @@
 
 #include "../Shared/ITMSwappingEngine_Shared.h"
 #include "../../../Objects/RenderStates/ITMRenderState_VH.h"
+#include "../../../../ORUtils/Trace.h"
 using namespace ITMLib;
 
 template<class TVoxel>
@@ -55,7 +56,10 @@ int ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::LoadFromGlobalMemory(ITMSc
 			if (globalCache->HasStoredData(entryId))
 			{
 				hasSyncedData_global[i] = true;
-				memcpy(syncedVoxelBlocks_global + i * SDF_BLOCK_SIZE3, globalCache->GetStoredVoxelBlock(entryId), SDF_BLOCK_SIZE3 * sizeof(TVoxel));
+				globalCache->GetStoredData(entryId, syncedVoxelBlocks_global + i * SDF_BLOCK_SIZE3);
+
+				// the block is about to be in the local VBA again and is saved when it next leaves it
+				if (globalCache->IsBounded()) globalCache->DropStoredData(entryId);
 			}
 		}
 	}
@@ -68,6 +72,8 @@ int ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::LoadFromGlobalMemory(ITMSc
 template<class TVoxel>
 void ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::IntegrateGlobalIntoLocal(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState *renderState)
 {
+	ORUtils::TraceSpan span("swap in");
+
 	ITMGlobalCache<TVoxel> *globalCache = scene->globalCache;
 
 	ITMHashEntry *hashTable = scene->index.GetEntries();
@@ -95,17 +101,23 @@ void ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::IntegrateGlobalIntoLocal(
 
 			for (int vIdx = 0; vIdx < SDF_BLOCK_SIZE3; vIdx++)
 			{
-				CombineVoxelInformation<TVoxel::hasColorInformation, TVoxel>::compute(srcVB[vIdx], dstVB[vIdx], maxW);
+				TVoxel dstVoxel = loadVoxel(dstVB, vIdx);
+				CombineVoxelInformation<TVoxel::hasColorInformation, TVoxel>::compute(loadVoxel(srcVB, vIdx), dstVoxel, maxW);
+				storeVoxel(dstVB, vIdx, dstVoxel);
 			}
 		}
 
 		swapStates[entryDestId].state = 2;
 	}
+
+	this->noSwappedInBlocks = noNeededEntries;
 }
 
 template<class TVoxel>
 void ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::SaveToGlobalMemory(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState *renderState)
 {
+	ORUtils::TraceSpan span("swap out");
+
 	ITMGlobalCache<TVoxel> *globalCache = scene->globalCache;
 
 	ITMHashSwapState *swapStates = globalCache->GetSwapStates(false);
@@ -123,6 +135,7 @@ void ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::SaveToGlobalMemory(ITMSce
 
 	TVoxel *localVBA = scene->localVBA.GetVoxelBlocks();
 	int *voxelAllocationList = scene->localVBA.GetAllocationList();
+	uchar *saturatedBlocks = scene->localVBA.GetSaturatedBlocks();
 
 	int noTotalEntries = globalCache->noTotalEntries;
 	
@@ -153,8 +166,9 @@ void ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::SaveToGlobalMemory(ITMSce
 				noAllocatedVoxelEntries++;
 				voxelAllocationList[vbaIdx + 1] = localPtr;
 				hashTable[entryDestId].ptr = -1;
+				saturatedBlocks[localPtr] = 0;
 
-				for (int i = 0; i < SDF_BLOCK_SIZE3; i++) localVBALocation[i] = TVoxel();
+				for (int i = 0; i < SDF_BLOCK_SIZE3; i++) storeVoxel(localVBALocation, i, TVoxel());
 			}
 
 			noNeededEntries++;
@@ -173,16 +187,21 @@ void ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::SaveToGlobalMemory(ITMSce
 				globalCache->SetStoredData(neededEntryIDs_global[entryId], syncedVoxelBlocks_global + entryId * SDF_BLOCK_SIZE3);
 		}
 	}
+
+	this->noSwappedOutBlocks = noNeededEntries;
 }
 
 template<class TVoxel>
 void ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::CleanLocalMemory(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState *renderState)
 {
+	ORUtils::TraceSpan span("clean local memory");
+
 	ITMHashEntry *hashTable = scene->index.GetEntries();
 	uchar *entriesVisibleType = ((ITMRenderState_VH*)renderState)->GetEntriesVisibleType();
 
 	TVoxel *localVBA = scene->localVBA.GetVoxelBlocks();
 	int *voxelAllocationList = scene->localVBA.GetAllocationList();
+	uchar *saturatedBlocks = scene->localVBA.GetSaturatedBlocks();
 
 	int noTotalEntries = scene->index.noTotalEntries;
 
@@ -204,9 +223,10 @@ void ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::CleanLocalMemory(ITMScene
 			{
 				noAllocatedVoxelEntries++;
 				voxelAllocationList[vbaIdx + 1] = localPtr;
-				hashTable[entryDestId].ptr = -1;
+				hashTable[entryDestId].ptr = -2;
+				saturatedBlocks[localPtr] = 0;
 
-				for (int i = 0; i < SDF_BLOCK_SIZE3; i++) localVBALocation[i] = TVoxel();
+				for (int i = 0; i < SDF_BLOCK_SIZE3; i++) storeVoxel(localVBALocation, i, TVoxel());
 			}
 
 			noNeededEntries++;
@@ -214,4 +234,77 @@ void ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::CleanLocalMemory(ITMScene
 	}
 
 	scene->localVBA.lastFreeBlockId = noAllocatedVoxelEntries;
-}
\ No newline at end of file
+
+	this->noSwappedOutBlocks = noNeededEntries;
+}
+
+template<class TVoxel>
+void ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::SaveDistantToGlobalMemory(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState *renderState,
+	const Vector3f &windowCentre, float windowRadius, int maxResidentBlocks)
+{
+	ORUtils::TraceSpan span("swap out distant blocks");
+
+	ITMGlobalCache<TVoxel> *globalCache = scene->globalCache;
+
+	ITMHashSwapState *swapStates = globalCache->GetSwapStates(false);
+
+	ITMHashEntry *hashTable = scene->index.GetEntries();
+	uchar *entriesVisibleType = ((ITMRenderState_VH*)renderState)->GetEntriesVisibleType();
+
+	int *neededEntryIDs_local = globalCache->GetNeededEntryIDs(false);
+
+	TVoxel *localVBA = scene->localVBA.GetVoxelBlocks();
+	int *voxelAllocationList = scene->localVBA.GetAllocationList();
+	uchar *saturatedBlocks = scene->localVBA.GetSaturatedBlocks();
+
+	int noTotalEntries = globalCache->noTotalEntries;
+	float blockSize = scene->sceneParams->voxelSize * SDF_BLOCK_SIZE;
+
+	std::vector<std::pair<float, int> > candidates;
+	for (int entryId = 0; entryId < noTotalEntries; entryId++)
+	{
+		if (swapStates[entryId].state == 2 && hashTable[entryId].ptr >= 0 && entriesVisibleType[entryId] == 0)
+		{
+			Vector3f blockCentre = (hashTable[entryId].pos.toFloat() + Vector3f(0.5f)) * blockSize;
+			Vector3f offset = blockCentre - windowCentre;
+			candidates.push_back(std::make_pair(dot(offset, offset), entryId));
+		}
+	}
+
+	int noAllocatedVoxelEntries = scene->localVBA.lastFreeBlockId;
+	int noResidentBlocks = scene->index.getNumAllocatedVoxelBlocks() - 1 - noAllocatedVoxelEntries;
+	int noNeededEntries = this->SelectDistantBlocks(candidates, noResidentBlocks, windowRadius, maxResidentBlocks);
+
+	for (int i = 0; i < noNeededEntries; i++)
+	{
+		int entryDestId = candidates[i].second;
+		int localPtr = hashTable[entryDestId].ptr;
+		TVoxel *localVBALocation = localVBA + localPtr * SDF_BLOCK_SIZE3;
+
+		globalCache->SetStoredData(entryDestId, localVBALocation);
+		swapStates[entryDestId].state = 0;
+
+		noAllocatedVoxelEntries++;
+		voxelAllocationList[noAllocatedVoxelEntries] = localPtr;
+		hashTable[entryDestId].ptr = -1;
+		saturatedBlocks[localPtr] = 0;
+
+		for (int vIdx = 0; vIdx < SDF_BLOCK_SIZE3; vIdx++) storeVoxel(localVBALocation, vIdx, TVoxel());
+	}
+
+	scene->localVBA.lastFreeBlockId = noAllocatedVoxelEntries;
+
+	// blocks dropped from a full cache are gone, free their hash entries
+	if (globalCache->IsBounded())
+	{
+		int noDroppedEntries = globalCache->DropOldestStoredData(neededEntryIDs_local, SDF_TRANSFER_BLOCK_NUM);
+		for (int i = 0; i < noDroppedEntries; i++)
+		{
+			int entryId = neededEntryIDs_local[i];
+			if (hashTable[entryId].ptr == -1) hashTable[entryId].ptr = -2;
+			swapStates[entryId].state = 0;
+		}
+	}
+
+	this->noSwappedOutBlocks = noNeededEntries;
+}
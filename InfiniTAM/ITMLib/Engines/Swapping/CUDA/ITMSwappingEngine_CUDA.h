@@ -13,6 +13,8 @@ namespace ITMLib
 		void IntegrateGlobalIntoLocal(ITMScene<TVoxel, TIndex> *scene, ITMRenderState *renderState) {}
 		void SaveToGlobalMemory(ITMScene<TVoxel, TIndex> *scene, ITMRenderState *renderState) {}
 		void CleanLocalMemory(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState *renderState) {}
+		void SaveDistantToGlobalMemory(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState *renderState,
+			const Vector3f &windowCentre, float windowRadius, int maxResidentBlocks) {}
 	};
 
 	template<class TVoxel>
@@ -21,6 +23,7 @@ namespace ITMLib
 	private:
 		int *noNeededEntries_device, *noAllocatedVoxelEntries_device;
 		int *entriesToClean_device;
+		float *candidateDistances_device;
 
 		int LoadFromGlobalMemory(ITMScene<TVoxel, ITMVoxelBlockHash> *scene);
 
@@ -28,6 +31,8 @@ namespace ITMLib
 		void IntegrateGlobalIntoLocal(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState *renderState);
 		void SaveToGlobalMemory(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState *renderState);
 		void CleanLocalMemory(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState *renderState);
+		void SaveDistantToGlobalMemory(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState *renderState,
+			const Vector3f &windowCentre, float windowRadius, int maxResidentBlocks);
 
 		ITMSwappingEngine_CUDA(void);
 		~ITMSwappingEngine_CUDA(void);
@@ -2,6 +2,10 @@
 
 #pragma once
 
+#include <algorithm>
+#include <functional>
+#include <vector>
+
 #include "../../../Objects/RenderStates/ITMRenderState.h"
 #include "../../../Objects/Scene/ITMScene.h"
 #include "../../../Objects/Views/ITMView.h"
@@ -16,11 +20,47 @@ namespace ITMLib
 	template<class TVoxel, class TIndex>
 	class ITMSwappingEngine
 	{
+	protected:
+		/// Blocks moved in and out of the local VBA by the last swap in and swap out (or clean) calls
+		int noSwappedInBlocks, noSwappedOutBlocks;
+
+		/** Moves the blocks to swap out to the front of \p candidates, which holds the squared
+		    distance from the window centre and the entry id of every block that may be swapped
+		    out, and returns their number. These are the blocks outside the window radius and,
+		    if more than \p maxResidentBlocks are in the local VBA, the farthest blocks inside it.
+		*/
+		static int SelectDistantBlocks(std::vector<std::pair<float, int> > &candidates, int noResidentBlocks, float windowRadius, int maxResidentBlocks)
+		{
+			int noOutside = 0;
+			for (size_t i = 0; i < candidates.size(); i++)
+				if (candidates[i].first > windowRadius * windowRadius) noOutside++;
+
+			int noSelected = noOutside;
+			if (maxResidentBlocks > 0) noSelected = std::max(noSelected, noResidentBlocks - maxResidentBlocks);
+			noSelected = std::min(noSelected, std::min((int)candidates.size(), SDF_TRANSFER_BLOCK_NUM));
+
+			if (noSelected > 0)
+				std::nth_element(candidates.begin(), candidates.begin() + (noSelected - 1), candidates.end(), std::greater<std::pair<float, int> >());
+
+			return noSelected;
+		}
+
 	public:
 		virtual void IntegrateGlobalIntoLocal(ITMScene<TVoxel, TIndex> *scene, ITMRenderState *renderState) = 0;
 		virtual void SaveToGlobalMemory(ITMScene<TVoxel, TIndex> *scene, ITMRenderState *renderState) = 0;
 		virtual void CleanLocalMemory(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState *renderState) = 0;
 
+		/** Swaps out the invisible blocks farthest from \p windowCentre, keeping the local VBA to
+		    a window of \p windowRadius metres and at most \p maxResidentBlocks blocks (0 for no
+		    limit). Blocks the bounded global cache has to drop to make room are deleted.
+		*/
+		virtual void SaveDistantToGlobalMemory(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState *renderState,
+			const Vector3f &windowCentre, float windowRadius, int maxResidentBlocks) = 0;
+
+		int GetNoSwappedInBlocks(void) const { return noSwappedInBlocks; }
+		int GetNoSwappedOutBlocks(void) const { return noSwappedOutBlocks; }
+
+		ITMSwappingEngine(void) : noSwappedInBlocks(0), noSwappedOutBlocks(0) { }
 		virtual ~ITMSwappingEngine(void) { }
 	};
 }
@@ -3,6 +3,8 @@
 #pragma once
 
 #include "../../../Utils/ITMMath.h"
+#include "../../../Objects/Scene/ITMVoxelBlockLayout.h"
+#include "../../../Objects/Scene/ITMVoxelTypes.h"
 
 template<class TVoxel>
 _CPU_AND_GPU_CODE_ inline void combineVoxelDepthInformation(const CONSTPTR(TVoxel) & src, DEVICEPTR(TVoxel) & dst, int maxW)
@@ -62,3 +64,29 @@ struct CombineVoxelInformation<true,TVoxel> {
 	}
 };
 
+#ifndef __METALC__
+
+/** ITMVoxel_b_rgb shares the depth weight for its colour. */
+template<>
+struct CombineVoxelInformation<true, ITMVoxel_b_rgb> {
+	_CPU_AND_GPU_CODE_ static void compute(const CONSTPTR(ITMVoxel_b_rgb) & src, DEVICEPTR(ITMVoxel_b_rgb) & dst, int maxW)
+	{
+		int newW = dst.w_depth;
+		int oldW = src.w_depth;
+
+		if (oldW != 0)
+		{
+			Vector3f newC = dst.clr.toFloat() / 255.0f;
+			Vector3f oldC = src.clr.toFloat() / 255.0f;
+
+			newC = oldC * (float)oldW + newC * (float)newW;
+			newC /= (float)(oldW + newW);
+
+			dst.clr = TO_UCHAR3(newC * 255.0f);
+		}
+
+		combineVoxelDepthInformation(src, dst, maxW);
+	}
+};
+
+#endif
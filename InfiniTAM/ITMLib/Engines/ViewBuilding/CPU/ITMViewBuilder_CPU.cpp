@@ -4,6 +4,7 @@
 
 #include "../Shared/ITMViewBuilder_Shared.h"
 #include "../../../../ORUtils/MetalContext.h"
+#include "../../../../ORUtils/TaskScheduler.h"
 
 using namespace ITMLib;
 using namespace ORUtils;
@@ -16,8 +17,6 @@ void ITMViewBuilder_CPU::UpdateView(ITMView **view_ptr, ITMUChar4Image *rgbImage
 	if (*view_ptr == NULL)
 	{
 		*view_ptr = new ITMView(calib, rgbImage->noDims, rawDepthImage->noDims, false);
-		if (this->shortImage != NULL) delete this->shortImage;
-		this->shortImage = new ITMShortImage(rawDepthImage->noDims, true, false);
 		if (this->floatImage != NULL) delete this->floatImage;
 		this->floatImage = new ITMFloatImage(rawDepthImage->noDims, true, false);
 
@@ -29,22 +28,23 @@ void ITMViewBuilder_CPU::UpdateView(ITMView **view_ptr, ITMUChar4Image *rgbImage
 	}
 	ITMView *view = *view_ptr;
 
+	// the current image becomes the previous one by swapping, rather than copying, the two buffers
 	if (storePreviousImage)
 	{
 		if (!view->rgb_prev) view->rgb_prev = new ITMUChar4Image(rgbImage->noDims, true, false);
-		else view->rgb_prev->SetFrom(view->rgb, MemoryBlock<Vector4u>::CPU_TO_CPU);
+		else view->rgb_prev->Swap(*view->rgb);
 	}
 
 	view->rgb->SetFrom(rgbImage, MemoryBlock<Vector4u>::CPU_TO_CPU);
-	this->shortImage->SetFrom(rawDepthImage, MemoryBlock<short>::CPU_TO_CPU);
 
+	// the raw depth is converted where it is, without first being copied
 	switch (view->calib.disparityCalib.GetType())
 	{
 	case ITMDisparityCalib::TRAFO_KINECT:
-		this->ConvertDisparityToDepth(view->depth, this->shortImage, &(view->calib.intrinsics_d), view->calib.disparityCalib.GetParams());
+		this->ConvertDisparityToDepth(view->depth, rawDepthImage, &(view->calib.intrinsics_d), view->calib.disparityCalib.GetParams());
 		break;
 	case ITMDisparityCalib::TRAFO_AFFINE:
-		this->ConvertDepthAffineToFloat(view->depth, this->shortImage, view->calib.disparityCalib.GetParams());
+		this->ConvertDepthAffineToFloat(view->depth, rawDepthImage, view->calib.disparityCalib.GetParams());
 		break;
 	default:
 		break;
@@ -58,7 +58,7 @@ void ITMViewBuilder_CPU::UpdateView(ITMView **view_ptr, ITMUChar4Image *rgbImage
 		this->DepthFiltering(this->floatImage, view->depth);
 		this->DepthFiltering(view->depth, this->floatImage);
 		this->DepthFiltering(this->floatImage, view->depth);
-		view->depth->SetFrom(this->floatImage, MemoryBlock<float>::CPU_TO_CPU);
+		view->depth->Swap(*this->floatImage);
 	}
 
 	if (modelSensorNoise)
@@ -72,8 +72,6 @@ void ITMViewBuilder_CPU::UpdateView(ITMView **view_ptr, ITMUChar4Image *rgbImage
 	if (*view_ptr == NULL)
 	{
 		*view_ptr = new ITMViewIMU(calib, rgbImage->noDims, depthImage->noDims, false);
-		if (this->shortImage != NULL) delete this->shortImage;
-		this->shortImage = new ITMShortImage(depthImage->noDims, true, false);
 		if (this->floatImage != NULL) delete this->floatImage;
 		this->floatImage = new ITMFloatImage(depthImage->noDims, true, false);
 
@@ -100,8 +98,11 @@ void ITMViewBuilder_CPU::ConvertDisparityToDepth(ITMFloatImage *depth_out, const
 
 	float fx_depth = depthIntrinsics->projectionParamsSimple.fx;
 
-	for (int y = 0; y < imgSize.y; y++) for (int x = 0; x < imgSize.x; x++)
-		convertDisparityToDepth(d_out, x, y, d_in, disparityCalibParams, fx_depth, imgSize);
+	ORUtils::ParallelFor(0, imgSize.y, [&](int y)
+	{
+		for (int x = 0; x < imgSize.x; x++)
+			convertDisparityToDepth(d_out, x, y, d_in, disparityCalibParams, fx_depth, imgSize);
+	});
 }
 
 void ITMViewBuilder_CPU::ConvertDepthAffineToFloat(ITMFloatImage *depth_out, const ITMShortImage *depth_in, const Vector2f depthCalibParams)
@@ -111,8 +112,11 @@ void ITMViewBuilder_CPU::ConvertDepthAffineToFloat(ITMFloatImage *depth_out, con
 	const short *d_in = depth_in->GetData(MEMORYDEVICE_CPU);
 	float *d_out = depth_out->GetData(MEMORYDEVICE_CPU);
 
-	for (int y = 0; y < imgSize.y; y++) for (int x = 0; x < imgSize.x; x++)
-		convertDepthAffineToFloat(d_out, x, y, d_in, imgSize, depthCalibParams);
+	ORUtils::ParallelFor(0, imgSize.y, [&](int y)
+	{
+		for (int x = 0; x < imgSize.x; x++)
+			convertDepthAffineToFloat(d_out, x, y, d_in, imgSize, depthCalibParams);
+	});
 }
 
 void ITMViewBuilder_CPU::DepthFiltering(ITMFloatImage *image_out, const ITMFloatImage *image_in)
@@ -124,8 +128,11 @@ void ITMViewBuilder_CPU::DepthFiltering(ITMFloatImage *image_out, const ITMFloat
 	float *imout = image_out->GetData(MEMORYDEVICE_CPU);
 	const float *imin = image_in->GetData(MEMORYDEVICE_CPU);
 
-	for (int y = 2; y < imgSize.y - 2; y++) for (int x = 2; x < imgSize.x - 2; x++)
-		filterDepth(imout, imin, x, y, imgSize);
+	ORUtils::ParallelFor(2, imgSize.y - 2, [&](int y)
+	{
+		for (int x = 2; x < imgSize.x - 2; x++)
+			filterDepth(imout, imin, x, y, imgSize);
+	});
 }
 
 void ITMViewBuilder_CPU::ComputeNormalAndWeights(ITMFloat4Image *normal_out, ITMFloatImage *sigmaZ_out, const ITMFloatImage *depth_in, Vector4f intrinsic)
@@ -137,7 +144,10 @@ void ITMViewBuilder_CPU::ComputeNormalAndWeights(ITMFloat4Image *normal_out, ITM
 	float *sigmaZData_out = sigmaZ_out->GetData(MEMORYDEVICE_CPU);
 	Vector4f *normalData_out = normal_out->GetData(MEMORYDEVICE_CPU);
 
-	for (int y = 2; y < imgDims.y - 2; y++) for (int x = 2; x < imgDims.x - 2; x++)
-		computeNormalAndWeight(depthData_in, normalData_out, sigmaZData_out, x, y, imgDims, intrinsic);
+	ORUtils::ParallelFor(2, imgDims.y - 2, [&](int y)
+	{
+		for (int x = 2; x < imgDims.x - 2; x++)
+			computeNormalAndWeight(depthData_in, normalData_out, sigmaZData_out, x, y, imgDims, intrinsic);
+	});
 }
 
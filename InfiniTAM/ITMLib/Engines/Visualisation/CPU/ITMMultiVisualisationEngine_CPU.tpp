@@ -6,6 +6,7 @@
 #include "../../../Objects/Scene/ITMMultiSceneAccess.h"
 
 #include "../Shared/ITMVisualisationEngine_Shared.h"
+#include "../../../../ORUtils/TaskScheduler.h"
 
 using namespace ITMLib;
 
@@ -111,17 +112,14 @@ void ITMMultiVisualisationEngine_CPU<TVoxel, TIndex>::RenderImage(const ORUtils:
 		typedef ITMMultiVoxel<TVoxel> VD;
 		typedef ITMMultiIndex<TIndex> ID;
 
-#ifdef WITH_OPENMP
-#pragma omp parallel for
-#endif
-		for (int locId = 0; locId < imgSize.x*imgSize.y; ++locId)
+		ORUtils::ParallelFor(0, imgSize.x*imgSize.y, [&](int locId)
 		{
 			int y = locId / imgSize.x;
 			int x = locId - y*imgSize.x;
 			int locId2 = (int)floor((float)x / minmaximg_subsample) + (int)floor((float)y / minmaximg_subsample) * imgSize.x;
 
 			castRay<VD, ID, false>(pointsRay[locId], NULL, x, y, &renderState->voxelData_host, &renderState->indexData_host, invM, invProjParams, oneOverVoxelSize, mu, minmaximg[locId2]);
-		}
+		});
 	}
 
 	Vector3f lightSource = -Vector3f(invM.getColumn(2));
@@ -133,86 +131,66 @@ void ITMMultiVisualisationEngine_CPU<TVoxel, TIndex>::RenderImage(const ORUtils:
 
 	switch (type) {
 	case IITMVisualisationEngine::RENDER_COLOUR_FROM_VOLUME:
-#ifdef WITH_OPENMP
-#pragma omp parallel for
-#endif
-		for (int locId = 0; locId < imgSize.x * imgSize.y; locId++) {
+		ORUtils::ParallelFor(0, imgSize.x * imgSize.y, [&](int locId)
+		{
 			Vector4f ptRay = pointsRay[locId];
 			processPixelColour<ITMMultiVoxel<TVoxel>, ITMMultiIndex<TIndex> >(outRendering[locId], ptRay.toVector3(), ptRay.w > 0, &(renderState->voxelData_host),
 				&(renderState->indexData_host));
-		}
+		});
 		break;
 	case IITMVisualisationEngine::RENDER_COLOUR_FROM_NORMAL:
 		if (intrinsics->FocalLengthSignsDiffer())
 		{
-#ifdef WITH_OPENMP
-#pragma omp parallel for
-#endif
-			for (int locId = 0; locId < imgSize.x * imgSize.y; locId++)
+			ORUtils::ParallelFor(0, imgSize.x * imgSize.y, [&](int locId)
 			{
 				int y = locId / imgSize.x, x = locId - y*imgSize.x;
 				processPixelNormals_ImageNormals<true, true>(outRendering, pointsRay, imgSize, x, y, voxelSize, lightSource);
-			}
+			});
 		}
 		else
 		{
-#ifdef WITH_OPENMP
-#pragma omp parallel for
-#endif
-			for (int locId = 0; locId < imgSize.x * imgSize.y; locId++)
+			ORUtils::ParallelFor(0, imgSize.x * imgSize.y, [&](int locId)
 			{
 				int y = locId / imgSize.x, x = locId - y*imgSize.x;
 				processPixelNormals_ImageNormals<true, false>(outRendering, pointsRay, imgSize, x, y, voxelSize, lightSource);
-			}
+			});
 		}
 		break;
 	case IITMVisualisationEngine::RENDER_COLOUR_FROM_CONFIDENCE:
 		if (intrinsics->FocalLengthSignsDiffer())
 		{
-#ifdef WITH_OPENMP
-#pragma omp parallel for
-#endif
-			for (int locId = 0; locId < imgSize.x * imgSize.y; locId++)
+			ORUtils::ParallelFor(0, imgSize.x * imgSize.y, [&](int locId)
 			{
 				int y = locId / imgSize.x, x = locId - y*imgSize.x;
 				processPixelConfidence_ImageNormals<true, true>(outRendering, pointsRay, imgSize, x, y, voxelSize, lightSource);
-			}
+			});
 		}
 		else
 		{
-#ifdef WITH_OPENMP
-#pragma omp parallel for
-#endif
-			for (int locId = 0; locId < imgSize.x * imgSize.y; locId++)
+			ORUtils::ParallelFor(0, imgSize.x * imgSize.y, [&](int locId)
 			{
 				int y = locId / imgSize.x, x = locId - y*imgSize.x;
 				processPixelConfidence_ImageNormals<true, false>(outRendering, pointsRay, imgSize, x, y, voxelSize, lightSource);
-			}
+			});
 		}
 		break;
 	case IITMVisualisationEngine::RENDER_SHADED_GREYSCALE:
 	default:
 		if (intrinsics->FocalLengthSignsDiffer())
 		{
-#ifdef WITH_OPENMP
-#pragma omp parallel for
-#endif
-			for (int locId = 0; locId < imgSize.x * imgSize.y; locId++)
+			ORUtils::ParallelFor(0, imgSize.x * imgSize.y, [&](int locId)
 			{
 				int y = locId / imgSize.x, x = locId - y*imgSize.x;
 				processPixelGrey_ImageNormals<true, true>(outRendering, pointsRay, imgSize, x, y, voxelSize, lightSource);
-			}
+			});
 		}
 		else
 		{
-#ifdef WITH_OPENMP
-#pragma omp parallel for
-#endif
-			for (int locId = 0; locId < imgSize.x * imgSize.y; locId++)
+			ORUtils::ParallelFor(0, imgSize.x * imgSize.y, [&](int locId)
 			{
 				int y = locId / imgSize.x, x = locId - y*imgSize.x;
 				processPixelGrey_ImageNormals<true, false>(outRendering, pointsRay, imgSize, x, y, voxelSize, lightSource);
-			}
+			});
 		}
 		break;
 	}
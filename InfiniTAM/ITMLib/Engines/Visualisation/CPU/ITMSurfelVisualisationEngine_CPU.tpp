@@ -5,6 +5,7 @@
 #include <stdexcept>
 
 #include "../Shared/ITMSurfelVisualisationEngine_Shared.h"
+#include "../../../../ORUtils/TaskScheduler.h"
 
 namespace ITMLib
 {
@@ -17,13 +18,10 @@ void ITMSurfelVisualisationEngine_CPU<TSurfel>::CopyCorrespondencesToBuffers(con
   const int surfelCount = static_cast<int>(scene->GetSurfelCount());
   const TSurfel *surfels = scene->GetSurfels()->GetData(MEMORYDEVICE_CPU);
 
-#ifdef WITH_OPENMP
-  #pragma omp parallel for
-#endif
-  for(int surfelId = 0; surfelId < surfelCount; ++surfelId)
+  ORUtils::ParallelFor(0, surfelCount, [&](int surfelId)
   {
     copy_correspondences_to_buffers(surfelId, surfels, newPositions, oldPositions, correspondences);
-  }
+  });
 }
 
 template <typename TSurfel>
@@ -32,13 +30,10 @@ void ITMSurfelVisualisationEngine_CPU<TSurfel>::CopySceneToBuffers(const ITMSurf
   const int surfelCount = static_cast<int>(scene->GetSurfelCount());
   const TSurfel *surfels = scene->GetSurfels()->GetData(MEMORYDEVICE_CPU);
 
-#ifdef WITH_OPENMP
-  #pragma omp parallel for
-#endif
-  for(int surfelId = 0; surfelId < surfelCount; ++surfelId)
+  ORUtils::ParallelFor(0, surfelCount, [&](int surfelId)
   {
     copy_surfel_to_buffers(surfelId, surfels, positions, normals, colours);
-  }
+  });
 }
 
 template <typename TSurfel>
@@ -52,13 +47,10 @@ void ITMSurfelVisualisationEngine_CPU<TSurfel>::CreateICPMaps(const ITMSurfelSce
   const unsigned int *surfelIndexImage = renderState->GetIndexImage()->GetData(MEMORYDEVICE_CPU);
   const TSurfel *surfels = scene->GetSurfels()->GetData(MEMORYDEVICE_CPU);
 
-#ifdef WITH_OPENMP
-  #pragma omp parallel for
-#endif
-  for(int locId = 0; locId < pixelCount; ++locId)
+  ORUtils::ParallelFor(0, pixelCount, [&](int locId)
   {
     copy_surfel_data_to_icp_maps(locId, surfels, surfelIndexImage, invT, sceneParams.trackingSurfelMaxDepth, sceneParams.trackingSurfelMinConfidence, pointsMap, normalsMap);
-  }
+  });
 }
 
 template <typename TSurfel>
@@ -71,13 +63,10 @@ void ITMSurfelVisualisationEngine_CPU<TSurfel>::RenderDepthImage(const ITMSurfel
   const unsigned int *surfelIndexImagePtr = renderState->GetIndexImage()->GetData(MEMORYDEVICE_CPU);
   const TSurfel *surfels = scene->GetSurfels()->GetData(MEMORYDEVICE_CPU);
 
-#ifdef WITH_OPENMP
-  #pragma omp parallel for
-#endif
-  for(int locId = 0; locId < pixelCount; ++locId)
+  ORUtils::ParallelFor(0, pixelCount, [&](int locId)
   {
     shade_pixel_depth(locId, surfelIndexImagePtr, surfels, cameraPosition, outputImagePtr);
-  }
+  });
 }
 
 template <typename TSurfel>
@@ -97,24 +86,18 @@ void ITMSurfelVisualisationEngine_CPU<TSurfel>::RenderImage(const ITMSurfelScene
   {
     case Base::RENDER_COLOUR:
     {
-#ifdef WITH_OPENMP
-      #pragma omp parallel for
-#endif
-      for(int locId = 0; locId < pixelCount; ++locId)
+      ORUtils::ParallelFor(0, pixelCount, [&](int locId)
       {
         shade_pixel_colour(locId, surfelIndexImagePtr, surfels, outputImagePtr);
-      }
+      });
       break;
     }
     case Base::RENDER_CONFIDENCE:
     {
-#ifdef WITH_OPENMP
-      #pragma omp parallel for
-#endif
-      for(int locId = 0; locId < pixelCount; ++locId)
+      ORUtils::ParallelFor(0, pixelCount, [&](int locId)
       {
         shade_pixel_confidence(locId, surfelIndexImagePtr, surfels, sceneParams.stableSurfelConfidence, outputImagePtr);
-      }
+      });
       break;
     }
     case Base::RENDER_FLAT:
@@ -128,24 +111,18 @@ void ITMSurfelVisualisationEngine_CPU<TSurfel>::RenderImage(const ITMSurfelScene
       const Vector3f lightPos = Vector3f(0.0f, -10.0f, -10.0f);
       const Vector3f viewerPos = Vector3f(pose->GetInvM().getColumn(3));
 
-#ifdef WITH_OPENMP
-      #pragma omp parallel for
-#endif
-      for(int locId = 0; locId < pixelCount; ++locId)
+      ORUtils::ParallelFor(0, pixelCount, [&](int locId)
       {
         shade_pixel_grey(locId, surfelIndexImagePtr, surfels, lightPos, viewerPos, lightingType, outputImagePtr);
-      }
+      });
       break;
     }
     case Base::RENDER_NORMAL:
     {
-#ifdef WITH_OPENMP
-      #pragma omp parallel for
-#endif
-      for(int locId = 0; locId < pixelCount; ++locId)
+      ORUtils::ParallelFor(0, pixelCount, [&](int locId)
       {
         shade_pixel_normal(locId, surfelIndexImagePtr, surfels, outputImagePtr);
-      }
+      });
       break;
     }
     default:
@@ -171,13 +148,10 @@ void ITMSurfelVisualisationEngine_CPU<TSurfel>::MakeIndexImage(const ITMSurfelSc
 {
   const int pixelCount = width * height;
 
-#ifdef WITH_OPENMP
-  #pragma omp parallel for
-#endif
-  for(int locId = 0; locId < pixelCount; ++locId)
+  ORUtils::ParallelFor(0, pixelCount, [&](int locId)
   {
     clear_surfel_index_image(locId, surfelIndexImage, depthBuffer);
-  }
+  });
 
   const Matrix4f& invT = pose->GetM();
   const ITMSurfelSceneParams& sceneParams = scene->GetParams();
@@ -4,6 +4,7 @@
 
 #include "../Shared/ITMVisualisationEngine_Shared.h"
 #include "../../Reconstruction/Shared/ITMSceneReconstructionEngine_Shared.h"
+#include "../../../../ORUtils/TaskScheduler.h"
 
 #include <vector>
 
@@ -188,10 +189,7 @@ static void GenericRaycast(const ITMScene<TVoxel, TIndex> *scene, const Vector2i
 		entriesVisibleType = ((ITMRenderState_VH*)renderState)->GetEntriesVisibleType();
 	}
 
-#ifdef WITH_OPENMP
-	#pragma omp parallel for
-#endif
-	for (int locId = 0; locId < imgSize.x*imgSize.y; ++locId)
+	ORUtils::ParallelFor(0, imgSize.x*imgSize.y, [&](int locId)
 	{
 		int y = locId/imgSize.x;
 		int x = locId - y*imgSize.x;
@@ -221,7 +219,7 @@ static void GenericRaycast(const ITMScene<TVoxel, TIndex> *scene, const Vector2i
 				mu,
 				minmaximg[locId2]
 			);
-	}
+	});
 }
 
 
@@ -258,40 +256,28 @@ static void RenderImage_common(const ITMScene<TVoxel,TIndex> *scene, const ORUti
 
 	switch (type) {
 	case IITMVisualisationEngine::RENDER_COLOUR_FROM_VOLUME:
-#ifdef WITH_OPENMP
-		#pragma omp parallel for
-#endif
-		for (int locId = 0; locId < imgSize.x * imgSize.y; locId++)
+		ORUtils::ParallelFor(0, imgSize.x * imgSize.y, [&](int locId)
 		{
 			Vector4f ptRay = pointsRay[locId];
 			processPixelColour<TVoxel, TIndex>(outRendering[locId], ptRay.toVector3(), ptRay.w > 0, voxelData, voxelIndex);
-		}
+		});
 		break;
 	case IITMVisualisationEngine::RENDER_COLOUR_FROM_NORMAL:
-#ifdef WITH_OPENMP
-		#pragma omp parallel for
-#endif
-		for (int locId = 0; locId < imgSize.x * imgSize.y; locId++)
+		ORUtils::ParallelFor(0, imgSize.x * imgSize.y, [&](int locId)
 		{
 			Vector4f ptRay = pointsRay[locId];
 			processPixelNormal<TVoxel, TIndex>(outRendering[locId], ptRay.toVector3(), ptRay.w > 0, voxelData, voxelIndex, lightSource);
-		}
+		});
 		break;
 	case IITMVisualisationEngine::RENDER_COLOUR_FROM_CONFIDENCE:
-#ifdef WITH_OPENMP
-		#pragma omp parallel for
-#endif
-		for (int locId = 0; locId < imgSize.x * imgSize.y; locId++)
+		ORUtils::ParallelFor(0, imgSize.x * imgSize.y, [&](int locId)
 		{
 			Vector4f ptRay = pointsRay[locId];
 			processPixelConfidence<TVoxel, TIndex>(outRendering[locId], ptRay, ptRay.w > 0, voxelData, voxelIndex, lightSource);
-		}
+		});
 		break;
 	case IITMVisualisationEngine::RENDER_SHADED_GREYSCALE_IMAGENORMALS:
-#ifdef WITH_OPENMP
-		#pragma omp parallel for
-#endif
-		for (int locId = 0; locId < imgSize.x * imgSize.y; locId++)
+		ORUtils::ParallelFor(0, imgSize.x * imgSize.y, [&](int locId)
 		{
 			int y = locId/imgSize.x;
 			int x = locId - y*imgSize.x;
@@ -304,18 +290,15 @@ static void RenderImage_common(const ITMScene<TVoxel,TIndex> *scene, const ORUti
 			{
 				processPixelGrey_ImageNormals<true, false>(outRendering, pointsRay, imgSize, x, y, scene->sceneParams->voxelSize, lightSource);
 			}
-		}
+		});
 		break;
 	case IITMVisualisationEngine::RENDER_SHADED_GREYSCALE:
 	default:
-#ifdef WITH_OPENMP
-		#pragma omp parallel for
-#endif
-		for (int locId = 0; locId < imgSize.x * imgSize.y; locId++)
+		ORUtils::ParallelFor(0, imgSize.x * imgSize.y, [&](int locId)
 		{
 			Vector4f ptRay = pointsRay[locId];
 			processPixelGrey<TVoxel, TIndex>(outRendering[locId], ptRay.toVector3(), ptRay.w > 0, voxelData, voxelIndex, lightSource);
-		}
+		});
 	}
 }
 
@@ -345,7 +328,8 @@ static void CreatePointCloud_common(const ITMScene<TVoxel,TIndex> *scene, const
 }
 
 template<class TVoxel, class TIndex>
-static void CreateICPMaps_common(const ITMScene<TVoxel,TIndex> *scene, const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState)
+static void CreateICPMaps_common(const ITMScene<TVoxel,TIndex> *scene, const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState,
+	ITMLibSettings::ICPNormalsMode normalsMode)
 {
 	Vector2i imgSize = renderState->raycastResult->noDims;
 	Matrix4f invM = trackingState->pose_d->GetInvM();
@@ -360,21 +344,51 @@ static void CreateICPMaps_common(const ITMScene<TVoxel,TIndex> *scene, const ITM
 	Vector4f *pointsMap = trackingState->pointCloud->locations->GetData(MEMORYDEVICE_CPU);
 	Vector4f *pointsRay = renderState->raycastResult->GetData(MEMORYDEVICE_CPU);
 	float voxelSize = scene->sceneParams->voxelSize;
+	const TVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
+	const typename TIndex::IndexData *voxelIndex = scene->index.getIndexData();
+	bool flipNormals = view->calib.intrinsics_d.FocalLengthSignsDiffer();
 
-#ifdef WITH_OPENMP
-	#pragma omp parallel for
-#endif
-	for (int y = 0; y < imgSize.y; y++) for (int x = 0; x < imgSize.x; x++)
+	switch (normalsMode)
 	{
-		if (view->calib.intrinsics_d.FocalLengthSignsDiffer())
+	case ITMLibSettings::ICPNORMALS_SDF:
+		ORUtils::ParallelFor(0, imgSize.y, [&](int y)
 		{
-			processPixelICP<true, true>(pointsMap, normalsMap, pointsRay, imgSize, x, y, voxelSize, lightSource);
-		}
-		else
+			for (int x = 0; x < imgSize.x; x++)
+				processPixelICP_SDFNormals<TVoxel, TIndex, true, false, false>(pointsMap, normalsMap, pointsRay, imgSize, x, y, voxelSize, lightSource, voxelData, voxelIndex);
+		});
+		break;
+	case ITMLibSettings::ICPNORMALS_IMAGE_SDF_FALLBACK:
+		ORUtils::ParallelFor(0, imgSize.y, [&](int y)
 		{
-			processPixelICP<true, false>(pointsMap, normalsMap, pointsRay, imgSize, x, y, voxelSize, lightSource);
-		}
-
+			for (int x = 0; x < imgSize.x; x++)
+			{
+				if (flipNormals)
+				{
+					processPixelICP_SDFNormals<TVoxel, TIndex, true, true, true>(pointsMap, normalsMap, pointsRay, imgSize, x, y, voxelSize, lightSource, voxelData, voxelIndex);
+				}
+				else
+				{
+					processPixelICP_SDFNormals<TVoxel, TIndex, true, false, true>(pointsMap, normalsMap, pointsRay, imgSize, x, y, voxelSize, lightSource, voxelData, voxelIndex);
+				}
+			}
+		});
+		break;
+	case ITMLibSettings::ICPNORMALS_IMAGE:
+	default:
+		ORUtils::ParallelFor(0, imgSize.y, [&](int y)
+		{
+			for (int x = 0; x < imgSize.x; x++)
+			{
+				if (flipNormals)
+				{
+					processPixelICP<true, true>(pointsMap, normalsMap, pointsRay, imgSize, x, y, voxelSize, lightSource);
+				}
+				else
+				{
+					processPixelICP<true, false>(pointsMap, normalsMap, pointsRay, imgSize, x, y, voxelSize, lightSource);
+				}
+			}
+		});
 	}
 }
 
@@ -486,16 +500,17 @@ void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockHash>::CreatePointCloud(cons
 }
 
 template<class TVoxel, class TIndex>
-void ITMVisualisationEngine_CPU<TVoxel,TIndex>::CreateICPMaps(const ITMScene<TVoxel,TIndex> *scene, const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState) const
+void ITMVisualisationEngine_CPU<TVoxel,TIndex>::CreateICPMaps(const ITMScene<TVoxel,TIndex> *scene, const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState,
+	ITMLibSettings::ICPNormalsMode normalsMode) const
 {
-	CreateICPMaps_common(scene, view, trackingState, renderState);
+	CreateICPMaps_common(scene, view, trackingState, renderState, normalsMode);
 }
 
 template<class TVoxel>
 void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockHash>::CreateICPMaps(const ITMScene<TVoxel,ITMVoxelBlockHash> *scene, const ITMView *view, ITMTrackingState *trackingState, 
-	ITMRenderState *renderState) const
+	ITMRenderState *renderState, ITMLibSettings::ICPNormalsMode normalsMode) const
 {
-	CreateICPMaps_common(scene, view, trackingState, renderState);
+	CreateICPMaps_common(scene, view, trackingState, renderState, normalsMode);
 }
 
 template<class TVoxel, class TIndex>
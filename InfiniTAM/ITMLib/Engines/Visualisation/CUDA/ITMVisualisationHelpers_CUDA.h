@@ -77,6 +77,17 @@ namespace ITMLib
 		processPixelICP<true, flipNormals>(pointsMap, normalsMap, pointsRay, imgSize, x, y, voxelSize, lightSource);
 	}
 
+	template<class TVoxel, class TIndex, bool flipNormals, bool useImageNormals>
+	__global__ void renderICP_SDFNormals_device(Vector4f *pointsMap, Vector4f *normalsMap, const Vector4f *pointsRay,
+		float voxelSize, Vector2i imgSize, Vector3f lightSource, const TVoxel *voxelData, const typename TIndex::IndexData *voxelIndex)
+	{
+		int x = (threadIdx.x + blockIdx.x * blockDim.x), y = (threadIdx.y + blockIdx.y * blockDim.y);
+
+		if (x >= imgSize.x || y >= imgSize.y) return;
+
+		processPixelICP_SDFNormals<TVoxel, TIndex, true, flipNormals, useImageNormals>(pointsMap, normalsMap, pointsRay, imgSize, x, y, voxelSize, lightSource, voxelData, voxelIndex);
+	}
+
 	template<bool flipNormals>
 	__global__ void renderGrey_ImageNormals_device(Vector4u *outRendering, const Vector4f *pointsRay, float voxelSize, Vector2i imgSize, Vector3f lightSource)
 	{
@@ -6,6 +6,7 @@
 #include "../../../Objects/Scene/ITMScene.h"
 #include "../../../Objects/Tracking/ITMTrackingState.h"
 #include "../../../Objects/Views/ITMView.h"
+#include "../../../Utils/ITMLibSettings.h"
 
 namespace ITMLib
 {
@@ -95,9 +96,11 @@ namespace ITMLib
 
 		/** Create an image of reference points and normals as
 		required by the ITMLib::Engine::ITMDepthTracker classes.
+		@p normalsMode selects between normals from neighbouring
+		raycast pixels and normals from the SDF gradient.
 		*/
 		virtual void CreateICPMaps(const ITMScene<TVoxel,TIndex> *scene, const ITMView *view, ITMTrackingState *trackingState, 
-			ITMRenderState *renderState) const = 0;
+			ITMRenderState *renderState, ITMLibSettings::ICPNormalsMode normalsMode = ITMLibSettings::ICPNORMALS_IMAGE) const = 0;
 
 		/** Create an image of reference points and normals as
 		required by the ITMLib::Engine::ITMDepthTracker classes.
@@ -207,9 +207,13 @@ static void RenderImage_common_metal(const ITMScene<TVoxel,ITMVoxelBlockHash> *s
 }
 
 template<class TVoxel>
-void ITMVisualisationEngine_Metal<TVoxel, ITMVoxelBlockHash>::CreateICPMaps(const ITMScene<TVoxel,ITMVoxelBlockHash> *scene, const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState) const
+void ITMVisualisationEngine_Metal<TVoxel, ITMVoxelBlockHash>::CreateICPMaps(const ITMScene<TVoxel,ITMVoxelBlockHash> *scene, const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState,
+                                                                           ITMLibSettings::ICPNormalsMode normalsMode) const
 {
-    CreateICPMaps_common_metal(scene, view, trackingState, renderState);
+    // the Metal kernel only computes image-space normals, SDF normals go through the (shared memory) CPU path
+    if (normalsMode != ITMLibSettings::ICPNORMALS_IMAGE)
+        ITMVisualisationEngine_CPU<TVoxel, ITMVoxelBlockHash>::CreateICPMaps(scene, view, trackingState, renderState, normalsMode);
+    else CreateICPMaps_common_metal(scene, view, trackingState, renderState);
 }
 
 template<class TVoxel>
@@ -195,7 +195,8 @@ _CPU_AND_GPU_CODE_ inline void computeNormalAndAngle(THREADPTR(bool) & foundPoin
 {
 	if (!foundPoint) return;
 
-	outNormal = computeSingleNormalFromSDF(voxelBlockData, indexData, point);
+	typename TIndex::IndexCache cache;
+	outNormal = computeSingleNormalFromSDF(voxelBlockData, indexData, point, cache);
 
 	float normScale = 1.0f / sqrt(outNormal.x * outNormal.x + outNormal.y * outNormal.y + outNormal.z * outNormal.z);
 	outNormal *= normScale;
@@ -389,6 +390,48 @@ _CPU_AND_GPU_CODE_ inline void processPixelICP(DEVICEPTR(Vector4f) *pointsMap, D
 	}
 }
 
+template<class TVoxel, class TIndex, bool useSmoothing, bool flipNormals, bool useImageNormals>
+_CPU_AND_GPU_CODE_ inline void processPixelICP_SDFNormals(DEVICEPTR(Vector4f) *pointsMap, DEVICEPTR(Vector4f) *normalsMap,
+	const CONSTPTR(Vector4f) *pointsRay, const THREADPTR(Vector2i) &imgSize, const THREADPTR(int) &x, const THREADPTR(int) &y, float voxelSize,
+	const THREADPTR(Vector3f) &lightSource, const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(typename TIndex::IndexData) *voxelIndex)
+{
+	Vector3f outNormal;
+	float angle;
+
+	int locId = x + y * imgSize.x;
+	Vector4f point = pointsRay[locId];
+
+	bool foundPoint = point.w > 0.0f;
+
+	if (useImageNormals) computeNormalAndAngle<useSmoothing, flipNormals>(foundPoint, x, y, pointsRay, lightSource, voxelSize, imgSize, outNormal, angle);
+
+	// the SDF gradient is used everywhere, or only where the image-space normal breaks down (depth discontinuities, image borders)
+	if (!useImageNormals || (!foundPoint && point.w > 0.0f))
+	{
+		foundPoint = point.w > 0.0f;
+		computeNormalAndAngle<TVoxel, TIndex>(foundPoint, TO_VECTOR3(point), voxelData, voxelIndex, lightSource, outNormal, angle);
+	}
+
+	if (foundPoint)
+	{
+		Vector4f outPoint4;
+		outPoint4.x = point.x * voxelSize; outPoint4.y = point.y * voxelSize;
+		outPoint4.z = point.z * voxelSize; outPoint4.w = point.w;
+		pointsMap[locId] = outPoint4;
+
+		Vector4f outNormal4;
+		outNormal4.x = outNormal.x; outNormal4.y = outNormal.y; outNormal4.z = outNormal.z; outNormal4.w = 0.0f;
+		normalsMap[locId] = outNormal4;
+	}
+	else
+	{
+		Vector4f out4;
+		out4.x = 0.0f; out4.y = 0.0f; out4.z = 0.0f; out4.w = -1.0f;
+
+		pointsMap[locId] = out4; normalsMap[locId] = out4;
+	}
+}
+
 template<bool useSmoothing, bool flipNormals>
 _CPU_AND_GPU_CODE_ inline void processPixelGrey_ImageNormals(DEVICEPTR(Vector4u) *outRendering, const CONSTPTR(Vector4f) *pointsRay, 
 	const THREADPTR(Vector2i) &imgSize, const THREADPTR(int) &x, const THREADPTR(int) &y, float voxelSize, const THREADPTR(Vector3f) &lightSource)
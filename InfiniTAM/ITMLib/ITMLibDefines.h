@@ -13,7 +13,8 @@
 typedef ITMLib::ITMSurfel_rgb ITMSurfelT;
 
 /** This chooses the information stored at each voxel. At the moment, valid
-    options are ITMVoxel_s, ITMVoxel_f, ITMVoxel_s_rgb and ITMVoxel_f_rgb.
+    options are ITMVoxel_s, ITMVoxel_f, ITMVoxel_s_rgb, ITMVoxel_f_rgb and the
+    compact ITMVoxel_b and ITMVoxel_b_rgb (not supported by the Metal engines).
 */
 typedef ITMVoxel_s ITMVoxel;
 
@@ -17,7 +17,8 @@ namespace ITMLib
 		MemoryDeviceType memoryType;
 
 		uint noTotalTriangles;
-		static const uint noMaxTriangles_default = SDF_LOCAL_BLOCK_NUM * 32 * 16;
+		static const uint noMaxTrianglesPerBlock = 32 * 16;
+		static const uint noMaxTriangles_default = SDF_LOCAL_BLOCK_NUM * noMaxTrianglesPerBlock;
 		uint noMaxTriangles;
 
 		ORUtils::MemoryBlock<Triangle> *triangles;
@@ -0,0 +1,247 @@
+// Copyright 2014-2017 Oxford University Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "../../../ORUtils/NVTimer.h"
+#include "../../Utils/ITMMath.h"
+
+#ifndef COMPILE_WITHOUT_CUDA
+#include "../../../ORUtils/CUDADefines.h"
+#endif
+
+namespace ITMLib
+{
+	/** \brief
+	    Timings of the processing stages and internal counters of
+	    the main engine, for the last frame and a rolling window of
+	    recent frames to compute percentiles over.
+
+	    While disabled, every call returns after testing a flag. When
+	    enabled on a CUDA device, the device is synchronised at each
+	    stage boundary so that kernel time is attributed to the stage
+	    that launched it - this costs some throughput.
+	*/
+	class ITMEngineStatistics
+	{
+	public:
+		enum Stage
+		{
+			STAGE_VIEW_BUILDING,
+			STAGE_TRACKING,
+			STAGE_RELOCALISATION,
+			STAGE_ALLOCATION,
+			STAGE_INTEGRATION,
+			STAGE_SWAPPING,
+			STAGE_RAYCASTING,
+			STAGE_FRAME,
+			STAGE_COUNT
+		};
+
+		enum Counter
+		{
+			COUNTER_VISIBLE_BLOCKS,
+			COUNTER_ALLOCATED_BLOCKS,
+			COUNTER_FREE_BLOCKS,
+			COUNTER_EXCESS_LIST_ENTRIES,
+			COUNTER_TRACKING_POINTS,
+			COUNTER_TRACKER_ITERATIONS,
+			COUNTER_SWAPPED_IN_BLOCKS,
+			COUNTER_SWAPPED_OUT_BLOCKS,
+			COUNTER_COUNT
+		};
+
+		enum { MAX_TRACKER_LEVELS = 8 };
+
+		/// Everything recorded for one frame, times are in milliseconds
+		struct Frame
+		{
+			int frameNo;
+			float stageTimes[STAGE_COUNT];
+			int counters[COUNTER_COUNT];
+			int noTrackerLevels;
+			int trackerIterations[MAX_TRACKER_LEVELS];
+		};
+
+	private:
+		bool enabled, synchroniseDevice;
+		int historySize, noFrames;
+
+		Frame current;
+		std::vector<Frame> history;
+
+		StopWatchInterface *stageTimers[STAGE_COUNT];
+
+		void Synchronise() const
+		{
+#ifndef COMPILE_WITHOUT_CUDA
+			if (synchroniseDevice) ORcudaSafeCall(cudaDeviceSynchronize());
+#endif
+		}
+
+		/// Nearest-rank percentile of a sample, \p p between 0 and 100
+		template <typename T>
+		static T Percentile(std::vector<T> &samples, float p)
+		{
+			if (samples.empty()) return T(0);
+
+			int rank = (int)ceilf(p / 100.0f * (float)samples.size()) - 1;
+			rank = CLAMP(rank, 0, (int)samples.size() - 1);
+
+			std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+			return samples[rank];
+		}
+
+	public:
+		/** Statistics over the last \p historySize frames, \p synchroniseDevice
+		    should be set when the engines run on a CUDA device.
+		*/
+		ITMEngineStatistics(bool enabled, bool synchroniseDevice, int historySize = 300)
+			: enabled(enabled), synchroniseDevice(synchroniseDevice), historySize(historySize), noFrames(0)
+		{
+			history.reserve(historySize);
+			for (int i = 0; i < STAGE_COUNT; i++) sdkCreateTimer(&stageTimers[i]);
+			memset(&current, 0, sizeof(Frame));
+		}
+
+		~ITMEngineStatistics()
+		{
+			for (int i = 0; i < STAGE_COUNT; i++) sdkDeleteTimer(&stageTimers[i]);
+		}
+
+		bool IsEnabled() const { return enabled; }
+		void SetEnabled(bool enabled) { this->enabled = enabled; }
+
+		/// Clears the counters and timers of the current frame and starts timing it
+		void BeginFrame()
+		{
+			if (!enabled) return;
+
+			memset(&current, 0, sizeof(Frame));
+			current.frameNo = noFrames;
+			for (int i = 0; i < STAGE_COUNT; i++) sdkResetTimer(&stageTimers[i]);
+
+			BeginStage(STAGE_FRAME);
+		}
+
+		/// Stops timing the current frame and adds it to the history
+		void EndFrame()
+		{
+			if (!enabled) return;
+
+			EndStage(STAGE_FRAME);
+
+			if ((int)history.size() < historySize) history.push_back(current);
+			else history[noFrames % historySize] = current;
+			noFrames++;
+		}
+
+		/// Stages may be entered several times per frame, their times add up
+		void BeginStage(Stage stage)
+		{
+			if (!enabled) return;
+
+			Synchronise();
+			sdkStartTimer(&stageTimers[stage]);
+		}
+
+		void EndStage(Stage stage)
+		{
+			if (!enabled) return;
+
+			Synchronise();
+			sdkStopTimer(&stageTimers[stage]);
+			current.stageTimes[stage] = sdkGetTimerValue(&stageTimers[stage]);
+		}
+
+		void SetCounter(Counter counter, int value) { if (enabled) current.counters[counter] = value; }
+		void AddToCounter(Counter counter, int value) { if (enabled) current.counters[counter] += value; }
+
+		/// Copies the iterations per level of the last tracker run, level 0 is the finest
+		void SetTrackerIterations(const int *iterations, int noLevels)
+		{
+			if (!enabled) return;
+
+			current.noTrackerLevels = MIN(noLevels, (int)MAX_TRACKER_LEVELS);
+			for (int i = 0; i < current.noTrackerLevels; i++) current.trackerIterations[i] = iterations[i];
+		}
+
+		/// Number of frames recorded since the statistics were created or reset
+		int GetNoFrames() const { return noFrames; }
+
+		/// Number of frames in the rolling window
+		int GetNoHistoryFrames() const { return (int)history.size(); }
+
+		/// The last complete frame, zeroed if none was recorded yet
+		Frame GetLastFrame() const
+		{
+			if (history.empty()) { Frame frame; memset(&frame, 0, sizeof(Frame)); return frame; }
+			return history[(noFrames - 1) % historySize];
+		}
+
+		/// The i-th frame of the rolling window, from oldest to newest
+		const Frame& GetHistoryFrame(int i) const
+		{
+			if ((int)history.size() < historySize) return history[i];
+			return history[(noFrames + i) % historySize];
+		}
+
+		/// Percentile \p p (0 to 100) of a stage time over the rolling window
+		float GetStagePercentile(Stage stage, float p) const
+		{
+			std::vector<float> samples(history.size());
+			for (size_t i = 0; i < history.size(); i++) samples[i] = history[i].stageTimes[stage];
+			return Percentile(samples, p);
+		}
+
+		/** Fraction of the frame time spent in a stage over the rolling
+		    window. With ITMLibSettings::pipelineFrames, view building
+		    overlaps the other stages, so the fractions can add up to more
+		    than one.
+		*/
+		float GetStageOccupancy(Stage stage) const
+		{
+			double stageTime = 0.0, frameTime = 0.0;
+			for (size_t i = 0; i < history.size(); i++)
+			{
+				stageTime += history[i].stageTimes[stage];
+				frameTime += history[i].stageTimes[STAGE_FRAME];
+			}
+			return frameTime > 0.0 ? (float)(stageTime / frameTime) : 0.0f;
+		}
+
+		/// Percentile \p p (0 to 100) of a counter over the rolling window
+		int GetCounterPercentile(Counter counter, float p) const
+		{
+			std::vector<int> samples(history.size());
+			for (size_t i = 0; i < history.size(); i++) samples[i] = history[i].counters[counter];
+			return Percentile(samples, p);
+		}
+
+		void Reset()
+		{
+			history.clear();
+			noFrames = 0;
+		}
+
+		static const char* GetStageName(Stage stage)
+		{
+			static const char *names[STAGE_COUNT] = { "view building", "tracking", "relocalisation", "allocation", "integration", "swapping", "raycasting", "frame" };
+			return names[stage];
+		}
+
+		static const char* GetCounterName(Counter counter)
+		{
+			static const char *names[COUNTER_COUNT] = { "visible blocks", "allocated blocks", "free blocks", "excess list entries", "tracking points", "tracker iterations", "swapped in blocks", "swapped out blocks" };
+			return names[counter];
+		}
+
+		// Suppress the default copy constructor and assignment operator
+		ITMEngineStatistics(const ITMEngineStatistics&);
+		ITMEngineStatistics& operator=(const ITMEngineStatistics&);
+	};
+}
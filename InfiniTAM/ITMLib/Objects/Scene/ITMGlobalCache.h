@@ -5,7 +5,12 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+#include <algorithm>
+#include <deque>
+#include <vector>
+
 #include "ITMVoxelBlockHash.h"
+#include "ITMVoxelBlockLayout.h"
 #include "../../../ORUtils/CUDADefines.h"
 
 namespace ITMLib
@@ -21,12 +26,64 @@ namespace ITMLib
 		uchar state;
 	};
 
+	/** \brief
+	    Host side store of the voxel blocks swapped out of the local VBA.
+
+	    By default every hash entry has room for one uncompressed block. A
+	    cache constructed with a capacity instead keeps at most that many
+	    blocks, with only the observed voxels of each block, and drops the
+	    oldest stored blocks once it is full. A bounded cache only holds
+	    blocks that are not in the local VBA, blocks that are swapped back in
+	    are removed from it.
+	*/
 	template<class TVoxel>
 	class ITMGlobalCache
 	{
 	private:
 		bool *hasStoredData;
 		TVoxel *storedVoxelBlocks;
+
+		int maxStoredBlocks, noStoredBlocks;
+		std::vector<std::vector<uchar> > compressedBlocks;
+
+		/// (address, sequence number) in the order the blocks were stored, entries whose
+		/// sequence number no longer matches storedSequence were dropped in the meantime
+		std::deque<std::pair<int, unsigned int> > storageOrder;
+		std::vector<unsigned int> storedSequence;
+		unsigned int nextSequence;
+
+		void CompressBlock(int address, const TVoxel *data)
+		{
+			std::vector<uchar> &compressed = compressedBlocks[address];
+			compressed.assign(SDF_BLOCK_SIZE3 / 8, 0);
+
+			for (int vIdx = 0; vIdx < SDF_BLOCK_SIZE3; vIdx++)
+			{
+				TVoxel voxel = loadVoxel(data, vIdx);
+				if (voxel.w_depth == 0) continue;
+
+				compressed[vIdx / 8] |= (uchar)(1 << (vIdx % 8));
+				const uchar *voxelBytes = (const uchar*)&voxel;
+				compressed.insert(compressed.end(), voxelBytes, voxelBytes + sizeof(TVoxel));
+			}
+		}
+
+		void DecompressBlock(int address, TVoxel *data) const
+		{
+			const std::vector<uchar> &compressed = compressedBlocks[address];
+			const uchar *voxelBytes = &compressed[SDF_BLOCK_SIZE3 / 8];
+
+			for (int vIdx = 0; vIdx < SDF_BLOCK_SIZE3; vIdx++)
+			{
+				TVoxel voxel;
+				if (compressed[vIdx / 8] & (1 << (vIdx % 8)))
+				{
+					memcpy(&voxel, voxelBytes, sizeof(TVoxel));
+					voxelBytes += sizeof(TVoxel);
+				}
+				storeVoxel(data, vIdx, voxel);
+			}
+		}
 		ITMHashSwapState *swapStates_host, *swapStates_device;
 
 		bool *hasSyncedData_host, *hasSyncedData_device;
@@ -36,11 +93,78 @@ namespace ITMLib
 	public:
 		inline void SetStoredData(int address, TVoxel *data) 
 		{ 
+			if (IsBounded())
+			{
+				if (!hasStoredData[address])
+				{
+					noStoredBlocks++;
+					storedSequence[address] = nextSequence;
+					storageOrder.push_back(std::make_pair(address, nextSequence++));
+				}
+				CompressBlock(address, data);
+			}
+			else memcpy(storedVoxelBlocks + address * SDF_BLOCK_SIZE3, data, sizeof(TVoxel) * SDF_BLOCK_SIZE3);
+
 			hasStoredData[address] = true; 
-			memcpy(storedVoxelBlocks + address * SDF_BLOCK_SIZE3, data, sizeof(TVoxel) * SDF_BLOCK_SIZE3);
 		}
 		inline bool HasStoredData(int address) const { return hasStoredData[address]; }
-		inline TVoxel *GetStoredVoxelBlock(int address) { return storedVoxelBlocks + address * SDF_BLOCK_SIZE3; }
+
+		/** Copies a stored block to \p data, which must have room for SDF_BLOCK_SIZE3 voxels. */
+		inline void GetStoredData(int address, TVoxel *data) const
+		{
+			if (IsBounded()) DecompressBlock(address, data);
+			else memcpy(data, storedVoxelBlocks + address * SDF_BLOCK_SIZE3, sizeof(TVoxel) * SDF_BLOCK_SIZE3);
+		}
+
+		inline void DropStoredData(int address)
+		{
+			if (!hasStoredData[address]) return;
+
+			hasStoredData[address] = false;
+			if (IsBounded())
+			{
+				noStoredBlocks--;
+				std::vector<uchar>().swap(compressedBlocks[address]);
+			}
+		}
+
+		/** Drops the oldest blocks of a bounded cache until it is within its capacity,
+		    at most \p maxDropped of them. Returns their number and writes their addresses
+		    to \p droppedAddresses.
+		*/
+		int DropOldestStoredData(int *droppedAddresses, int maxDropped)
+		{
+			int noDropped = 0;
+
+			while (noStoredBlocks > maxStoredBlocks && noDropped < maxDropped && !storageOrder.empty())
+			{
+				int address = storageOrder.front().first;
+				bool isCurrent = hasStoredData[address] && storedSequence[address] == storageOrder.front().second;
+				storageOrder.pop_front();
+
+				if (!isCurrent) continue;
+
+				DropStoredData(address);
+				droppedAddresses[noDropped++] = address;
+			}
+
+			// blocks swapped back in leave stale entries behind, keep them from piling up
+			if ((int)storageOrder.size() > 2 * maxStoredBlocks)
+			{
+				std::deque<std::pair<int, unsigned int> > currentOrder;
+				for (size_t i = 0; i < storageOrder.size(); i++)
+				{
+					int address = storageOrder[i].first;
+					if (hasStoredData[address] && storedSequence[address] == storageOrder[i].second) currentOrder.push_back(storageOrder[i]);
+				}
+				storageOrder.swap(currentOrder);
+			}
+
+			return noDropped;
+		}
+
+		inline bool IsBounded(void) const { return maxStoredBlocks > 0; }
+		inline int GetNoStoredBlocks(void) const { return noStoredBlocks; }
 
 		bool *GetHasSyncedData(bool useGPU) const { return useGPU ? hasSyncedData_device : hasSyncedData_host; }
 		TVoxel *GetSyncedVoxelBlocks(bool useGPU) const { return useGPU ? syncedVoxelBlocks_device : syncedVoxelBlocks_host; }
@@ -50,12 +174,20 @@ namespace ITMLib
 
 		int noTotalEntries; 
 
-		ITMGlobalCache() : noTotalEntries(SDF_BUCKET_NUM + SDF_EXCESS_LIST_SIZE)
+		/** A positive \p maxStoredBlocks gives a bounded, compressed cache. */
+		explicit ITMGlobalCache(int maxStoredBlocks = 0) : maxStoredBlocks(maxStoredBlocks), noStoredBlocks(0), nextSequence(0), noTotalEntries(SDF_BUCKET_NUM + SDF_EXCESS_LIST_SIZE)
 		{	
 			hasStoredData = (bool*)malloc(noTotalEntries * sizeof(bool));
-			storedVoxelBlocks = (TVoxel*)malloc(noTotalEntries * sizeof(TVoxel) * SDF_BLOCK_SIZE3);
 			memset(hasStoredData, 0, noTotalEntries);
 
+			if (IsBounded())
+			{
+				storedVoxelBlocks = NULL;
+				compressedBlocks.resize(noTotalEntries);
+				storedSequence.resize(noTotalEntries);
+			}
+			else storedVoxelBlocks = (TVoxel*)malloc(noTotalEntries * sizeof(TVoxel) * SDF_BLOCK_SIZE3);
+
 			swapStates_host = (ITMHashSwapState *)malloc(noTotalEntries * sizeof(ITMHashSwapState));
 			memset(swapStates_host, 0, sizeof(ITMHashSwapState) * noTotalEntries);
 
@@ -81,12 +213,22 @@ namespace ITMLib
 		void SaveToFile(char *fileName) const
 		{
 			TVoxel *storedData = storedVoxelBlocks;
+			std::vector<TVoxel> block(IsBounded() ? SDF_BLOCK_SIZE3 : 0);
 
 			FILE *f = fopen(fileName, "wb");
 
 			fwrite(hasStoredData, sizeof(bool), noTotalEntries, f);
 			for (int i = 0; i < noTotalEntries; i++)
 			{
+				if (IsBounded())
+				{
+					// bounded caches are written uncompressed, in the same format
+					if (hasStoredData[i]) GetStoredData(i, &block[0]);
+					else std::fill(block.begin(), block.end(), TVoxel());
+					fwrite(&block[0], sizeof(TVoxel) * SDF_BLOCK_SIZE3, 1, f);
+					continue;
+				}
+
 				fwrite(storedData, sizeof(TVoxel) * SDF_BLOCK_SIZE3, 1, f);
 				storedData += SDF_BLOCK_SIZE3;
 			}
@@ -97,11 +239,25 @@ namespace ITMLib
 		void ReadFromFile(char *fileName)
 		{
 			TVoxel *storedData = storedVoxelBlocks;
+			std::vector<TVoxel> block(IsBounded() ? SDF_BLOCK_SIZE3 : 0);
 			FILE *f = fopen(fileName, "rb");
 
 			size_t tmp = fread(hasStoredData, sizeof(bool), noTotalEntries, f);
 			if (tmp == (size_t)noTotalEntries) {
-				for (int i = 0; i < noTotalEntries; i++)
+				if (IsBounded())
+				{
+					std::vector<bool> isStored(hasStoredData, hasStoredData + noTotalEntries);
+					memset(hasStoredData, 0, noTotalEntries);
+					noStoredBlocks = 0;
+					storageOrder.clear();
+
+					for (int i = 0; i < noTotalEntries; i++)
+					{
+						fread(&block[0], sizeof(TVoxel) * SDF_BLOCK_SIZE3, 1, f);
+						if (isStored[i]) SetStoredData(i, &block[0]);
+					}
+				}
+				else for (int i = 0; i < noTotalEntries; i++)
 				{
 					fread(storedData, sizeof(TVoxel) * SDF_BLOCK_SIZE3, 1, f);
 					storedData += SDF_BLOCK_SIZE3;
@@ -4,6 +4,7 @@
 
 #include "../../../ORUtils/MemoryBlock.h"
 #include "../../../ORUtils/MemoryBlockPersister.h"
+#include "ITMVoxelBlockLayout.h"
 
 namespace ITMLib
 {
@@ -17,6 +18,7 @@ namespace ITMLib
 	private:
 		ORUtils::MemoryBlock<TVoxel> *voxelBlocks;
 		ORUtils::MemoryBlock<int> *allocationList;
+		ORUtils::MemoryBlock<uchar> *saturatedBlocks;
 
 		MemoryDeviceType memoryType;
 
@@ -25,6 +27,13 @@ namespace ITMLib
 		inline const TVoxel *GetVoxelBlocks(void) const { return voxelBlocks->GetData(memoryType); }
 		int *GetAllocationList(void) { return allocationList->GetData(memoryType); }
 
+		/** One flag per voxel block, set by the integration once every
+		    voxel of the block has reached maxW. Anything that frees a block
+		    or lowers its weights must clear the flag again.
+		*/
+		uchar *GetSaturatedBlocks(void) { return saturatedBlocks->GetData(memoryType); }
+		void ClearSaturatedBlocks(void) { saturatedBlocks->Clear(); }
+
 #ifdef COMPILE_WITH_METAL
 		const void* GetVoxelBlocks_MB() const { return voxelBlocks->GetMetalBuffer(); }
 		const void* GetAllocationList_MB(void) const { return allocationList->GetMetalBuffer(); }
@@ -61,6 +70,8 @@ namespace ITMLib
 			if (!ifs) throw std::runtime_error("Could not open " + AllocSizeFileName + " for reading");
 
 			ifs >> lastFreeBlockId >> allocatedSize;
+
+			ClearSaturatedBlocks();
 		}
 
 		ITMLocalVBA(MemoryDeviceType memoryType, int noBlocks, int blockSize)
@@ -68,15 +79,21 @@ namespace ITMLib
 			this->memoryType = memoryType;
 
 			allocatedSize = noBlocks * blockSize;
+#ifdef SDF_BLOCK_LAYOUT_SOA
+			// the SoA layout addresses voxels in whole runs of SDF_BLOCK_SIZE3
+			allocatedSize = (allocatedSize + SDF_BLOCK_SIZE3 - 1) / SDF_BLOCK_SIZE3 * SDF_BLOCK_SIZE3;
+#endif
 
 			voxelBlocks = new ORUtils::MemoryBlock<TVoxel>(allocatedSize, memoryType);
 			allocationList = new ORUtils::MemoryBlock<int>(noBlocks, memoryType);
+			saturatedBlocks = new ORUtils::MemoryBlock<uchar>(noBlocks, memoryType);
 		}
 
 		~ITMLocalVBA(void)
 		{
 			delete voxelBlocks;
 			delete allocationList;
+			delete saturatedBlocks;
 		}
 
 		// Suppress the default copy constructor and assignment operator
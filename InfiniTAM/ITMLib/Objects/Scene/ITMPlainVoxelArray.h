@@ -41,7 +41,8 @@ namespace ITMLib
 		MemoryDeviceType memoryType;
 
 	public:
-		ITMPlainVoxelArray(MemoryDeviceType memoryType)
+		/** The array always has a single block of the whole volume, \p noVoxelBlocks is ignored. */
+		explicit ITMPlainVoxelArray(MemoryDeviceType memoryType, int noVoxelBlocks = 0)
 		{
 			this->memoryType = memoryType;
 
@@ -58,7 +59,7 @@ namespace ITMLib
 		}
 
 		/** Maximum number of total entries. */
-		int getNumAllocatedVoxelBlocks(void) { return 1; }
+		int getNumAllocatedVoxelBlocks(void) const { return 1; }
 		int getVoxelBlockSize(void) 
 		{ 
 			return indexData->GetData(MEMORYDEVICE_CPU)->size.x * 
@@ -2,7 +2,7 @@
 
 #pragma once
 
-#include "ITMVoxelBlockHash.h"
+#include "ITMVoxelBlockLayout.h"
 
 template<typename T> _CPU_AND_GPU_CODE_ inline int hashIndex(const THREADPTR(T) & blockPos) {
 	return (((uint)blockPos.x * 73856093u) ^ ((uint)blockPos.y * 19349669u) ^ ((uint)blockPos.z * 83492791u)) & (uint)SDF_HASH_MASK;
@@ -18,16 +18,23 @@ _CPU_AND_GPU_CODE_ inline int pointToVoxelBlockPos(const THREADPTR(Vector3i) & p
 	return point.x + (point.y - blockPos.x) * SDF_BLOCK_SIZE + (point.z - blockPos.y) * SDF_BLOCK_SIZE * SDF_BLOCK_SIZE - blockPos.z * SDF_BLOCK_SIZE3;
 }
 
-_CPU_AND_GPU_CODE_ inline int findVoxel(const CONSTPTR(ITMLib::ITMVoxelBlockHash::IndexData) *voxelIndex, const THREADPTR(Vector3i) & point,
+_CPU_AND_GPU_CODE_ inline int indexCacheSlot(const THREADPTR(Vector3i) & blockPos) {
+	return ((blockPos.x & 1) | ((blockPos.y & 1) << 1) | ((blockPos.z & 1) << 2)) & (SDF_INDEX_CACHE_SIZE - 1);
+}
+
+/** Returns the offset of the first voxel of the block at blockPos, or -1 if
+    the block is not allocated. vmIndex is true on a cache hit, the hash
+    index + 1 on a hash table hit and false otherwise.
+*/
+_CPU_AND_GPU_CODE_ inline int findBlock(const CONSTPTR(ITMLib::ITMVoxelBlockHash::IndexData) *voxelIndex, const THREADPTR(Vector3i) & blockPos,
 	THREADPTR(int) &vmIndex, THREADPTR(ITMLib::ITMVoxelBlockHash::IndexCache) & cache)
 {
-	Vector3i blockPos;
-	short linearIdx = pointToVoxelBlockPos(point, blockPos);
+	int slot = indexCacheSlot(blockPos);
 
-	if IS_EQUAL3(blockPos, cache.blockPos)
+	if IS_EQUAL3(blockPos, cache.blockPos[slot])
 	{
 		vmIndex = true;
-		return cache.blockPtr + linearIdx;
+		return cache.blockPtr[slot];
 	}
 
 	int hashIdx = hashIndex(blockPos);
@@ -38,9 +45,10 @@ _CPU_AND_GPU_CODE_ inline int findVoxel(const CONSTPTR(ITMLib::ITMVoxelBlockHash
 
 		if (IS_EQUAL3(hashEntry.pos, blockPos) && hashEntry.ptr >= 0)
 		{
-			vmIndex = true;
-			cache.blockPos = blockPos; cache.blockPtr = hashEntry.ptr * SDF_BLOCK_SIZE3;
-			return cache.blockPtr + linearIdx;
+			cache.blockPos[slot] = blockPos; cache.blockPtr[slot] = hashEntry.ptr * SDF_BLOCK_SIZE3;
+			vmIndex = hashIdx + 1; // add 1 to support legacy true / false operations for isFound
+
+			return cache.blockPtr[slot];
 		}
 
 		if (hashEntry.offset < 1) break;
@@ -51,6 +59,19 @@ _CPU_AND_GPU_CODE_ inline int findVoxel(const CONSTPTR(ITMLib::ITMVoxelBlockHash
 	return -1;
 }
 
+_CPU_AND_GPU_CODE_ inline int findVoxel(const CONSTPTR(ITMLib::ITMVoxelBlockHash::IndexData) *voxelIndex, const THREADPTR(Vector3i) & point,
+	THREADPTR(int) &vmIndex, THREADPTR(ITMLib::ITMVoxelBlockHash::IndexCache) & cache)
+{
+	Vector3i blockPos;
+	int linearIdx = pointToVoxelBlockPos(point, blockPos);
+
+	int blockPtr = findBlock(voxelIndex, blockPos, vmIndex, cache);
+	if (blockPtr < 0) return -1;
+
+	vmIndex = true;
+	return blockPtr + linearIdx;
+}
+
 _CPU_AND_GPU_CODE_ inline int findVoxel(const CONSTPTR(ITMLib::ITMVoxelBlockHash::IndexData) *voxelIndex, Vector3i point, THREADPTR(int) &vmIndex)
 {
 	ITMLib::ITMVoxelBlockHash::IndexCache cache;
@@ -73,32 +94,10 @@ _CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(TVoxel) *voxelData, co
 	Vector3i blockPos;
 	int linearIdx = pointToVoxelBlockPos(point, blockPos);
 
-	if IS_EQUAL3(blockPos, cache.blockPos)
-	{
-		vmIndex = true;
-		return voxelData[cache.blockPtr + linearIdx];
-	}
-
-	int hashIdx = hashIndex(blockPos);
-
-	while (true)
-	{
-		ITMHashEntry hashEntry = voxelIndex[hashIdx];
-
-		if (IS_EQUAL3(hashEntry.pos, blockPos) && hashEntry.ptr >= 0)
-		{
-			cache.blockPos = blockPos; cache.blockPtr = hashEntry.ptr * SDF_BLOCK_SIZE3;
-			vmIndex = hashIdx + 1; // add 1 to support legacy true / false operations for isFound
-
-			return voxelData[cache.blockPtr + linearIdx];
-		}
+	int blockPtr = findBlock(voxelIndex, blockPos, vmIndex, cache);
+	if (blockPtr < 0) return TVoxel();
 
-		if (hashEntry.offset < 1) break;
-		hashIdx = SDF_BUCKET_NUM + hashEntry.offset - 1;
-	}
-
-	vmIndex = false;
-	return TVoxel();
+	return loadVoxel(voxelData, blockPtr + linearIdx);
 }
 
 template<class TVoxel>
@@ -120,6 +119,58 @@ _CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(TVoxel) *voxelData, co
 	return result;
 }
 
+/** Reads the 2x2x2 voxels starting at pos, corner i being at
+    pos + (i & 1, (i >> 1) & 1, (i >> 2) & 1). Corners in unallocated blocks
+    read as TVoxel(). If all corners lie in one block, that block is only
+    looked up once. Returns a mask with bit i set if corner i was found.
+*/
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline int readVoxelCorners(THREADPTR(TVoxel) *corners, const CONSTPTR(TVoxel) *voxelData,
+	const CONSTPTR(ITMLib::ITMVoxelBlockHash::IndexData) *voxelIndex, const THREADPTR(Vector3i) & pos, THREADPTR(ITMLib::ITMVoxelBlockHash::IndexCache) & cache)
+{
+	Vector3i blockPos; int vmIndex;
+	int linearIdx = pointToVoxelBlockPos(pos, blockPos);
+	Vector3i locPos = pos - blockPos * SDF_BLOCK_SIZE;
+
+	if (locPos.x < SDF_BLOCK_SIZE - 1 && locPos.y < SDF_BLOCK_SIZE - 1 && locPos.z < SDF_BLOCK_SIZE - 1)
+	{
+		int blockPtr = findBlock(voxelIndex, blockPos, vmIndex, cache);
+		if (blockPtr < 0)
+		{
+			for (int i = 0; i < 8; i++) corners[i] = TVoxel();
+			return 0;
+		}
+
+		int voxelIdx = blockPtr + linearIdx;
+		corners[0] = loadVoxel(voxelData, voxelIdx);
+		corners[1] = loadVoxel(voxelData, voxelIdx + 1);
+		corners[2] = loadVoxel(voxelData, voxelIdx + SDF_BLOCK_SIZE);
+		corners[3] = loadVoxel(voxelData, voxelIdx + SDF_BLOCK_SIZE + 1);
+		corners[4] = loadVoxel(voxelData, voxelIdx + SDF_BLOCK_SIZE * SDF_BLOCK_SIZE);
+		corners[5] = loadVoxel(voxelData, voxelIdx + SDF_BLOCK_SIZE * SDF_BLOCK_SIZE + 1);
+		corners[6] = loadVoxel(voxelData, voxelIdx + SDF_BLOCK_SIZE * SDF_BLOCK_SIZE + SDF_BLOCK_SIZE);
+		corners[7] = loadVoxel(voxelData, voxelIdx + SDF_BLOCK_SIZE * SDF_BLOCK_SIZE + SDF_BLOCK_SIZE + 1);
+		return 0xff;
+	}
+
+	// the corners straddle a block boundary, every neighbouring block is resolved once through the cache
+	int foundMask = 0;
+	for (int i = 0; i < 8; i++)
+	{
+		Vector3i cornerLoc(locPos.x + (i & 1), locPos.y + ((i >> 1) & 1), locPos.z + ((i >> 2) & 1));
+		Vector3i cornerBlock(blockPos.x + cornerLoc.x / SDF_BLOCK_SIZE, blockPos.y + cornerLoc.y / SDF_BLOCK_SIZE, blockPos.z + cornerLoc.z / SDF_BLOCK_SIZE);
+
+		int blockPtr = findBlock(voxelIndex, cornerBlock, vmIndex, cache);
+		if (blockPtr < 0) { corners[i] = TVoxel(); continue; }
+
+		cornerLoc.x &= SDF_BLOCK_SIZE - 1; cornerLoc.y &= SDF_BLOCK_SIZE - 1; cornerLoc.z &= SDF_BLOCK_SIZE - 1;
+		corners[i] = loadVoxel(voxelData, blockPtr + cornerLoc.x + cornerLoc.y * SDF_BLOCK_SIZE + cornerLoc.z * SDF_BLOCK_SIZE * SDF_BLOCK_SIZE);
+		foundMask |= 1 << i;
+	}
+
+	return foundMask;
+}
+
 template<class TVoxel, class TIndex>
 _CPU_AND_GPU_CODE_ inline float readFromSDF_float_uninterpolated(const CONSTPTR(TVoxel) *voxelData,
 	const CONSTPTR(TIndex) *voxelIndex, Vector3f point, THREADPTR(int) &vmIndex)
@@ -140,24 +191,17 @@ template<class TVoxel, class TIndex, class TCache>
 _CPU_AND_GPU_CODE_ inline float readFromSDF_float_interpolated(const CONSTPTR(TVoxel) *voxelData,
 	const CONSTPTR(TIndex) *voxelIndex, Vector3f point, THREADPTR(int) &vmIndex, THREADPTR(TCache) & cache)
 {
-	float res1, res2, v1, v2;
+	float res1, res2;
 	Vector3f coeff; Vector3i pos; TO_INT_FLOOR3(pos, coeff, point);
 
-	v1 = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 0), vmIndex, cache).sdf;
-	v2 = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 0), vmIndex, cache).sdf;
-	res1 = (1.0f - coeff.x) * v1 + coeff.x * v2;
-
-	v1 = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 0), vmIndex, cache).sdf;
-	v2 = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 0), vmIndex, cache).sdf;
-	res1 = (1.0f - coeff.y) * res1 + coeff.y * ((1.0f - coeff.x) * v1 + coeff.x * v2);
+	TVoxel v[8];
+	readVoxelCorners(v, voxelData, voxelIndex, pos, cache);
 
-	v1 = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 1), vmIndex, cache).sdf;
-	v2 = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 1), vmIndex, cache).sdf;
-	res2 = (1.0f - coeff.x) * v1 + coeff.x * v2;
+	res1 = (1.0f - coeff.x) * v[0].sdf + coeff.x * v[1].sdf;
+	res1 = (1.0f - coeff.y) * res1 + coeff.y * ((1.0f - coeff.x) * v[2].sdf + coeff.x * v[3].sdf);
 
-	v1 = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 1), vmIndex, cache).sdf;
-	v2 = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 1), vmIndex, cache).sdf;
-	res2 = (1.0f - coeff.y) * res2 + coeff.y * ((1.0f - coeff.x) * v1 + coeff.x * v2);
+	res2 = (1.0f - coeff.x) * v[4].sdf + coeff.x * v[5].sdf;
+	res2 = (1.0f - coeff.y) * res2 + coeff.y * ((1.0f - coeff.x) * v[6].sdf + coeff.x * v[7].sdf);
 
 	vmIndex = true;
 	return TVoxel::valueToFloat((1.0f - coeff.z) * res1 + coeff.z * res2);
@@ -167,31 +211,25 @@ template<class TVoxel, class TIndex, class TCache>
 _CPU_AND_GPU_CODE_ inline float readWithConfidenceFromSDF_float_interpolated(THREADPTR(float) &confidence, const CONSTPTR(TVoxel) *voxelData,
 	const CONSTPTR(TIndex) *voxelIndex, Vector3f point, THREADPTR(int) &vmIndex, THREADPTR(TCache) & cache)
 {
-	float res1, res2, v1, v2;
-	float res1_c, res2_c, v1_c, v2_c;
-	TVoxel voxel;
+	float res1, res2;
+	float res1_c, res2_c;
 
 	Vector3f coeff; Vector3i pos; TO_INT_FLOOR3(pos, coeff, point);
 
-	voxel = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 0), vmIndex, cache); v1 = voxel.sdf; v1_c = voxel.w_depth;
-	voxel = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 0), vmIndex, cache); v2 = voxel.sdf; v2_c = voxel.w_depth;
-	res1 = (1.0f - coeff.x) * v1 + coeff.x * v2;
-	res1_c = (1.0f - coeff.x) * v1_c + coeff.x * v2_c;
+	TVoxel v[8];
+	readVoxelCorners(v, voxelData, voxelIndex, pos, cache);
 
-	voxel = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 0), vmIndex, cache); v1 = voxel.sdf; v1_c = voxel.w_depth;
-	voxel = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 0), vmIndex, cache); v2 = voxel.sdf; v2_c = voxel.w_depth;
-	res1 = (1.0f - coeff.y) * res1 + coeff.y * ((1.0f - coeff.x) * v1 + coeff.x * v2);
-	res1_c = (1.0f - coeff.y) * res1_c + coeff.y * ((1.0f - coeff.x) * v1_c + coeff.x * v2_c);
+	res1 = (1.0f - coeff.x) * v[0].sdf + coeff.x * v[1].sdf;
+	res1_c = (1.0f - coeff.x) * v[0].w_depth + coeff.x * v[1].w_depth;
 
-	voxel = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 1), vmIndex, cache); v1 = voxel.sdf; v1_c = voxel.w_depth;
-	voxel = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 1), vmIndex, cache); v2 = voxel.sdf; v2_c = voxel.w_depth;
-	res2 = (1.0f - coeff.x) * v1 + coeff.x * v2;
-	res2_c = (1.0f - coeff.x) * v1_c + coeff.x * v2_c;
+	res1 = (1.0f - coeff.y) * res1 + coeff.y * ((1.0f - coeff.x) * v[2].sdf + coeff.x * v[3].sdf);
+	res1_c = (1.0f - coeff.y) * res1_c + coeff.y * ((1.0f - coeff.x) * v[2].w_depth + coeff.x * v[3].w_depth);
 
-	voxel = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 1), vmIndex, cache); v1 = voxel.sdf; v1_c = voxel.w_depth;
-	voxel = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 1), vmIndex, cache); v2 = voxel.sdf; v2_c = voxel.w_depth;
-	res2 = (1.0f - coeff.y) * res2 + coeff.y * ((1.0f - coeff.x) * v1 + coeff.x * v2);
-	res2_c = (1.0f - coeff.y) * res2_c + coeff.y * ((1.0f - coeff.x) * v1_c + coeff.x * v2_c);
+	res2 = (1.0f - coeff.x) * v[4].sdf + coeff.x * v[5].sdf;
+	res2_c = (1.0f - coeff.x) * v[4].w_depth + coeff.x * v[5].w_depth;
+
+	res2 = (1.0f - coeff.y) * res2 + coeff.y * ((1.0f - coeff.x) * v[6].sdf + coeff.x * v[7].sdf);
+	res2_c = (1.0f - coeff.y) * res2_c + coeff.y * ((1.0f - coeff.x) * v[6].w_depth + coeff.x * v[7].w_depth);
 
 	vmIndex = true;
 
@@ -204,56 +242,20 @@ template<class TVoxel, class TIndex, class TCache>
 _CPU_AND_GPU_CODE_ inline float readFromSDF_float_interpolated(const CONSTPTR(TVoxel) *voxelData,
 	const CONSTPTR(TIndex) *voxelIndex, Vector3f point, THREADPTR(int) &vmIndex, THREADPTR(TCache) & cache, int & maxW)
 {
-	float res1, res2, v1, v2;
+	float res1, res2;
 	Vector3f coeff; Vector3i pos; TO_INT_FLOOR3(pos, coeff, point);
 
-	{
-		const TVoxel & v = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 0), vmIndex, cache);
-		v1 = v.sdf;
-		maxW = v.w_depth;
-	}
-	{
-		const TVoxel & v = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 0), vmIndex, cache);
-		v2 = v.sdf;
-		if (v.w_depth > maxW) maxW = v.w_depth;
-	}
-	res1 = (1.0f - coeff.x) * v1 + coeff.x * v2;
+	TVoxel v[8];
+	readVoxelCorners(v, voxelData, voxelIndex, pos, cache);
 
-	{
-		const TVoxel & v = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 0), vmIndex, cache);
-		v1 = v.sdf;
-		if (v.w_depth > maxW) maxW = v.w_depth;
-	}
-	{
-		const TVoxel & v = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 0), vmIndex, cache);
-		v2 = v.sdf;
-		if (v.w_depth > maxW) maxW = v.w_depth;
-	}
-	res1 = (1.0f - coeff.y) * res1 + coeff.y * ((1.0f - coeff.x) * v1 + coeff.x * v2);
+	maxW = v[0].w_depth;
+	for (int i = 1; i < 8; i++) if (v[i].w_depth > maxW) maxW = v[i].w_depth;
 
-	{
-		const TVoxel & v = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 1), vmIndex, cache);
-		v1 = v.sdf;
-		if (v.w_depth > maxW) maxW = v.w_depth;
-	}
-	{
-		const TVoxel & v = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 1), vmIndex, cache);
-		v2 = v.sdf;
-		if (v.w_depth > maxW) maxW = v.w_depth;
-	}
-	res2 = (1.0f - coeff.x) * v1 + coeff.x * v2;
+	res1 = (1.0f - coeff.x) * v[0].sdf + coeff.x * v[1].sdf;
+	res1 = (1.0f - coeff.y) * res1 + coeff.y * ((1.0f - coeff.x) * v[2].sdf + coeff.x * v[3].sdf);
 
-	{
-		const TVoxel & v = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 1), vmIndex, cache);
-		v1 = v.sdf;
-		if (v.w_depth > maxW) maxW = v.w_depth;
-	}
-	{
-		const TVoxel & v = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 1), vmIndex, cache);
-		v2 = v.sdf;
-		if (v.w_depth > maxW) maxW = v.w_depth;
-	}
-	res2 = (1.0f - coeff.y) * res2 + coeff.y * ((1.0f - coeff.x) * v1 + coeff.x * v2);
+	res2 = (1.0f - coeff.x) * v[4].sdf + coeff.x * v[5].sdf;
+	res2 = (1.0f - coeff.y) * res2 + coeff.y * ((1.0f - coeff.x) * v[6].sdf + coeff.x * v[7].sdf);
 
 	vmIndex = true;
 	return TVoxel::valueToFloat((1.0f - coeff.z) * res1 + coeff.z * res2);
@@ -263,32 +265,20 @@ template<class TVoxel, class TIndex, class TCache>
 _CPU_AND_GPU_CODE_ inline Vector4f readFromSDF_color4u_interpolated(const CONSTPTR(TVoxel) *voxelData,
 	const CONSTPTR(TIndex) *voxelIndex, const THREADPTR(Vector3f) & point, THREADPTR(TCache) & cache)
 {
-	TVoxel resn; Vector3f ret(0.0f); Vector4f ret4; int vmIndex;
+	Vector3f ret(0.0f); Vector4f ret4;
 	Vector3f coeff; Vector3i pos; TO_INT_FLOOR3(pos, coeff, point);
 
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 0), vmIndex, cache);
-	ret += (1.0f - coeff.x) * (1.0f - coeff.y) * (1.0f - coeff.z) * resn.clr.toFloat();
-
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 0), vmIndex, cache);
-	ret += (coeff.x) * (1.0f - coeff.y) * (1.0f - coeff.z) * resn.clr.toFloat();
-
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 0), vmIndex, cache);
-	ret += (1.0f - coeff.x) * (coeff.y) * (1.0f - coeff.z) * resn.clr.toFloat();
-
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 0), vmIndex, cache);
-	ret += (coeff.x) * (coeff.y) * (1.0f - coeff.z) * resn.clr.toFloat();
+	TVoxel v[8];
+	readVoxelCorners(v, voxelData, voxelIndex, pos, cache);
 
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 1), vmIndex, cache);
-	ret += (1.0f - coeff.x) * (1.0f - coeff.y) * coeff.z * resn.clr.toFloat();
-
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 1), vmIndex, cache);
-	ret += (coeff.x) * (1.0f - coeff.y) * coeff.z * resn.clr.toFloat();
-
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 1), vmIndex, cache);
-	ret += (1.0f - coeff.x) * (coeff.y) * coeff.z * resn.clr.toFloat();
-
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 1), vmIndex, cache);
-	ret += (coeff.x) * (coeff.y) * coeff.z * resn.clr.toFloat();
+	ret += (1.0f - coeff.x) * (1.0f - coeff.y) * (1.0f - coeff.z) * v[0].clr.toFloat();
+	ret += (coeff.x) * (1.0f - coeff.y) * (1.0f - coeff.z) * v[1].clr.toFloat();
+	ret += (1.0f - coeff.x) * (coeff.y) * (1.0f - coeff.z) * v[2].clr.toFloat();
+	ret += (coeff.x) * (coeff.y) * (1.0f - coeff.z) * v[3].clr.toFloat();
+	ret += (1.0f - coeff.x) * (1.0f - coeff.y) * coeff.z * v[4].clr.toFloat();
+	ret += (coeff.x) * (1.0f - coeff.y) * coeff.z * v[5].clr.toFloat();
+	ret += (1.0f - coeff.x) * (coeff.y) * coeff.z * v[6].clr.toFloat();
+	ret += (coeff.x) * (coeff.y) * coeff.z * v[7].clr.toFloat();
 
 	ret4.x = ret.x; ret4.y = ret.y; ret4.z = ret.z; ret4.w = 255.0f;
 
@@ -299,48 +289,32 @@ template<class TVoxel, class TIndex, class TCache>
 _CPU_AND_GPU_CODE_ inline Vector4f readFromSDF_color4u_interpolated(const CONSTPTR(TVoxel) *voxelData,
 	const CONSTPTR(TIndex) *voxelIndex, const THREADPTR(Vector3f) & point, THREADPTR(TCache) & cache, int & maxW)
 {
-	TVoxel resn; Vector3f ret(0.0f); Vector4f ret4; int vmIndex;
+	Vector3f ret(0.0f); Vector4f ret4;
 	Vector3f coeff; Vector3i pos; TO_INT_FLOOR3(pos, coeff, point);
 
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 0), vmIndex, cache);
-	maxW = resn.w_depth;
-	ret += (1.0f - coeff.x) * (1.0f - coeff.y) * (1.0f - coeff.z) * resn.clr.toFloat();
-
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 0), vmIndex, cache);
-	if (resn.w_depth > maxW) maxW = resn.w_depth;
-	ret += (coeff.x) * (1.0f - coeff.y) * (1.0f - coeff.z) * resn.clr.toFloat();
-
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 0), vmIndex, cache);
-	if (resn.w_depth > maxW) maxW = resn.w_depth;
-	ret += (1.0f - coeff.x) * (coeff.y) * (1.0f - coeff.z) * resn.clr.toFloat();
-
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 0), vmIndex, cache);
-	if (resn.w_depth > maxW) maxW = resn.w_depth;
-	ret += (coeff.x) * (coeff.y) * (1.0f - coeff.z) * resn.clr.toFloat();
+	TVoxel v[8];
+	readVoxelCorners(v, voxelData, voxelIndex, pos, cache);
 
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 1), vmIndex, cache);
-	if (resn.w_depth > maxW) maxW = resn.w_depth;
-	ret += (1.0f - coeff.x) * (1.0f - coeff.y) * coeff.z * resn.clr.toFloat();
+	maxW = v[0].w_depth;
+	for (int i = 1; i < 8; i++) if (v[i].w_depth > maxW) maxW = v[i].w_depth;
 
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 1), vmIndex, cache);
-	if (resn.w_depth > maxW) maxW = resn.w_depth;
-	ret += (coeff.x) * (1.0f - coeff.y) * coeff.z * resn.clr.toFloat();
-
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 1), vmIndex, cache);
-	if (resn.w_depth > maxW) maxW = resn.w_depth;
-	ret += (1.0f - coeff.x) * (coeff.y) * coeff.z * resn.clr.toFloat();
-
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 1), vmIndex, cache);
-	if (resn.w_depth > maxW) maxW = resn.w_depth;
-	ret += (coeff.x) * (coeff.y) * coeff.z * resn.clr.toFloat();
+	ret += (1.0f - coeff.x) * (1.0f - coeff.y) * (1.0f - coeff.z) * v[0].clr.toFloat();
+	ret += (coeff.x) * (1.0f - coeff.y) * (1.0f - coeff.z) * v[1].clr.toFloat();
+	ret += (1.0f - coeff.x) * (coeff.y) * (1.0f - coeff.z) * v[2].clr.toFloat();
+	ret += (coeff.x) * (coeff.y) * (1.0f - coeff.z) * v[3].clr.toFloat();
+	ret += (1.0f - coeff.x) * (1.0f - coeff.y) * coeff.z * v[4].clr.toFloat();
+	ret += (coeff.x) * (1.0f - coeff.y) * coeff.z * v[5].clr.toFloat();
+	ret += (1.0f - coeff.x) * (coeff.y) * coeff.z * v[6].clr.toFloat();
+	ret += (coeff.x) * (coeff.y) * coeff.z * v[7].clr.toFloat();
 
 	ret4.x = ret.x; ret4.y = ret.y; ret4.z = ret.z; ret4.w = 255.0f;
 
 	return ret4 / 255.0f;
 }
 
-template<class TVoxel, class TIndex>
-_CPU_AND_GPU_CODE_ inline Vector3f computeSingleNormalFromSDF(const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(TIndex) *voxelIndex, const THREADPTR(Vector3f) &point)
+template<class TVoxel, class TIndex, class TCache>
+_CPU_AND_GPU_CODE_ inline Vector3f computeSingleNormalFromSDF(const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(TIndex) *voxelIndex, const THREADPTR(Vector3f) &point,
+	THREADPTR(TCache) & cache)
 {
 	int vmIndex;
 
@@ -349,16 +323,15 @@ _CPU_AND_GPU_CODE_ inline Vector3f computeSingleNormalFromSDF(const CONSTPTR(TVo
 	Vector3f ncoeff(1.0f - coeff.x, 1.0f - coeff.y, 1.0f - coeff.z);
 
 	// all 8 values are going to be reused several times
+	TVoxel v[8];
+	readVoxelCorners(v, voxelData, voxelIndex, pos, cache);
+
 	Vector4f front, back;
-	front.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 0), vmIndex).sdf;
-	front.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 0), vmIndex).sdf;
-	front.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 0), vmIndex).sdf;
-	front.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 0), vmIndex).sdf;
-	back.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 1), vmIndex).sdf;
-	back.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 1), vmIndex).sdf;
-	back.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 1), vmIndex).sdf;
-	back.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 1), vmIndex).sdf;
+	front.x = v[0].sdf; front.y = v[1].sdf; front.z = v[2].sdf; front.w = v[3].sdf;
+	back.x = v[4].sdf; back.y = v[5].sdf; back.z = v[6].sdf; back.w = v[7].sdf;
 
+	// the whole stencil spans at most 2x2x2 blocks, so the parity slotted
+	// cache resolves each of them from the hash table at most once
 	Vector4f tmp;
 	float p1, p2, v1;
 	// gradient x
@@ -366,10 +339,10 @@ _CPU_AND_GPU_CODE_ inline Vector3f computeSingleNormalFromSDF(const CONSTPTR(TVo
 		front.z *  coeff.y * ncoeff.z +
 		back.x  * ncoeff.y *  coeff.z +
 		back.z  *  coeff.y *  coeff.z;
-	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(-1, 0, 0), vmIndex).sdf;
-	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(-1, 1, 0), vmIndex).sdf;
-	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(-1, 0, 1), vmIndex).sdf;
-	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(-1, 1, 1), vmIndex).sdf;
+	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(-1, 0, 0), vmIndex, cache).sdf;
+	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(-1, 1, 0), vmIndex, cache).sdf;
+	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(-1, 0, 1), vmIndex, cache).sdf;
+	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(-1, 1, 1), vmIndex, cache).sdf;
 	p2 = tmp.x * ncoeff.y * ncoeff.z +
 		tmp.y *  coeff.y * ncoeff.z +
 		tmp.z * ncoeff.y *  coeff.z +
@@ -380,10 +353,10 @@ _CPU_AND_GPU_CODE_ inline Vector3f computeSingleNormalFromSDF(const CONSTPTR(TVo
 		front.w *  coeff.y * ncoeff.z +
 		back.y  * ncoeff.y *  coeff.z +
 		back.w  *  coeff.y *  coeff.z;
-	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(2, 0, 0), vmIndex).sdf;
-	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(2, 1, 0), vmIndex).sdf;
-	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(2, 0, 1), vmIndex).sdf;
-	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(2, 1, 1), vmIndex).sdf;
+	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(2, 0, 0), vmIndex, cache).sdf;
+	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(2, 1, 0), vmIndex, cache).sdf;
+	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(2, 0, 1), vmIndex, cache).sdf;
+	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(2, 1, 1), vmIndex, cache).sdf;
 	p2 = tmp.x * ncoeff.y * ncoeff.z +
 		tmp.y *  coeff.y * ncoeff.z +
 		tmp.z * ncoeff.y *  coeff.z +
@@ -396,10 +369,10 @@ _CPU_AND_GPU_CODE_ inline Vector3f computeSingleNormalFromSDF(const CONSTPTR(TVo
 		front.y *  coeff.x * ncoeff.z +
 		back.x  * ncoeff.x *  coeff.z +
 		back.y  *  coeff.x *  coeff.z;
-	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, -1, 0), vmIndex).sdf;
-	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, -1, 0), vmIndex).sdf;
-	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, -1, 1), vmIndex).sdf;
-	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, -1, 1), vmIndex).sdf;
+	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, -1, 0), vmIndex, cache).sdf;
+	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, -1, 0), vmIndex, cache).sdf;
+	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, -1, 1), vmIndex, cache).sdf;
+	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, -1, 1), vmIndex, cache).sdf;
 	p2 = tmp.x * ncoeff.x * ncoeff.z +
 		tmp.y *  coeff.x * ncoeff.z +
 		tmp.z * ncoeff.x *  coeff.z +
@@ -410,10 +383,10 @@ _CPU_AND_GPU_CODE_ inline Vector3f computeSingleNormalFromSDF(const CONSTPTR(TVo
 		front.w *  coeff.x * ncoeff.z +
 		back.z  * ncoeff.x *  coeff.z +
 		back.w  *  coeff.x *  coeff.z;
-	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 2, 0), vmIndex).sdf;
-	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 2, 0), vmIndex).sdf;
-	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 2, 1), vmIndex).sdf;
-	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 2, 1), vmIndex).sdf;
+	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 2, 0), vmIndex, cache).sdf;
+	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 2, 0), vmIndex, cache).sdf;
+	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 2, 1), vmIndex, cache).sdf;
+	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 2, 1), vmIndex, cache).sdf;
 	p2 = tmp.x * ncoeff.x * ncoeff.z +
 		tmp.y *  coeff.x * ncoeff.z +
 		tmp.z * ncoeff.x *  coeff.z +
@@ -426,10 +399,10 @@ _CPU_AND_GPU_CODE_ inline Vector3f computeSingleNormalFromSDF(const CONSTPTR(TVo
 		front.y *  coeff.x * ncoeff.y +
 		front.z * ncoeff.x *  coeff.y +
 		front.w *  coeff.x *  coeff.y;
-	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, -1), vmIndex).sdf;
-	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, -1), vmIndex).sdf;
-	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, -1), vmIndex).sdf;
-	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, -1), vmIndex).sdf;
+	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, -1), vmIndex, cache).sdf;
+	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, -1), vmIndex, cache).sdf;
+	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, -1), vmIndex, cache).sdf;
+	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, -1), vmIndex, cache).sdf;
 	p2 = tmp.x * ncoeff.x * ncoeff.y +
 		tmp.y *  coeff.x * ncoeff.y +
 		tmp.z * ncoeff.x *  coeff.y +
@@ -440,10 +413,10 @@ _CPU_AND_GPU_CODE_ inline Vector3f computeSingleNormalFromSDF(const CONSTPTR(TVo
 		back.y *  coeff.x * ncoeff.y +
 		back.z * ncoeff.x *  coeff.y +
 		back.w *  coeff.x *  coeff.y;
-	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 2), vmIndex).sdf;
-	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 2), vmIndex).sdf;
-	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 2), vmIndex).sdf;
-	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 2), vmIndex).sdf;
+	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 2), vmIndex, cache).sdf;
+	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 2), vmIndex, cache).sdf;
+	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 2), vmIndex, cache).sdf;
+	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 2), vmIndex, cache).sdf;
 	p2 = tmp.x * ncoeff.x * ncoeff.y +
 		tmp.y *  coeff.x * ncoeff.y +
 		tmp.z * ncoeff.x *  coeff.y +
@@ -509,7 +482,7 @@ _CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(TVoxel) *voxelData, co
 	const THREADPTR(Vector3i) & point_orig, THREADPTR(int) &vmIndex)
 {
 	int voxelAddress = findVoxel(voxelIndex, point_orig, vmIndex);
-	return vmIndex ? voxelData[voxelAddress] : TVoxel();
+	return vmIndex ? loadVoxel(voxelData, voxelAddress) : TVoxel();
 }
 
 template<class TVoxel>
@@ -519,6 +492,19 @@ _CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(TVoxel) *voxelData, co
 	return readVoxel(voxelData, voxelIndex, point_orig, vmIndex);
 }
 
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline int readVoxelCorners(THREADPTR(TVoxel) *corners, const CONSTPTR(TVoxel) *voxelData,
+	const CONSTPTR(ITMLib::ITMPlainVoxelArray::IndexData) *voxelIndex, const THREADPTR(Vector3i) & pos, THREADPTR(ITMLib::ITMPlainVoxelArray::IndexCache) & cache)
+{
+	int vmIndex, foundMask = 0;
+	for (int i = 0; i < 8; i++)
+	{
+		corners[i] = readVoxel(voxelData, voxelIndex, pos + Vector3i(i & 1, (i >> 1) & 1, (i >> 2) & 1), vmIndex);
+		if (vmIndex) foundMask |= 1 << i;
+	}
+	return foundMask;
+}
+
 /**
 * \brief The specialisations of this struct template can be used to write/read colours to/from surfels.
 *
@@ -40,10 +40,12 @@ namespace ITMLib
 			index.LoadFromDirectory(outputDirectory);			
 		}
 
-		ITMScene(const ITMSceneParams *_sceneParams, bool _useSwapping, MemoryDeviceType _memoryType)
-			: sceneParams(_sceneParams), index(_memoryType), localVBA(_memoryType, index.getNumAllocatedVoxelBlocks(), index.getVoxelBlockSize())
+		/** \p _maxStoredBlocks bounds the global cache, 0 keeps every swapped out block.
+		    \p _noVoxelBlocks is the size of the local VBA, see ITMLibSettings::noLocalVoxelBlocks. */
+		ITMScene(const ITMSceneParams *_sceneParams, bool _useSwapping, MemoryDeviceType _memoryType, int _maxStoredBlocks = 0, int _noVoxelBlocks = 0)
+			: sceneParams(_sceneParams), index(_memoryType, _noVoxelBlocks), localVBA(_memoryType, index.getNumAllocatedVoxelBlocks(), index.getVoxelBlockSize())
 		{
-			if (_useSwapping) globalCache = new ITMGlobalCache<TVoxel>();
+			if (_useSwapping) globalCache = new ITMGlobalCache<TVoxel>(_maxStoredBlocks);
 			else globalCache = NULL;
 		}
 
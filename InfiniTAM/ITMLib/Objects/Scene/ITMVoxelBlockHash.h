@@ -30,6 +30,8 @@
 
 #define SDF_TRANSFER_BLOCK_NUM 0x1000	// Maximum number of blocks transfered in one swap operation
 
+#define SDF_INDEX_CACHE_SIZE 8			// Number of blocks remembered by IndexCache, 1, 2, 4 or 8, slot is chosen by the block position parity
+
 /** \brief
 	A single entry in the hash table.
 */
@@ -59,10 +61,18 @@ namespace ITMLib
 	public:
 		typedef ITMHashEntry IndexData;
 
+		/** Small direct mapped cache of recently resolved blocks. The
+		    slot is picked from the parity of the block position, so the
+		    (up to) eight blocks touched by one 2x2x2 gather never evict
+		    each other.
+		*/
 		struct IndexCache {
-			Vector3i blockPos;
-			int blockPtr;
-			_CPU_AND_GPU_CODE_ IndexCache(void) : blockPos(0x7fffffff), blockPtr(-1) {}
+			Vector3i blockPos[SDF_INDEX_CACHE_SIZE];
+			int blockPtr[SDF_INDEX_CACHE_SIZE];
+			_CPU_AND_GPU_CODE_ IndexCache(void)
+			{
+				for (int i = 0; i < SDF_INDEX_CACHE_SIZE; i++) { blockPos[i] = Vector3i(0x7fffffff); blockPtr[i] = -1; }
+			}
 		};
 
 		/** Maximum number of total entries. */
@@ -85,10 +95,15 @@ namespace ITMLib
 
 		MemoryDeviceType memoryType;
 
+		/** Number of voxel blocks in the local VBA, at most SDF_LOCAL_BLOCK_NUM. */
+		int noVoxelBlocks;
+
 	public:
-		ITMVoxelBlockHash(MemoryDeviceType memoryType)
+		/** \p noVoxelBlocks bounds the local VBA below SDF_LOCAL_BLOCK_NUM, 0 uses SDF_LOCAL_BLOCK_NUM. */
+		explicit ITMVoxelBlockHash(MemoryDeviceType memoryType, int noVoxelBlocks = 0)
 		{
 			this->memoryType = memoryType;
+			this->noVoxelBlocks = noVoxelBlocks > 0 && noVoxelBlocks < SDF_LOCAL_BLOCK_NUM ? noVoxelBlocks : SDF_LOCAL_BLOCK_NUM;
 			hashEntries = new ORUtils::MemoryBlock<ITMHashEntry>(noTotalEntries, memoryType);
 			excessAllocationList = new ORUtils::MemoryBlock<int>(SDF_EXCESS_LIST_SIZE, memoryType);
 		}
@@ -123,7 +138,7 @@ namespace ITMLib
 #endif
 
 		/** Maximum number of total entries. */
-		int getNumAllocatedVoxelBlocks(void) { return SDF_LOCAL_BLOCK_NUM; }
+		int getNumAllocatedVoxelBlocks(void) const { return noVoxelBlocks; }
 		int getVoxelBlockSize(void) { return SDF_BLOCK_SIZE3; }
 
 		void SaveToDirectory(const std::string &outputDirectory) const
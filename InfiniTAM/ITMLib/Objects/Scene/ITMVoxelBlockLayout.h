@@ -0,0 +1,142 @@
+// Copyright 2014-2017 Oxford University Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include "ITMVoxelBlockHash.h"
+#include "ITMVoxelTypes.h"
+
+/** \brief
+    Selects how voxels are laid out within each run of SDF_BLOCK_SIZE3
+    voxels of the local VBA.
+
+    By default a block is an array of TVoxel. With SDF_BLOCK_LAYOUT_SOA
+    defined, each block instead stores all sdf values, then all depth
+    weights, then the colours and colour weights (or the confidences). A
+    block still takes SDF_BLOCK_SIZE3 * sizeof(TVoxel) bytes, so allocation,
+    swapping and persistence copy whole blocks unchanged, but saved scenes
+    are only readable with the layout they were written with.
+
+    Voxel memory must only be accessed through loadVoxel and storeVoxel.
+    Readers that only use some fields of the returned TVoxel (e.g. the sdf
+    in the raycaster) then only touch the corresponding arrays.
+*/
+//#define SDF_BLOCK_LAYOUT_SOA
+
+#if defined(SDF_BLOCK_LAYOUT_SOA) && (defined(COMPILE_WITH_METAL) || defined(__METALC__))
+#error SDF_BLOCK_LAYOUT_SOA is not supported by the Metal engines
+#endif
+
+#ifndef SDF_BLOCK_LAYOUT_SOA
+
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline TVoxel loadVoxel(const CONSTPTR(TVoxel) *voxelData, int voxelIdx)
+{
+	return voxelData[voxelIdx];
+}
+
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline void storeVoxel(DEVICEPTR(TVoxel) *voxelData, int voxelIdx, const THREADPTR(TVoxel) & voxel)
+{
+	voxelData[voxelIdx] = voxel;
+}
+
+#else
+
+/** Byte offsets of the per field arrays inside one block. */
+template<class TVoxel>
+struct ITMVoxelBlockSoA
+{
+	typedef decltype(TVoxel::sdf) SDFType;
+
+	enum {
+		sdfOffset = 0,
+		wDepthOffset = sdfOffset + SDF_BLOCK_SIZE3 * sizeof(SDFType),
+		extraOffset = wDepthOffset + SDF_BLOCK_SIZE3 * sizeof(uchar)
+	};
+};
+
+template<class TField, class TVoxel>
+_CPU_AND_GPU_CODE_ inline TField *voxelFieldSoA(const CONSTPTR(TVoxel) *voxelData, int voxelIdx, int fieldOffset)
+{
+	int linearIdx = voxelIdx & (SDF_BLOCK_SIZE3 - 1);
+	return (TField*)((const char*)(voxelData + (voxelIdx - linearIdx)) + fieldOffset) + linearIdx;
+}
+
+template<bool hasColor, bool hasConfidence, class TVoxel> struct VoxelExtraFieldsSoA;
+
+template<class TVoxel>
+struct VoxelExtraFieldsSoA<false, false, TVoxel> {
+	_CPU_AND_GPU_CODE_ static void load(const CONSTPTR(TVoxel) *voxelData, int voxelIdx, THREADPTR(TVoxel) & voxel) {}
+	_CPU_AND_GPU_CODE_ static void store(DEVICEPTR(TVoxel) *voxelData, int voxelIdx, const THREADPTR(TVoxel) & voxel) {}
+};
+
+template<class TVoxel>
+struct VoxelExtraFieldsSoA<true, false, TVoxel> {
+	enum { clrOffset = ITMVoxelBlockSoA<TVoxel>::extraOffset, wColorOffset = clrOffset + SDF_BLOCK_SIZE3 * sizeof(Vector3u) };
+
+	_CPU_AND_GPU_CODE_ static void load(const CONSTPTR(TVoxel) *voxelData, int voxelIdx, THREADPTR(TVoxel) & voxel)
+	{
+		voxel.clr = *voxelFieldSoA<Vector3u>(voxelData, voxelIdx, clrOffset);
+		voxel.w_color = *voxelFieldSoA<uchar>(voxelData, voxelIdx, wColorOffset);
+	}
+
+	_CPU_AND_GPU_CODE_ static void store(DEVICEPTR(TVoxel) *voxelData, int voxelIdx, const THREADPTR(TVoxel) & voxel)
+	{
+		*voxelFieldSoA<Vector3u>(voxelData, voxelIdx, clrOffset) = voxel.clr;
+		*voxelFieldSoA<uchar>(voxelData, voxelIdx, wColorOffset) = voxel.w_color;
+	}
+};
+
+template<>
+struct VoxelExtraFieldsSoA<true, false, ITMVoxel_b_rgb> {
+	enum { clrOffset = ITMVoxelBlockSoA<ITMVoxel_b_rgb>::extraOffset };
+
+	_CPU_AND_GPU_CODE_ static void load(const CONSTPTR(ITMVoxel_b_rgb) *voxelData, int voxelIdx, THREADPTR(ITMVoxel_b_rgb) & voxel)
+	{
+		voxel.clr = *voxelFieldSoA<ITMColor565>(voxelData, voxelIdx, clrOffset);
+	}
+
+	_CPU_AND_GPU_CODE_ static void store(DEVICEPTR(ITMVoxel_b_rgb) *voxelData, int voxelIdx, const THREADPTR(ITMVoxel_b_rgb) & voxel)
+	{
+		*voxelFieldSoA<ITMColor565>(voxelData, voxelIdx, clrOffset) = voxel.clr;
+	}
+};
+
+template<class TVoxel>
+struct VoxelExtraFieldsSoA<false, true, TVoxel> {
+	enum { confidenceOffset = ITMVoxelBlockSoA<TVoxel>::extraOffset };
+
+	_CPU_AND_GPU_CODE_ static void load(const CONSTPTR(TVoxel) *voxelData, int voxelIdx, THREADPTR(TVoxel) & voxel)
+	{
+		voxel.confidence = *voxelFieldSoA<float>(voxelData, voxelIdx, confidenceOffset);
+	}
+
+	_CPU_AND_GPU_CODE_ static void store(DEVICEPTR(TVoxel) *voxelData, int voxelIdx, const THREADPTR(TVoxel) & voxel)
+	{
+		*voxelFieldSoA<float>(voxelData, voxelIdx, confidenceOffset) = voxel.confidence;
+	}
+};
+
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline TVoxel loadVoxel(const CONSTPTR(TVoxel) *voxelData, int voxelIdx)
+{
+	typedef ITMVoxelBlockSoA<TVoxel> Layout;
+
+	TVoxel voxel;
+	voxel.sdf = *voxelFieldSoA<typename Layout::SDFType>(voxelData, voxelIdx, Layout::sdfOffset);
+	voxel.w_depth = *voxelFieldSoA<uchar>(voxelData, voxelIdx, Layout::wDepthOffset);
+	VoxelExtraFieldsSoA<TVoxel::hasColorInformation, TVoxel::hasConfidenceInformation, TVoxel>::load(voxelData, voxelIdx, voxel);
+	return voxel;
+}
+
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline void storeVoxel(DEVICEPTR(TVoxel) *voxelData, int voxelIdx, const THREADPTR(TVoxel) & voxel)
+{
+	typedef ITMVoxelBlockSoA<TVoxel> Layout;
+
+	*voxelFieldSoA<typename Layout::SDFType>(voxelData, voxelIdx, Layout::sdfOffset) = voxel.sdf;
+	*voxelFieldSoA<uchar>(voxelData, voxelIdx, Layout::wDepthOffset) = voxel.w_depth;
+	VoxelExtraFieldsSoA<TVoxel::hasColorInformation, TVoxel::hasConfidenceInformation, TVoxel>::store(voxelData, voxelIdx, voxel);
+}
+
+#endif
@@ -142,3 +142,82 @@ struct ITMVoxel_f_conf
 	}
 };
 
+#ifndef __METALC__
+
+/** \brief
+    RGB colour packed into 16 bits as 5-6-5, converts to and from Vector3u
+*/
+struct ITMColor565
+{
+	ushort rgb;
+
+	_CPU_AND_GPU_CODE_ ITMColor565() : rgb(0) {}
+	_CPU_AND_GPU_CODE_ ITMColor565(const Vector3u & c)
+	{
+		rgb = (ushort)((((c.x * 31 + 127) / 255) << 11) | (((c.y * 63 + 127) / 255) << 5) | ((c.z * 31 + 127) / 255));
+	}
+
+	_CPU_AND_GPU_CODE_ operator Vector3u() const
+	{
+		return Vector3u((uchar)(((rgb >> 11) * 255 + 15) / 31), (uchar)((((rgb >> 5) & 0x3f) * 255 + 31) / 63), (uchar)(((rgb & 0x1f) * 255 + 15) / 31));
+	}
+
+	_CPU_AND_GPU_CODE_ Vector3f toFloat() const { return ((Vector3u)*this).toFloat(); }
+};
+
+/** \brief
+    Compact voxel with an 8 bit quantised SDF and an 8 bit weight (2 bytes)
+*/
+struct ITMVoxel_b
+{
+	_CPU_AND_GPU_CODE_ static signed char SDF_initialValue() { return 127; }
+	_CPU_AND_GPU_CODE_ static float valueToFloat(float x) { return (float)(x) / 127.0f; }
+	// rounded rather than truncated, truncation would bias every value towards 0 by up to one step
+	_CPU_AND_GPU_CODE_ static signed char floatToValue(float x) { return (signed char)ROUND((x) * 127.0f); }
+
+	static const CONSTPTR(bool) hasColorInformation = false;
+	static const CONSTPTR(bool) hasConfidenceInformation = false;
+	static const CONSTPTR(bool) hasSemanticInformation = false;
+
+	/** Value of the truncated signed distance transformation. */
+	signed char sdf;
+	/** Number of fused observations that make up @p sdf. */
+	uchar w_depth;
+
+	_CPU_AND_GPU_CODE_ ITMVoxel_b()
+	{
+		sdf = SDF_initialValue();
+		w_depth = 0;
+	}
+};
+
+/** \brief
+    Compact voxel with an 8 bit quantised SDF, an 8 bit weight and RGB565
+    colour (4 bytes). There is no separate colour weight, the colour is
+    averaged using @p w_depth instead.
+*/
+struct ITMVoxel_b_rgb
+{
+	_CPU_AND_GPU_CODE_ static signed char SDF_initialValue() { return 127; }
+	_CPU_AND_GPU_CODE_ static float valueToFloat(float x) { return (float)(x) / 127.0f; }
+	_CPU_AND_GPU_CODE_ static signed char floatToValue(float x) { return (signed char)ROUND((x) * 127.0f); }
+
+	static const CONSTPTR(bool) hasColorInformation = true;
+	static const CONSTPTR(bool) hasConfidenceInformation = false;
+	static const CONSTPTR(bool) hasSemanticInformation = false;
+
+	/** Value of the truncated signed distance transformation. */
+	signed char sdf;
+	/** Number of fused observations that make up @p sdf and @p clr. */
+	uchar w_depth;
+	/** RGB colour information stored for this voxel. */
+	ITMColor565 clr;
+
+	_CPU_AND_GPU_CODE_ ITMVoxel_b_rgb()
+	{
+		sdf = SDF_initialValue();
+		w_depth = 0;
+	}
+};
+
+#endif
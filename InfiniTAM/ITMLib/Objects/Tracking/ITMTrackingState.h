@@ -35,6 +35,15 @@ namespace ITMLib
 		/// Current pose of the depth camera.
 		ORUtils::SE3Pose *pose_d;
 
+		enum { MAX_TRACKER_LEVELS = 8 };
+
+		/// Iterations run on each level of the hierarchy by the last call of the tracker,
+		/// level 0 being the finest, and the valid points of its last accepted step.
+		/// Only the ICP based trackers fill these in.
+		int noTrackerLevels;
+		int trackerIterations[MAX_TRACKER_LEVELS];
+		int noValidPoints;
+
 		/// Tracking quality: 1.0: success, 0.0: failure
 		enum TrackingResult
 		{
@@ -84,6 +93,8 @@ namespace ITMLib
 			this->pose_d->SetFrom(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
 			this->pose_pointCloud->SetFrom(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
 			this->trackerResult = TRACKING_GOOD;
+			this->noTrackerLevels = 0;
+			this->noValidPoints = 0;
 		}
 
 		// Suppress the default copy constructor and assignment operator
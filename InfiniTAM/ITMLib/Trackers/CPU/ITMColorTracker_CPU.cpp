@@ -2,9 +2,38 @@
 
 #include "ITMColorTracker_CPU.h"
 #include "../Shared/ITMColorTracker_Shared.h"
+#include "../../../ORUtils/TaskScheduler.h"
+
+#include <utility>
 
 using namespace ITMLib;
 
+namespace
+{
+	/// Sums of the per point terms of G_oneLevel over a range of points
+	struct AccuCell
+	{
+		float g[6];
+		float h[6 + 5 + 4 + 3 + 2 + 1];
+
+		AccuCell(void)
+		{
+			memset(g, 0, sizeof(g));
+			memset(h, 0, sizeof(h));
+		}
+	};
+
+	AccuCell AddAccuCells(AccuCell a, const AccuCell& b)
+	{
+		for (int i = 0; i < 6; i++) a.g[i] += b.g[i];
+		for (int i = 0; i < 6 + 5 + 4 + 3 + 2 + 1; i++) a.h[i] += b.h[i];
+		return a;
+	}
+
+	// the points are summed in ranges of this many, so the sums do not depend on the number of threads
+	const int POINTS_PER_RANGE = 4096;
+}
+
 ITMColorTracker_CPU::ITMColorTracker_CPU(Vector2i imgSize, TrackerIterationType *trackingRegime, int noHierarchyLevels, const ITMLowLevelEngine *lowLevelEngine)
 	: ITMColorTracker(imgSize, trackingRegime, noHierarchyLevels, lowLevelEngine, MEMORYDEVICE_CPU) {  }
 
@@ -28,12 +57,19 @@ int ITMColorTracker_CPU::F_oneLevel(float *f, ORUtils::SE3Pose *pose)
 	Vector4f *colours = trackingState->pointCloud->colours->GetData(MEMORYDEVICE_CPU);
 	Vector4u *rgb = viewHierarchy->GetLevel(levelId)->rgb->GetData(MEMORYDEVICE_CPU);
 
-	final_f = 0; countedPoints_valid = 0;
-	for (int locId = 0; locId < noTotalPoints; locId++)
+	// the sum of the colour differences and the number of points it is over
+	std::pair<float, int> sums = ORUtils::ParallelReduce(0, noTotalPoints, POINTS_PER_RANGE, std::make_pair(0.0f, 0), [&](int begin, int end)
 	{
-		float colorDiffSq = getColorDifferenceSq(locations, colours, rgb, imgSize, locId, projParams, M);
-		if (colorDiffSq >= 0) { final_f += colorDiffSq; countedPoints_valid++; }
-	}
+		std::pair<float, int> rangeSums(0.0f, 0);
+		for (int locId = begin; locId < end; locId++)
+		{
+			float colorDiffSq = getColorDifferenceSq(locations, colours, rgb, imgSize, locId, projParams, M);
+			if (colorDiffSq >= 0) { rangeSums.first += colorDiffSq; rangeSums.second++; }
+		}
+		return rangeSums;
+	}, [](const std::pair<float, int>& a, const std::pair<float, int>& b) { return std::make_pair(a.first + b.first, a.second + b.second); });
+
+	final_f = sums.first; countedPoints_valid = sums.second;
 
 	if (countedPoints_valid == 0) { final_f = 1e10; scaleForOcclusions = 1.0; }
 	else { scaleForOcclusions = (float)noTotalPoints / countedPoints_valid; }
@@ -60,40 +96,43 @@ void ITMColorTracker_CPU::G_oneLevel(float *gradient, float *hessian, ORUtils::S
 	bool rotationOnly = iterationType == TRACKER_ITERATION_ROTATION;
 	int numPara = rotationOnly ? 3 : 6, startPara = rotationOnly ? 3 : 0, numParaSQ = rotationOnly ? 3 + 2 + 1 : 6 + 5 + 4 + 3 + 2 + 1;
 
-	float globalGradient[6], globalHessian[21];
-	for (int i = 0; i < numPara; i++) globalGradient[i] = 0.0f;
-	for (int i = 0; i < numParaSQ; i++) globalHessian[i] = 0.0f;
-
 	Vector4f *locations = trackingState->pointCloud->locations->GetData(MEMORYDEVICE_CPU);
 	Vector4f *colours = trackingState->pointCloud->colours->GetData(MEMORYDEVICE_CPU);
 	Vector4u *rgb = viewHierarchy->GetLevel(levelId)->rgb->GetData(MEMORYDEVICE_CPU);
 	Vector4s *gx = viewHierarchy->GetLevel(levelId)->gradientX_rgb->GetData(MEMORYDEVICE_CPU);
 	Vector4s *gy = viewHierarchy->GetLevel(levelId)->gradientY_rgb->GetData(MEMORYDEVICE_CPU);
 
-	for (int locId = 0; locId < noTotalPoints; locId++)
+	AccuCell sums = ORUtils::ParallelReduce(0, noTotalPoints, POINTS_PER_RANGE, AccuCell(), [&](int begin, int end)
 	{
-		float localGradient[6], localHessian[21];
+		AccuCell rangeSums;
 
-		computePerPointGH_rt_Color(localGradient, localHessian, locations, colours, rgb, imgSize, locId,
-			projParams, M, gx, gy, 6, 0);
+		for (int locId = begin; locId < end; locId++)
+		{
+			float localGradient[6], localHessian[21];
 
-		bool isValidPoint = computePerPointGH_rt_Color(localGradient, localHessian, locations, colours, rgb, imgSize, locId,
-			projParams, M, gx, gy, numPara, startPara);
+			computePerPointGH_rt_Color(localGradient, localHessian, locations, colours, rgb, imgSize, locId,
+				projParams, M, gx, gy, 6, 0);
 
-		if (isValidPoint)
-		{
-			for (int i = 0; i < numPara; i++) globalGradient[i] += localGradient[i];
-			for (int i = 0; i < numParaSQ; i++) globalHessian[i] += localHessian[i];
+			bool isValidPoint = computePerPointGH_rt_Color(localGradient, localHessian, locations, colours, rgb, imgSize, locId,
+				projParams, M, gx, gy, numPara, startPara);
+
+			if (isValidPoint)
+			{
+				for (int i = 0; i < numPara; i++) rangeSums.g[i] += localGradient[i];
+				for (int i = 0; i < numParaSQ; i++) rangeSums.h[i] += localHessian[i];
+			}
 		}
-	}
+
+		return rangeSums;
+	}, AddAccuCells);
 
 	scaleForOcclusions = (float)noTotalPoints / countedPoints_valid;
 	if (countedPoints_valid == 0) { scaleForOcclusions = 1.0f; }
 
 	for (int para = 0, counter = 0; para < numPara; para++)
 	{
-		gradient[para] = globalGradient[para] * scaleForOcclusions;
-		for (int col = 0; col <= para; col++, counter++) hessian[para + col * numPara] = globalHessian[counter] * scaleForOcclusions;
+		gradient[para] = sums.g[para] * scaleForOcclusions;
+		for (int col = 0; col <= para; col++, counter++) hessian[para + col * numPara] = sums.h[counter] * scaleForOcclusions;
 	}
 	for (int row = 0; row < numPara; row++)
 	{
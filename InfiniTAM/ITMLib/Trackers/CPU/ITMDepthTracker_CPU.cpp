@@ -2,9 +2,40 @@
 
 #include "ITMDepthTracker_CPU.h"
 #include "../Shared/ITMDepthTracker_Shared.h"
+#include "../../../ORUtils/TaskScheduler.h"
 
 using namespace ITMLib;
 
+namespace
+{
+	/// Sums of the per point terms of ComputeGandH over a range of rows, as ITMDepthTracker_CUDA::AccuCell
+	struct AccuCell
+	{
+		int numPoints;
+		float f;
+		float g[6];
+		float h[6 + 5 + 4 + 3 + 2 + 1];
+
+		AccuCell(void) : numPoints(0), f(0.0f)
+		{
+			memset(g, 0, sizeof(g));
+			memset(h, 0, sizeof(h));
+		}
+	};
+
+	AccuCell AddAccuCells(AccuCell a, const AccuCell& b)
+	{
+		a.numPoints += b.numPoints;
+		a.f += b.f;
+		for (int i = 0; i < 6; i++) a.g[i] += b.g[i];
+		for (int i = 0; i < 6 + 5 + 4 + 3 + 2 + 1; i++) a.h[i] += b.h[i];
+		return a;
+	}
+
+	// the rows are summed in ranges of this many, so the sums do not depend on the number of threads
+	const int ROWS_PER_RANGE = 8;
+}
+
 ITMDepthTracker_CPU::ITMDepthTracker_CPU(Vector2i imgSize, TrackerIterationType *trackingRegime, int noHierarchyLevels,
 	float terminationThreshold, float failureDetectorThreshold, const ITMLowLevelEngine *lowLevelEngine)
  : ITMDepthTracker(imgSize, trackingRegime, noHierarchyLevels, terminationThreshold,  failureDetectorThreshold, lowLevelEngine, MEMORYDEVICE_CPU)
@@ -27,54 +58,56 @@ int ITMDepthTracker_CPU::ComputeGandH(float &f, float *nabla, float *hessian, Ma
 
 	bool shortIteration = (iterationType == TRACKER_ITERATION_ROTATION) || (iterationType == TRACKER_ITERATION_TRANSLATION);
 
-	float sumHessian[6 * 6], sumNabla[6], sumF; int noValidPoints;
 	int noPara = shortIteration ? 3 : 6, noParaSQ = shortIteration ? 3 + 2 + 1 : 6 + 5 + 4 + 3 + 2 + 1;
 
-	noValidPoints = 0; sumF = 0.0f;
-	memset(sumHessian, 0, sizeof(float) * noParaSQ);
-	memset(sumNabla, 0, sizeof(float) * noPara);
-
-	for (int y = 0; y < viewImageSize.y; y++) for (int x = 0; x < viewImageSize.x; x++)
+	AccuCell sums = ORUtils::ParallelReduce(0, viewImageSize.y, ROWS_PER_RANGE, AccuCell(), [&](int rowBegin, int rowEnd)
 	{
-		float localHessian[6 + 5 + 4 + 3 + 2 + 1], localNabla[6], localF = 0;
+		AccuCell rangeSums;
 
-		for (int i = 0; i < noPara; i++) localNabla[i] = 0.0f;
-		for (int i = 0; i < noParaSQ; i++) localHessian[i] = 0.0f;
-
-		bool isValidPoint;
-        
-		switch (iterationType)
+		for (int y = rowBegin; y < rowEnd; y++) for (int x = 0; x < viewImageSize.x; x++)
 		{
-		case TRACKER_ITERATION_ROTATION:
-			isValidPoint = computePerPointGH_Depth<true, true>(localNabla, localHessian, localF, x, y, depth[x + y * viewImageSize.x], viewImageSize,
-				viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, distThresh[levelId]);
-			break;
-		case TRACKER_ITERATION_TRANSLATION:
-			isValidPoint = computePerPointGH_Depth<true, false>(localNabla, localHessian, localF, x, y, depth[x + y * viewImageSize.x], viewImageSize,
-				viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, distThresh[levelId]);
-			break;
-		case TRACKER_ITERATION_BOTH:
-			isValidPoint = computePerPointGH_Depth<false, false>(localNabla, localHessian, localF, x, y, depth[x + y * viewImageSize.x], viewImageSize,
-				viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, distThresh[levelId]);
-			break;
-		default:
-			isValidPoint = false;
-			break;
+			float localHessian[6 + 5 + 4 + 3 + 2 + 1], localNabla[6], localF = 0;
+
+			for (int i = 0; i < noPara; i++) localNabla[i] = 0.0f;
+			for (int i = 0; i < noParaSQ; i++) localHessian[i] = 0.0f;
+
+			bool isValidPoint;
+
+			switch (iterationType)
+			{
+			case TRACKER_ITERATION_ROTATION:
+				isValidPoint = computePerPointGH_Depth<true, true>(localNabla, localHessian, localF, x, y, depth[x + y * viewImageSize.x], viewImageSize,
+					viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, distThresh[levelId]);
+				break;
+			case TRACKER_ITERATION_TRANSLATION:
+				isValidPoint = computePerPointGH_Depth<true, false>(localNabla, localHessian, localF, x, y, depth[x + y * viewImageSize.x], viewImageSize,
+					viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, distThresh[levelId]);
+				break;
+			case TRACKER_ITERATION_BOTH:
+				isValidPoint = computePerPointGH_Depth<false, false>(localNabla, localHessian, localF, x, y, depth[x + y * viewImageSize.x], viewImageSize,
+					viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, distThresh[levelId]);
+				break;
+			default:
+				isValidPoint = false;
+				break;
+			}
+
+			if (isValidPoint)
+			{
+				rangeSums.numPoints++; rangeSums.f += localF;
+				for (int i = 0; i < noPara; i++) rangeSums.g[i] += localNabla[i];
+				for (int i = 0; i < noParaSQ; i++) rangeSums.h[i] += localHessian[i];
+			}
 		}
 
-		if (isValidPoint)
-		{
-			noValidPoints++; sumF += localF;
-			for (int i = 0; i < noPara; i++) sumNabla[i] += localNabla[i];
-			for (int i = 0; i < noParaSQ; i++) sumHessian[i] += localHessian[i];
-		}
-	}
+		return rangeSums;
+	}, AddAccuCells);
 
-	for (int r = 0, counter = 0; r < noPara; r++) for (int c = 0; c <= r; c++, counter++) hessian[r + c * 6] = sumHessian[counter];
+	for (int r = 0, counter = 0; r < noPara; r++) for (int c = 0; c <= r; c++, counter++) hessian[r + c * 6] = sums.h[counter];
 	for (int r = 0; r < noPara; ++r) for (int c = r + 1; c < noPara; c++) hessian[r + c * 6] = hessian[c + r * 6];
 	
-	memcpy(nabla, sumNabla, noPara * sizeof(float));
-	f = (noValidPoints > 100) ? sumF / noValidPoints : 1e5f;
+	memcpy(nabla, sums.g, noPara * sizeof(float));
+	f = (sums.numPoints > 100) ? sums.f / sums.numPoints : 1e5f;
 
-	return noValidPoints;
+	return sums.numPoints;
 }
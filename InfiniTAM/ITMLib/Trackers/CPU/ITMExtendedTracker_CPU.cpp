@@ -2,9 +2,40 @@
 
 #include "ITMExtendedTracker_CPU.h"
 #include "../Shared/ITMExtendedTracker_Shared.h"
+#include "../../../ORUtils/TaskScheduler.h"
 
 using namespace ITMLib;
 
+namespace
+{
+	/// Sums of the per point terms of ComputeGandH over a range of rows, as ITMExtendedTracker_CUDA::AccuCell
+	struct AccuCell
+	{
+		int numPoints;
+		float f;
+		float g[6];
+		float h[6 + 5 + 4 + 3 + 2 + 1];
+
+		AccuCell(void) : numPoints(0), f(0.0f)
+		{
+			memset(g, 0, sizeof(g));
+			memset(h, 0, sizeof(h));
+		}
+	};
+
+	AccuCell AddAccuCells(AccuCell a, const AccuCell& b)
+	{
+		a.numPoints += b.numPoints;
+		a.f += b.f;
+		for (int i = 0; i < 6; i++) a.g[i] += b.g[i];
+		for (int i = 0; i < 6 + 5 + 4 + 3 + 2 + 1; i++) a.h[i] += b.h[i];
+		return a;
+	}
+
+	// the rows are summed in ranges of this many, so the sums do not depend on the number of threads
+	const int ROWS_PER_RANGE = 8;
+}
+
 ITMExtendedTracker_CPU::ITMExtendedTracker_CPU(Vector2i imgSize_d,
 											   Vector2i imgSize_rgb,
 											   bool useDepth,
@@ -58,97 +89,99 @@ int ITMExtendedTracker_CPU::ComputeGandH_Depth(float &f, float *nabla, float *he
 	bool shortIteration = (currentIterationType == TRACKER_ITERATION_ROTATION)
 						   || (currentIterationType == TRACKER_ITERATION_TRANSLATION);
 
-	float sumHessian[6 * 6], sumNabla[6], sumF; int noValidPoints;
 	int noPara = shortIteration ? 3 : 6, noParaSQ = shortIteration ? 3 + 2 + 1 : 6 + 5 + 4 + 3 + 2 + 1;
 
-	noValidPoints = 0; sumF = 0.0f;
-	memset(sumHessian, 0, sizeof(float) * noParaSQ);
-	memset(sumNabla, 0, sizeof(float) * noPara);
-
-	for (int y = 0; y < viewImageSize.y; y++) for (int x = 0; x < viewImageSize.x; x++)
+	AccuCell sums = ORUtils::ParallelReduce(0, viewImageSize.y, ROWS_PER_RANGE, AccuCell(), [&](int rowBegin, int rowEnd)
 	{
-		float localHessian[6 + 5 + 4 + 3 + 2 + 1], localNabla[6], localF = 0;
+		AccuCell rangeSums;
+
+		for (int y = rowBegin; y < rowEnd; y++) for (int x = 0; x < viewImageSize.x; x++)
+		{
+			float localHessian[6 + 5 + 4 + 3 + 2 + 1], localNabla[6], localF = 0;
 
-		for (int i = 0; i < noPara; i++) localNabla[i] = 0.0f;
-		for (int i = 0; i < noParaSQ; i++) localHessian[i] = 0.0f;
+			for (int i = 0; i < noPara; i++) localNabla[i] = 0.0f;
+			for (int i = 0; i < noParaSQ; i++) localHessian[i] = 0.0f;
 
-		bool isValidPoint;
+			bool isValidPoint;
 
-		float depthWeight;
+			float depthWeight;
 
-		if (framesProcessed < 100)
-		{
-			switch (currentIterationType)
+			if (framesProcessed < 100)
 			{
-			case TRACKER_ITERATION_ROTATION:
-				isValidPoint = computePerPointGH_exDepth<true, true, false>(localNabla, localHessian, localF, x, y, depth[x + y * viewImageSize.x], depthWeight,
-					viewImageSize, viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, spaceThresh[currentLevelId],
-					viewFrustum_min, viewFrustum_max, tukeyCutOff, framesToSkip, framesToWeight);
-				break;
-			case TRACKER_ITERATION_TRANSLATION:
-				isValidPoint = computePerPointGH_exDepth<true, false, false>(localNabla, localHessian, localF, x, y, depth[x + y * viewImageSize.x], depthWeight,
-					viewImageSize, viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, spaceThresh[currentLevelId],
-					viewFrustum_min, viewFrustum_max, tukeyCutOff, framesToSkip, framesToWeight);
-				break;
-			case TRACKER_ITERATION_BOTH:
-				isValidPoint = computePerPointGH_exDepth<false, false, false>(localNabla, localHessian, localF, x, y, depth[x + y * viewImageSize.x], depthWeight,
-					viewImageSize, viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, spaceThresh[currentLevelId],
-					viewFrustum_min, viewFrustum_max, tukeyCutOff, framesToSkip, framesToWeight);
-				break;
-			default:
-				isValidPoint = false;
-				break;
+				switch (currentIterationType)
+				{
+				case TRACKER_ITERATION_ROTATION:
+					isValidPoint = computePerPointGH_exDepth<true, true, false>(localNabla, localHessian, localF, x, y, depth[x + y * viewImageSize.x], depthWeight,
+						viewImageSize, viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, spaceThresh[currentLevelId],
+						viewFrustum_min, viewFrustum_max, tukeyCutOff, framesToSkip, framesToWeight);
+					break;
+				case TRACKER_ITERATION_TRANSLATION:
+					isValidPoint = computePerPointGH_exDepth<true, false, false>(localNabla, localHessian, localF, x, y, depth[x + y * viewImageSize.x], depthWeight,
+						viewImageSize, viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, spaceThresh[currentLevelId],
+						viewFrustum_min, viewFrustum_max, tukeyCutOff, framesToSkip, framesToWeight);
+					break;
+				case TRACKER_ITERATION_BOTH:
+					isValidPoint = computePerPointGH_exDepth<false, false, false>(localNabla, localHessian, localF, x, y, depth[x + y * viewImageSize.x], depthWeight,
+						viewImageSize, viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, spaceThresh[currentLevelId],
+						viewFrustum_min, viewFrustum_max, tukeyCutOff, framesToSkip, framesToWeight);
+					break;
+				default:
+					isValidPoint = false;
+					break;
+				}
 			}
-		}
-		else
-		{
-			switch (currentIterationType)
+			else
 			{
-			case TRACKER_ITERATION_ROTATION:
-				isValidPoint = computePerPointGH_exDepth<true, true, true>(localNabla, localHessian, localF, x, y, depth[x + y * viewImageSize.x], depthWeight,
-					viewImageSize, viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, spaceThresh[currentLevelId],
-					viewFrustum_min, viewFrustum_max, tukeyCutOff, framesToSkip, framesToWeight);
-				break;
-			case TRACKER_ITERATION_TRANSLATION:
-				isValidPoint = computePerPointGH_exDepth<true, false, true>(localNabla, localHessian, localF, x, y, depth[x + y * viewImageSize.x], depthWeight,
-					viewImageSize, viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, spaceThresh[currentLevelId],
-					viewFrustum_min, viewFrustum_max, tukeyCutOff, framesToSkip, framesToWeight);
-				break;
-			case TRACKER_ITERATION_BOTH:
-				isValidPoint = computePerPointGH_exDepth<false, false, true>(localNabla, localHessian, localF, x, y, depth[x + y * viewImageSize.x], depthWeight,
-					viewImageSize, viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, spaceThresh[currentLevelId],
-					viewFrustum_min, viewFrustum_max, tukeyCutOff, framesToSkip, framesToWeight);
-				break;
-			default:
-				isValidPoint = false;
-				break;
+				switch (currentIterationType)
+				{
+				case TRACKER_ITERATION_ROTATION:
+					isValidPoint = computePerPointGH_exDepth<true, true, true>(localNabla, localHessian, localF, x, y, depth[x + y * viewImageSize.x], depthWeight,
+						viewImageSize, viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, spaceThresh[currentLevelId],
+						viewFrustum_min, viewFrustum_max, tukeyCutOff, framesToSkip, framesToWeight);
+					break;
+				case TRACKER_ITERATION_TRANSLATION:
+					isValidPoint = computePerPointGH_exDepth<true, false, true>(localNabla, localHessian, localF, x, y, depth[x + y * viewImageSize.x], depthWeight,
+						viewImageSize, viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, spaceThresh[currentLevelId],
+						viewFrustum_min, viewFrustum_max, tukeyCutOff, framesToSkip, framesToWeight);
+					break;
+				case TRACKER_ITERATION_BOTH:
+					isValidPoint = computePerPointGH_exDepth<false, false, true>(localNabla, localHessian, localF, x, y, depth[x + y * viewImageSize.x], depthWeight,
+						viewImageSize, viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, spaceThresh[currentLevelId],
+						viewFrustum_min, viewFrustum_max, tukeyCutOff, framesToSkip, framesToWeight);
+					break;
+				default:
+					isValidPoint = false;
+					break;
+				}
 			}
-		}
 
-		if (isValidPoint)
-		{
-			noValidPoints++;
-			sumF += localF;
-			for (int i = 0; i < noPara; i++) sumNabla[i] += localNabla[i];
-			for (int i = 0; i < noParaSQ; i++) sumHessian[i] += localHessian[i];
+			if (isValidPoint)
+			{
+				rangeSums.numPoints++;
+				rangeSums.f += localF;
+				for (int i = 0; i < noPara; i++) rangeSums.g[i] += localNabla[i];
+				for (int i = 0; i < noParaSQ; i++) rangeSums.h[i] += localHessian[i];
+			}
 		}
-	}
+
+		return rangeSums;
+	}, AddAccuCells);
 
 	// Copy the lower triangular part of the matrix.
 	for (int r = 0, counter = 0; r < noPara; r++)
 		for (int c = 0; c <= r; c++, counter++)
-			hessian[r + c * 6] = sumHessian[counter];
+			hessian[r + c * 6] = sums.h[counter];
 
 	// Transpose to fill the upper triangle.
 	for (int r = 0; r < noPara; ++r)
 		for (int c = r + 1; c < noPara; c++)
 			hessian[r + c * 6] = hessian[c + r * 6];
 
-	memcpy(nabla, sumNabla, noPara * sizeof(float));
+	memcpy(nabla, sums.g, noPara * sizeof(float));
 
-	f = sumF;
+	f = sums.f;
 
-	return noValidPoints;
+	return sums.numPoints;
 }
 
 int ITMExtendedTracker_CPU::ComputeGandH_RGB(float &f, float *nabla, float *hessian, Matrix4f approxInvPose)
@@ -169,126 +202,127 @@ int ITMExtendedTracker_CPU::ComputeGandH_RGB(float &f, float *nabla, float *hess
 	bool shortIteration = (currentIterationType == TRACKER_ITERATION_ROTATION)
 						   || (currentIterationType == TRACKER_ITERATION_TRANSLATION);
 
-	float sumHessian[6 * 6], sumNabla[6], sumF;
-	int noValidPoints;
 	int noPara = shortIteration ? 3 : 6, noParaSQ = shortIteration ? 3 + 2 + 1 : 6 + 5 + 4 + 3 + 2 + 1;
 
-	noValidPoints = 0; sumF = 0.0f;
-	memset(sumHessian, 0, sizeof(float) * noParaSQ);
-	memset(sumNabla, 0, sizeof(float) * noPara);
-
-	for (int y = 0; y < viewImageSize_depth.y; y++) for (int x = 0; x < viewImageSize_depth.x; x++)
+	AccuCell sums = ORUtils::ParallelReduce(0, viewImageSize_depth.y, ROWS_PER_RANGE, AccuCell(), [&](int rowBegin, int rowEnd)
 	{
-		float localHessian[6 + 5 + 4 + 3 + 2 + 1], localNabla[6], localF = 0;
+		AccuCell rangeSums;
 
-		for (int i = 0; i < noPara; i++) localNabla[i] = 0.0f;
-		for (int i = 0; i < noParaSQ; i++) localHessian[i] = 0.0f;
+		for (int y = rowBegin; y < rowEnd; y++) for (int x = 0; x < viewImageSize_depth.x; x++)
+		{
+			float localHessian[6 + 5 + 4 + 3 + 2 + 1], localNabla[6], localF = 0;
 
-		bool isValidPoint = false;
+			for (int i = 0; i < noPara; i++) localNabla[i] = 0.0f;
+			for (int i = 0; i < noParaSQ; i++) localHessian[i] = 0.0f;
 
-		switch (currentIterationType)
-		{
-		case TRACKER_ITERATION_ROTATION:
-			isValidPoint = computePerPointGH_exRGB_inv_Ab<true, true>(
-					localF,
-					localNabla,
-					localHessian,
-					x,
-					y,
-					points_curr,
-					intensities_current,
-					intensities_prev,
-					gradients,
-					viewImageSize_depth,
-					viewImageSize_rgb,
-					projParams_depth,
-					projParams_rgb,
-					approxInvPose,
-					depthToRGBTransform * scenePose,
-					colourThresh[currentLevelId],
-					minColourGradient,
-					viewFrustum_min,
-					viewFrustum_max,
-					tukeyCutOff
-					);
-			break;
-		case TRACKER_ITERATION_TRANSLATION:
-			isValidPoint = computePerPointGH_exRGB_inv_Ab<true, false>(
-					localF,
-					localNabla,
-					localHessian,
-					x,
-					y,
-					points_curr,
-					intensities_current,
-					intensities_prev,
-					gradients,
-					viewImageSize_depth,
-					viewImageSize_rgb,
-					projParams_depth,
-					projParams_rgb,
-					approxInvPose,
-					depthToRGBTransform * scenePose,
-					colourThresh[currentLevelId],
-					minColourGradient,
-					viewFrustum_min,
-					viewFrustum_max,
-					tukeyCutOff
-					);
-			break;
-		case TRACKER_ITERATION_BOTH:
-			isValidPoint = computePerPointGH_exRGB_inv_Ab<false, false>(
-					localF,
-					localNabla,
-					localHessian,
-					x,
-					y,
-					points_curr,
-					intensities_current,
-					intensities_prev,
-					gradients,
-					viewImageSize_depth,
-					viewImageSize_rgb,
-					projParams_depth,
-					projParams_rgb,
-					approxInvPose,
-					depthToRGBTransform * scenePose,
-					colourThresh[currentLevelId],
-					minColourGradient,
-					viewFrustum_min,
-					viewFrustum_max,
-					tukeyCutOff
-					);
-			break;
-		default:
-			isValidPoint = false;
-			break;
-		}
+			bool isValidPoint = false;
 
-		if (isValidPoint)
-		{
-			noValidPoints++;
-			sumF += localF;
-			for (int i = 0; i < noPara; i++) sumNabla[i] += localNabla[i];
-			for (int i = 0; i < noParaSQ; i++) sumHessian[i] += localHessian[i];
+			switch (currentIterationType)
+			{
+			case TRACKER_ITERATION_ROTATION:
+				isValidPoint = computePerPointGH_exRGB_inv_Ab<true, true>(
+						localF,
+						localNabla,
+						localHessian,
+						x,
+						y,
+						points_curr,
+						intensities_current,
+						intensities_prev,
+						gradients,
+						viewImageSize_depth,
+						viewImageSize_rgb,
+						projParams_depth,
+						projParams_rgb,
+						approxInvPose,
+						depthToRGBTransform * scenePose,
+						colourThresh[currentLevelId],
+						minColourGradient,
+						viewFrustum_min,
+						viewFrustum_max,
+						tukeyCutOff
+						);
+				break;
+			case TRACKER_ITERATION_TRANSLATION:
+				isValidPoint = computePerPointGH_exRGB_inv_Ab<true, false>(
+						localF,
+						localNabla,
+						localHessian,
+						x,
+						y,
+						points_curr,
+						intensities_current,
+						intensities_prev,
+						gradients,
+						viewImageSize_depth,
+						viewImageSize_rgb,
+						projParams_depth,
+						projParams_rgb,
+						approxInvPose,
+						depthToRGBTransform * scenePose,
+						colourThresh[currentLevelId],
+						minColourGradient,
+						viewFrustum_min,
+						viewFrustum_max,
+						tukeyCutOff
+						);
+				break;
+			case TRACKER_ITERATION_BOTH:
+				isValidPoint = computePerPointGH_exRGB_inv_Ab<false, false>(
+						localF,
+						localNabla,
+						localHessian,
+						x,
+						y,
+						points_curr,
+						intensities_current,
+						intensities_prev,
+						gradients,
+						viewImageSize_depth,
+						viewImageSize_rgb,
+						projParams_depth,
+						projParams_rgb,
+						approxInvPose,
+						depthToRGBTransform * scenePose,
+						colourThresh[currentLevelId],
+						minColourGradient,
+						viewFrustum_min,
+						viewFrustum_max,
+						tukeyCutOff
+						);
+				break;
+			default:
+				isValidPoint = false;
+				break;
+			}
+
+			if (isValidPoint)
+			{
+				rangeSums.numPoints++;
+				rangeSums.f += localF;
+				for (int i = 0; i < noPara; i++) rangeSums.g[i] += localNabla[i];
+				for (int i = 0; i < noParaSQ; i++) rangeSums.h[i] += localHessian[i];
+			}
 		}
-	}
+
+		return rangeSums;
+	}, AddAccuCells);
 
 	// Copy the lower triangular part of the matrix.
 	for (int r = 0, counter = 0; r < noPara; r++)
 		for (int c = 0; c <= r; c++, counter++)
-			hessian[r + c * 6] = sumHessian[counter];
+			hessian[r + c * 6] = sums.h[counter];
 
 	// Transpose to fill the upper triangle.
 	for (int r = 0; r < noPara; ++r)
 		for (int c = r + 1; c < noPara; c++)
 			hessian[r + c * 6] = hessian[c + r * 6];
 
-	memcpy(nabla, sumNabla, noPara * sizeof(float));
+	memcpy(nabla, sums.g, noPara * sizeof(float));
 
-	f = sumF;
+	f = sums.f;
 
-	return noValidPoints;
+	return sums.numPoints;
 }
 
 void ITMExtendedTracker_CPU::ProjectCurrentIntensityFrame(ITMFloat4Image *points_out,
@@ -310,6 +344,9 @@ void ITMExtendedTracker_CPU::ProjectCurrentIntensityFrame(ITMFloat4Image *points
 	Vector4f *pointsOut = points_out->GetData(MEMORYDEVICE_CPU);
 	float *intensityOut = intensity_out->GetData(MEMORYDEVICE_CPU);
 
-	for (int y = 0; y < imageSize_depth.y; y++) for (int x = 0; x < imageSize_depth.x; x++)
-		projectPoint_exRGB(x, y, pointsOut, intensityOut, intensityIn, depths, imageSize_rgb, imageSize_depth, intrinsics_rgb, intrinsics_depth, scenePose);
+	ORUtils::ParallelFor(0, imageSize_depth.y, [&](int y)
+	{
+		for (int x = 0; x < imageSize_depth.x; x++)
+			projectPoint_exRGB(x, y, pointsOut, intensityOut, intensityIn, depths, imageSize_rgb, imageSize_depth, intrinsics_rgb, intrinsics_depth, scenePose);
+	});
 }
@@ -32,6 +32,9 @@ namespace ITMLib
 {
 	/**
 	 * \brief An instance of this class can be used to construct trackers.
+	 *
+	 * Instances are cheap and hold no state besides the list of tracker types, so each main engine
+	 * creates its own rather than sharing a process wide one.
 	 */
 	class ITMTrackerFactory
 	{
@@ -72,7 +75,8 @@ namespace ITMLib
 		/** A list of maker functions for the various tracker types. */
 		std::vector<Maker> makers;
 
-		//################## SINGLETON IMPLEMENTATION ##################
+	public:
+		//#################### CONSTRUCTORS ####################
 		/**
 		 * \brief Constructs a tracker factory.
 		 */
@@ -87,16 +91,6 @@ namespace ITMLib
 			makers.push_back(Maker("forcefail", "Force fail tracker", TRACKER_FORCEFAIL, &MakeForceFailTracker));
 		}
 
-	public:
-		/**
-		 * \brief Gets the singleton instance for the current set of template parameters.
-		 */
-		static ITMTrackerFactory& Instance()
-		{
-			static ITMTrackerFactory s_instance;
-			return s_instance;
-		}
-
 		//################## PUBLIC MEMBER FUNCTIONS ##################
 	public:
 	/**
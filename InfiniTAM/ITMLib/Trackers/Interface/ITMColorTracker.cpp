@@ -2,6 +2,7 @@
 
 #include "ITMColorTracker.h"
 #include "../../../ORUtils/Cholesky.h"
+#include "../../../ORUtils/Trace.h"
 
 #include <math.h>
 
@@ -24,6 +25,8 @@ ITMColorTracker::~ITMColorTracker(void)
 
 void ITMColorTracker::TrackCamera(ITMTrackingState *trackingState, const ITMView *view)
 {
+	ORUtils::TraceSpan span("ITMColorTracker::TrackCamera");
+
 	this->view = view; this->trackingState = trackingState;
 
 	this->PrepareForEvaluation(view);
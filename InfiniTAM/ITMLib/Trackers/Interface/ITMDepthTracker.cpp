@@ -2,6 +2,7 @@
 
 #include "ITMDepthTracker.h"
 #include "../../../ORUtils/Cholesky.h"
+#include "../../../ORUtils/Trace.h"
 
 #include <math.h>
 
@@ -11,7 +12,8 @@ ITMDepthTracker::ITMDepthTracker(Vector2i imgSize, TrackerIterationType *trackin
 	float terminationThreshold, float failureDetectorThreshold, const ITMLowLevelEngine *lowLevelEngine, MemoryDeviceType memoryType)
 {
 	viewHierarchy = new ITMImageHierarchy<ITMTemplatedHierarchyLevel<ITMFloatImage> >(imgSize, trackingRegime, noHierarchyLevels, memoryType, true);
-	sceneHierarchy = new ITMImageHierarchy<ITMSceneHierarchyLevel>(imgSize, trackingRegime, noHierarchyLevels, memoryType, true);
+	// the raycast is only ever used at full resolution, hence a single level pointing to external data
+	sceneHierarchy = new ITMImageHierarchy<ITMSceneHierarchyLevel>(imgSize, trackingRegime, 1, memoryType, true);
 
 	this->noIterationsPerLevel = new int[noHierarchyLevels];
 	this->distThresh = new float[noHierarchyLevels];
@@ -98,12 +100,6 @@ void ITMDepthTracker::PrepareForEvaluation()
 		ITMTemplatedHierarchyLevel<ITMFloatImage> *previousLevelView = viewHierarchy->GetLevel(i - 1);
 		lowLevelEngine->FilterSubsampleWithHoles(currentLevelView->data, previousLevelView->data);
 		currentLevelView->intrinsics = previousLevelView->intrinsics * 0.5f;
-
-		ITMSceneHierarchyLevel *currentLevelScene = sceneHierarchy->GetLevel(i);
-		ITMSceneHierarchyLevel *previousLevelScene = sceneHierarchy->GetLevel(i - 1);
-		//lowLevelEngine->FilterSubsampleWithHoles(currentLevelScene->pointsMap, previousLevelScene->pointsMap);
-		//lowLevelEngine->FilterSubsampleWithHoles(currentLevelScene->normalsMap, previousLevelScene->normalsMap);
-		currentLevelScene->intrinsics = previousLevelScene->intrinsics * 0.5f;
 	}
 }
 
@@ -231,6 +227,8 @@ void ITMDepthTracker::UpdatePoseQuality(int noValidPoints_old, float *hessian_go
 
 void ITMDepthTracker::TrackCamera(ITMTrackingState *trackingState, const ITMView *view)
 {
+	ORUtils::TraceSpan span("ITMDepthTracker::TrackCamera");
+
 	this->SetEvaluationData(trackingState, view);
 	this->PrepareForEvaluation();
 
@@ -245,6 +243,9 @@ void ITMDepthTracker::TrackCamera(ITMTrackingState *trackingState, const ITMView
 	for (int i = 0; i < 6 * 6; ++i) hessian_good[i] = 0.0f;
 	for (int i = 0; i < 6; ++i) nabla_good[i] = 0.0f;
 
+	trackingState->noTrackerLevels = MIN(viewHierarchy->GetNoLevels(), (int)ITMTrackingState::MAX_TRACKER_LEVELS);
+	for (int i = 0; i < trackingState->noTrackerLevels; ++i) trackingState->trackerIterations[i] = 0;
+
 	for (int levelId = viewHierarchy->GetNoLevels() - 1; levelId >= 0; levelId--)
 	{
 		this->SetEvaluationParams(levelId);
@@ -258,6 +259,8 @@ void ITMDepthTracker::TrackCamera(ITMTrackingState *trackingState, const ITMView
 
 		for (int iterNo = 0; iterNo < noIterationsPerLevel[levelId]; iterNo++)
 		{
+			if (levelId < trackingState->noTrackerLevels) trackingState->trackerIterations[levelId]++;
+
 			// evaluate error function and gradients
 			noValidPoints_new = this->ComputeGandH(f_new, nabla_new, hessian_new, approxInvPose);
 
@@ -291,5 +294,7 @@ void ITMDepthTracker::TrackCamera(ITMTrackingState *trackingState, const ITMView
 		}
 	}
 
+	trackingState->noValidPoints = noValidPoints_old;
+
 	this->UpdatePoseQuality(noValidPoints_old, hessian_good, f_old);
 }
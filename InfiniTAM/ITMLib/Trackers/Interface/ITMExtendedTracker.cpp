@@ -6,6 +6,7 @@
 
 #include "ITMExtendedTracker.h"
 #include "../../../ORUtils/Cholesky.h"
+#include "../../../ORUtils/Trace.h"
 
 #include "../../../ORUtils/FileUtils.h"
 
@@ -67,9 +68,15 @@ ITMExtendedTracker::ITMExtendedTracker(Vector2i imgSize_d,
 	}
 
 	// We need the scene hierarchy (ICP and Normal raycasts) only if depth is used for tracking.
+	// Every level of the depth pyramid is matched against the full resolution raycast, so only
+	// level 0 is kept and it points to the external point cloud of the tracking state.
 	if (useDepth)
 	{
-		sceneHierarchy = new ITMImageHierarchy<ITMSceneHierarchyLevel>(imgSize_d, trackingRegime, noHierarchyLevels, memoryType, true);
+		sceneHierarchy = new ITMImageHierarchy<ITMSceneHierarchyLevel>(imgSize_d, trackingRegime, 1, memoryType, true);
+	}
+	else
+	{
+		sceneHierarchy = NULL;
 	}
 
 	this->noIterationsPerLevel = new int[noHierarchyLevels];
@@ -243,19 +250,8 @@ void ITMExtendedTracker::PrepareForEvaluation()
 		}
 	}
 
-	// Create raycasted pyramid
-	if (useDepth)
-	{
-		for (int i = 1; i < sceneHierarchy->GetNoLevels(); i++)
-		{
-			ITMSceneHierarchyLevel *currentLevel = sceneHierarchy->GetLevel(i);
-			ITMSceneHierarchyLevel *previousLevel = sceneHierarchy->GetLevel(i - 1);
-
-			lowLevelEngine->FilterSubsampleWithHoles(currentLevel->pointsMap, previousLevel->pointsMap);
-			lowLevelEngine->FilterSubsampleWithHoles(currentLevel->normalsMap, previousLevel->normalsMap);
-			currentLevel->intrinsics = previousLevel->intrinsics * 0.5f;
-		}
-	}
+	// No raycasted pyramid is built: the coarse depth levels are matched against the full
+	// resolution raycast (see SetEvaluationParams), so subsampling it would be wasted work.
 }
 
 void ITMExtendedTracker::SetEvaluationParams(int levelId)
@@ -409,6 +405,8 @@ void ITMExtendedTracker::UpdatePoseQuality(int noValidPoints_old, float *hessian
 
 void ITMExtendedTracker::TrackCamera(ITMTrackingState *trackingState, const ITMView *view)
 {
+	ORUtils::TraceSpan span("ITMExtendedTracker::TrackCamera");
+
 	if (trackingState->age_pointCloud >= 0) trackingState->framesProcessed++;
 	else trackingState->framesProcessed = 0;
 
@@ -428,6 +426,9 @@ void ITMExtendedTracker::TrackCamera(ITMTrackingState *trackingState, const ITMV
 	int noValidPoints_depth_good = 0;
 	memset(hessian_depth_good, 0, sizeof(hessian_depth_good));
 
+	trackingState->noTrackerLevels = MIN(viewHierarchy_Depth->GetNoLevels(), (int)ITMTrackingState::MAX_TRACKER_LEVELS);
+	for (int i = 0; i < trackingState->noTrackerLevels; ++i) trackingState->trackerIterations[i] = 0;
+
 	for (int levelId = viewHierarchy_Depth->GetNoLevels() - 1; levelId >= 0; levelId--)
 	{
 		SetEvaluationParams(levelId);
@@ -442,6 +443,8 @@ void ITMExtendedTracker::TrackCamera(ITMTrackingState *trackingState, const ITMV
 
 		for (int iterNo = 0; iterNo < noIterationsPerLevel[levelId]; iterNo++)
 		{
+			if (levelId < trackingState->noTrackerLevels) trackingState->trackerIterations[levelId]++;
+
 			float hessian_depth[6 * 6], hessian_RGB[6 * 6];
 			float nabla_depth[6], nabla_RGB[6];
 			float f_depth = 0.f, f_RGB = 0.f;
@@ -580,5 +583,7 @@ void ITMExtendedTracker::TrackCamera(ITMTrackingState *trackingState, const ITMV
 		}
 	}
 
+	trackingState->noValidPoints = noValidPoints_depth_good;
+
 	this->UpdatePoseQuality(noValidPoints_depth_good, hessian_depth_good, f_depth_good);
 }
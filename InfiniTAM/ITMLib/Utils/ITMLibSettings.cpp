@@ -29,18 +29,47 @@ ITMLibSettings::ITMLibSettings(void)
 
 	//deviceType = DEVICE_CPU;
 
-	/// how swapping works: disabled, fully enabled (still with dragons) and delete what's not visible - not supported in loop closure version
+	/// how swapping works: disabled, fully enabled (still with dragons), delete what's not visible and
+	/// keep a window around the camera with a bounded store behind it - not supported in loop closure version
 	swappingMode = SWAPPINGMODE_DISABLED;
 
+	/// the full local VBA of SDF_LOCAL_BLOCK_NUM blocks, lower it to host several scenes in one process
+	noLocalVoxelBlocks = 0;
+
+	/// the sliding window keeps memory flat: 4m around the camera stay in the local VBA, about 0.5M blocks in a compressed host store
+	slidingWindowRadius = 4.0f;
+	slidingWindowMaxBlocks = 0;
+	slidingWindowStoredBlocks = 0x80000;
+
+	/// deleted blocks leave dead entries in the excess lists of the hash table, they are reclaimed a few buckets at a time
+	excessListReclaimBuckets = 0x4000;
+	excessListReclaimThreshold = 0.9f;
+
+	/// voxel block defragmentation on frames without fusion, each swap moves two blocks
+	maxDefragmentationSwaps = 0;
+
 	/// enables or disables approximate raycast
 	useApproximateRaycast = false;
 
 	/// enable or disable bilateral depth filtering
 	useBilateralFilter = false;
 
+	/// image-space normals are cheapest, the SDF gradient costs six extra voxel lookups per pixel
+	icpNormalsMode = ICPNORMALS_IMAGE;
+
 	/// what to do on tracker failure: ignore, relocalise or stop integration - not supported in loop closure version
 	behaviourOnFailure = FAILUREMODE_IGNORE;
 
+	/// stage timings and counters for ITMMainEngine::GetStatistics(), off as they cost device synchronisations
+	collectStatistics = false;
+
+	/// overlap view building with fusion of the previous frame, opt-in as the scene then lags the pose by a frame
+	pipelineFrames = false;
+
+	/// all hardware threads for the CPU engines, without pinning them to cores
+	noCPUThreads = 0;
+	firstCPUCore = -1;
+
 	/// switch between various library modes - basic, with loop closure, etc.
 	libMode = LIBMODE_BASIC;
 	//libMode = LIBMODE_BASIC_SURFELS;
@@ -81,3 +110,13 @@ MemoryDeviceType ITMLibSettings::GetMemoryType() const
 {
 	return deviceType == ITMLibSettings::DEVICE_CUDA ? MEMORYDEVICE_CUDA : MEMORYDEVICE_CPU;
 }
+
+bool ITMLibSettings::UseGlobalCache() const
+{
+	return swappingMode == SWAPPINGMODE_ENABLED || swappingMode == SWAPPINGMODE_SLIDING_WINDOW;
+}
+
+int ITMLibSettings::GetGlobalCacheCapacity() const
+{
+	return swappingMode == SWAPPINGMODE_SLIDING_WINDOW ? slidingWindowStoredBlocks : 0;
+}
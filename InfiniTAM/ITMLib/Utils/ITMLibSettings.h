@@ -29,9 +29,17 @@ namespace ITMLib
 		{
 			SWAPPINGMODE_DISABLED,
 			SWAPPINGMODE_ENABLED,
-			SWAPPINGMODE_DELETE
+			SWAPPINGMODE_DELETE,
+			SWAPPINGMODE_SLIDING_WINDOW
 		} SwappingMode;
 
+		typedef enum
+		{
+			ICPNORMALS_IMAGE,
+			ICPNORMALS_IMAGE_SDF_FALLBACK,
+			ICPNORMALS_SDF
+		} ICPNormalsMode;
+
 		typedef enum
 		{
 			LIBMODE_BASIC,
@@ -46,6 +54,10 @@ namespace ITMLib
 
 		bool useBilateralFilter;
 
+		/// How the normals of the ICP maps are computed: from neighbouring pixels of the raycast,
+		/// from neighbouring pixels with the SDF gradient at discontinuities, or from the SDF gradient only.
+		ICPNormalsMode icpNormalsMode;
+
 		/// For ITMColorTracker: skip every other point in energy function evaluation.
 		bool skipPoints;
 
@@ -53,6 +65,44 @@ namespace ITMLib
         
 		FailureMode behaviourOnFailure;
 		SwappingMode swappingMode;
+
+		/// Number of voxel blocks in the local VBA of a scene, at most SDF_LOCAL_BLOCK_NUM, which 0 stands for.
+		/// The VBA is allocated up front and is most of the memory of a main engine, so this is its memory budget.
+		int noLocalVoxelBlocks;
+
+		/// With SWAPPINGMODE_DELETE or SWAPPINGMODE_SLIDING_WINDOW, the number of hash buckets per frame whose excess lists are cleared of deleted entries.
+		int excessListReclaimBuckets;
+
+		/// Fraction of the excess list in use above which all buckets are cleared at once.
+		float excessListReclaimThreshold;
+
+		/// With SWAPPINGMODE_SLIDING_WINDOW, blocks farther than this from the camera (in metres) are swapped out.
+		float slidingWindowRadius;
+
+		/// With SWAPPINGMODE_SLIDING_WINDOW, the most blocks kept in the local VBA, 0 for no limit besides the radius.
+		int slidingWindowMaxBlocks;
+
+		/// With SWAPPINGMODE_SLIDING_WINDOW, the capacity of the compressed host store in blocks, the oldest blocks are dropped beyond it.
+		int slidingWindowStoredBlocks;
+
+		/// How many pairs of voxel blocks may be exchanged to restore Morton order on a frame without fusion, 0 disables it.
+		int maxDefragmentationSwaps;
+
+		/// Whether the main engine times its processing stages and records internal counters, see ITMMainEngine::GetStatistics().
+		/// On CUDA this synchronises the device at every stage boundary.
+		bool collectStatistics;
+
+		/// Whether ITMBasicEngine on the CPU builds the view of a frame while it fuses the previous frame, as tasks of its scheduler.
+		/// The scene and its raycast then lag the returned pose by one frame, the poses are the same as without.
+		bool pipelineFrames;
+
+		/// Number of threads the CPU engines of a main engine run on, including the calling thread, 0 uses one per hardware thread.
+		/// Unless it is given a scheduler shared with other engines, each main engine owns its own ORUtils::TaskScheduler.
+		int noCPUThreads;
+
+		/// Core the first worker thread of the CPU engines is pinned to, the others to the following cores, -1 does not pin them (Linux only)
+		int firstCPUCore;
+
 		LibMode libMode;
 
 		const char *trackerConfig;
@@ -69,5 +119,9 @@ namespace ITMLib
 		ITMLibSettings& operator=(const ITMLibSettings&);
 
 		MemoryDeviceType GetMemoryType() const;
+
+		/// Whether the scene needs a global cache, and its capacity in blocks (0 for an unbounded cache).
+		bool UseGlobalCache() const;
+		int GetGlobalCacheCapacity() const;
 	};
 }
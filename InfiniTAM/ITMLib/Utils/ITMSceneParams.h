@@ -42,7 +42,25 @@ namespace ITMLib
 		/** Stop integration once maxW has been reached. */
 		bool stopIntegratingAtMaxW;
 
-		ITMSceneParams(void) {}
+		/** Hand out the voxel blocks allocated in one frame in Morton
+		    order of their positions, so that neighbouring blocks end up
+		    next to each other in memory.
+		*/
+		bool allocateBlocksInMortonOrder;
+
+		/** @{ */
+		/** \brief
+		    Per frame budgets that bound the latency of the
+		    mapping, 0 for no limit. Allocation requests nearest
+		    to the camera and visible blocks nearest to the
+		    observed surface are served first. Requests that are
+		    not served come up again in later frames, deferred
+		    blocks move up in the order for every frame they wait.
+		*/
+		int maxAllocatedBlocksPerFrame, maxIntegratedBlocksPerFrame;
+		/** @} */
+
+		ITMSceneParams(void) : allocateBlocksInMortonOrder(false), maxAllocatedBlocksPerFrame(0), maxIntegratedBlocksPerFrame(0) {}
 
 		ITMSceneParams(float mu, int maxW, float voxelSize, 
 			float viewFrustum_min, float viewFrustum_max, bool stopIntegratingAtMaxW)
@@ -52,6 +70,9 @@ namespace ITMLib
 			this->voxelSize = voxelSize;
 			this->viewFrustum_min = viewFrustum_min; this->viewFrustum_max = viewFrustum_max;
 			this->stopIntegratingAtMaxW = stopIntegratingAtMaxW;
+			this->allocateBlocksInMortonOrder = false;
+			this->maxAllocatedBlocksPerFrame = 0;
+			this->maxIntegratedBlocksPerFrame = 0;
 		}
 
 		explicit ITMSceneParams(const ITMSceneParams *sceneParams) { this->SetFrom(sceneParams); }
@@ -64,6 +85,9 @@ namespace ITMLib
 			this->mu = sceneParams->mu;
 			this->maxW = sceneParams->maxW;
 			this->stopIntegratingAtMaxW = sceneParams->stopIntegratingAtMaxW;
+			this->allocateBlocksInMortonOrder = sceneParams->allocateBlocksInMortonOrder;
+			this->maxAllocatedBlocksPerFrame = sceneParams->maxAllocatedBlocksPerFrame;
+			this->maxIntegratedBlocksPerFrame = sceneParams->maxIntegratedBlocksPerFrame;
 		}
 	};
 }
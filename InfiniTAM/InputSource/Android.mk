@@ -3,7 +3,7 @@ LOCAL_PATH := $(call my-dir)
 include $(CLEAR_VARS)
 
 LOCAL_MODULE    := InputSource
-LOCAL_SRC_FILES := ImageSourceEngine.cpp IMUSourceEngine.cpp OpenNIEngine.cpp FFMPEGReader.cpp FFMPEGWriter.cpp
+LOCAL_SRC_FILES := ImageSourceEngine.cpp IMUSourceEngine.cpp OpenNIEngine.cpp FFMPEGReader.cpp FFMPEGWriter.cpp PrefetchingImageSourceEngine.cpp PackedSequence.cpp RVLDepthCodec.cpp AsyncFrameRecorder.cpp SharedMemoryRing.cpp LatestFrameImageSourceEngine.cpp
 LOCAL_CFLAGS := -Werror
 ifneq ($(FFMPEG_ROOT),)
 LOCAL_CFLAGS += -DCOMPILE_WITH_FFMPEG
@@ -0,0 +1,239 @@
+// Copyright 2014-2017 Oxford University Innovation Limited and the authors of InfiniTAM
+
+#include "AsyncFrameRecorder.h"
+
+#include "../ORUtils/Trace.h"
+
+#include <algorithm>
+#include <vector>
+
+#ifndef NO_CPP11
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+using namespace InputSource;
+
+//#################### PackedSequenceSink ####################
+
+PackedSequenceSink::PackedSequenceSink(const char *fileName, const ITMLib::ITMRGBDCalib &calib, bool compressDepth)
+	: fileName(fileName), calib(calib), compressDepth(compressDepth), hasFailed(false)
+{}
+
+bool PackedSequenceSink::writeFrame(ITMUChar4Image *rgb, ITMShortImage *rawDepth)
+{
+	if (hasFailed) return false;
+
+	if (!writer.isOpen() && !writer.open(fileName.c_str(), calib, rgb->noDims, rawDepth->noDims, compressDepth))
+	{
+		printf("error: could not create %s\n", fileName.c_str());
+		hasFailed = true;
+		return false;
+	}
+
+	return writer.writeFrame(rgb, rawDepth);
+}
+
+//#################### VideoSink ####################
+
+VideoSink::VideoSink(const char *rgbFileName, const char *depthFileName, int fps)
+	: rgbFileName(rgbFileName != NULL ? rgbFileName : ""), depthFileName(depthFileName != NULL ? depthFileName : ""), fps(fps)
+{}
+
+bool VideoSink::writeFrame(ITMUChar4Image *rgb, ITMShortImage *rawDepth)
+{
+	bool success = true;
+
+	if (!rgbFileName.empty() && rgb->noDims.x != 0)
+	{
+		if (!rgbWriter.isOpen()) rgbWriter.open(rgbFileName.c_str(), rgb->noDims.x, rgb->noDims.y, false, fps);
+		success = rgbWriter.writeFrame(rgb) && success;
+	}
+
+	if (!depthFileName.empty() && rawDepth->noDims.x != 0)
+	{
+		if (!depthWriter.isOpen()) depthWriter.open(depthFileName.c_str(), rawDepth->noDims.x, rawDepth->noDims.y, true, fps);
+		success = depthWriter.writeFrame(rawDepth) && success;
+	}
+
+	return success;
+}
+
+//#################### AsyncFrameRecorder ####################
+
+struct AsyncFrameRecorder::PrivateData
+{
+	int noRecordedFrames, noDroppedFrames;
+
+#ifndef NO_CPP11
+	struct Slot
+	{
+		ITMUChar4Image *rgb;
+		ITMShortImage *rawDepth;
+	};
+
+	std::vector<Slot> slots;
+	std::thread writerThread;
+	bool blockWhenFull;
+
+	// frames are numbered in the order they are queued, frame i uses slot i % slots.size()
+	std::mutex mutex;
+	std::condition_variable stateChanged;
+	size_t nextQueuedFrameNo, nextWrittenFrameNo;
+	bool stopThread;
+
+	PrivateData(void) : noRecordedFrames(0), noDroppedFrames(0), blockWhenFull(false), nextQueuedFrameNo(0), nextWrittenFrameNo(0), stopThread(false) {}
+#else
+	ITMUChar4Image *rgb;
+	ITMShortImage *rawDepth;
+
+	PrivateData(void) : noRecordedFrames(0), noDroppedFrames(0) {}
+#endif
+};
+
+AsyncFrameRecorder::AsyncFrameRecorder(FrameSink *sink, int noBufferedFrames, bool blockWhenFull)
+	: data(new PrivateData), sink(sink)
+{
+#ifndef NO_CPP11
+	data->blockWhenFull = blockWhenFull;
+	data->slots.resize(std::max(noBufferedFrames, 1));
+	for (size_t slotId = 0; slotId < data->slots.size(); slotId++)
+	{
+		data->slots[slotId].rgb = new ITMUChar4Image(true, false);
+		data->slots[slotId].rawDepth = new ITMShortImage(true, false);
+	}
+
+	data->writerThread = std::thread(&AsyncFrameRecorder::writerThreadMain, this);
+#else
+	data->rgb = new ITMUChar4Image(true, false);
+	data->rawDepth = new ITMShortImage(true, false);
+#endif
+}
+
+AsyncFrameRecorder::~AsyncFrameRecorder(void)
+{
+#ifndef NO_CPP11
+	{
+		std::lock_guard<std::mutex> lock(data->mutex);
+		data->stopThread = true;
+	}
+	data->stateChanged.notify_all();
+	data->writerThread.join();
+
+	for (size_t slotId = 0; slotId < data->slots.size(); slotId++)
+	{
+		delete data->slots[slotId].rgb;
+		delete data->slots[slotId].rawDepth;
+	}
+#else
+	delete data->rgb;
+	delete data->rawDepth;
+#endif
+
+	delete sink;
+	delete data;
+}
+
+void AsyncFrameRecorder::writerThreadMain(void)
+{
+#ifndef NO_CPP11
+	ORUtils::TraceRecorder::SetThreadName("frame recording");
+
+	std::unique_lock<std::mutex> lock(data->mutex);
+
+	while (true)
+	{
+		// the queued frames are still written once the recorder is being destroyed
+		while (!data->stopThread && data->nextWrittenFrameNo == data->nextQueuedFrameNo) data->stateChanged.wait(lock);
+		if (data->nextWrittenFrameNo == data->nextQueuedFrameNo) break;
+
+		PrivateData::Slot &slot = data->slots[data->nextWrittenFrameNo % data->slots.size()];
+
+		lock.unlock();
+
+		bool success;
+		{
+			ORUtils::TraceSpan span("write frame", "InputSource");
+			success = sink->writeFrame(slot.rgb, slot.rawDepth);
+		}
+
+		lock.lock();
+
+		if (success) data->noRecordedFrames++;
+		else data->noDroppedFrames++;
+
+		data->nextWrittenFrameNo++;
+		data->stateChanged.notify_all();
+	}
+#endif
+}
+
+bool AsyncFrameRecorder::recordFrame(const ITMUChar4Image *rgb, const ITMShortImage *rawDepth)
+{
+#ifndef NO_CPP11
+	size_t noSlots = data->slots.size();
+	PrivateData::Slot *slot;
+
+	{
+		std::unique_lock<std::mutex> lock(data->mutex);
+
+		if (data->blockWhenFull)
+		{
+			while (data->nextQueuedFrameNo == data->nextWrittenFrameNo + noSlots) data->stateChanged.wait(lock);
+		}
+		else if (data->nextQueuedFrameNo == data->nextWrittenFrameNo + noSlots)
+		{
+			data->noDroppedFrames++;
+			return false;
+		}
+
+		slot = &data->slots[data->nextQueuedFrameNo % noSlots];
+	}
+
+	// the writer thread does not touch the slot until it has been queued below
+	slot->rgb->SetFrom(rgb, ORUtils::MemoryBlock<Vector4u>::CPU_TO_CPU);
+	slot->rawDepth->SetFrom(rawDepth, ORUtils::MemoryBlock<short>::CPU_TO_CPU);
+
+	{
+		std::lock_guard<std::mutex> lock(data->mutex);
+		data->nextQueuedFrameNo++;
+	}
+	data->stateChanged.notify_all();
+
+	return true;
+#else
+	data->rgb->SetFrom(rgb, ORUtils::MemoryBlock<Vector4u>::CPU_TO_CPU);
+	data->rawDepth->SetFrom(rawDepth, ORUtils::MemoryBlock<short>::CPU_TO_CPU);
+
+	bool success = sink->writeFrame(data->rgb, data->rawDepth);
+	if (success) data->noRecordedFrames++;
+	else data->noDroppedFrames++;
+
+	return success;
+#endif
+}
+
+void AsyncFrameRecorder::waitUntilWritten(void)
+{
+#ifndef NO_CPP11
+	std::unique_lock<std::mutex> lock(data->mutex);
+	while (data->nextWrittenFrameNo != data->nextQueuedFrameNo) data->stateChanged.wait(lock);
+#endif
+}
+
+int AsyncFrameRecorder::getNoRecordedFrames(void) const
+{
+#ifndef NO_CPP11
+	std::lock_guard<std::mutex> lock(data->mutex);
+#endif
+	return data->noRecordedFrames;
+}
+
+int AsyncFrameRecorder::getNoDroppedFrames(void) const
+{
+#ifndef NO_CPP11
+	std::lock_guard<std::mutex> lock(data->mutex);
+#endif
+	return data->noDroppedFrames;
+}
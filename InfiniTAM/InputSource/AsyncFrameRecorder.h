@@ -0,0 +1,104 @@
+// Copyright 2014-2017 Oxford University Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include <string>
+
+#include "FFMPEGWriter.h"
+#include "PackedSequence.h"
+
+namespace InputSource {
+
+	/**
+	 * \brief Somewhere recorded frames are written to, used by AsyncFrameRecorder on its writer thread.
+	 */
+	class FrameSink
+	{
+	public:
+		virtual ~FrameSink(void) {}
+
+		/// Writes a frame, an RGB image of 0x0 means there is no RGB
+		virtual bool writeFrame(ITMUChar4Image *rgb, ITMShortImage *rawDepth) = 0;
+	};
+
+	/**
+	 * \brief Writes frames into a packed sequence, which is created with the image sizes of the first frame.
+	 */
+	class PackedSequenceSink : public FrameSink
+	{
+	private:
+		PackedSequenceWriter writer;
+		std::string fileName;
+		ITMLib::ITMRGBDCalib calib;
+		bool compressDepth, hasFailed;
+
+	public:
+		PackedSequenceSink(const char *fileName, const ITMLib::ITMRGBDCalib &calib, bool compressDepth = true);
+
+		bool writeFrame(ITMUChar4Image *rgb, ITMShortImage *rawDepth);
+	};
+
+	/**
+	 * \brief Writes frames into an RGB and a depth video with FFMPEGWriter, either file name may be NULL.
+	 */
+	class VideoSink : public FrameSink
+	{
+	private:
+		FFMPEGWriter rgbWriter, depthWriter;
+		std::string rgbFileName, depthFileName;
+		int fps;
+
+	public:
+		VideoSink(const char *rgbFileName, const char *depthFileName, int fps = 30);
+
+		bool writeFrame(ITMUChar4Image *rgb, ITMShortImage *rawDepth);
+	};
+
+	/**
+	 * \brief Records frames on a background thread, so that encoding and writing them does not hold up processing.
+	 *
+	 * recordFrame() copies a frame into a pool of buffers, which the writer thread hands to the FrameSink. When all
+	 * buffers are queued, recordFrame() either drops the frame or waits for the writer. Without C++11 (NO_CPP11) the
+	 * frames are written by recordFrame() itself.
+	 */
+	class AsyncFrameRecorder
+	{
+	private:
+		struct PrivateData;
+		PrivateData *data;
+
+		FrameSink *sink;
+
+		void writerThreadMain(void);
+
+	public:
+		/**
+		 * \brief Constructs a recorder and starts its writer thread.
+		 *
+		 * \param sink              Where the frames are written, which is deleted with the recorder.
+		 * \param noBufferedFrames  The number of frames that may wait to be written.
+		 * \param blockWhenFull     Whether recordFrame() waits for a free buffer rather than dropping the frame.
+		 */
+		AsyncFrameRecorder(FrameSink *sink, int noBufferedFrames = 8, bool blockWhenFull = false);
+
+		/// Writes the frames that are still queued, then deletes the sink
+		~AsyncFrameRecorder(void);
+
+		/// Queues a copy of a frame, returns false if it was dropped
+		bool recordFrame(const ITMUChar4Image *rgb, const ITMShortImage *rawDepth);
+
+		/// Waits until the sink has written all queued frames
+		void waitUntilWritten(void);
+
+		/// The number of frames the sink has written
+		int getNoRecordedFrames(void) const;
+
+		/// The number of frames that were dropped, because no buffer was free or the sink failed to write them
+		int getNoDroppedFrames(void) const;
+
+		// Suppress the default copy constructor and assignment operator
+		AsyncFrameRecorder(const AsyncFrameRecorder&);
+		AsyncFrameRecorder& operator=(const AsyncFrameRecorder&);
+	};
+
+}
@@ -96,23 +96,31 @@ void ImageFileReader<PathGenerator>::loadIntoCache(void) const
 	if (currentFrameNo == cachedFrameNo) return;
 	cachedFrameNo = currentFrameNo;
 
-	cacheIsValid = true;
+	cacheIsValid = readImages(currentFrameNo, cached_rgb, cached_depth);
+}
+
+template <typename PathGenerator>
+bool ImageFileReader<PathGenerator>::readImages(size_t frameNo, ITMUChar4Image *rgb, ITMShortImage *rawDepth) const
+{
+	bool isValid = true;
 
-	std::string rgbPath = pathGenerator.getRgbImagePath(currentFrameNo);
-	if (!ReadImageFromFile(cached_rgb, rgbPath.c_str()))
+	std::string rgbPath = pathGenerator.getRgbImagePath(frameNo);
+	if (!ReadImageFromFile(rgb, rgbPath.c_str()))
 	{
-		if (cached_rgb->noDims.x > 0) cacheIsValid = false;
+		if (rgb->noDims.x > 0) isValid = false;
 		printf("error reading file '%s'\n", rgbPath.c_str());
 	}
 
-	std::string depthPath = pathGenerator.getDepthImagePath(currentFrameNo);
-	if (!ReadImageFromFile(cached_depth, depthPath.c_str()))
+	std::string depthPath = pathGenerator.getDepthImagePath(frameNo);
+	if (!ReadImageFromFile(rawDepth, depthPath.c_str()))
 	{
-		if (cached_depth->noDims.x > 0) cacheIsValid = false;
+		if (rawDepth->noDims.x > 0) isValid = false;
 		printf("error reading file '%s'\n", depthPath.c_str());
 	}
 
-	if ((cached_rgb->noDims.x <= 0) && (cached_depth->noDims.x <= 0)) cacheIsValid = false;
+	if ((rgb->noDims.x <= 0) && (rawDepth->noDims.x <= 0)) isValid = false;
+
+	return isValid;
 }
 
 template <typename PathGenerator>
@@ -126,8 +134,8 @@ template <typename PathGenerator>
 void ImageFileReader<PathGenerator>::getImages(ITMUChar4Image *rgb, ITMShortImage *rawDepth)
 {
 	loadIntoCache();
-	rgb->SetFrom(cached_rgb, ORUtils::MemoryBlock<Vector4u>::CPU_TO_CPU);
-	rawDepth->SetFrom(cached_depth, ORUtils::MemoryBlock<short>::CPU_TO_CPU);
+	handOverImage(rgb, cached_rgb);
+	handOverImage(rawDepth, cached_depth);
 
 	++currentFrameNo;
 }
@@ -176,8 +184,16 @@ RawFileReader::RawFileReader(const char *calibFilename, const char *rgbImageMask
 	currentFrameNo = 0;
 	cachedFrameNo = -1;
 
-	cached_rgb = NULL;
-	cached_depth = NULL;
+	// the cached images are reused for every frame
+	cached_rgb = new ITMUChar4Image(imgSize, MEMORYDEVICE_CPU);
+	cached_depth = new ITMShortImage(imgSize, MEMORYDEVICE_CPU);
+	cachedRGBIsValid = cachedDepthIsValid = false;
+}
+
+RawFileReader::~RawFileReader()
+{
+	delete cached_rgb;
+	delete cached_depth;
 }
 
 void RawFileReader::ResizeIntrinsics(ITMIntrinsics &intrinsics, float ratio)
@@ -194,13 +210,6 @@ void RawFileReader::loadIntoCache(void) const
 	if (currentFrameNo == cachedFrameNo) return;
 	cachedFrameNo = currentFrameNo;
 
-	//TODO> make nicer
-    if (cached_rgb == NULL && cached_depth == NULL)
-    {
-        cached_rgb = new ITMUChar4Image(imgSize, MEMORYDEVICE_CPU);
-        cached_depth = new ITMShortImage(imgSize, MEMORYDEVICE_CPU);
-    }
-    
 	char str[2048]; FILE *f; bool success = false;
 
 	sprintf(str, rgbImageMask, currentFrameNo);
@@ -212,11 +221,8 @@ void RawFileReader::loadIntoCache(void) const
 		fclose(f);
 		if (tmp == (size_t)imgSize.x * imgSize.y) success = true;
 	}
-	if (!success)
-	{
-		delete cached_rgb; cached_rgb = NULL;
-		printf("error reading file '%s'\n", str);
-	}
+	cachedRGBIsValid = success;
+	if (!success) printf("error reading file '%s'\n", str);
 
 	sprintf(str, depthImageMask, currentFrameNo); success = false;
 	f = fopen(str, "rb");
@@ -226,11 +232,8 @@ void RawFileReader::loadIntoCache(void) const
 		fclose(f);
 		if (tmp == (size_t)imgSize.x * imgSize.y) success = true;
 	}
-	if (!success)
-	{
-		delete cached_depth; cached_depth = NULL;
-		printf("error reading file '%s'\n", str);
-	}
+	cachedDepthIsValid = success;
+	if (!success) printf("error reading file '%s'\n", str);
 }
 
 
@@ -238,26 +241,24 @@ bool RawFileReader::hasMoreImages(void) const
 {
 	loadIntoCache();
 
-	return ((cached_rgb != NULL) || (cached_depth != NULL));
+	return cachedRGBIsValid || cachedDepthIsValid;
 }
 
 void RawFileReader::getImages(ITMUChar4Image *rgb, ITMShortImage *rawDepth)
 {
 	bool bUsedCache = false;
 
-	if (cached_rgb != NULL)
+	if (cachedRGBIsValid)
 	{
-		rgb->SetFrom(cached_rgb, ORUtils::MemoryBlock<Vector4u>::CPU_TO_CPU);
-		delete cached_rgb;
-		cached_rgb = NULL;
+		handOverImage(rgb, cached_rgb);
+		cachedRGBIsValid = false;
 		bUsedCache = true;
 	}
 
-	if (cached_depth != NULL)
+	if (cachedDepthIsValid)
 	{
-		rawDepth->SetFrom(cached_depth, ORUtils::MemoryBlock<short>::CPU_TO_CPU);
-		delete cached_depth;
-		cached_depth = NULL;
+		handOverImage(rawDepth, cached_depth);
+		cachedDepthIsValid = false;
 		bUsedCache = true;
 	}
 
@@ -65,6 +65,49 @@ namespace InputSource {
 		 * \return  true, if the image source engine is able to yield more RGB-D images, or false otherwise.
 		 */
 		virtual bool hasMoreImages(void) const = 0;
+
+	protected:
+		/**
+		 * \brief Hands an image the source has read over to the caller of getImages().
+		 *
+		 * The buffers of the two images are swapped if they are allocated on the same devices, so that
+		 * \p source then holds the caller's old buffer for the source to reuse, resized to the size it had.
+		 * Otherwise the image is copied.
+		 */
+		template <typename T>
+		static void handOverImage(ORUtils::Image<T> *dest, ORUtils::Image<T> *source)
+		{
+			if (dest->HasSameAllocation(*source))
+			{
+				dest->Swap(*source);
+				source->ChangeDims(dest->noDims, false);
+			}
+			else dest->SetFrom(source, ORUtils::MemoryBlock<T>::CPU_TO_CPU);
+		}
+	};
+
+	/**
+	 * \brief An image source whose frames can be read by number, by several threads at once.
+	 */
+	class IndexedImageSource
+	{
+	public:
+		virtual ~IndexedImageSource() {}
+
+		/**
+		 * \brief Gets the number of the frame that getImages() yields next.
+		 */
+		virtual size_t getCurrentFrameNo(void) const = 0;
+
+		/**
+		 * \brief Reads the RGB and depth images of a frame without changing the state of the source, this must be thread safe.
+		 *
+		 * \param frameNo   The number of the frame to read.
+		 * \param rgb       An image into which to store the RGB image.
+		 * \param rawDepth  An image into which to store the depth image.
+		 * \return          true, if the frame exists, or false otherwise.
+		 */
+		virtual bool readImages(size_t frameNo, ITMUChar4Image *rgb, ITMShortImage *rawDepth) const = 0;
 	};
 
 	class BaseImageSourceEngine : public ImageSourceEngine
@@ -108,7 +151,7 @@ namespace InputSource {
 	};
 
 	template <typename PathGenerator>
-	class ImageFileReader : public BaseImageSourceEngine
+	class ImageFileReader : public BaseImageSourceEngine, public IndexedImageSource
 	{
 	private:
 		ITMUChar4Image *cached_rgb;
@@ -129,6 +172,14 @@ namespace InputSource {
 		void getImages(ITMUChar4Image *rgb, ITMShortImage *rawDepth);
 		Vector2i getDepthImageSize(void) const;
 		Vector2i getRGBImageSize(void) const;
+
+		size_t getCurrentFrameNo(void) const { return currentFrameNo; }
+
+		/** An image that cannot be read only invalidates the frame if
+		    \p rgb or \p rawDepth already holds an image, so that
+		    sequences without RGB or without depth can be read.
+		*/
+		bool readImages(size_t frameNo, ITMUChar4Image *rgb, ITMShortImage *rawDepth) const;
 	};
 
 	class CalibSource : public BaseImageSourceEngine
@@ -154,8 +205,9 @@ namespace InputSource {
 		char rgbImageMask[BUF_SIZE];
 		char depthImageMask[BUF_SIZE];
 
-		mutable ITMUChar4Image *cached_rgb;
-		mutable ITMShortImage *cached_depth;
+		ITMUChar4Image *cached_rgb;
+		ITMShortImage *cached_depth;
+		mutable bool cachedRGBIsValid, cachedDepthIsValid;
 
 		void loadIntoCache() const;
 		mutable int cachedFrameNo;
@@ -166,7 +218,7 @@ namespace InputSource {
 
 	public:
 		RawFileReader(const char *calibFilename, const char *rgbImageMask, const char *depthImageMask, Vector2i setImageSize, float ratio);
-		~RawFileReader() { }
+		~RawFileReader();
 
 		bool hasMoreImages(void) const;
 		void getImages(ITMUChar4Image *rgb, ITMShortImage *rawDepth);
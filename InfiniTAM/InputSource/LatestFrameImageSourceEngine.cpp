@@ -0,0 +1,176 @@
+// Copyright 2014-2017 Oxford University Innovation Limited and the authors of InfiniTAM
+
+#include "LatestFrameImageSourceEngine.h"
+
+#include "../ORUtils/Trace.h"
+
+#include <algorithm>
+
+#ifndef NO_CPP11
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+using namespace InputSource;
+
+struct LatestFrameImageSourceEngine::PrivateData
+{
+	int noCapturedFrames, noSkippedFrames;
+
+#ifndef NO_CPP11
+	// the capture thread reads into the capture buffers, which it then swaps with the latest frame
+	ITMUChar4Image *captureRGB, *latestRGB;
+	ITMShortImage *captureDepth, *latestDepth;
+
+	std::thread captureThread;
+	std::mutex mutex;
+	std::condition_variable stateChanged;
+	bool hasLatestFrame, isEnded, stopThread;
+
+	PrivateData(void) : noCapturedFrames(0), noSkippedFrames(0), hasLatestFrame(false), isEnded(false), stopThread(false) {}
+
+	bool isStopping(void)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return stopThread;
+	}
+#else
+	PrivateData(void) : noCapturedFrames(0), noSkippedFrames(0) {}
+#endif
+};
+
+LatestFrameImageSourceEngine::LatestFrameImageSourceEngine(ImageSourceEngine *source, bool useGPU)
+	: data(new PrivateData), source(source)
+{
+	// the source is only read by the capture thread once it has started
+	calib = source->getCalib();
+	rgbImageSize = source->getRGBImageSize();
+	depthImageSize = source->getDepthImageSize();
+
+#ifndef NO_CPP11
+	data->captureRGB = new ITMUChar4Image(rgbImageSize, true, useGPU);
+	data->latestRGB = new ITMUChar4Image(rgbImageSize, true, useGPU);
+	data->captureDepth = new ITMShortImage(depthImageSize, true, useGPU);
+	data->latestDepth = new ITMShortImage(depthImageSize, true, useGPU);
+
+	data->captureThread = std::thread(&LatestFrameImageSourceEngine::captureThreadMain, this);
+#endif
+}
+
+LatestFrameImageSourceEngine::~LatestFrameImageSourceEngine()
+{
+#ifndef NO_CPP11
+	{
+		std::lock_guard<std::mutex> lock(data->mutex);
+		data->stopThread = true;
+	}
+	data->stateChanged.notify_all();
+	data->captureThread.join();
+
+	delete data->captureRGB;
+	delete data->latestRGB;
+	delete data->captureDepth;
+	delete data->latestDepth;
+#endif
+
+	delete data;
+	delete source;
+}
+
+void LatestFrameImageSourceEngine::captureThreadMain(void)
+{
+#ifndef NO_CPP11
+	ORUtils::TraceRecorder::SetThreadName("frame capture");
+
+	// the stop flag is checked before every call into the source, so that stopping only waits for the call in progress
+	while (!data->isStopping())
+	{
+		// a live source blocks here until the sensor delivers the next frame
+		bool isValid;
+		{
+			ORUtils::TraceSpan span("capture frame", "InputSource");
+
+			isValid = source->hasMoreImages();
+			if (isValid && data->isStopping()) break;
+			if (isValid) source->getImages(data->captureRGB, data->captureDepth);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(data->mutex);
+
+			if (!isValid) data->isEnded = true;
+			else
+			{
+				if (data->hasLatestFrame) data->noSkippedFrames++;
+
+				std::swap(data->captureRGB, data->latestRGB);
+				std::swap(data->captureDepth, data->latestDepth);
+				data->hasLatestFrame = true;
+				data->noCapturedFrames++;
+			}
+		}
+		data->stateChanged.notify_all();
+
+		if (!isValid) break;
+	}
+#endif
+}
+
+bool LatestFrameImageSourceEngine::waitForNextFrame(void) const
+{
+#ifndef NO_CPP11
+	std::unique_lock<std::mutex> lock(data->mutex);
+	while (!data->hasLatestFrame && !data->isEnded) data->stateChanged.wait(lock);
+	return data->hasLatestFrame;
+#else
+	return source->hasMoreImages();
+#endif
+}
+
+void LatestFrameImageSourceEngine::getImages(ITMUChar4Image *rgb, ITMShortImage *rawDepth)
+{
+#ifndef NO_CPP11
+	if (!waitForNextFrame()) return;
+
+	std::lock_guard<std::mutex> lock(data->mutex);
+
+	handOverImage(rgb, data->latestRGB);
+	handOverImage(rawDepth, data->latestDepth);
+	data->hasLatestFrame = false;
+#else
+	source->getImages(rgb, rawDepth);
+	data->noCapturedFrames++;
+#endif
+}
+
+bool LatestFrameImageSourceEngine::hasImagesNow(void) const
+{
+#ifndef NO_CPP11
+	std::lock_guard<std::mutex> lock(data->mutex);
+	return data->hasLatestFrame;
+#else
+	return source->hasImagesNow();
+#endif
+}
+
+bool LatestFrameImageSourceEngine::hasMoreImages(void) const
+{
+	return waitForNextFrame();
+}
+
+int LatestFrameImageSourceEngine::getNoCapturedFrames(void) const
+{
+#ifndef NO_CPP11
+	std::lock_guard<std::mutex> lock(data->mutex);
+#endif
+	return data->noCapturedFrames;
+}
+
+int LatestFrameImageSourceEngine::getNoSkippedFrames(void) const
+{
+#ifndef NO_CPP11
+	std::lock_guard<std::mutex> lock(data->mutex);
+#endif
+	return data->noSkippedFrames;
+}
@@ -0,0 +1,71 @@
+// Copyright 2014-2017 Oxford University Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include "ImageSourceEngine.h"
+
+namespace InputSource {
+
+	/**
+	 * \brief Reads another image source on a capture thread and always yields the newest frame, for real-time use.
+	 *
+	 * The capture thread reads frames as fast as the source delivers them and overwrites a single "latest" slot,
+	 * so a caller that processes frames more slowly than the sensor delivers them skips the frames in between,
+	 * rather than falling further and further behind. getImages() waits for a frame newer than the one it last
+	 * yielded and hands it over by swapping buffers, as PrefetchingImageSourceEngine does. The skipped frames are
+	 * counted. Without C++11 (NO_CPP11) the frames are read when they are requested and none are skipped.
+	 */
+	class LatestFrameImageSourceEngine : public ImageSourceEngine
+	{
+	private:
+		struct PrivateData;
+		PrivateData *data;
+
+		ImageSourceEngine *source;
+		ITMLib::ITMRGBDCalib calib;
+		Vector2i rgbImageSize, depthImageSize;
+
+		/// Waits until a frame newer than the last one yielded has been read, returns false if there is none
+		bool waitForNextFrame(void) const;
+
+		void captureThreadMain(void);
+
+	public:
+		/**
+		 * \brief Constructs a latest-frame image source and starts capturing.
+		 *
+		 * \param source  The image source to read from, which is deleted with this one.
+		 * \param useGPU  Whether the frame buffers are also allocated on the GPU, which should match the images
+		 *                passed to getImages() for them to be swapped rather than copied.
+		 */
+		LatestFrameImageSourceEngine(ImageSourceEngine *source, bool useGPU = false);
+
+		/**
+		 * \brief Stops capturing and deletes the source.
+		 *
+		 * The capture thread makes no further calls into the source, but a call in progress is waited for. Sources
+		 * should therefore only block for a bounded time in hasMoreImages() and getImages(), such as the timeout of
+		 * SharedMemoryImageSource. A source that can block indefinitely, e.g. a stalled sensor, has to be unblocked
+		 * by the caller (e.g. by closing the device) before this is destroyed.
+		 */
+		~LatestFrameImageSourceEngine();
+
+		ITMLib::ITMRGBDCalib getCalib(void) const { return calib; }
+		Vector2i getDepthImageSize(void) const { return depthImageSize; }
+		void getImages(ITMUChar4Image *rgb, ITMShortImage *rawDepth);
+		Vector2i getRGBImageSize(void) const { return rgbImageSize; }
+		bool hasImagesNow(void) const;
+		bool hasMoreImages(void) const;
+
+		/// The number of frames read from the source
+		int getNoCapturedFrames(void) const;
+
+		/// The number of frames that were overwritten by a newer frame before they were yielded
+		int getNoSkippedFrames(void) const;
+
+		// Suppress the default copy constructor and assignment operator
+		LatestFrameImageSourceEngine(const LatestFrameImageSourceEngine&);
+		LatestFrameImageSourceEngine& operator=(const LatestFrameImageSourceEngine&);
+	};
+
+}
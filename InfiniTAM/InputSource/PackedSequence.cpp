@@ -0,0 +1,336 @@
+// Copyright 2014-2017 Oxford University Innovation Limited and the authors of InfiniTAM
+
+#include "PackedSequence.h"
+#include "RVLDepthCodec.h"
+
+#include "../ITMLib/Objects/Camera/ITMCalibIO.h"
+
+#include <cstring>
+#include <sstream>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace InputSource;
+using namespace InputSource::PackedSequence;
+
+/// Number of bytes of an image of \p imgSize with pixels of \p T
+template <typename T>
+static size_t ImageBytes(Vector2i imgSize)
+{
+	return (size_t)imgSize.x * (size_t)imgSize.y * sizeof(T);
+}
+
+static bool DecodeRVL(ITMUChar4Image *image, const unsigned char *payload, size_t payloadSize)
+{
+	// only depth is compressed
+	return false;
+}
+
+static bool DecodeRVL(ITMShortImage *image, const unsigned char *payload, size_t payloadSize)
+{
+	return RVLDepthCodec::decompress(payload, payloadSize, image->GetData(MEMORYDEVICE_CPU), (int)image->dataSize);
+}
+
+/// Decodes a payload into \p image, which is resized to \p imgSize first
+template <typename T>
+static bool DecodePayload(ORUtils::Image<T> *image, Vector2i imgSize, uint32_t encoding, const unsigned char *payload, size_t payloadSize)
+{
+	image->ChangeDims(imgSize, false);
+
+	switch (encoding)
+	{
+	case ENCODING_NONE:
+		return imgSize.x * imgSize.y == 0;
+	case ENCODING_RAW:
+		if (payloadSize != ImageBytes<T>(imgSize)) return false;
+		memcpy(image->GetData(MEMORYDEVICE_CPU), payload, payloadSize);
+		return true;
+	case ENCODING_RVL:
+		return DecodeRVL(image, payload, payloadSize);
+	default:
+		return false;
+	}
+}
+
+//#################### PackedSequenceWriter ####################
+
+PackedSequenceWriter::PackedSequenceWriter(void)
+	: file(NULL), fileSize(0), compressDepth(true)
+{
+	memset(&header, 0, sizeof(FileHeader));
+}
+
+PackedSequenceWriter::~PackedSequenceWriter(void)
+{
+	if (file != NULL) close();
+}
+
+bool PackedSequenceWriter::writeBytes(const void *data, size_t size)
+{
+	if (size > 0 && fwrite(data, 1, size, file) != size) return false;
+
+	fileSize += size;
+	return true;
+}
+
+bool PackedSequenceWriter::writePayload(const void *data, size_t size, uint64_t &offset)
+{
+	static const unsigned char padding[PAYLOAD_ALIGNMENT] = { 0 };
+
+	size_t paddingSize = (size_t)((PAYLOAD_ALIGNMENT - fileSize % PAYLOAD_ALIGNMENT) % PAYLOAD_ALIGNMENT);
+	if (!writeBytes(padding, paddingSize)) return false;
+
+	offset = fileSize;
+	return writeBytes(data, size);
+}
+
+bool PackedSequenceWriter::open(const char *fileName, const ITMLib::ITMRGBDCalib &calib, Vector2i rgbImageSize, Vector2i depthImageSize, bool compressDepth)
+{
+	if (file != NULL) close();
+
+	file = fopen(fileName, "wb");
+	if (file == NULL) return false;
+
+	index.clear();
+	this->compressDepth = compressDepth;
+	if (compressDepth) compressedDepth.resize(RVLDepthCodec::getMaxCompressedSize(depthImageSize.x * depthImageSize.y));
+
+	memset(&header, 0, sizeof(FileHeader));
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.rgbWidth = rgbImageSize.x; header.rgbHeight = rgbImageSize.y;
+	header.depthWidth = depthImageSize.x; header.depthHeight = depthImageSize.y;
+
+	std::ostringstream calibText;
+	ITMLib::writeRGBDCalib(calibText, calib);
+	std::string calibString = calibText.str();
+
+	// the header is written again by close(), once the index is known
+	header.calibOffset = sizeof(FileHeader);
+	header.calibSize = calibString.size();
+	fileSize = 0;
+	if (!writeBytes(&header, sizeof(FileHeader)) || !writeBytes(calibString.data(), calibString.size()))
+	{
+		fclose(file);
+		file = NULL;
+		return false;
+	}
+
+	return true;
+}
+
+bool PackedSequenceWriter::writeFrame(const ITMUChar4Image *rgb, const ITMShortImage *rawDepth)
+{
+	if (file == NULL) return false;
+
+	Vector2i rgbImageSize(header.rgbWidth, header.rgbHeight), depthImageSize(header.depthWidth, header.depthHeight);
+	bool hasRGB = rgbImageSize.x * rgbImageSize.y > 0;
+	if ((hasRGB && rgb->noDims != rgbImageSize) || rawDepth->noDims != depthImageSize) return false;
+
+	FrameIndexEntry entry;
+	memset(&entry, 0, sizeof(FrameIndexEntry));
+
+	if (hasRGB)
+	{
+		entry.rgbEncoding = ENCODING_RAW;
+		entry.rgbSize = (uint32_t)ImageBytes<Vector4u>(rgbImageSize);
+		if (!writePayload(rgb->GetData(MEMORYDEVICE_CPU), entry.rgbSize, entry.rgbOffset)) return false;
+	}
+
+	const void *depthPayload = rawDepth->GetData(MEMORYDEVICE_CPU);
+	entry.depthEncoding = ENCODING_RAW;
+	entry.depthSize = (uint32_t)ImageBytes<short>(depthImageSize);
+
+	if (compressDepth)
+	{
+		size_t compressedSize = RVLDepthCodec::compress(rawDepth->GetData(MEMORYDEVICE_CPU), (int)rawDepth->dataSize, &compressedDepth[0]);
+
+		// noisy depth may not get any smaller
+		if (compressedSize < entry.depthSize)
+		{
+			depthPayload = &compressedDepth[0];
+			entry.depthEncoding = ENCODING_RVL;
+			entry.depthSize = (uint32_t)compressedSize;
+		}
+	}
+
+	if (!writePayload(depthPayload, entry.depthSize, entry.depthOffset)) return false;
+
+	index.push_back(entry);
+	return true;
+}
+
+bool PackedSequenceWriter::close(void)
+{
+	if (file == NULL) return false;
+
+	bool success = true;
+
+	header.noFrames = (uint32_t)index.size();
+	success = success && writePayload(index.empty() ? NULL : &index[0], index.size() * sizeof(FrameIndexEntry), header.indexOffset);
+	success = success && fseek(file, 0, SEEK_SET) == 0;
+	success = success && fwrite(&header, sizeof(FileHeader), 1, file) == 1;
+	success = fclose(file) == 0 && success;
+
+	file = NULL;
+	return success;
+}
+
+//#################### PackedSequenceReader ####################
+
+struct PackedSequenceReader::PrivateData
+{
+#ifdef _WIN32
+	HANDLE fileHandle, mappingHandle;
+
+	PrivateData(void) : fileHandle(INVALID_HANDLE_VALUE), mappingHandle(NULL) {}
+#endif
+};
+
+PackedSequenceReader::PackedSequenceReader(const char *calibFilename, const char *fileName)
+	: data(new PrivateData), rgbImageSize(0, 0), depthImageSize(0, 0), fileData(NULL), fileSize(0), frameIndex(NULL), noFrames(0), currentFrameNo(0)
+{
+	if (!mapFile(fileName)) return;
+
+	FileHeader header;
+	bool isValid = fileSize >= sizeof(FileHeader);
+	if (isValid)
+	{
+		memcpy(&header, fileData, sizeof(FileHeader));
+		isValid = memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0;
+	}
+
+	if (!isValid)
+	{
+		unmapFile();
+		return;
+	}
+
+	if (header.version != VERSION || header.calibOffset + header.calibSize > fileSize ||
+		header.indexOffset % sizeof(uint64_t) != 0 || header.indexOffset + (uint64_t)header.noFrames * sizeof(FrameIndexEntry) > fileSize)
+	{
+		printf("error: '%s' is not a complete packed sequence of version %u\n", fileName, VERSION);
+		unmapFile();
+		return;
+	}
+
+	std::istringstream calibText(std::string((const char*)fileData + header.calibOffset, header.calibSize));
+	if (!ITMLib::readRGBDCalib(calibText, calib)) printf("error: could not read the calibration stored in '%s'\n", fileName);
+
+	if (calibFilename != NULL && strlen(calibFilename) > 0 && !ITMLib::readRGBDCalib(calibFilename, calib))
+		DIEWITHEXCEPTION("error: path to the calibration file was specified but data could not be read");
+
+	rgbImageSize = Vector2i(header.rgbWidth, header.rgbHeight);
+	depthImageSize = Vector2i(header.depthWidth, header.depthHeight);
+	frameIndex = (const FrameIndexEntry*)(fileData + header.indexOffset);
+	noFrames = header.noFrames;
+}
+
+PackedSequenceReader::~PackedSequenceReader(void)
+{
+	unmapFile();
+	delete data;
+}
+
+bool PackedSequenceReader::mapFile(const char *fileName)
+{
+#ifdef _WIN32
+	data->fileHandle = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (data->fileHandle == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+	if (GetFileSizeEx(data->fileHandle, &size) && size.QuadPart > 0)
+	{
+		fileSize = (size_t)size.QuadPart;
+		data->mappingHandle = CreateFileMappingA(data->fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (data->mappingHandle != NULL) fileData = (const unsigned char*)MapViewOfFile(data->mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	}
+#else
+	int fd = ::open(fileName, O_RDONLY);
+	if (fd < 0) return false;
+
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0)
+	{
+		fileSize = (size_t)fileStat.st_size;
+		void *mapping = mmap(NULL, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+		if (mapping != MAP_FAILED)
+		{
+			fileData = (const unsigned char*)mapping;
+			madvise(mapping, fileSize, MADV_SEQUENTIAL);
+		}
+	}
+
+	// the mapping stays valid without the descriptor
+	::close(fd);
+#endif
+
+	if (fileData == NULL)
+	{
+		unmapFile();
+		return false;
+	}
+
+	return true;
+}
+
+void PackedSequenceReader::unmapFile(void)
+{
+#ifdef _WIN32
+	if (fileData != NULL) UnmapViewOfFile(fileData);
+	if (data->mappingHandle != NULL) CloseHandle(data->mappingHandle);
+	if (data->fileHandle != INVALID_HANDLE_VALUE) CloseHandle(data->fileHandle);
+	data->mappingHandle = NULL;
+	data->fileHandle = INVALID_HANDLE_VALUE;
+#else
+	if (fileData != NULL) munmap((void*)fileData, fileSize);
+#endif
+
+	fileData = NULL;
+	fileSize = 0;
+	frameIndex = NULL;
+	noFrames = 0;
+	rgbImageSize = depthImageSize = Vector2i(0, 0);
+}
+
+bool PackedSequenceReader::readImages(size_t frameNo, ITMUChar4Image *rgb, ITMShortImage *rawDepth) const
+{
+	if (frameNo >= noFrames) return false;
+
+	const FrameIndexEntry &entry = frameIndex[frameNo];
+	if (entry.rgbOffset + entry.rgbSize > fileSize || entry.depthOffset + entry.depthSize > fileSize)
+	{
+		printf("error: frame %d lies outside the packed sequence\n", (int)frameNo);
+		return false;
+	}
+
+	bool isValid = DecodePayload(rgb, rgbImageSize, entry.rgbEncoding, fileData + entry.rgbOffset, entry.rgbSize);
+	isValid = DecodePayload(rawDepth, depthImageSize, entry.depthEncoding, fileData + entry.depthOffset, entry.depthSize) && isValid;
+	if (!isValid) printf("error: frame %d of the packed sequence could not be decoded\n", (int)frameNo);
+
+	return isValid;
+}
+
+bool PackedSequenceReader::hasMoreImages(void) const
+{
+	return currentFrameNo < noFrames;
+}
+
+void PackedSequenceReader::getImages(ITMUChar4Image *rgb, ITMShortImage *rawDepth)
+{
+	readImages(currentFrameNo, rgb, rawDepth);
+	++currentFrameNo;
+}
+
+void PackedSequenceReader::seek(size_t frameNo)
+{
+	currentFrameNo = frameNo < noFrames ? frameNo : noFrames;
+}
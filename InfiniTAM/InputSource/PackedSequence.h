@@ -0,0 +1,160 @@
+// Copyright 2014-2017 Oxford University Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+#include "ImageSourceEngine.h"
+
+namespace InputSource {
+
+	/**
+	 * \brief The layout of a packed RGB-D sequence file, which holds a whole sequence of frames and its calibration.
+	 *
+	 * The file starts with a FileHeader. It is followed by the calibration, in the text format of the calibration
+	 * files, then by the payloads of the frames and finally by a FrameIndexEntry per frame. All numbers are stored
+	 * little endian, all offsets are from the start of the file and payloads start at multiples of PAYLOAD_ALIGNMENT.
+	 * All frames of a sequence have the same image sizes, a sequence without RGB has an RGB image size of 0x0.
+	 */
+	namespace PackedSequence
+	{
+		static const char MAGIC[8] = { 'I', 'T', 'M', 'P', 'S', 'E', 'Q', 0 };
+		static const uint32_t VERSION = 1;
+		static const int PAYLOAD_ALIGNMENT = 64;
+
+		/// How the pixels of an image are stored
+		enum PayloadEncoding
+		{
+			/// The frame has no such image
+			ENCODING_NONE = 0,
+			/// The pixels as they are in memory
+			ENCODING_RAW = 1,
+			/// Depth compressed by RVLDepthCodec
+			ENCODING_RVL = 2
+		};
+
+		struct FileHeader
+		{
+			char magic[8];
+			uint32_t version;
+			uint32_t noFrames;
+			int32_t rgbWidth, rgbHeight;
+			int32_t depthWidth, depthHeight;
+			uint64_t calibOffset, calibSize;
+			uint64_t indexOffset;
+		};
+
+		struct FrameIndexEntry
+		{
+			uint64_t rgbOffset, depthOffset;
+			uint32_t rgbSize, depthSize;
+			uint32_t rgbEncoding, depthEncoding;
+		};
+	}
+
+	/**
+	 * \brief Writes RGB-D frames into a packed sequence file.
+	 *
+	 * The frame index is written by close(), a file that was not closed cannot be read.
+	 */
+	class PackedSequenceWriter
+	{
+	private:
+		FILE *file;
+		/// The number of bytes written so far, counted here as ftell() only returns 32 bits on some platforms
+		uint64_t fileSize;
+		PackedSequence::FileHeader header;
+		std::vector<PackedSequence::FrameIndexEntry> index;
+
+		bool compressDepth;
+		std::vector<unsigned char> compressedDepth;
+
+		bool writeBytes(const void *data, size_t size);
+		bool writePayload(const void *data, size_t size, uint64_t &offset);
+
+	public:
+		PackedSequenceWriter(void);
+		~PackedSequenceWriter(void);
+
+		/**
+		 * \brief Creates a packed sequence file, an RGB image size of 0x0 makes a sequence without RGB.
+		 *
+		 * Depth is compressed losslessly with RVLDepthCodec unless \p compressDepth is false.
+		 */
+		bool open(const char *fileName, const ITMLib::ITMRGBDCalib &calib, Vector2i rgbImageSize, Vector2i depthImageSize, bool compressDepth = true);
+
+		/**
+		 * \brief Appends a frame, whose images must have the sizes given to open().
+		 */
+		bool writeFrame(const ITMUChar4Image *rgb, const ITMShortImage *rawDepth);
+
+		/**
+		 * \brief Writes the frame index and closes the file.
+		 */
+		bool close(void);
+
+		bool isOpen(void) const { return file != NULL; }
+		size_t getNoFrames(void) const { return index.size(); }
+
+		// Suppress the default copy constructor and assignment operator
+		PackedSequenceWriter(const PackedSequenceWriter&);
+		PackedSequenceWriter& operator=(const PackedSequenceWriter&);
+	};
+
+	/**
+	 * \brief Reads the frames of a packed sequence file, which is mapped into memory and decoded frame by frame.
+	 *
+	 * If the file does not exist, or is not a packed sequence, the image sizes are 0x0 and there are no images.
+	 */
+	class PackedSequenceReader : public ImageSourceEngine, public IndexedImageSource
+	{
+	private:
+		struct PrivateData;
+		PrivateData *data;
+
+		ITMLib::ITMRGBDCalib calib;
+		Vector2i rgbImageSize, depthImageSize;
+
+		const unsigned char *fileData;
+		size_t fileSize;
+		const PackedSequence::FrameIndexEntry *frameIndex;
+		size_t noFrames, currentFrameNo;
+
+		bool mapFile(const char *fileName);
+		void unmapFile(void);
+
+	public:
+		/**
+		 * \brief Opens a packed sequence file.
+		 *
+		 * \param calibFilename  A calibration file to use instead of the calibration stored in the sequence, or an empty string.
+		 * \param fileName       The packed sequence file.
+		 */
+		PackedSequenceReader(const char *calibFilename, const char *fileName);
+		~PackedSequenceReader(void);
+
+		ITMLib::ITMRGBDCalib getCalib(void) const { return calib; }
+		Vector2i getDepthImageSize(void) const { return depthImageSize; }
+		Vector2i getRGBImageSize(void) const { return rgbImageSize; }
+
+		bool hasMoreImages(void) const;
+		void getImages(ITMUChar4Image *rgb, ITMShortImage *rawDepth);
+
+		size_t getCurrentFrameNo(void) const { return currentFrameNo; }
+		bool readImages(size_t frameNo, ITMUChar4Image *rgb, ITMShortImage *rawDepth) const;
+
+		size_t getNoFrames(void) const { return noFrames; }
+
+		/**
+		 * \brief Makes \p frameNo the next frame yielded by getImages().
+		 */
+		void seek(size_t frameNo);
+
+		// Suppress the default copy constructor and assignment operator
+		PackedSequenceReader(const PackedSequenceReader&);
+		PackedSequenceReader& operator=(const PackedSequenceReader&);
+	};
+
+}
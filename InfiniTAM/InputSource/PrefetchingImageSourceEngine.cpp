@@ -0,0 +1,246 @@
+// Copyright 2014-2017 Oxford University Innovation Limited and the authors of InfiniTAM
+
+#include "PrefetchingImageSourceEngine.h"
+
+#include "../ORUtils/Trace.h"
+
+#include <algorithm>
+#include <vector>
+
+#ifndef NO_CPP11
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+using namespace InputSource;
+
+struct PrefetchingImageSourceEngine::PrivateData
+{
+#ifndef NO_CPP11
+	struct Slot
+	{
+		ITMUChar4Image *rgb;
+		ITMShortImage *rawDepth;
+		size_t frameNo;
+		bool isReady;
+	};
+
+	const IndexedImageSource *indexedSource;
+	size_t firstFrameNo;
+
+	std::vector<Slot> slots;
+	std::vector<std::thread> readerThreads;
+
+	// frames are numbered from 0 in the order they are returned
+	std::mutex mutex;
+	std::condition_variable stateChanged;
+	size_t nextReadFrameNo, nextReturnedFrameNo, endFrameNo, lastStalledFrameNo;
+	int noStalls;
+	bool stopThreads;
+
+	PrivateData(void) : indexedSource(NULL), firstFrameNo(0), nextReadFrameNo(0), nextReturnedFrameNo(0),
+		endFrameNo((size_t)-1), lastStalledFrameNo((size_t)-1), noStalls(0), stopThreads(false) {}
+#endif
+};
+
+PrefetchingImageSourceEngine::PrefetchingImageSourceEngine(ImageSourceEngine *source, int noBufferedFrames, int noThreads, bool useGPU)
+	: data(new PrivateData), source(source)
+{
+#ifndef NO_CPP11
+	data->indexedSource = dynamic_cast<const IndexedImageSource*>(source);
+	if (data->indexedSource != NULL) data->firstFrameNo = data->indexedSource->getCurrentFrameNo();
+
+	// a source without random access can only be read in order
+	if (data->indexedSource == NULL) noThreads = 1;
+	noBufferedFrames = std::max(noBufferedFrames, 1);
+	noThreads = std::max(std::min(noThreads, noBufferedFrames), 1);
+
+	data->slots.resize(noBufferedFrames);
+	for (size_t slotId = 0; slotId < data->slots.size(); slotId++)
+	{
+		PrivateData::Slot &slot = data->slots[slotId];
+		slot.rgb = new ITMUChar4Image(true, useGPU);
+		slot.rawDepth = new ITMShortImage(true, useGPU);
+		slot.frameNo = 0;
+		slot.isReady = false;
+	}
+
+	for (int threadId = 0; threadId < noThreads; threadId++)
+		data->readerThreads.push_back(std::thread(&PrefetchingImageSourceEngine::readerThreadMain, this));
+#endif
+}
+
+PrefetchingImageSourceEngine::~PrefetchingImageSourceEngine()
+{
+#ifndef NO_CPP11
+	{
+		std::lock_guard<std::mutex> lock(data->mutex);
+		data->stopThreads = true;
+	}
+	data->stateChanged.notify_all();
+
+	for (size_t threadId = 0; threadId < data->readerThreads.size(); threadId++) data->readerThreads[threadId].join();
+
+	for (size_t slotId = 0; slotId < data->slots.size(); slotId++)
+	{
+		delete data->slots[slotId].rgb;
+		delete data->slots[slotId].rawDepth;
+	}
+#endif
+
+	delete data;
+	delete source;
+}
+
+void PrefetchingImageSourceEngine::readerThreadMain(void)
+{
+#ifndef NO_CPP11
+	ORUtils::TraceRecorder::SetThreadName("image prefetching");
+
+	std::unique_lock<std::mutex> lock(data->mutex);
+	size_t noSlots = data->slots.size();
+
+	while (true)
+	{
+		// the slot of the next frame is free once the frame that used it noSlots frames earlier has been returned
+		while (!data->stopThreads && data->nextReadFrameNo < data->endFrameNo && data->nextReadFrameNo >= data->nextReturnedFrameNo + noSlots)
+			data->stateChanged.wait(lock);
+
+		if (data->stopThreads || data->nextReadFrameNo >= data->endFrameNo) break;
+
+		size_t frameNo = data->nextReadFrameNo++;
+		PrivateData::Slot &slot = data->slots[frameNo % noSlots];
+
+		lock.unlock();
+
+		bool isValid;
+		{
+			ORUtils::TraceSpan span("read frame", "InputSource");
+
+			if (data->indexedSource != NULL) isValid = data->indexedSource->readImages(data->firstFrameNo + frameNo, slot.rgb, slot.rawDepth);
+			else
+			{
+				isValid = source->hasMoreImages();
+				if (isValid) source->getImages(slot.rgb, slot.rawDepth);
+			}
+		}
+
+		lock.lock();
+
+		if (isValid)
+		{
+			slot.frameNo = frameNo;
+			slot.isReady = true;
+		}
+		else data->endFrameNo = std::min(data->endFrameNo, frameNo);
+
+		data->stateChanged.notify_all();
+	}
+#endif
+}
+
+bool PrefetchingImageSourceEngine::waitForNextFrame(void) const
+{
+#ifndef NO_CPP11
+	std::unique_lock<std::mutex> lock(data->mutex);
+
+	size_t frameNo = data->nextReturnedFrameNo;
+	const PrivateData::Slot &slot = data->slots[frameNo % data->slots.size()];
+
+	while (!(slot.isReady && slot.frameNo == frameNo) && frameNo < data->endFrameNo)
+	{
+		if (data->lastStalledFrameNo != frameNo)
+		{
+			data->lastStalledFrameNo = frameNo;
+			data->noStalls++;
+		}
+
+		data->stateChanged.wait(lock);
+	}
+
+	return frameNo < data->endFrameNo;
+#else
+	return source->hasMoreImages();
+#endif
+}
+
+ITMLib::ITMRGBDCalib PrefetchingImageSourceEngine::getCalib(void) const
+{
+	return source->getCalib();
+}
+
+Vector2i PrefetchingImageSourceEngine::getDepthImageSize(void) const
+{
+#ifndef NO_CPP11
+	if (!waitForNextFrame()) return Vector2i(0, 0);
+
+	std::lock_guard<std::mutex> lock(data->mutex);
+	return data->slots[data->nextReturnedFrameNo % data->slots.size()].rawDepth->noDims;
+#else
+	return source->getDepthImageSize();
+#endif
+}
+
+Vector2i PrefetchingImageSourceEngine::getRGBImageSize(void) const
+{
+#ifndef NO_CPP11
+	if (!waitForNextFrame()) return Vector2i(0, 0);
+
+	std::lock_guard<std::mutex> lock(data->mutex);
+	return data->slots[data->nextReturnedFrameNo % data->slots.size()].rgb->noDims;
+#else
+	return source->getRGBImageSize();
+#endif
+}
+
+void PrefetchingImageSourceEngine::getImages(ITMUChar4Image *rgb, ITMShortImage *rawDepth)
+{
+#ifndef NO_CPP11
+	if (!waitForNextFrame()) return;
+
+	{
+		// the slot is not touched by the reader threads until it is released below
+		std::lock_guard<std::mutex> lock(data->mutex);
+		PrivateData::Slot &slot = data->slots[data->nextReturnedFrameNo % data->slots.size()];
+
+		handOverImage(rgb, slot.rgb);
+		handOverImage(rawDepth, slot.rawDepth);
+
+		slot.isReady = false;
+		data->nextReturnedFrameNo++;
+	}
+
+	data->stateChanged.notify_all();
+#else
+	source->getImages(rgb, rawDepth);
+#endif
+}
+
+bool PrefetchingImageSourceEngine::hasImagesNow(void) const
+{
+#ifndef NO_CPP11
+	std::lock_guard<std::mutex> lock(data->mutex);
+
+	size_t frameNo = data->nextReturnedFrameNo;
+	const PrivateData::Slot &slot = data->slots[frameNo % data->slots.size()];
+	return slot.isReady && slot.frameNo == frameNo;
+#else
+	return source->hasImagesNow();
+#endif
+}
+
+bool PrefetchingImageSourceEngine::hasMoreImages(void) const
+{
+	return waitForNextFrame();
+}
+
+int PrefetchingImageSourceEngine::getNoStalls(void) const
+{
+#ifndef NO_CPP11
+	std::lock_guard<std::mutex> lock(data->mutex);
+	return data->noStalls;
+#else
+	return 0;
+#endif
+}
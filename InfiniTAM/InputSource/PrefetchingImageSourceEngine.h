@@ -0,0 +1,61 @@
+// Copyright 2014-2017 Oxford University Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include "ImageSourceEngine.h"
+
+namespace InputSource {
+
+	/**
+	 * \brief Reads the frames of another image source ahead of time on background threads.
+	 *
+	 * The frames are read into a ring of image buffers. getImages() hands a buffer to the caller by swapping it
+	 * with the caller's images, which then go back into the ring to be reused, so nothing is copied as long as
+	 * the caller's images are allocated on the same devices as the ring buffers. Otherwise the frame is copied.
+	 *
+	 * Sources that are an IndexedImageSource, such as ImageFileReader, are read by several threads at once.
+	 * Any other source is read by a single thread, in order. Without C++11 (NO_CPP11) the frames are read
+	 * when they are requested.
+	 */
+	class PrefetchingImageSourceEngine : public ImageSourceEngine
+	{
+	private:
+		struct PrivateData;
+		PrivateData *data;
+
+		ImageSourceEngine *source;
+
+		/// Waits until the next frame has been read, returns false if there is none
+		bool waitForNextFrame(void) const;
+
+		void readerThreadMain(void);
+
+	public:
+		/**
+		 * \brief Constructs a prefetching image source and starts reading.
+		 *
+		 * \param source            The image source to read from, which is deleted with this one.
+		 * \param noBufferedFrames  The number of frames that may be read ahead.
+		 * \param noThreads         The number of threads reading an IndexedImageSource.
+		 * \param useGPU            Whether the ring buffers are also allocated on the GPU, which should match the
+		 *                          images passed to getImages() for them to be swapped rather than copied.
+		 */
+		PrefetchingImageSourceEngine(ImageSourceEngine *source, int noBufferedFrames = 8, int noThreads = 2, bool useGPU = false);
+		~PrefetchingImageSourceEngine();
+
+		ITMLib::ITMRGBDCalib getCalib(void) const;
+		Vector2i getDepthImageSize(void) const;
+		void getImages(ITMUChar4Image *rgb, ITMShortImage *rawDepth);
+		Vector2i getRGBImageSize(void) const;
+		bool hasImagesNow(void) const;
+		bool hasMoreImages(void) const;
+
+		/// The number of times a frame was requested before it had been read
+		int getNoStalls(void) const;
+
+		// Suppress the default copy constructor and assignment operator
+		PrefetchingImageSourceEngine(const PrefetchingImageSourceEngine&);
+		PrefetchingImageSourceEngine& operator=(const PrefetchingImageSourceEngine&);
+	};
+
+}
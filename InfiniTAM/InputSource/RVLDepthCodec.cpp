@@ -0,0 +1,406 @@
+// Copyright 2014-2017 Oxford University Innovation Limited and the authors of InfiniTAM
+
+#include "RVLDepthCodec.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RVL_DECODE_SSE2
+#endif
+
+using namespace InputSource;
+
+namespace
+{
+	// a count below 2^32 takes at most 11 nibbles, a zigzag-coded difference of two shorts at most 6
+	const int MAX_VALUE_NIBBLES = 11;
+	const size_t MAX_COUNT_NIBBLES = 11;
+	const size_t MAX_DIFFERENCE_NIBBLES = 6;
+
+	// values of up to three nibbles, which are almost all differences, are encoded with a lookup table
+	const int ENCODE_TABLE_NIBBLES = 3;
+	const uint32_t ENCODE_TABLE_VALUES = 1 << (3 * ENCODE_TABLE_NIBBLES);
+
+	// words decoded at a time, each holds at most eight values
+	const int DECODE_CHUNK_WORDS = 32;
+
+	/// How the eight nibbles of a word split into values, for each combination of continuation bits
+	struct WordLayout
+	{
+		/// Number of values ending in the word
+		unsigned char noValues;
+		/// Number of nibbles of the first value that are in the word
+		unsigned char firstValueNibbles;
+		/// Payload bit offset of each value ending in the word
+		unsigned char valueShift[8];
+		/// Payload bit offset and number of nibbles of the value continuing into the next word
+		unsigned char tailShift, tailNibbles;
+		/// Payload bits of each value ending in the word, 0 for the others
+		uint32_t valueMask[8];
+	};
+
+	struct CodeTables
+	{
+		/// The nibbles of each value below ENCODE_TABLE_VALUES, first nibble in the highest bits, and their number << 12
+		uint16_t encode[ENCODE_TABLE_VALUES];
+		/// Indexed by the continuation bits of the nibbles of a word, the first nibble in the lowest bit
+		WordLayout decode[256];
+
+		CodeTables(void)
+		{
+			for (uint32_t value = 0; value < ENCODE_TABLE_VALUES; value++)
+			{
+				uint32_t code = 0, rest = value;
+				int noNibbles = 0;
+				do
+				{
+					uint32_t nibble = rest & 0x7;
+					rest >>= 3;
+					if (rest != 0) nibble |= 0x8;
+
+					code = (code << 4) | nibble;
+					noNibbles++;
+				} while (rest != 0);
+
+				encode[value] = (uint16_t)(code | (noNibbles << 12));
+			}
+
+			for (int continuations = 0; continuations < 256; continuations++)
+			{
+				WordLayout &layout = decode[continuations];
+				memset(&layout, 0, sizeof(WordLayout));
+
+				int valueStart = 0;
+				for (int nibbleId = 0; nibbleId < 8; nibbleId++)
+				{
+					if (continuations & (1 << nibbleId)) continue;
+
+					if (layout.noValues == 0) layout.firstValueNibbles = (unsigned char)(nibbleId + 1);
+					layout.valueShift[layout.noValues] = (unsigned char)(3 * valueStart);
+					layout.valueMask[layout.noValues] = (1u << (3 * (nibbleId + 1 - valueStart))) - 1;
+					layout.noValues++;
+					valueStart = nibbleId + 1;
+				}
+
+				layout.tailShift = (unsigned char)(3 * valueStart);
+				layout.tailNibbles = (unsigned char)(8 - valueStart);
+			}
+		}
+	};
+
+	const CodeTables codeTables;
+
+	// a 64 bit word of four pixels has a zero pixel iff this is non-zero
+	inline uint64_t findZeroPixels(uint64_t pixels)
+	{
+		return (pixels - 0x0001000100010001ull) & ~pixels & 0x8000800080008000ull;
+	}
+
+	inline const short *skipZeroPixels(const short *depth, const short *end)
+	{
+		for (uint64_t pixels; end - depth >= 4; depth += 4)
+		{
+			memcpy(&pixels, depth, sizeof(uint64_t));
+			if (pixels != 0) break;
+		}
+		while (depth != end && *depth == 0) depth++;
+		return depth;
+	}
+
+	inline const short *skipNonZeroPixels(const short *depth, const short *end)
+	{
+		for (uint64_t pixels; end - depth >= 4; depth += 4)
+		{
+			memcpy(&pixels, depth, sizeof(uint64_t));
+			if (findZeroPixels(pixels) != 0) break;
+		}
+		while (depth != end && *depth != 0) depth++;
+		return depth;
+	}
+
+	inline uint32_t zigzag(int difference)
+	{
+		return ((uint32_t)difference << 1) ^ (uint32_t)(difference >> 31);
+	}
+
+	/// Adds up the zigzag-coded differences to previous and stores each sum as a pixel
+	inline void decodeDifferences(const uint32_t *codes, int noDifferences, uint32_t &previous, short *depth)
+	{
+		int i = 0;
+
+#ifdef RVL_DECODE_SSE2
+		// prefix sums of four differences at a time, so that only one addition per four pixels depends on the previous one
+		const __m128i one = _mm_set1_epi32(1);
+		__m128i previous4 = _mm_set1_epi32((int)previous);
+
+		for (; i + 8 <= noDifferences; i += 8)
+		{
+			__m128i sums[2];
+			for (int half = 0; half < 2; half++)
+			{
+				__m128i code = _mm_loadu_si128((const __m128i*)(codes + i + 4 * half));
+				__m128i difference = _mm_xor_si128(_mm_srli_epi32(code, 1), _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(code, one)));
+
+				difference = _mm_add_epi32(difference, _mm_slli_si128(difference, 4));
+				difference = _mm_add_epi32(difference, _mm_slli_si128(difference, 8));
+				sums[half] = _mm_add_epi32(difference, previous4);
+				previous4 = _mm_shuffle_epi32(sums[half], 0xff);
+
+				// truncate to 16 bits, so that packing does not saturate
+				sums[half] = _mm_srai_epi32(_mm_slli_epi32(sums[half], 16), 16);
+			}
+
+			_mm_storeu_si128((__m128i*)(depth + i), _mm_packs_epi32(sums[0], sums[1]));
+		}
+
+		previous = (uint32_t)_mm_cvtsi128_si32(previous4);
+#endif
+
+		for (; i < noDifferences; i++)
+		{
+			previous += (codes[i] >> 1) ^ (0 - (codes[i] & 1));
+			depth[i] = (short)previous;
+		}
+	}
+
+	struct NibbleWriter
+	{
+		unsigned char *output;
+		/// The nibbles of the current word are the lowest noBits bits
+		uint64_t bits;
+		int noBits;
+
+		explicit NibbleWriter(unsigned char *output) : output(output), bits(0), noBits(0) {}
+
+		inline void writeWord(uint32_t value)
+		{
+			memcpy(output, &value, sizeof(uint32_t));
+		}
+
+		/// Appends the lowest noCodeBits (at most 32) bits of code
+		inline void append(uint32_t code, int noCodeBits)
+		{
+			bits = (bits << noCodeBits) | code;
+			noBits += noCodeBits;
+
+			// the current word is stored every time, which avoids a hard to predict branch, but only kept once it is full
+			int isFull = noBits >> 5;
+			noBits &= 31;
+			writeWord((uint32_t)(bits >> noBits));
+			output += sizeof(uint32_t) * isFull;
+		}
+
+		inline void encode(uint32_t value)
+		{
+			if (value < ENCODE_TABLE_VALUES)
+			{
+				uint32_t entry = codeTables.encode[value];
+				append(entry & 0xfff, 4 * (entry >> 12));
+				return;
+			}
+
+			uint64_t code = 0;
+			int noNibbles = 0;
+			do
+			{
+				uint32_t nibble = value & 0x7;
+				value >>= 3;
+				if (value != 0) nibble |= 0x8;
+
+				code = (code << 4) | nibble;
+				noNibbles++;
+			} while (value != 0);
+
+			if (noNibbles > 8) append((uint32_t)(code >> 32), 4 * (noNibbles - 8));
+			append((uint32_t)code, 4 * (noNibbles < 8 ? noNibbles : 8));
+		}
+
+		/// Two values at once, which halves the dependency chain through the bit buffer for small values
+		inline void encodePair(uint32_t first, uint32_t second)
+		{
+			if ((first | second) >= ENCODE_TABLE_VALUES)
+			{
+				encode(first);
+				encode(second);
+				return;
+			}
+
+			uint32_t firstEntry = codeTables.encode[first], secondEntry = codeTables.encode[second];
+			int noSecondBits = 4 * (secondEntry >> 12);
+			append(((firstEntry & 0xfff) << noSecondBits) | (secondEntry & 0xfff), 4 * (firstEntry >> 12) + noSecondBits);
+		}
+
+		inline void flush(void)
+		{
+			if (noBits > 0)
+			{
+				writeWord((uint32_t)(bits << (32 - noBits)));
+				output += sizeof(uint32_t);
+			}
+			bits = 0;
+			noBits = 0;
+		}
+	};
+
+	/// Decodes a word at a time into a buffer of values, which are then handed out one by one
+	struct NibbleReader
+	{
+		const unsigned char *input, *inputEnd;
+
+		uint32_t values[DECODE_CHUNK_WORDS * 8];
+		int noValues, valueId;
+
+		/// Number of values handed out before the current buffer, and of values ending before the last word
+		size_t noPreviousValues, noValuesBeforeLastWord;
+
+		/// The payload and number of nibbles of a value continuing from the previous word
+		uint64_t tail;
+		int noTailNibbles;
+
+		NibbleReader(const unsigned char *input, size_t inputSize)
+			: input(input), inputEnd(input + inputSize), noValues(0), valueId(0), noPreviousValues(0),
+			  noValuesBeforeLastWord((size_t)-1), tail(0), noTailNibbles(0) {}
+
+		/// Decodes the next chunk of words, returns false if the input has ended or holds a value longer than 32 bits
+		bool decodeChunk(void)
+		{
+			noPreviousValues += noValues;
+			noValues = 0;
+			valueId = 0;
+
+			for (int wordId = 0; wordId < DECODE_CHUNK_WORDS && input != inputEnd; wordId++)
+			{
+				uint32_t word;
+				memcpy(&word, input, sizeof(uint32_t));
+				input += sizeof(uint32_t);
+
+				if (input == inputEnd) noValuesBeforeLastWord = noPreviousValues + noValues;
+
+				// reorder the nibbles so that the first one is in the lowest bits
+				word = (word >> 24) | ((word >> 8) & 0xff00) | ((word << 8) & 0xff0000) | (word << 24);
+				word = ((word >> 4) & 0x0f0f0f0f) | ((word & 0x0f0f0f0f) << 4);
+
+				// gather the continuation bits into eight bits and the payloads into 24
+				uint32_t continuations = (word >> 3) & 0x11111111;
+				continuations = (continuations | (continuations >> 3)) & 0x03030303;
+				continuations = (continuations | (continuations >> 6)) & 0x000f000f;
+				continuations = (continuations | (continuations >> 12)) & 0xff;
+
+				uint32_t payload = word & 0x77777777;
+				payload = (payload & 0x07070707) | ((payload & 0x70707070) >> 1);
+				payload = (payload & 0x003f003f) | ((payload & 0x3f003f00) >> 2);
+				payload = (payload & 0x00000fff) | ((payload & 0x0fff0000) >> 4);
+
+				const WordLayout &layout = codeTables.decode[continuations];
+
+				if (layout.noValues == 0)
+				{
+					tail |= (uint64_t)payload << (3 * noTailNibbles);
+					noTailNibbles += 8;
+					if (noTailNibbles > MAX_VALUE_NIBBLES) return false;
+					continue;
+				}
+
+				if (noTailNibbles + layout.firstValueNibbles > MAX_VALUE_NIBBLES) return false;
+
+				// all eight slots are written, only the first noValues are kept
+				uint32_t *wordValues = values + noValues;
+				for (int i = 0; i < 8; i++)
+					wordValues[i] = (payload >> layout.valueShift[i]) & layout.valueMask[i];
+				wordValues[0] = (uint32_t)(tail | ((uint64_t)wordValues[0] << (3 * noTailNibbles)));
+
+				noValues += layout.noValues;
+				tail = payload >> layout.tailShift;
+				noTailNibbles = layout.tailNibbles;
+			}
+
+			return noValues > 0;
+		}
+
+		/// Returns false if the input ends, or the value does not fit into 32 bits
+		inline bool decode(uint32_t &value)
+		{
+			if (valueId == noValues && !decodeChunk()) return false;
+			value = values[valueId++];
+			return true;
+		}
+
+		/// True if the last value handed out ends in the last word of the input
+		bool isAtEnd(void) const
+		{
+			return input == inputEnd && noPreviousValues + valueId > noValuesBeforeLastWord;
+		}
+	};
+}
+
+size_t RVLDepthCodec::getMaxCompressedSize(int noPixels)
+{
+	// every pair of runs holds at least one pixel, plus the word the writer may store past the end
+	size_t maxNoNibbles = (size_t)noPixels * (2 * MAX_COUNT_NIBBLES + MAX_DIFFERENCE_NIBBLES);
+	return ((maxNoNibbles + 7) / 8 + 1) * sizeof(uint32_t);
+}
+
+size_t RVLDepthCodec::compress(const short *depth, int noPixels, unsigned char *output)
+{
+	NibbleWriter writer(output);
+
+	const short *end = depth + noPixels;
+	int previous = 0;
+
+	while (depth != end)
+	{
+		const short *runStart = depth;
+		depth = skipZeroPixels(depth, end);
+		writer.encode((uint32_t)(depth - runStart));
+
+		runStart = depth;
+		depth = skipNonZeroPixels(depth, end);
+		writer.encode((uint32_t)(depth - runStart));
+
+		const short *p = runStart;
+		for (; depth - p >= 2; p += 2) writer.encodePair(zigzag(p[0] - previous), zigzag(p[1] - p[0])), previous = p[1];
+		if (p != depth) writer.encode(zigzag(*p - previous)), previous = *p;
+	}
+
+	writer.flush();
+	return writer.output - output;
+}
+
+bool RVLDepthCodec::decompress(const unsigned char *input, size_t inputSize, short *depth, int noPixels)
+{
+	if (inputSize % sizeof(uint32_t) != 0) return false;
+	if (noPixels == 0) return inputSize == 0;
+
+	NibbleReader reader(input, inputSize);
+
+	short *end = depth + noPixels;
+	uint32_t previous = 0;
+
+	while (depth != end)
+	{
+		uint32_t noZeros, noNonZeros;
+
+		if (!reader.decode(noZeros) || noZeros > (uint32_t)(end - depth)) return false;
+		memset(depth, 0, noZeros * sizeof(short));
+		depth += noZeros;
+
+		if (!reader.decode(noNonZeros) || noNonZeros > (uint32_t)(end - depth)) return false;
+		for (short *runEnd = depth + noNonZeros; depth != runEnd; )
+		{
+			if (reader.valueId == reader.noValues && !reader.decodeChunk()) return false;
+
+			// as many differences as are both in the run and already decoded
+			int noDifferences = reader.noValues - reader.valueId;
+			if (noDifferences > runEnd - depth) noDifferences = (int)(runEnd - depth);
+
+			decodeDifferences(reader.values + reader.valueId, noDifferences, previous, depth);
+			reader.valueId += noDifferences;
+			depth += noDifferences;
+		}
+	}
+
+	// the data ends with the word holding the last nibble
+	return reader.isAtEnd();
+}
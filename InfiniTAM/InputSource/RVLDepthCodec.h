@@ -0,0 +1,43 @@
+// Copyright 2014-2017 Oxford University Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include <stddef.h>
+
+namespace InputSource {
+
+	/**
+	 * \brief Lossless compression of depth images with run-length and variable-length coding (RVL).
+	 *
+	 * The pixels are coded in scan order as alternating runs of zero and non-zero pixels. Each run is stored as
+	 * its length, a non-zero run is followed by the zigzag-coded differences between consecutive non-zero pixels.
+	 * All numbers are stored in nibbles of three value bits and a continuation bit, which are packed eight to a
+	 * little endian 32 bit word, the first nibble in the highest bits.
+	 *
+	 * See A. D. Wilson, "Fast lossless depth image compression", ISS 2017.
+	 */
+	class RVLDepthCodec
+	{
+	public:
+		/// An upper bound of the number of bytes compress() writes for \p noPixels pixels
+		static size_t getMaxCompressedSize(int noPixels);
+
+		/**
+		 * \brief Compresses a depth image.
+		 *
+		 * \param depth     The depth pixels.
+		 * \param noPixels  The number of pixels.
+		 * \param output    The compressed data, at least getMaxCompressedSize(noPixels) bytes.
+		 * \return          The number of bytes written, a multiple of four.
+		 */
+		static size_t compress(const short *depth, int noPixels, unsigned char *output);
+
+		/**
+		 * \brief Decompresses a depth image.
+		 *
+		 * \return False if \p input is not the compressed data of exactly \p noPixels pixels.
+		 */
+		static bool decompress(const unsigned char *input, size_t inputSize, short *depth, int noPixels);
+	};
+
+}
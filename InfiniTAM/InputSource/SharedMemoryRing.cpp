@@ -0,0 +1,423 @@
+// Copyright 2014-2017 Oxford University Innovation Limited and the authors of InfiniTAM
+
+#include "SharedMemoryRing.h"
+
+#include "../ITMLib/Objects/Camera/ITMCalibIO.h"
+
+#include <cstring>
+#include <sstream>
+#include <string>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+using namespace InputSource;
+using namespace InputSource::SharedMemoryRing;
+
+#ifndef _WIN32
+
+static size_t AlignUp(size_t value, size_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+/// Shared memory names start with a single slash
+static std::string GetSegmentName(const char *name)
+{
+	return name[0] == '/' ? std::string(name) : "/" + std::string(name);
+}
+
+static uint64_t GetMonotonicTimeNs(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+/// The offsets of the RGB and depth pixels in a slot, and the size of a slot
+static void GetSlotLayout(Vector2i rgbImageSize, Vector2i depthImageSize, size_t &rgbOffset, size_t &depthOffset, size_t &slotSize)
+{
+	rgbOffset = AlignUp(sizeof(SlotHeader), ALIGNMENT);
+	depthOffset = AlignUp(rgbOffset + (size_t)rgbImageSize.x * rgbImageSize.y * sizeof(Vector4u), ALIGNMENT);
+	slotSize = AlignUp(depthOffset + (size_t)depthImageSize.x * depthImageSize.y * sizeof(short), ALIGNMENT);
+}
+
+static void WakeConsumers(uint32_t *wakeCounter)
+{
+#ifdef __linux__
+	syscall(SYS_futex, wakeCounter, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#endif
+}
+
+/// Waits at most \p timeoutMs for \p wakeCounter to change from \p value
+static void WaitForWake(uint32_t *wakeCounter, uint32_t value, int timeoutMs)
+{
+#ifdef __linux__
+	struct timespec timeout;
+	timeout.tv_sec = timeoutMs / 1000;
+	timeout.tv_nsec = (long)(timeoutMs % 1000) * 1000000;
+	syscall(SYS_futex, wakeCounter, FUTEX_WAIT, value, &timeout, NULL, 0);
+#else
+	// without futexes the counter is polled
+	for (int i = 0; i < timeoutMs * 10 && __atomic_load_n(wakeCounter, __ATOMIC_ACQUIRE) == value; i++) usleep(100);
+#endif
+}
+
+#endif
+
+//#################### SharedMemoryRingWriter ####################
+
+struct SharedMemoryRingWriter::PrivateData
+{
+#ifndef _WIN32
+	std::string segmentName;
+	unsigned char *segment;
+	size_t segmentSize;
+	RingHeader *header;
+
+	Vector2i rgbImageSize, depthImageSize;
+	size_t rgbOffset, depthOffset;
+
+	PrivateData(void) : segment(NULL), segmentSize(0), header(NULL) {}
+#endif
+};
+
+SharedMemoryRingWriter::SharedMemoryRingWriter(void)
+	: data(new PrivateData)
+{}
+
+SharedMemoryRingWriter::~SharedMemoryRingWriter(void)
+{
+	close();
+	delete data;
+}
+
+bool SharedMemoryRingWriter::open(const char *name, const ITMLib::ITMRGBDCalib &calib, Vector2i rgbImageSize, Vector2i depthImageSize, int noSlots)
+{
+#ifndef _WIN32
+	close();
+
+	std::ostringstream calibText;
+	ITMLib::writeRGBDCalib(calibText, calib);
+	std::string calibString = calibText.str();
+
+	size_t slotSize;
+	GetSlotLayout(rgbImageSize, depthImageSize, data->rgbOffset, data->depthOffset, slotSize);
+
+	size_t calibOffset = AlignUp(sizeof(RingHeader), ALIGNMENT);
+	size_t slotsOffset = AlignUp(calibOffset + calibString.size(), 4096);
+	data->segmentSize = slotsOffset + (size_t)noSlots * slotSize;
+
+	// a segment left behind by a producer that did not close it is replaced
+	data->segmentName = GetSegmentName(name);
+	shm_unlink(data->segmentName.c_str());
+
+	int fd = shm_open(data->segmentName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd < 0) return false;
+
+	void *mapping = MAP_FAILED;
+	if (ftruncate(fd, (off_t)data->segmentSize) == 0) mapping = mmap(NULL, data->segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+
+	if (mapping == MAP_FAILED)
+	{
+		shm_unlink(data->segmentName.c_str());
+		return false;
+	}
+
+	// the segment starts out zeroed, so no slot holds a frame yet
+	data->segment = (unsigned char*)mapping;
+	data->header = (RingHeader*)mapping;
+	data->rgbImageSize = rgbImageSize;
+	data->depthImageSize = depthImageSize;
+
+	RingHeader *header = data->header;
+	memcpy(header->magic, MAGIC, sizeof(MAGIC));
+	header->noSlots = noSlots;
+	header->rgbWidth = rgbImageSize.x; header->rgbHeight = rgbImageSize.y;
+	header->depthWidth = depthImageSize.x; header->depthHeight = depthImageSize.y;
+	header->calibOffset = calibOffset;
+	header->calibSize = calibString.size();
+	header->slotsOffset = slotsOffset;
+	header->slotSize = slotSize;
+	memcpy(data->segment + calibOffset, calibString.data(), calibString.size());
+
+	__atomic_store_n(&header->version, VERSION, __ATOMIC_RELEASE);
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool SharedMemoryRingWriter::writeFrame(const ITMUChar4Image *rgb, const ITMShortImage *rawDepth, const ITMLib::ITMIMUMeasurement *imu)
+{
+#ifndef _WIN32
+	if (data->header == NULL) return false;
+
+	bool hasRGB = data->rgbImageSize.x * data->rgbImageSize.y > 0;
+	if ((hasRGB && rgb->noDims != data->rgbImageSize) || rawDepth->noDims != data->depthImageSize) return false;
+
+	RingHeader *header = data->header;
+	uint64_t frameNo = header->noPublishedFrames;
+	unsigned char *slot = data->segment + header->slotsOffset + (frameNo % header->noSlots) * header->slotSize;
+	SlotHeader *slotHeader = (SlotHeader*)slot;
+
+	__atomic_store_n(&slotHeader->sequence, 2 * frameNo + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	if (hasRGB) memcpy(slot + data->rgbOffset, rgb->GetData(MEMORYDEVICE_CPU), rgb->dataSize * sizeof(Vector4u));
+	memcpy(slot + data->depthOffset, rawDepth->GetData(MEMORYDEVICE_CPU), rawDepth->dataSize * sizeof(short));
+
+	slotHeader->hasIMU = imu != NULL;
+	if (imu != NULL) memcpy(slotHeader->imuR, imu->R.m, sizeof(slotHeader->imuR));
+	slotHeader->timestamp = GetMonotonicTimeNs();
+
+	__atomic_store_n(&slotHeader->sequence, 2 * frameNo + 2, __ATOMIC_RELEASE);
+	__atomic_store_n(&header->noPublishedFrames, frameNo + 1, __ATOMIC_RELEASE);
+	__atomic_add_fetch(&header->wakeCounter, 1, __ATOMIC_RELEASE);
+	WakeConsumers(&header->wakeCounter);
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+void SharedMemoryRingWriter::close(void)
+{
+#ifndef _WIN32
+	if (data->header == NULL) return;
+
+	// consumers that are attached keep the segment until they detach
+	__atomic_store_n(&data->header->isClosed, 1, __ATOMIC_RELEASE);
+	__atomic_add_fetch(&data->header->wakeCounter, 1, __ATOMIC_RELEASE);
+	WakeConsumers(&data->header->wakeCounter);
+
+	munmap(data->segment, data->segmentSize);
+	shm_unlink(data->segmentName.c_str());
+
+	data->segment = NULL;
+	data->header = NULL;
+#endif
+}
+
+bool SharedMemoryRingWriter::isOpen(void) const
+{
+#ifndef _WIN32
+	return data->header != NULL;
+#else
+	return false;
+#endif
+}
+
+//#################### SharedMemoryImageSource ####################
+
+struct SharedMemoryImageSource::PrivateData
+{
+#ifndef _WIN32
+	unsigned char *segment;
+	size_t segmentSize;
+	RingHeader *header;
+	size_t rgbOffset, depthOffset;
+
+	uint64_t nextFrameNo;
+	int noDroppedFrames;
+
+	bool lastHasIMU;
+	Matrix3f lastIMU;
+	double lastLatencyUs;
+
+	PrivateData(void) : segment(NULL), segmentSize(0), header(NULL), nextFrameNo(0), noDroppedFrames(0), lastHasIMU(false), lastLatencyUs(0.0) {}
+#endif
+};
+
+SharedMemoryImageSource::SharedMemoryImageSource(const char *calibFilename, const char *name, int timeoutMs)
+	: data(new PrivateData), rgbImageSize(0, 0), depthImageSize(0, 0), timeoutMs(timeoutMs)
+{
+#ifndef _WIN32
+	std::string segmentName = GetSegmentName(name);
+	int fd = shm_open(segmentName.c_str(), O_RDONLY, 0);
+	if (fd < 0) return;
+
+	struct stat segmentStat;
+	void *mapping = MAP_FAILED;
+	if (fstat(fd, &segmentStat) == 0 && (size_t)segmentStat.st_size >= sizeof(RingHeader))
+	{
+		data->segmentSize = (size_t)segmentStat.st_size;
+		mapping = mmap(NULL, data->segmentSize, PROT_READ, MAP_SHARED, fd, 0);
+	}
+	::close(fd);
+
+	if (mapping == MAP_FAILED) return;
+
+	data->segment = (unsigned char*)mapping;
+	RingHeader *header = (RingHeader*)mapping;
+
+	bool isValid = memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0 && __atomic_load_n(&header->version, __ATOMIC_ACQUIRE) == VERSION;
+
+	size_t slotSize = 0;
+	Vector2i rgbSize(header->rgbWidth, header->rgbHeight), depthSize(header->depthWidth, header->depthHeight);
+	if (isValid) GetSlotLayout(rgbSize, depthSize, data->rgbOffset, data->depthOffset, slotSize);
+
+	isValid = isValid && header->noSlots > 0 && header->slotSize == slotSize && header->calibOffset + header->calibSize <= data->segmentSize &&
+		header->slotsOffset + (uint64_t)header->noSlots * header->slotSize <= data->segmentSize;
+
+	if (!isValid)
+	{
+		printf("error: '%s' is not a shared memory ring buffer of version %u\n", name, VERSION);
+		munmap(data->segment, data->segmentSize);
+		data->segment = NULL;
+		return;
+	}
+
+	std::istringstream calibText(std::string((const char*)data->segment + header->calibOffset, header->calibSize));
+	if (!ITMLib::readRGBDCalib(calibText, calib)) printf("error: could not read the calibration in '%s'\n", name);
+
+	if (calibFilename != NULL && strlen(calibFilename) > 0 && !ITMLib::readRGBDCalib(calibFilename, calib))
+		DIEWITHEXCEPTION("error: path to the calibration file was specified but data could not be read");
+
+	data->header = header;
+	rgbImageSize = rgbSize;
+	depthImageSize = depthSize;
+
+	// start with the oldest frame that is still in the ring, the slot after it may be being overwritten
+	uint64_t noPublishedFrames = __atomic_load_n(&header->noPublishedFrames, __ATOMIC_ACQUIRE);
+	data->nextFrameNo = noPublishedFrames >= header->noSlots ? noPublishedFrames - header->noSlots + 1 : 0;
+#else
+	printf("error: shared memory image sources are not supported on this platform\n");
+#endif
+}
+
+SharedMemoryImageSource::~SharedMemoryImageSource(void)
+{
+#ifndef _WIN32
+	if (data->segment != NULL) munmap(data->segment, data->segmentSize);
+#endif
+	delete data;
+}
+
+bool SharedMemoryImageSource::waitForNextFrame(int timeoutMs) const
+{
+#ifndef _WIN32
+	RingHeader *header = data->header;
+	if (header == NULL) return false;
+
+	uint64_t startTime = GetMonotonicTimeNs();
+
+	while (true)
+	{
+		// the counter is read first, so that a frame published after the check below still ends the wait
+		uint32_t wakeCounter = __atomic_load_n(&header->wakeCounter, __ATOMIC_ACQUIRE);
+
+		if (__atomic_load_n(&header->noPublishedFrames, __ATOMIC_ACQUIRE) > data->nextFrameNo) return true;
+		if (__atomic_load_n(&header->isClosed, __ATOMIC_ACQUIRE)) return false;
+
+		int remainingMs = timeoutMs - (int)((GetMonotonicTimeNs() - startTime) / 1000000);
+		if (remainingMs <= 0) return false;
+
+		WaitForWake(&header->wakeCounter, wakeCounter, remainingMs < 100 ? remainingMs : 100);
+	}
+#else
+	return false;
+#endif
+}
+
+void SharedMemoryImageSource::getImages(ITMUChar4Image *rgb, ITMShortImage *rawDepth)
+{
+#ifndef _WIN32
+	RingHeader *header = data->header;
+	rgb->ChangeDims(rgbImageSize, false);
+	rawDepth->ChangeDims(depthImageSize, false);
+
+	while (waitForNextFrame(timeoutMs))
+	{
+		uint64_t noPublishedFrames = __atomic_load_n(&header->noPublishedFrames, __ATOMIC_ACQUIRE);
+		if (noPublishedFrames - data->nextFrameNo >= header->noSlots)
+		{
+			uint64_t oldestFrameNo = noPublishedFrames - header->noSlots + 1;
+			data->noDroppedFrames += (int)(oldestFrameNo - data->nextFrameNo);
+			data->nextFrameNo = oldestFrameNo;
+		}
+
+		uint64_t frameNo = data->nextFrameNo++;
+		const unsigned char *slot = data->segment + header->slotsOffset + (frameNo % header->noSlots) * header->slotSize;
+		SlotHeader *slotHeader = (SlotHeader*)slot;
+
+		uint64_t sequence = __atomic_load_n(&slotHeader->sequence, __ATOMIC_ACQUIRE);
+		if (sequence == 2 * frameNo + 2)
+		{
+			memcpy(rgb->GetData(MEMORYDEVICE_CPU), slot + data->rgbOffset, rgb->dataSize * sizeof(Vector4u));
+			memcpy(rawDepth->GetData(MEMORYDEVICE_CPU), slot + data->depthOffset, rawDepth->dataSize * sizeof(short));
+			bool hasIMU = slotHeader->hasIMU != 0;
+			if (hasIMU) memcpy(data->lastIMU.m, slotHeader->imuR, sizeof(slotHeader->imuR));
+			uint64_t timestamp = slotHeader->timestamp;
+
+			// the frame is only complete if the producer has not started to overwrite it meanwhile
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+			if (__atomic_load_n(&slotHeader->sequence, __ATOMIC_RELAXED) == sequence)
+			{
+				data->lastHasIMU = hasIMU;
+				data->lastLatencyUs = (double)(GetMonotonicTimeNs() - timestamp) / 1000.0;
+				return;
+			}
+		}
+
+		data->noDroppedFrames++;
+	}
+#endif
+}
+
+bool SharedMemoryImageSource::hasImagesNow(void) const
+{
+#ifndef _WIN32
+	return data->header != NULL && __atomic_load_n(&data->header->noPublishedFrames, __ATOMIC_ACQUIRE) > data->nextFrameNo;
+#else
+	return false;
+#endif
+}
+
+bool SharedMemoryImageSource::hasMoreImages(void) const
+{
+	return waitForNextFrame(timeoutMs);
+}
+
+bool SharedMemoryImageSource::getIMUMeasurement(ITMLib::ITMIMUMeasurement *imu) const
+{
+#ifndef _WIN32
+	if (!data->lastHasIMU) return false;
+
+	imu->R = data->lastIMU;
+	return true;
+#else
+	return false;
+#endif
+}
+
+double SharedMemoryImageSource::getLastLatencyUs(void) const
+{
+#ifndef _WIN32
+	return data->lastLatencyUs;
+#else
+	return 0.0;
+#endif
+}
+
+int SharedMemoryImageSource::getNoDroppedFrames(void) const
+{
+#ifndef _WIN32
+	return data->noDroppedFrames;
+#else
+	return 0;
+#endif
+}
@@ -0,0 +1,149 @@
+// Copyright 2014-2017 Oxford University Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include <stdint.h>
+
+#include "ImageSourceEngine.h"
+#include "../ITMLib/Objects/Misc/ITMIMUMeasurement.h"
+
+namespace InputSource {
+
+	/**
+	 * \brief The layout of a POSIX shared memory ring buffer, through which a capture process passes RGB-D frames to InfiniTAM.
+	 *
+	 * The segment starts with a RingHeader, followed by the calibration in the text format of the calibration files and,
+	 * at slotsOffset, by noSlots slots of slotSize bytes. Each slot holds a SlotHeader, followed by the RGB pixels and
+	 * the depth pixels of a frame, each at the first multiple of ALIGNMENT bytes from the start of the slot after what
+	 * precedes it. Frame i is written to slot i % noSlots. All numbers are in the byte order of the machine.
+	 *
+	 * The producer publishes a header by storing its version last. A slot's sequence is odd while frame i is written
+	 * to it, 2 * i + 1, and 2 * i + 2 once it is complete; a consumer checks that it is unchanged after reading the
+	 * frame, which it skips otherwise. After each frame, noPublishedFrames is set to the number of frames written
+	 * and wakeCounter is incremented, consumers wait on wakeCounter with a futex on Linux and poll elsewhere.
+	 * All fields written while the producer runs are accessed atomically.
+	 */
+	namespace SharedMemoryRing
+	{
+		static const char MAGIC[8] = { 'I', 'T', 'M', 'S', 'H', 'M', 'R', 0 };
+		static const uint32_t VERSION = 1;
+		static const int ALIGNMENT = 64;
+
+		struct RingHeader
+		{
+			char magic[8];
+			uint32_t version;
+			uint32_t noSlots;
+			int32_t rgbWidth, rgbHeight;
+			int32_t depthWidth, depthHeight;
+			uint64_t calibOffset, calibSize;
+			uint64_t slotsOffset, slotSize;
+
+			uint64_t noPublishedFrames;
+			uint32_t wakeCounter;
+			uint32_t isClosed;
+		};
+
+		struct SlotHeader
+		{
+			uint64_t sequence;
+			/// CLOCK_MONOTONIC time at which the frame was published, in nanoseconds
+			uint64_t timestamp;
+			uint32_t hasIMU;
+			/// The IMU orientation, column major as in Matrix3f
+			float imuR[9];
+		};
+	}
+
+	/**
+	 * \brief Creates a shared memory ring buffer and publishes frames into it, for use in capture processes.
+	 */
+	class SharedMemoryRingWriter
+	{
+	private:
+		struct PrivateData;
+		PrivateData *data;
+
+	public:
+		SharedMemoryRingWriter(void);
+		~SharedMemoryRingWriter(void);
+
+		/**
+		 * \brief Creates the named shared memory segment, replacing any segment of that name.
+		 *
+		 * An RGB image size of 0x0 makes a ring without RGB.
+		 */
+		bool open(const char *name, const ITMLib::ITMRGBDCalib &calib, Vector2i rgbImageSize, Vector2i depthImageSize, int noSlots = 4);
+
+		/**
+		 * \brief Publishes a frame, whose images must have the sizes given to open(). \p imu may be NULL.
+		 */
+		bool writeFrame(const ITMUChar4Image *rgb, const ITMShortImage *rawDepth, const ITMLib::ITMIMUMeasurement *imu = NULL);
+
+		/**
+		 * \brief Tells the consumers that no more frames follow and removes the segment's name.
+		 */
+		void close(void);
+
+		bool isOpen(void) const;
+
+		// Suppress the default copy constructor and assignment operator
+		SharedMemoryRingWriter(const SharedMemoryRingWriter&);
+		SharedMemoryRingWriter& operator=(const SharedMemoryRingWriter&);
+	};
+
+	/**
+	 * \brief Reads the frames a capture process publishes into a shared memory ring buffer.
+	 *
+	 * Frames are yielded in order and copied once, straight from shared memory into the images passed to getImages().
+	 * If the reader falls behind by more than the ring holds, the frames that were overwritten are skipped.
+	 * If the segment does not exist, the image sizes are 0x0 and there are no images. Shared memory is not
+	 * supported on Windows.
+	 */
+	class SharedMemoryImageSource : public ImageSourceEngine
+	{
+	private:
+		struct PrivateData;
+		PrivateData *data;
+
+		ITMLib::ITMRGBDCalib calib;
+		Vector2i rgbImageSize, depthImageSize;
+		int timeoutMs;
+
+		/// Waits up to timeoutMs for the next frame, returns false if there is none
+		bool waitForNextFrame(int timeoutMs) const;
+
+	public:
+		/**
+		 * \brief Attaches to a shared memory ring buffer.
+		 *
+		 * \param calibFilename  A calibration file to use instead of the calibration in the ring, or an empty string.
+		 * \param name           The name of the shared memory segment.
+		 * \param timeoutMs      How long hasMoreImages() waits for the producer before the source ends.
+		 */
+		SharedMemoryImageSource(const char *calibFilename, const char *name, int timeoutMs = 5000);
+		~SharedMemoryImageSource(void);
+
+		ITMLib::ITMRGBDCalib getCalib(void) const { return calib; }
+		Vector2i getDepthImageSize(void) const { return depthImageSize; }
+		Vector2i getRGBImageSize(void) const { return rgbImageSize; }
+
+		void getImages(ITMUChar4Image *rgb, ITMShortImage *rawDepth);
+		bool hasImagesNow(void) const;
+		bool hasMoreImages(void) const;
+
+		/// Gets the IMU measurement of the frame last yielded by getImages(), returns false if it had none
+		bool getIMUMeasurement(ITMLib::ITMIMUMeasurement *imu) const;
+
+		/// The time from publishing the frame last yielded by getImages() until it had been copied, in microseconds
+		double getLastLatencyUs(void) const;
+
+		/// The number of frames that were overwritten before they could be read
+		int getNoDroppedFrames(void) const;
+
+		// Suppress the default copy constructor and assignment operator
+		SharedMemoryImageSource(const SharedMemoryImageSource&);
+		SharedMemoryImageSource& operator=(const SharedMemoryImageSource&);
+	};
+
+}
@@ -82,6 +82,11 @@ namespace ORUtils
 			std::swap(this->noDims, rhs.noDims);
 		}
 
+		bool HasSameAllocation(const Image<T>& rhs) const
+		{
+			return MemoryBlock<T>::HasSameAllocation(rhs);
+		}
+
 		// Suppress the default copy constructor and assignment operator
 		Image(const Image&);
 		Image& operator=(const Image&);
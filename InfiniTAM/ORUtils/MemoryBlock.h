@@ -315,6 +315,14 @@ namespace ORUtils
 			std::swap(this->isMetalCompatible, rhs.isMetalCompatible);
 		}
 
+		/** Whether @p rhs is allocated on the same devices, so that
+		the two can be swapped without either changing where it lives.
+		*/
+		bool HasSameAllocation(const MemoryBlock<T>& rhs) const
+		{
+			return isAllocated_CPU == rhs.isAllocated_CPU && isAllocated_CUDA == rhs.isAllocated_CUDA && isMetalCompatible == rhs.isMetalCompatible;
+		}
+
 		// Suppress the default copy constructor and assignment operator
 		MemoryBlock(const MemoryBlock&);
 		MemoryBlock& operator=(const MemoryBlock&);
@@ -0,0 +1,342 @@
+// Copyright 2014-2017 Oxford University Innovation Limited and the authors of InfiniTAM
+
+#include "TaskScheduler.h"
+
+#include "Trace.h"
+
+#ifndef NO_CPP11
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#endif
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace ORUtils;
+
+#ifndef NO_CPP11
+
+namespace
+{
+	struct QueuedTask
+	{
+		TaskScheduler::Task *task;
+		TaskScheduler::TaskGroup *group;
+	};
+
+	struct TaskQueue
+	{
+		std::mutex mutex;
+		std::deque<QueuedTask> tasks;
+	};
+
+	// the scheduler used by the calling thread, and the scheduler and id of the worker it is, if any
+	thread_local TaskScheduler *currentScheduler = NULL;
+	thread_local TaskScheduler *workerScheduler = NULL;
+	thread_local int workerId = -1;
+}
+
+struct TaskScheduler::TaskGroup::PrivateData
+{
+	std::atomic<int> noPending;
+	std::mutex mutex;
+	std::condition_variable finished;
+
+	PrivateData(void) : noPending(0) {}
+};
+
+struct TaskScheduler::PrivateData
+{
+	// one queue per worker, followed by the one shared by all threads outside the pool
+	std::vector<TaskQueue*> queues;
+	std::vector<std::thread> workerThreads;
+
+	std::atomic<int> noQueuedTasks;
+	std::mutex sleepMutex;
+	std::condition_variable wakeUp;
+	bool stopThreads;
+
+	PrivateData(void) : noQueuedTasks(0), stopThreads(false) {}
+};
+
+#else
+
+struct TaskScheduler::TaskGroup::PrivateData {};
+struct TaskScheduler::PrivateData {};
+
+#endif
+
+TaskScheduler::TaskGroup::TaskGroup(void) : data(new PrivateData) {}
+TaskScheduler::TaskGroup::~TaskGroup(void) { delete data; }
+
+TaskScheduler::Scope::Scope(TaskScheduler *scheduler)
+{
+#ifndef NO_CPP11
+	previous = currentScheduler;
+	currentScheduler = scheduler;
+#else
+	previous = NULL;
+#endif
+}
+
+TaskScheduler::Scope::~Scope(void)
+{
+#ifndef NO_CPP11
+	currentScheduler = previous;
+#endif
+}
+
+TaskScheduler::TaskScheduler(int noThreads, int firstCore)
+	: data(new PrivateData)
+{
+#ifndef NO_CPP11
+	int noHardwareThreads = (int)std::thread::hardware_concurrency();
+	if (noHardwareThreads < 1) noHardwareThreads = 1;
+
+	this->noThreads = noThreads > 0 ? noThreads : noHardwareThreads;
+
+	int noWorkers = this->noThreads - 1;
+	for (int i = 0; i <= noWorkers; ++i) data->queues.push_back(new TaskQueue);
+	for (int i = 0; i < noWorkers; ++i)
+	{
+		int core = firstCore >= 0 ? (firstCore + i) % noHardwareThreads : -1;
+		data->workerThreads.push_back(std::thread(&TaskScheduler::WorkerThreadMain, this, i, core));
+	}
+#else
+	this->noThreads = 1;
+#endif
+}
+
+TaskScheduler::~TaskScheduler(void)
+{
+#ifndef NO_CPP11
+	{
+		std::lock_guard<std::mutex> lock(data->sleepMutex);
+		data->stopThreads = true;
+	}
+	data->wakeUp.notify_all();
+	for (size_t i = 0; i < data->workerThreads.size(); ++i) data->workerThreads[i].join();
+
+	for (size_t i = 0; i < data->queues.size(); ++i) delete data->queues[i];
+#endif
+
+	delete data;
+}
+
+TaskScheduler* TaskScheduler::GetCurrent(void)
+{
+#ifndef NO_CPP11
+	return currentScheduler;
+#else
+	return NULL;
+#endif
+}
+
+void TaskScheduler::WorkerThreadMain(int workerId, int core)
+{
+#ifndef NO_CPP11
+	TraceRecorder::SetThreadName("task scheduler worker");
+
+#ifdef __linux__
+	if (core >= 0 && core < CPU_SETSIZE)
+	{
+		cpu_set_t cores;
+		CPU_ZERO(&cores);
+		CPU_SET(core, &cores);
+		pthread_setaffinity_np(pthread_self(), sizeof(cores), &cores);
+	}
+#endif
+
+	currentScheduler = this;
+	workerScheduler = this;
+	::workerId = workerId;
+
+	while (true)
+	{
+		if (RunQueuedTask()) continue;
+
+		std::unique_lock<std::mutex> lock(data->sleepMutex);
+		while (!data->stopThreads && data->noQueuedTasks.load() == 0) data->wakeUp.wait(lock);
+		if (data->stopThreads) break;
+	}
+#endif
+}
+
+bool TaskScheduler::RunQueuedTask(void)
+{
+#ifndef NO_CPP11
+	if (data->noQueuedTasks.load() == 0) return false;
+
+	int noWorkers = (int)data->workerThreads.size();
+	int ownQueueId = workerScheduler == this ? workerId : -1;
+
+	QueuedTask queuedTask = { NULL, NULL };
+
+	// the newest task of the own queue, which is most likely still in the cache
+	if (ownQueueId >= 0)
+	{
+		TaskQueue *queue = data->queues[ownQueueId];
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		if (!queue->tasks.empty()) { queuedTask = queue->tasks.back(); queue->tasks.pop_back(); }
+	}
+
+	// otherwise the oldest task of the shared queue or of another worker
+	for (int i = 0; i <= noWorkers && queuedTask.task == NULL; ++i)
+	{
+		int queueId = (noWorkers + ownQueueId + 1 + i) % (noWorkers + 1);
+		if (queueId == ownQueueId) continue;
+
+		TaskQueue *queue = data->queues[queueId];
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		if (!queue->tasks.empty()) { queuedTask = queue->tasks.front(); queue->tasks.pop_front(); }
+	}
+
+	if (queuedTask.task == NULL) return false;
+	data->noQueuedTasks--;
+
+	queuedTask.task->Run();
+
+	// the waiting thread may destroy the group as soon as it sees no pending tasks, which it checks under the lock
+	TaskGroup::PrivateData *groupData = queuedTask.group->data;
+	std::lock_guard<std::mutex> lock(groupData->mutex);
+	if (--groupData->noPending == 0) groupData->finished.notify_all();
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+void TaskScheduler::Submit(Task *task, TaskGroup *group)
+{
+#ifndef NO_CPP11
+	group->data->noPending++;
+
+	int noWorkers = (int)data->workerThreads.size();
+	TaskQueue *queue = data->queues[workerScheduler == this ? workerId : noWorkers];
+	{
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		QueuedTask queuedTask = { task, group };
+		queue->tasks.push_back(queuedTask);
+	}
+	data->noQueuedTasks++;
+
+	if (noWorkers > 0)
+	{
+		// a worker about to sleep either sees the new task or is woken up
+		{ std::lock_guard<std::mutex> lock(data->sleepMutex); }
+		data->wakeUp.notify_one();
+	}
+#else
+	task->Run();
+#endif
+}
+
+void TaskScheduler::Wait(TaskGroup *group)
+{
+#ifndef NO_CPP11
+	TaskGroup::PrivateData *groupData = group->data;
+
+	while (groupData->noPending.load() > 0)
+	{
+		if (RunQueuedTask()) continue;
+
+		// the remaining tasks are running on other threads, which may still submit new ones
+		std::unique_lock<std::mutex> lock(groupData->mutex);
+		if (groupData->noPending.load() > 0) groupData->finished.wait_for(lock, std::chrono::microseconds(100));
+	}
+
+	std::lock_guard<std::mutex> lock(groupData->mutex);
+#endif
+}
+
+void TaskScheduler::RunAll(Task *const *tasks, int noTasks)
+{
+	if (noTasks <= 0) return;
+
+	TaskGroup group;
+	for (int i = 1; i < noTasks; ++i) Submit(tasks[i], &group);
+
+	tasks[0]->Run();
+	Wait(&group);
+}
+
+#ifndef NO_CPP11
+
+struct TaskGraph::Node : public TaskScheduler::Task
+{
+	std::function<void(void)> function;
+	std::vector<Node*> successors;
+	int noDependencies;
+
+	// only set while the graph is running
+	std::atomic<int> noPendingDependencies;
+	TaskScheduler *scheduler;
+	TaskScheduler::TaskGroup *group;
+
+	void Run(void)
+	{
+		function();
+
+		for (size_t i = 0; i < successors.size(); ++i)
+			if (--successors[i]->noPendingDependencies == 0) scheduler->Submit(successors[i], group);
+	}
+};
+
+TaskGraph::~TaskGraph(void)
+{
+	for (size_t i = 0; i < nodes.size(); ++i) delete nodes[i];
+}
+
+int TaskGraph::AddTask(const std::function<void(void)>& function, const std::vector<int>& dependencies)
+{
+	int taskId = (int)nodes.size();
+
+	Node *node = new Node;
+	node->function = function;
+	node->noDependencies = 0;
+
+	for (size_t i = 0; i < dependencies.size(); ++i)
+	{
+		if (dependencies[i] < 0 || dependencies[i] >= taskId) continue;
+
+		nodes[dependencies[i]]->successors.push_back(node);
+		node->noDependencies++;
+	}
+
+	nodes.push_back(node);
+	return taskId;
+}
+
+void TaskGraph::Run(TaskScheduler *scheduler)
+{
+	if (scheduler == NULL || scheduler->GetNoThreads() <= 1)
+	{
+		for (size_t i = 0; i < nodes.size(); ++i) nodes[i]->function();
+		return;
+	}
+
+	TaskScheduler::TaskGroup group;
+
+	for (size_t i = 0; i < nodes.size(); ++i)
+	{
+		nodes[i]->noPendingDependencies = nodes[i]->noDependencies;
+		nodes[i]->scheduler = scheduler;
+		nodes[i]->group = &group;
+	}
+
+	for (size_t i = 0; i < nodes.size(); ++i)
+		if (nodes[i]->noDependencies == 0) scheduler->Submit(nodes[i], &group);
+
+	// the calling thread runs tasks as well while it waits
+	TaskScheduler::Scope scope(scheduler);
+	scheduler->Wait(&group);
+}
+
+#endif
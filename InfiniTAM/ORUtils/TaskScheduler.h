@@ -0,0 +1,248 @@
+// Copyright 2014-2017 Oxford University Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include <vector>
+
+#ifndef NO_CPP11
+#include <functional>
+#endif
+
+namespace ORUtils
+{
+	/** \brief
+	    A small work-stealing task scheduler for the CPU engines.
+
+	    The scheduler owns noThreads - 1 worker threads, the thread
+	    that waits for tasks is the remaining one and runs tasks itself
+	    while it waits. Each worker keeps its own task deque: it takes
+	    the tasks it submitted last first, while idle workers steal the
+	    oldest ones. Tasks submitted from outside the pool go to a
+	    shared queue. Workers may be pinned to consecutive cores.
+
+	    The scheduler used by ParallelFor(), ParallelReduce() and
+	    TaskGraph is the one installed on the calling thread by a
+	    TaskScheduler::Scope, which the worker threads of a scheduler
+	    have installed as well. Without one they run serially, there is
+	    no process wide default pool. Without C++11 (NO_CPP11) there
+	    are no worker threads and everything runs serially.
+	*/
+	class TaskScheduler
+	{
+	public:
+		/// A unit of work, owned by the caller until it has been run
+		class Task
+		{
+		public:
+			virtual ~Task(void) {}
+			virtual void Run(void) = 0;
+		};
+
+		/// Tasks that are waited for together
+		class TaskGroup
+		{
+		private:
+			friend class TaskScheduler;
+			struct PrivateData;
+			PrivateData *data;
+
+		public:
+			TaskGroup(void);
+			~TaskGroup(void);
+
+			// Suppress the default copy constructor and assignment operator
+			TaskGroup(const TaskGroup&);
+			TaskGroup& operator=(const TaskGroup&);
+		};
+
+		/// Installs a scheduler on the calling thread for the lifetime of the object, NULL runs everything serially
+		class Scope
+		{
+		private:
+			TaskScheduler *previous;
+
+		public:
+			explicit Scope(TaskScheduler *scheduler);
+			~Scope(void);
+
+			// Suppress the default copy constructor and assignment operator
+			Scope(const Scope&);
+			Scope& operator=(const Scope&);
+		};
+
+	private:
+		struct PrivateData;
+		PrivateData *data;
+
+		int noThreads;
+
+		/// Runs one queued task, returns false if there was none
+		bool RunQueuedTask(void);
+
+		void WorkerThreadMain(int workerId, int core);
+
+	public:
+		/** \param noThreads  Number of threads running tasks including the waiting thread, 0 uses one per hardware thread.
+		    \param firstCore  Core the first worker is pinned to, the others to the following ones, -1 does not pin them.
+		                      The waiting thread is never pinned. Pinning is only supported on Linux.
+		*/
+		explicit TaskScheduler(int noThreads = 0, int firstCore = -1);
+		~TaskScheduler(void);
+
+		/// Number of threads running tasks including the waiting thread
+		int GetNoThreads(void) const { return noThreads; }
+
+		/// The scheduler installed on the calling thread, or NULL
+		static TaskScheduler* GetCurrent(void);
+
+		/// Queues a task of \p group, which may be called from within a running task
+		void Submit(Task *task, TaskGroup *group);
+
+		/// Runs queued tasks until all tasks of \p group have finished
+		void Wait(TaskGroup *group);
+
+		/// Runs all \p tasks, the first one on the calling thread, and returns once all have finished
+		void RunAll(Task *const *tasks, int noTasks);
+
+		// Suppress the default copy constructor and assignment operator
+		TaskScheduler(const TaskScheduler&);
+		TaskScheduler& operator=(const TaskScheduler&);
+	};
+
+	namespace TaskSchedulerInternal
+	{
+		template <typename TBody>
+		class RangeTask : public TaskScheduler::Task
+		{
+		private:
+			const TBody *body;
+			int begin, end;
+
+		public:
+			RangeTask(void) : body(0), begin(0), end(0) {}
+			RangeTask(const TBody *body, int begin, int end) : body(body), begin(begin), end(end) {}
+
+			void Run(void) { for (int i = begin; i < end; ++i) (*body)(i); }
+		};
+
+		template <typename T, typename TBody>
+		class ReduceTask : public TaskScheduler::Task
+		{
+		private:
+			const TBody *body;
+			int begin, end;
+			T *result;
+
+		public:
+			ReduceTask(void) : body(0), begin(0), end(0), result(0) {}
+			ReduceTask(const TBody *body, int begin, int end, T *result) : body(body), begin(begin), end(end), result(result) {}
+
+			void Run(void) { *result = (*body)(begin, end); }
+		};
+
+		inline void RunAll(TaskScheduler *scheduler, std::vector<TaskScheduler::Task*>& tasks)
+		{
+			if (scheduler != 0) scheduler->RunAll(&tasks[0], (int)tasks.size());
+			else for (int i = 0; i < (int)tasks.size(); ++i) tasks[i]->Run();
+		}
+	}
+
+	/** Calls body(i) for all i in [begin, end) on the current scheduler, in chunks of at least \p grainSize
+	    indices. Different indices may be processed concurrently and in any order.
+	*/
+	template <typename TBody>
+	void ParallelFor(int begin, int end, const TBody& body, int grainSize = 1)
+	{
+		TaskScheduler *scheduler = TaskScheduler::GetCurrent();
+		int noThreads = scheduler != 0 ? scheduler->GetNoThreads() : 1;
+		int noItems = end - begin;
+
+		if (grainSize < 1) grainSize = 1;
+		if (noThreads <= 1 || noItems <= grainSize)
+		{
+			for (int i = begin; i < end; ++i) body(i);
+			return;
+		}
+
+		// a few chunks per thread, so that threads finishing early can steal the remaining ones
+		int noChunks = noThreads * 4;
+		if (noChunks > noItems / grainSize) noChunks = noItems / grainSize;
+
+		std::vector<TaskSchedulerInternal::RangeTask<TBody> > chunks(noChunks);
+		std::vector<TaskScheduler::Task*> tasks(noChunks);
+		for (int chunkId = 0; chunkId < noChunks; ++chunkId)
+		{
+			chunks[chunkId] = TaskSchedulerInternal::RangeTask<TBody>(&body,
+				begin + (int)((long long)noItems * chunkId / noChunks), begin + (int)((long long)noItems * (chunkId + 1) / noChunks));
+			tasks[chunkId] = &chunks[chunkId];
+		}
+
+		TaskSchedulerInternal::RunAll(scheduler, tasks);
+	}
+
+	/** Splits [begin, end) into ranges of \p grainSize indices, computes body(rangeBegin, rangeEnd) for each
+	    range on the current scheduler and folds the results from left to right with combine(a, b), starting
+	    from \p identity. The ranges do not depend on the number of threads, so neither does the result, even
+	    if combine() is not associative as for floating point sums.
+	*/
+	template <typename T, typename TBody, typename TCombine>
+	T ParallelReduce(int begin, int end, int grainSize, const T& identity, const TBody& body, const TCombine& combine)
+	{
+		if (grainSize < 1) grainSize = 1;
+
+		int noRanges = end > begin ? (end - begin + grainSize - 1) / grainSize : 0;
+		std::vector<T> results(noRanges, identity);
+
+		std::vector<TaskSchedulerInternal::ReduceTask<T, TBody> > ranges(noRanges);
+		std::vector<TaskScheduler::Task*> tasks(noRanges);
+		for (int rangeId = 0; rangeId < noRanges; ++rangeId)
+		{
+			int rangeBegin = begin + rangeId * grainSize;
+			int rangeEnd = rangeBegin + grainSize < end ? rangeBegin + grainSize : end;
+			ranges[rangeId] = TaskSchedulerInternal::ReduceTask<T, TBody>(&body, rangeBegin, rangeEnd, &results[rangeId]);
+			tasks[rangeId] = &ranges[rangeId];
+		}
+
+		if (noRanges > 0)
+		{
+			TaskScheduler *scheduler = TaskScheduler::GetCurrent();
+			TaskSchedulerInternal::RunAll(scheduler != 0 && scheduler->GetNoThreads() > 1 ? scheduler : 0, tasks);
+		}
+
+		T result = identity;
+		for (int rangeId = 0; rangeId < noRanges; ++rangeId) result = combine(result, results[rangeId]);
+		return result;
+	}
+
+#ifndef NO_CPP11
+	/** \brief
+	    Tasks with dependencies between them, run on a scheduler.
+
+	    A task may only depend on tasks added before it, so adding
+	    order is always a valid order to run them in. Each task starts
+	    once all tasks it depends on have finished, tasks without a
+	    dependency between them may run concurrently. Without a
+	    scheduler they run in the order they were added.
+	*/
+	class TaskGraph
+	{
+	private:
+		struct Node;
+		std::vector<Node*> nodes;
+
+	public:
+		TaskGraph(void) {}
+		~TaskGraph(void);
+
+		/// Adds a task running \p function after the tasks with the ids in \p dependencies, returns its id
+		int AddTask(const std::function<void(void)>& function, const std::vector<int>& dependencies = std::vector<int>());
+
+		/// Runs all tasks on \p scheduler and returns once they have finished, NULL runs them serially on the calling thread
+		void Run(TaskScheduler *scheduler);
+
+		// Suppress the default copy constructor and assignment operator
+		TaskGraph(const TaskGraph&);
+		TaskGraph& operator=(const TaskGraph&);
+	};
+#endif
+}
@@ -0,0 +1,173 @@
+// Copyright 2014-2017 Oxford University Innovation Limited and the authors of InfiniTAM
+
+#include "Trace.h"
+
+#include <stdio.h>
+
+#ifndef NO_CPP11
+#include <chrono>
+#include <mutex>
+#include <vector>
+#endif
+
+using namespace ORUtils;
+
+#ifndef NO_CPP11
+
+namespace
+{
+	struct TraceEvent
+	{
+		const char *name, *category;
+		long long begin, duration;
+	};
+
+	struct ThreadBuffer
+	{
+		int threadId;
+		const char *threadName;
+		std::vector<TraceEvent> events;
+		std::atomic<long long> noRecorded;
+
+		explicit ThreadBuffer(int threadId) : threadId(threadId), threadName(NULL), events(TraceRecorder::BUFFER_CAPACITY), noRecorded(0) {}
+	};
+
+	// buffers are never freed, so that the spans of threads that have exited can still be written
+	struct TraceRegistry
+	{
+		std::mutex mutex;
+		std::vector<ThreadBuffer*> buffers;
+		std::chrono::steady_clock::time_point start;
+
+		TraceRegistry(void) : start(std::chrono::steady_clock::now()) {}
+	};
+
+	TraceRegistry& GetRegistry(void)
+	{
+		static TraceRegistry registry;
+		return registry;
+	}
+
+	thread_local ThreadBuffer *threadBuffer = NULL;
+
+	ThreadBuffer* GetThreadBuffer(void)
+	{
+		if (threadBuffer == NULL)
+		{
+			TraceRegistry &registry = GetRegistry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			threadBuffer = new ThreadBuffer((int)registry.buffers.size() + 1);
+			registry.buffers.push_back(threadBuffer);
+		}
+		return threadBuffer;
+	}
+
+	void WriteJSONString(FILE *f, const char *s)
+	{
+		fputc('"', f);
+		for (; *s != 0; s++)
+		{
+			if (*s == '"' || *s == '\\') fputc('\\', f);
+			if ((unsigned char)*s >= 0x20) fputc(*s, f);
+		}
+		fputc('"', f);
+	}
+}
+
+std::atomic<bool> TraceRecorder::enabled(false);
+
+void TraceRecorder::SetEnabled(bool enabled)
+{
+	if (enabled) Now(); // start the clock
+	TraceRecorder::enabled.store(enabled);
+}
+
+long long TraceRecorder::Now(void)
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - GetRegistry().start).count();
+}
+
+void TraceRecorder::Record(const char *name, const char *category, long long begin, long long end)
+{
+	ThreadBuffer *buffer = GetThreadBuffer();
+
+	long long eventId = buffer->noRecorded.load(std::memory_order_relaxed);
+	TraceEvent &event = buffer->events[eventId % BUFFER_CAPACITY];
+	event.name = name;
+	event.category = category;
+	event.begin = begin;
+	event.duration = end - begin;
+
+	buffer->noRecorded.store(eventId + 1, std::memory_order_release);
+}
+
+void TraceRecorder::SetThreadName(const char *name)
+{
+	GetThreadBuffer()->threadName = name;
+}
+
+bool TraceRecorder::WriteChromeTrace(const char *fileName)
+{
+	FILE *f = fopen(fileName, "w");
+	if (f == NULL) return false;
+
+	fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+	TraceRegistry &registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	bool first = true;
+	for (size_t bufferId = 0; bufferId < registry.buffers.size(); bufferId++)
+	{
+		const ThreadBuffer *buffer = registry.buffers[bufferId];
+
+		if (buffer->threadName != NULL)
+		{
+			fprintf(f, "%s{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_name\",\"args\":{\"name\":", first ? "" : ",\n", buffer->threadId);
+			WriteJSONString(f, buffer->threadName);
+			fprintf(f, "}}");
+			first = false;
+		}
+
+		long long noRecorded = buffer->noRecorded.load(std::memory_order_acquire);
+		long long firstEventId = noRecorded > BUFFER_CAPACITY ? noRecorded - BUFFER_CAPACITY : 0;
+
+		for (long long eventId = firstEventId; eventId < noRecorded; eventId++)
+		{
+			const TraceEvent &event = buffer->events[eventId % BUFFER_CAPACITY];
+
+			fprintf(f, "%s{\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%lld,\"dur\":%lld,\"name\":", first ? "" : ",\n", buffer->threadId, event.begin, event.duration);
+			WriteJSONString(f, event.name);
+			fprintf(f, ",\"cat\":");
+			WriteJSONString(f, event.category);
+			fprintf(f, "}");
+			first = false;
+		}
+	}
+
+	fprintf(f, "\n]}\n");
+
+	bool success = ferror(f) == 0;
+	success = fclose(f) == 0 && success;
+	return success;
+}
+
+void TraceRecorder::Clear(void)
+{
+	TraceRegistry &registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	for (size_t bufferId = 0; bufferId < registry.buffers.size(); bufferId++)
+		registry.buffers[bufferId]->noRecorded.store(0);
+}
+
+#else
+
+void TraceRecorder::SetEnabled(bool enabled) {}
+long long TraceRecorder::Now(void) { return 0; }
+void TraceRecorder::Record(const char *name, const char *category, long long begin, long long end) {}
+void TraceRecorder::SetThreadName(const char *name) {}
+bool TraceRecorder::WriteChromeTrace(const char *fileName) { return false; }
+void TraceRecorder::Clear(void) {}
+
+#endif
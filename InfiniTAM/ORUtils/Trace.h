@@ -0,0 +1,85 @@
+// Copyright 2014-2017 Oxford University Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#ifndef NO_CPP11
+#include <atomic>
+#endif
+
+namespace ORUtils
+{
+	/** \brief
+	    Records timed spans of code into per-thread ring buffers and
+	    writes them out as a Chrome trace event file, to be viewed in
+	    chrome://tracing or ui.perfetto.dev.
+
+	    Each thread appends to its own buffer without locking, only its
+	    first span takes a lock to register the buffer. When a buffer
+	    is full the oldest spans of that thread are overwritten. Span
+	    names and categories are stored as pointers and must be string
+	    literals. Spans measure host time: CUDA work shows up in the
+	    span that waits for it, not in the one that launched it.
+
+	    Without C++11 (NO_CPP11) nothing is recorded.
+	*/
+	class TraceRecorder
+	{
+	private:
+#ifndef NO_CPP11
+		static std::atomic<bool> enabled;
+#endif
+
+	public:
+		/// Number of spans kept per thread
+		static const int BUFFER_CAPACITY = 1 << 16;
+
+		static bool IsEnabled(void)
+		{
+#ifndef NO_CPP11
+			return enabled.load(std::memory_order_relaxed);
+#else
+			return false;
+#endif
+		}
+
+		static void SetEnabled(bool enabled);
+
+		/// Microseconds since the first call
+		static long long Now(void);
+
+		/// Appends a span of the calling thread, times are from Now()
+		static void Record(const char *name, const char *category, long long begin, long long end);
+
+		/// Names the calling thread in the written trace
+		static void SetThreadName(const char *name);
+
+		/** Writes the spans of all threads to a Chrome trace event JSON file, returns false
+		    if the file cannot be written. Spans recorded while writing may or may not be included.
+		*/
+		static bool WriteChromeTrace(const char *fileName);
+
+		/// Drops all recorded spans, only while no other thread is recording
+		static void Clear(void);
+	};
+
+	/// Records the lifetime of the object as a span, if tracing is enabled when it is created
+	class TraceSpan
+	{
+	private:
+		const char *name, *category;
+		long long begin;
+
+	public:
+		explicit TraceSpan(const char *name, const char *category = "ITMLib")
+			: name(name), category(category), begin(TraceRecorder::IsEnabled() ? TraceRecorder::Now() : -1) {}
+
+		~TraceSpan(void)
+		{
+			if (begin >= 0) TraceRecorder::Record(name, category, begin, TraceRecorder::Now());
+		}
+
+		// Suppress the default copy constructor and assignment operator
+		TraceSpan(const TraceSpan&);
+		TraceSpan& operator=(const TraceSpan&);
+	};
+}